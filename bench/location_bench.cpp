@@ -0,0 +1,137 @@
+// Copyright 2025 Ideal Broccoli
+
+// Measures location lookup with the linear prefix scan the server used to
+// do and with LocationTrie, over one server with many locations, and
+// checks that both pick the same location.
+//
+// Usage: location_bench [locations (default 10000)] [lookups (default 100000)]
+
+#include <sys/time.h>
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../src/config/config_location_trie.hpp"
+#include "../toolbox/string.hpp"
+
+namespace {
+double nowMicroseconds() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1e6 + tv.tv_usec;
+}
+
+// - The loop of the former Request::findDeepestMatchingLocation, copy of
+//   each path included.
+std::size_t linearMatch(const std::vector<std::string>& locations,
+                        const std::string& path) {
+    std::size_t bestMatch = config::LocationTrie::npos;
+    std::size_t longestMatchLength = 0;
+    for (std::size_t i = 0; i < locations.size(); ++i) {
+        std::string locPath = locations[i];
+        if (locPath == path) {
+            return i;
+        }
+        if (path.find(locPath) == 0 && locPath.size() > longestMatchLength) {
+            if (locPath[locPath.size() - 1] == '/' ||
+                path.size() == locPath.size() ||
+                path[locPath.size()] == '/') {
+                bestMatch = i;
+                longestMatchLength = locPath.size();
+            }
+        }
+    }
+    return bestMatch;
+}
+
+// - Shaped like a generated configuration: tenants, API versions and
+//   resources, with and without a trailing slash.
+std::vector<std::string> makeLocations(std::size_t count) {
+    std::vector<std::string> locations(1, "/");
+    for (std::size_t i = 0; locations.size() < count; ++i) {
+        std::string tenant = "/t" + toolbox::to_string(i % 500);
+        std::string path = tenant + "/api/v" + toolbox::to_string(i % 3)
+            + "/res" + toolbox::to_string(i);
+        locations.push_back(i % 2 == 0 ? path : path + "/");
+        if (i < 500) {
+            locations.push_back(tenant);
+        }
+    }
+    locations.resize(count);
+    return locations;
+}
+
+std::vector<std::string> makePaths(const std::vector<std::string>& locations,
+                                   std::size_t count) {
+    std::vector<std::string> paths;
+    std::srand(42);
+    for (std::size_t i = 0; i < count; ++i) {
+        const std::string& location = locations[std::rand() % locations.size()];
+        switch (i % 4) {
+            case 0: paths.push_back(location); break;
+            case 1: paths.push_back(location + "/index.html"); break;
+            case 2: paths.push_back(location + "x/y"); break;
+            default: paths.push_back("/static/app.js"); break;
+        }
+    }
+    return paths;
+}
+
+double run(const char* name, bool useTrie,
+           const std::vector<std::string>& locations,
+           const config::LocationTrie& trie,
+           const std::vector<std::string>& paths,
+           std::vector<std::size_t>* results) {
+    std::vector<std::size_t> found(paths.size());
+    double start = nowMicroseconds();
+    for (std::size_t i = 0; i < paths.size(); ++i) {
+        bool isExact = false;
+        found[i] = useTrie ? trie.match(paths[i], &isExact)
+                           : linearMatch(locations, paths[i]);
+    }
+    double elapsed = nowMicroseconds() - start;
+    std::cout << std::left << std::setw(7) << name << std::right
+              << std::fixed << std::setprecision(3) << std::setw(10)
+              << elapsed / paths.size() << " us/lookup" << std::endl;
+    results->swap(found);
+    return elapsed;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+    long locationCount = argc > 1 ? std::strtol(argv[1], NULL, 10) : 10000;
+    long lookups = argc > 2 ? std::strtol(argv[2], NULL, 10) : 100000;
+    if (locationCount <= 0 || lookups <= 0) {
+        std::cerr << "usage: location_bench [locations] [lookups]" << std::endl;
+        return 1;
+    }
+    std::vector<std::string> locations = makeLocations(locationCount);
+    std::vector<std::string> paths = makePaths(locations, lookups);
+    double start = nowMicroseconds();
+    config::LocationTrie trie;
+    for (std::size_t i = 0; i < locations.size(); ++i) {
+        trie.insert(locations[i], i);
+    }
+    std::cout << locations.size() << " locations, " << paths.size()
+              << " lookups, trie built in " << std::fixed
+              << std::setprecision(1) << (nowMicroseconds() - start) / 1000
+              << " ms" << std::endl;
+
+    std::vector<std::size_t> linearResults;
+    std::vector<std::size_t> trieResults;
+    double linearTime = run("linear", false, locations, trie, paths,
+                            &linearResults);
+    double trieTime = run("trie", true, locations, trie, paths, &trieResults);
+    for (std::size_t i = 0; i < paths.size(); ++i) {
+        if (linearResults[i] != trieResults[i]) {
+            std::cerr << "mismatch for " << paths[i] << std::endl;
+            return 1;
+        }
+    }
+    std::cout << "speedup " << std::setprecision(1)
+              << linearTime / trieTime << "x" << std::endl;
+    return 0;
+}
@@ -0,0 +1,45 @@
+#!/bin/bash
+# Runs the webserv-bench scenarios against a local webserv started with
+# conf/bench.conf. Build both first with make && make bench.
+#
+# Usage: bench/run.sh [scenario...]   (default: all of bench/scenarios)
+# THREADS, CONNECTIONS, DURATION, DEPTH and RATE are passed on as -t, -c,
+# -d, -p and -r.
+
+set -e
+cd "$(dirname "$0")/.."
+
+URL=http://127.0.0.1:8090
+WWW=bench/www
+
+if [ ! -x ./webserv ] || [ ! -x bench/webserv-bench ]; then
+    echo "run make && make bench first" >&2
+    exit 1
+fi
+
+mkdir -p $WWW/listing $WWW/uploads/store
+head -c 1024 /dev/zero | tr '\0' 'x' > $WWW/small.html
+head -c $((8 * 1024 * 1024)) /dev/urandom > $WWW/large.bin
+for i in $(seq 1 200); do
+    echo "file $i" > $WWW/listing/file_$i.txt
+done
+
+./webserv conf/bench.conf > /dev/null 2>&1 &
+SERVER=$!
+trap 'kill -INT $SERVER 2>/dev/null; wait $SERVER 2>/dev/null; rm -rf $WWW/uploads/store' EXIT
+for _ in $(seq 1 50); do
+    if (echo > /dev/tcp/127.0.0.1/8090) 2>/dev/null; then
+        break
+    fi
+    sleep 0.1
+done
+
+if [ $# -eq 0 ]; then
+    set -- bench/scenarios/*.mix
+fi
+for scenario in "$@"; do
+    echo "== $(basename "$scenario" .mix)"
+    bench/webserv-bench -t "${THREADS:-2}" -c "${CONNECTIONS:-16}" \
+        -d "${DURATION:-10}" -p "${DEPTH:-1}" -r "${RATE:-0}" \
+        -m "$scenario" $URL
+done
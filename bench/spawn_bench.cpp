@@ -0,0 +1,104 @@
+// Copyright 2025 Ideal Broccoli
+
+// Measures how long the server is blocked starting one CGI, with
+// ChildLauncher's SPAWN (posix_spawn) and FORK methods, while the process
+// holds a given amount of touched memory.
+//
+// Usage: spawn_bench [resident MiB (default 1024)] [launches (default 200)]
+
+#include <fcntl.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../src/event/child_launcher.hpp"
+
+namespace {
+const char* PROGRAM = "/bin/true";
+
+double nowMicroseconds() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1e6 + tv.tv_usec;
+}
+
+// - Mirrors what CgiExecute asks for: a working directory, stdin from
+//   /dev/null and stdout to a pipe.
+bool measure(ChildLauncher::Method method, int launches,
+             std::vector<double>* samples) {
+    int output[2];
+    if (pipe2(output, O_CLOEXEC) == -1) {
+        return false;
+    }
+    ChildLauncher launcher;
+    launcher.changeDirectory("/");
+    launcher.redirectToNull(STDIN_FILENO, O_RDONLY);
+    launcher.redirect(output[1], STDOUT_FILENO);
+    std::vector<std::string> argv(1, PROGRAM);
+    for (int i = 0; i < launches; ++i) {
+        double start = nowMicroseconds();
+        pid_t pid = launcher.launch(PROGRAM, argv, NULL, method);
+        samples->push_back(nowMicroseconds() - start);
+        if (pid == -1) {
+            return false;
+        }
+        waitpid(pid, NULL, 0);
+    }
+    close(output[0]);
+    close(output[1]);
+    return true;
+}
+
+void report(const char* name, std::vector<double> samples) {
+    std::sort(samples.begin(), samples.end());
+    double total = 0;
+    for (std::size_t i = 0; i < samples.size(); ++i) {
+        total += samples[i];
+    }
+    std::cout << std::left << std::setw(7) << name << std::right
+              << std::fixed << std::setprecision(1)
+              << " mean " << std::setw(9) << total / samples.size()
+              << " us  p50 " << std::setw(9) << samples[samples.size() / 2]
+              << " us  p99 " << std::setw(9)
+              << samples[samples.size() * 99 / 100] << " us" << std::endl;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+    long residentMiB = argc > 1 ? std::strtol(argv[1], NULL, 10) : 1024;
+    int launches = argc > 2 ? std::atoi(argv[2]) : 200;
+    if (residentMiB < 0 || launches <= 0) {
+        std::cerr << "usage: spawn_bench [resident MiB] [launches]" << std::endl;
+        return 1;
+    }
+    std::size_t size = static_cast<std::size_t>(residentMiB) << 20;
+    char* memory = static_cast<char*>(std::malloc(size > 0 ? size : 1));
+    if (memory == NULL) {
+        std::cerr << "cannot allocate " << residentMiB << " MiB" << std::endl;
+        return 1;
+    }
+    std::memset(memory, 1, size);
+    std::cout << "resident " << residentMiB << " MiB, "
+              << launches << " launches of " << PROGRAM << std::endl;
+
+    std::vector<double> spawnSamples;
+    std::vector<double> forkSamples;
+    if (!measure(ChildLauncher::SPAWN, launches, &spawnSamples) ||
+        !measure(ChildLauncher::FORK, launches, &forkSamples)) {
+        std::cerr << "launch failed" << std::endl;
+        std::free(memory);
+        return 1;
+    }
+    report("spawn", spawnSamples);
+    report("fork", forkSamples);
+    std::free(memory);
+    return 0;
+}
@@ -0,0 +1,1007 @@
+// Copyright 2025 Ideal Broccoli
+
+// An HTTP/1.1 load generator. Each thread drives its share of the
+// connections from its own epoll instance, keeps up to the pipeline depth
+// of requests in flight on each, and reconnects whenever the server closes
+// one. Without -r, every response is answered by the next request (closed
+// loop); with -r, requests are started at a fixed rate whatever the server
+// does (open loop), and their latency counts from when they were due, so
+// that a stalled server shows in the percentiles instead of slowing the
+// load down.
+//
+// A mix file lists the requests to send, one per line, picked at random
+// in proportion to their weight:
+//
+//   # weight method path [@body-size | <body-file]
+//   8 GET /small.html
+//   1 POST /uploads/ @65536
+//
+// Usage: webserv-bench [-t threads] [-c connections] [-d seconds]
+//                      [-p depth] [-r rate] [-C] [-m mix-file] URL
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+const std::size_t READ_SIZE = 64 * 1024;
+const std::size_t MAX_HEADER_SIZE = 64 * 1024;
+const double RECONNECT_DELAY = 0.1;
+const int MAX_EVENTS = 256;
+const std::size_t SUB_BUCKETS = 64;
+const std::size_t BUCKET_COUNT = SUB_BUCKETS * 60;
+
+double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+bool startsWithIgnoreCase(const std::string& str, const std::string& prefix) {
+    if (str.size() < prefix.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < prefix.size(); ++i) {
+        if (std::tolower(static_cast<unsigned char>(str[i]))
+                != std::tolower(static_cast<unsigned char>(prefix[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string toLower(std::string str) {
+    for (std::size_t i = 0; i < str.size(); ++i) {
+        str[i] = static_cast<char>(
+            std::tolower(static_cast<unsigned char>(str[i])));
+    }
+    return str;
+}
+
+struct Options {
+    Options()
+        : threads(2), connections(16), duration(10), depth(1), rate(0),
+          isKeepAlive(true) {}
+
+    int threads;
+    int connections;
+    double duration;    // seconds
+    int depth;          // requests in flight per connection
+    double rate;        // requests per second in all, 0 for a closed loop
+    bool isKeepAlive;
+    std::string mixFile;
+    std::string host;
+    std::string port;
+    std::string path;
+};
+
+struct MixEntry {
+    std::string method;
+    std::string path;
+    std::string wire;   // the request as sent
+    unsigned weight;
+};
+
+// - Latencies in microseconds, in buckets of 1/64 of a power of two, so
+//   that every percentile is within 1.6% whatever the range.
+class LatencyHistogram {
+ public:
+    LatencyHistogram()
+        : _counts(BUCKET_COUNT, 0), _count(0), _sum(0), _min(0), _max(0) {}
+
+    void record(uint64_t micros) {
+        ++_counts[bucketOf(micros)];
+        _min = _count == 0 ? micros : std::min(_min, micros);
+        _max = std::max(_max, micros);
+        _sum += micros;
+        ++_count;
+    }
+
+    void merge(const LatencyHistogram& other) {
+        if (other._count == 0) {
+            return;
+        }
+        for (std::size_t i = 0; i < BUCKET_COUNT; ++i) {
+            _counts[i] += other._counts[i];
+        }
+        _min = _count == 0 ? other._min : std::min(_min, other._min);
+        _max = std::max(_max, other._max);
+        _sum += other._sum;
+        _count += other._count;
+    }
+
+    uint64_t getCount() const { return _count; }
+    double getMin() const { return _min; }
+    double getMax() const { return _max; }
+    double getMean() const {
+        return _count == 0 ? 0 : static_cast<double>(_sum) / _count;
+    }
+
+    // The middle of the bucket holding the quantile, capped by the maximum.
+    double getPercentile(double quantile) const {
+        uint64_t target = static_cast<uint64_t>(quantile * _count);
+        uint64_t seen = 0;
+        for (std::size_t i = 0; i < BUCKET_COUNT; ++i) {
+            seen += _counts[i];
+            if (seen > target) {
+                return std::min(valueOf(i), static_cast<double>(_max));
+            }
+        }
+        return _max;
+    }
+
+ private:
+    static std::size_t bucketOf(uint64_t value) {
+        if (value < 2 * SUB_BUCKETS) {
+            return static_cast<std::size_t>(value);
+        }
+        std::size_t shift = 0;
+        while ((value >> shift) >= 2 * SUB_BUCKETS) {
+            ++shift;
+        }
+        return (shift + 1) * SUB_BUCKETS
+            + static_cast<std::size_t>(value >> shift) - SUB_BUCKETS;
+    }
+
+    static double valueOf(std::size_t bucket) {
+        if (bucket < 2 * SUB_BUCKETS) {
+            return bucket;
+        }
+        std::size_t shift = bucket / SUB_BUCKETS - 1;
+        double low = static_cast<double>(
+            (bucket % SUB_BUCKETS + SUB_BUCKETS) << shift);
+        double width = static_cast<double>(static_cast<uint64_t>(1) << shift);
+        return low + (width - 1) / 2;
+    }
+
+    std::vector<uint64_t> _counts;
+    uint64_t _count;
+    uint64_t _sum;
+    uint64_t _min;
+    uint64_t _max;
+};
+
+struct Stats {
+    Stats()
+        : responses(0), bytes(0), connects(0), serverCloses(0),
+          connectErrors(0), readErrors(0), invalidResponses(0) {
+        for (int i = 0; i < 6; ++i) {
+            statusClasses[i] = 0;
+        }
+    }
+
+    void merge(const Stats& other) {
+        responses += other.responses;
+        bytes += other.bytes;
+        connects += other.connects;
+        serverCloses += other.serverCloses;
+        connectErrors += other.connectErrors;
+        readErrors += other.readErrors;
+        invalidResponses += other.invalidResponses;
+        for (int i = 0; i < 6; ++i) {
+            statusClasses[i] += other.statusClasses[i];
+        }
+        latency.merge(other.latency);
+    }
+
+    uint64_t responses;
+    uint64_t statusClasses[6];  // by the first digit, 0 for the others
+    uint64_t bytes;
+    uint64_t connects;
+    uint64_t serverCloses;
+    uint64_t connectErrors;
+    uint64_t readErrors;
+    uint64_t invalidResponses;
+    LatencyHistogram latency;
+};
+
+// - Follows one response at a time through its headers and its body,
+//   delimited by Content-Length, chunked encoding or the end of the
+//   connection. Body bytes are only counted, never kept.
+class ResponseParser {
+ public:
+    enum Result {
+        INCOMPLETE,
+        COMPLETE,
+        INVALID
+    };
+
+    ResponseParser() { reset(false); }
+
+    void reset(bool isHead) {
+        _state = STATUS_AND_HEADERS;
+        _isHead = isHead;
+        _line.clear();
+        _remaining = 0;
+        _status = 0;
+        _isClose = false;
+    }
+
+    bool hasStarted() const {
+        return _state != STATUS_AND_HEADERS || !_line.empty();
+    }
+    int getStatus() const { return _status; }
+    bool isClose() const { return _isClose; }
+
+    // - Consumes what belongs to the current response; *used tells how
+    //   much, the rest starts the next one.
+    Result feed(const char* data, std::size_t size, std::size_t* used) {
+        *used = 0;
+        while (*used < size || _state == DONE) {
+            const char* rest = data + *used;
+            std::size_t restSize = size - *used;
+            std::size_t taken = 0;
+            switch (_state) {
+                case STATUS_AND_HEADERS:
+                    if (!takeUntil(rest, restSize, "\r\n\r\n", &taken)) {
+                        *used += taken;
+                        return _line.size() > MAX_HEADER_SIZE
+                            ? INVALID : INCOMPLETE;
+                    }
+                    *used += taken;
+                    if (!parseHeaders()) {
+                        return INVALID;
+                    }
+                    break;
+                case BODY:
+                    taken = std::min<std::size_t>(restSize, _remaining);
+                    _remaining -= taken;
+                    *used += taken;
+                    if (_remaining == 0) {
+                        _state = DONE;
+                    }
+                    break;
+                case CHUNK_SIZE:
+                    if (!takeUntil(rest, restSize, "\r\n", &taken)) {
+                        *used += taken;
+                        return INCOMPLETE;
+                    }
+                    *used += taken;
+                    if (!parseChunkSize()) {
+                        return INVALID;
+                    }
+                    break;
+                case CHUNK_DATA:
+                    taken = std::min<std::size_t>(restSize, _remaining);
+                    _remaining -= taken;
+                    *used += taken;
+                    if (_remaining == 0) {
+                        _state = CHUNK_END;
+                    }
+                    break;
+                case CHUNK_END:
+                    if (!takeUntil(rest, restSize, "\r\n", &taken)) {
+                        *used += taken;
+                        return INCOMPLETE;
+                    }
+                    *used += taken;
+                    if (!_line.empty()) {
+                        return INVALID;
+                    }
+                    _state = CHUNK_SIZE;
+                    break;
+                case TRAILERS:
+                    if (!takeUntil(rest, restSize, "\r\n\r\n", &taken)) {
+                        *used += taken;
+                        return INCOMPLETE;
+                    }
+                    *used += taken;
+                    _state = DONE;
+                    break;
+                case UNTIL_CLOSE:
+                    *used = size;
+                    return INCOMPLETE;
+                case DONE:
+                    _line.clear();
+                    return COMPLETE;
+            }
+        }
+        return INCOMPLETE;
+    }
+
+    // - At the end of the connection.
+    Result finish() {
+        if (_state == UNTIL_CLOSE) {
+            return COMPLETE;
+        }
+        return hasStarted() ? INVALID : INCOMPLETE;
+    }
+
+ private:
+    enum State {
+        STATUS_AND_HEADERS,
+        BODY,
+        CHUNK_SIZE,
+        CHUNK_DATA,
+        CHUNK_END,
+        TRAILERS,
+        UNTIL_CLOSE,
+        DONE
+    };
+
+    // - Collects bytes into _line up to the terminator, which is dropped.
+    bool takeUntil(const char* data, std::size_t size, const char* terminator,
+                   std::size_t* taken) {
+        std::size_t before = _line.size();
+        std::size_t length = std::strlen(terminator);
+        _line.append(data, size);
+        std::size_t from = before >= length ? before - length + 1 : 0;
+        std::size_t end = _line.find(terminator, from);
+        if (end == std::string::npos) {
+            *taken = size;
+            return false;
+        }
+        *taken = end + length - before;
+        _line.resize(end);
+        return true;
+    }
+
+    bool parseHeaders() {
+        std::istringstream lines(_line);
+        std::string line;
+        std::getline(lines, line);
+        if (line.compare(0, 5, "HTTP/") != 0 || line.size() < 12) {
+            return false;
+        }
+        _status = std::atoi(line.c_str() + 9);
+        _isClose = line.compare(0, 8, "HTTP/1.0") == 0;
+        bool hasLength = false;
+        bool isChunked = false;
+        while (std::getline(lines, line)) {
+            if (!line.empty() && line[line.size() - 1] == '\r') {
+                line.erase(line.size() - 1);
+            }
+            if (startsWithIgnoreCase(line, "content-length:")) {
+                hasLength = true;
+                _remaining = std::strtoul(line.c_str() + 15, NULL, 10);
+            } else if (startsWithIgnoreCase(line, "transfer-encoding:")) {
+                isChunked = toLower(line).find("chunked") != std::string::npos;
+            } else if (startsWithIgnoreCase(line, "connection:")) {
+                std::string value = toLower(line.substr(11));
+                _isClose = value.find("close") != std::string::npos
+                    || (_isClose
+                        && value.find("keep-alive") == std::string::npos);
+            }
+        }
+        _line.clear();
+        if (_isHead || _status == 204 || _status == 304 || _status < 200) {
+            _state = DONE;
+        } else if (isChunked) {
+            _state = CHUNK_SIZE;
+        } else if (hasLength) {
+            _state = _remaining > 0 ? BODY : DONE;
+        } else {
+            _state = UNTIL_CLOSE;
+            _isClose = true;
+        }
+        return true;
+    }
+
+    bool parseChunkSize() {
+        char* end = NULL;
+        _remaining = std::strtoul(_line.c_str(), &end, 16);
+        if (end == _line.c_str()) {
+            return false;
+        }
+        if (_remaining == 0) {
+            // The last chunk: an empty line, or trailers and an empty line.
+            _line = "\r\n";
+            _state = TRAILERS;
+        } else {
+            _line.clear();
+            _state = CHUNK_DATA;
+        }
+        return true;
+    }
+
+    State _state;
+    bool _isHead;
+    std::string _line;
+    std::size_t _remaining;
+    int _status;
+    bool _isClose;
+};
+
+struct InFlight {
+    std::size_t entry;
+    double startedAt;   // when it was due, in an open loop
+};
+
+struct Connection {
+    Connection() : fd(-1), isConnecting(false), retryAt(0), sent(0) {}
+
+    int fd;
+    bool isConnecting;
+    double retryAt;
+    std::string out;
+    std::size_t sent;
+    std::deque<InFlight> inFlight;
+    ResponseParser parser;
+};
+
+struct Target {
+    struct sockaddr_storage address;
+    socklen_t length;
+};
+
+class Worker {
+ public:
+    Worker(const Options& options, const Target& target,
+           const std::vector<MixEntry>& mix, int connections, double rate,
+           unsigned seed)
+        : _options(options), _target(target), _mix(mix),
+          _connections(connections), _rate(rate), _epollFd(-1),
+          _deadline(0), _nextDue(0), _seed(seed ? seed : 1), _next(0) {
+        unsigned total = 0;
+        for (std::size_t i = 0; i < mix.size(); ++i) {
+            total += mix[i].weight;
+            _cumulativeWeights.push_back(total);
+        }
+    }
+
+    const Stats& getStats() const { return _stats; }
+
+    static void* start(void* worker) {
+        static_cast<Worker*>(worker)->run();
+        return NULL;
+    }
+
+ private:
+    void run() {
+        _epollFd = epoll_create1(EPOLL_CLOEXEC);
+        if (_epollFd == -1) {
+            return;
+        }
+        double startedAt = now();
+        _deadline = startedAt + _options.duration;
+        _nextDue = startedAt;
+        struct epoll_event events[MAX_EVENTS];
+        while (now() < _deadline) {
+            scheduleDue();
+            refill();
+            int count = epoll_wait(_epollFd, events, MAX_EVENTS, getTimeout());
+            for (int i = 0; i < count; ++i) {
+                Connection& connection = _connections[events[i].data.u32];
+                if (events[i].events & (EPOLLOUT | EPOLLERR | EPOLLHUP)) {
+                    handleWritable(&connection);
+                }
+                if (connection.fd != -1
+                        && (events[i].events & (EPOLLIN | EPOLLHUP))) {
+                    handleReadable(&connection);
+                }
+            }
+        }
+        for (std::size_t i = 0; i < _connections.size(); ++i) {
+            if (_connections[i].fd != -1) {
+                close(_connections[i].fd);
+            }
+        }
+        close(_epollFd);
+    }
+
+    bool isOpenLoop() const { return _rate > 0; }
+
+    // - In an open loop, requests fall due at a fixed pace and wait here
+    //   for a connection that can take them.
+    void scheduleDue() {
+        if (!isOpenLoop()) {
+            return;
+        }
+        double current = now();
+        while (_nextDue <= current && _nextDue < _deadline) {
+            _pending.push_back(_nextDue);
+            _nextDue += 1 / _rate;
+        }
+    }
+
+    int getTimeout() const {
+        double wakeAt = _deadline;
+        if (isOpenLoop() && _pending.empty()) {
+            wakeAt = std::min(wakeAt, _nextDue);
+        }
+        for (std::size_t i = 0; i < _connections.size(); ++i) {
+            if (_connections[i].fd == -1) {
+                wakeAt = std::min(wakeAt, _connections[i].retryAt);
+            }
+        }
+        double wait = (wakeAt - now()) * 1000;
+        return wait <= 0 ? 0 : static_cast<int>(wait) + 1;
+    }
+
+    // - Opens the connections that are due and gives each as many requests
+    //   as the pipeline depth allows, starting after the last one served so
+    //   that an open loop spreads over all of them.
+    void refill() {
+        double current = now();
+        std::size_t count = _connections.size();
+        for (std::size_t n = 0; n < count; ++n) {
+            std::size_t i = (_next + n) % count;
+            Connection& connection = _connections[i];
+            if (connection.fd == -1 && connection.retryAt <= current) {
+                open(&connection, i);
+            }
+            if (connection.fd == -1 || connection.isConnecting) {
+                continue;
+            }
+            bool isAdded = false;
+            while (connection.inFlight.size()
+                    < static_cast<std::size_t>(_options.depth)) {
+                InFlight request;
+                if (isOpenLoop()) {
+                    if (_pending.empty()) {
+                        break;
+                    }
+                    request.startedAt = _pending.front();
+                    _pending.pop_front();
+                } else {
+                    request.startedAt = current;
+                }
+                request.entry = pickEntry();
+                if (connection.inFlight.empty()) {
+                    connection.parser.reset(
+                        _mix[request.entry].method == "HEAD");
+                }
+                connection.inFlight.push_back(request);
+                connection.out += _mix[request.entry].wire;
+                isAdded = true;
+                _next = i + 1;
+            }
+            if (isAdded) {
+                handleWritable(&connection);
+            }
+        }
+    }
+
+    std::size_t pickEntry() {
+        _seed ^= _seed << 13;
+        _seed ^= _seed >> 17;
+        _seed ^= _seed << 5;
+        unsigned point = _seed % _cumulativeWeights.back();
+        return std::upper_bound(_cumulativeWeights.begin(),
+                                _cumulativeWeights.end(), point)
+            - _cumulativeWeights.begin();
+    }
+
+    void open(Connection* connection, std::size_t index) {
+        int fd = socket(_target.address.ss_family,
+                        SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd == -1) {
+            failConnect(connection);
+            return;
+        }
+        int on = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        if (connect(fd, reinterpret_cast<const struct sockaddr*>(
+                &_target.address), _target.length) == -1
+                && errno != EINPROGRESS) {
+            close(fd);
+            failConnect(connection);
+            return;
+        }
+        struct epoll_event event;
+        event.events = EPOLLIN | EPOLLOUT;
+        event.data.u64 = 0;
+        event.data.u32 = static_cast<uint32_t>(index);
+        epoll_ctl(_epollFd, EPOLL_CTL_ADD, fd, &event);
+        connection->fd = fd;
+        connection->isConnecting = true;
+        connection->out.clear();
+        connection->sent = 0;
+        ++_stats.connects;
+    }
+
+    void failConnect(Connection* connection) {
+        ++_stats.connectErrors;
+        connection->retryAt = now() + RECONNECT_DELAY;
+    }
+
+    // - Requests sent but not answered are sent again on the next
+    //   connection, keeping when they were due in an open loop.
+    void reconnect(Connection* connection) {
+        epoll_ctl(_epollFd, EPOLL_CTL_DEL, connection->fd, NULL);
+        close(connection->fd);
+        connection->fd = -1;
+        connection->isConnecting = false;
+        connection->retryAt = 0;
+        if (isOpenLoop()) {
+            while (!connection->inFlight.empty()) {
+                _pending.push_front(connection->inFlight.back().startedAt);
+                connection->inFlight.pop_back();
+            }
+        }
+        connection->inFlight.clear();
+        connection->parser.reset(false);
+    }
+
+    void watch(Connection* connection, bool isWriting) {
+        struct epoll_event event;
+        event.events = isWriting ? EPOLLIN | EPOLLOUT : EPOLLIN;
+        event.data.u64 = 0;
+        event.data.u32 = static_cast<uint32_t>(connection - &_connections[0]);
+        epoll_ctl(_epollFd, EPOLL_CTL_MOD, connection->fd, &event);
+    }
+
+    void handleWritable(Connection* connection) {
+        if (connection->isConnecting) {
+            int error = 0;
+            socklen_t length = sizeof(error);
+            getsockopt(connection->fd, SOL_SOCKET, SO_ERROR, &error, &length);
+            if (error != 0) {
+                reconnect(connection);
+                failConnect(connection);
+                return;
+            }
+            connection->isConnecting = false;
+            if (connection->out.empty()) {
+                watch(connection, false);
+                return;
+            }
+        }
+        while (connection->sent < connection->out.size()) {
+            ssize_t written = send(connection->fd,
+                connection->out.data() + connection->sent,
+                connection->out.size() - connection->sent, MSG_NOSIGNAL);
+            if (written == -1) {
+                if (errno == EAGAIN) {
+                    watch(connection, true);
+                    return;
+                }
+                ++_stats.serverCloses;
+                reconnect(connection);
+                return;
+            }
+            connection->sent += written;
+        }
+        connection->out.clear();
+        connection->sent = 0;
+        watch(connection, false);
+    }
+
+    void handleReadable(Connection* connection) {
+        char buffer[READ_SIZE];
+        ssize_t received = recv(connection->fd, buffer, sizeof(buffer), 0);
+        if (received == -1 && errno == EAGAIN) {
+            return;
+        }
+        if (received <= 0) {
+            // A response read until the close ends here, and reconnects.
+            if (!connection->inFlight.empty() && connection->parser.finish()
+                    == ResponseParser::COMPLETE) {
+                complete(connection);
+                return;
+            }
+            if (connection->parser.hasStarted()) {
+                ++_stats.readErrors;
+            }
+            ++_stats.serverCloses;
+            reconnect(connection);
+            return;
+        }
+        _stats.bytes += received;
+        std::size_t offset = 0;
+        while (offset < static_cast<std::size_t>(received)) {
+            if (connection->inFlight.empty()) {
+                ++_stats.invalidResponses;
+                reconnect(connection);
+                return;
+            }
+            std::size_t used = 0;
+            ResponseParser::Result result = connection->parser.feed(
+                buffer + offset, received - offset, &used);
+            offset += used;
+            if (result == ResponseParser::INVALID) {
+                ++_stats.invalidResponses;
+                connection->inFlight.clear();
+                reconnect(connection);
+                return;
+            }
+            if (result == ResponseParser::COMPLETE
+                    && !complete(connection)) {
+                return;
+            }
+        }
+    }
+
+    // - Records the response at the front; false if the server asked to
+    //   close, or the connection is used once.
+    bool complete(Connection* connection) {
+        const InFlight& request = connection->inFlight.front();
+        if (request.startedAt < _deadline) {
+            double latency = now() - request.startedAt;
+            _stats.latency.record(static_cast<uint64_t>(latency * 1e6));
+            ++_stats.responses;
+            int statusClass = connection->parser.getStatus() / 100;
+            ++_stats.statusClasses[statusClass >= 1 && statusClass <= 5
+                                   ? statusClass : 0];
+        }
+        bool isClose = connection->parser.isClose() || !_options.isKeepAlive;
+        connection->inFlight.pop_front();
+        if (isClose) {
+            if (connection->parser.isClose()) {
+                ++_stats.serverCloses;
+            }
+            reconnect(connection);
+            return false;
+        }
+        bool isHead = !connection->inFlight.empty()
+            && _mix[connection->inFlight.front().entry].method == "HEAD";
+        connection->parser.reset(isHead);
+        return true;
+    }
+
+    const Options& _options;
+    const Target& _target;
+    const std::vector<MixEntry>& _mix;
+    std::vector<unsigned> _cumulativeWeights;
+    std::vector<Connection> _connections;
+    double _rate;       // requests per second for this thread
+    int _epollFd;
+    double _deadline;
+    double _nextDue;
+    std::deque<double> _pending;
+    unsigned _seed;
+    std::size_t _next;
+    Stats _stats;
+};
+
+void usage() {
+    std::cerr << "usage: webserv-bench [-t threads] [-c connections]"
+              << " [-d seconds] [-p depth] [-r rate] [-C] [-m mix-file] URL"
+              << std::endl;
+}
+
+bool parseUrl(const std::string& url, Options* options) {
+    const std::string scheme = "http://";
+    if (url.compare(0, scheme.size(), scheme) != 0) {
+        return false;
+    }
+    std::string rest = url.substr(scheme.size());
+    std::size_t slash = rest.find('/');
+    std::string authority = rest.substr(0, slash);
+    options->path = slash == std::string::npos ? "/" : rest.substr(slash);
+    std::size_t colon = authority.rfind(':');
+    options->host = authority.substr(0, colon);
+    options->port = colon == std::string::npos ? "80"
+                                               : authority.substr(colon + 1);
+    return !options->host.empty() && !options->port.empty();
+}
+
+std::string makeWire(const Options& options, const std::string& method,
+                     const std::string& path, const std::string& body,
+                     bool hasBody) {
+    std::string wire = method + " " + path + " HTTP/1.1\r\n"
+        + "Host: " + options.host + ":" + options.port + "\r\n"
+        + "User-Agent: webserv-bench\r\n";
+    if (!options.isKeepAlive) {
+        wire += "Connection: close\r\n";
+    }
+    if (hasBody) {
+        std::ostringstream length;
+        length << body.size();
+        wire += "Content-Type: application/octet-stream\r\n";
+        wire += "Content-Length: " + length.str() + "\r\n";
+    }
+    return wire + "\r\n" + body;
+}
+
+// - One request per line: weight, method, path, and optionally a body of
+//   "@<bytes>" generated bytes or "<<file>" read from a file.
+bool loadMix(const Options& options, std::vector<MixEntry>* mix) {
+    if (options.mixFile.empty()) {
+        MixEntry entry;
+        entry.method = "GET";
+        entry.path = options.path;
+        entry.weight = 1;
+        entry.wire = makeWire(options, entry.method, entry.path, "", false);
+        mix->push_back(entry);
+        return true;
+    }
+    std::ifstream file(options.mixFile.c_str());
+    if (!file) {
+        std::cerr << "cannot open " << options.mixFile << std::endl;
+        return false;
+    }
+    std::string line;
+    for (int number = 1; std::getline(file, line); ++number) {
+        std::istringstream fields(line);
+        MixEntry entry;
+        std::string bodySpec;
+        int weight = 0;
+        if (!(fields >> weight)) {
+            continue;   // a blank line or a comment
+        }
+        if (weight <= 0 || !(fields >> entry.method >> entry.path)) {
+            std::cerr << options.mixFile << ":" << number
+                      << ": expected \"weight method path [body]\""
+                      << std::endl;
+            return false;
+        }
+        std::string body;
+        bool hasBody = !!(fields >> bodySpec);
+        if (hasBody && bodySpec[0] == '@') {
+            body.assign(std::strtoul(bodySpec.c_str() + 1, NULL, 10), 'x');
+        } else if (hasBody && bodySpec[0] == '<') {
+            std::ifstream bodyFile(bodySpec.c_str() + 1, std::ios::binary);
+            if (!bodyFile) {
+                std::cerr << "cannot open " << bodySpec.substr(1) << std::endl;
+                return false;
+            }
+            std::ostringstream content;
+            content << bodyFile.rdbuf();
+            body = content.str();
+        } else if (hasBody) {
+            std::cerr << options.mixFile << ":" << number
+                      << ": the body is @<bytes> or <<file>" << std::endl;
+            return false;
+        }
+        entry.weight = static_cast<unsigned>(weight);
+        entry.wire = makeWire(options, entry.method, entry.path, body,
+                              hasBody);
+        mix->push_back(entry);
+    }
+    if (mix->empty()) {
+        std::cerr << options.mixFile << ": no requests" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool resolve(const Options& options, Target* target) {
+    struct addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* result = NULL;
+    int error = getaddrinfo(options.host.c_str(), options.port.c_str(),
+                            &hints, &result);
+    if (error != 0) {
+        std::cerr << options.host << ": " << gai_strerror(error) << std::endl;
+        return false;
+    }
+    std::memcpy(&target->address, result->ai_addr, result->ai_addrlen);
+    target->length = result->ai_addrlen;
+    freeaddrinfo(result);
+    return true;
+}
+
+std::string formatBytes(double bytes) {
+    const char* units[] = {"B", "KiB", "MiB", "GiB"};
+    int unit = 0;
+    while (bytes >= 1024 && unit < 3) {
+        bytes /= 1024;
+        ++unit;
+    }
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(unit == 0 ? 0 : 2) << bytes
+        << " " << units[unit];
+    return out.str();
+}
+
+void report(const Options& options, const Stats& stats, double elapsed) {
+    std::cout << std::fixed << std::setprecision(2)
+              << "  " << stats.responses << " responses in " << elapsed
+              << "s, " << stats.responses / elapsed << " requests/s, "
+              << formatBytes(stats.bytes) << " read ("
+              << formatBytes(stats.bytes / elapsed) << "/s)" << std::endl;
+    std::cout << "  status   1xx " << stats.statusClasses[1]
+              << "  2xx " << stats.statusClasses[2]
+              << "  3xx " << stats.statusClasses[3]
+              << "  4xx " << stats.statusClasses[4]
+              << "  5xx " << stats.statusClasses[5]
+              << "  other " << stats.statusClasses[0] << std::endl;
+    std::cout << "  sockets  opened " << stats.connects
+              << "  closed by the server " << stats.serverCloses
+              << "  connect errors " << stats.connectErrors
+              << "  read errors " << stats.readErrors
+              << "  invalid responses " << stats.invalidResponses
+              << std::endl;
+    const LatencyHistogram& latency = stats.latency;
+    const double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+    const char* names[] = {"p50", "p90", "p99", "p99.9"};
+    std::cout << "  latency  " << std::setprecision(3)
+              << "min " << latency.getMin() / 1000
+              << "  mean " << latency.getMean() / 1000;
+    for (int i = 0; i < 4; ++i) {
+        std::cout << "  " << names[i] << " "
+                  << latency.getPercentile(quantiles[i]) / 1000;
+    }
+    std::cout << "  max " << latency.getMax() / 1000 << " ms" << std::endl;
+    if (options.isKeepAlive && stats.connects > stats.responses / 2 + 1) {
+        std::cout << "  note: the server closed most connections, so"
+                  << " keep-alive and pipelining did not apply" << std::endl;
+    }
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    int option;
+    while ((option = getopt(argc, argv, "t:c:d:p:r:Cm:")) != -1) {
+        switch (option) {
+            case 't': options.threads = std::atoi(optarg); break;
+            case 'c': options.connections = std::atoi(optarg); break;
+            case 'd': options.duration = std::atof(optarg); break;
+            case 'p': options.depth = std::atoi(optarg); break;
+            case 'r': options.rate = std::atof(optarg); break;
+            case 'C': options.isKeepAlive = false; break;
+            case 'm': options.mixFile = optarg; break;
+            default: usage(); return 1;
+        }
+    }
+    if (optind != argc - 1 || !parseUrl(argv[optind], &options)
+            || options.threads <= 0 || options.connections <= 0
+            || options.duration <= 0 || options.depth <= 0
+            || options.rate < 0) {
+        usage();
+        return 1;
+    }
+    options.threads = std::min(options.threads, options.connections);
+    if (!options.isKeepAlive) {
+        options.depth = 1;
+    }
+    std::vector<MixEntry> mix;
+    Target target;
+    if (!loadMix(options, &mix) || !resolve(options, &target)) {
+        return 1;
+    }
+
+    std::cout << "webserv-bench " << argv[optind] << ": "
+              << options.threads << " threads, " << options.connections
+              << " connections, pipeline depth " << options.depth << ", "
+              << (options.isKeepAlive ? "keep-alive" : "connection: close")
+              << ", ";
+    if (options.rate > 0) {
+        std::cout << "open loop at " << options.rate << " requests/s";
+    } else {
+        std::cout << "closed loop";
+    }
+    std::cout << ", " << options.duration << "s";
+    if (!options.mixFile.empty()) {
+        std::cout << ", mix " << options.mixFile << " (" << mix.size()
+                  << " requests)";
+    }
+    std::cout << std::endl;
+
+    std::vector<Worker*> workers;
+    std::vector<pthread_t> threads(options.threads);
+    double startedAt = now();
+    for (int i = 0; i < options.threads; ++i) {
+        int connections = options.connections / options.threads
+            + (i < options.connections % options.threads ? 1 : 0);
+        double rate = options.rate * connections / options.connections;
+        workers.push_back(new Worker(options, target, mix, connections, rate,
+                                     static_cast<unsigned>(i + 1) * 2654435761U));
+        if (pthread_create(&threads[i], NULL, Worker::start, workers[i]) != 0) {
+            std::cerr << "pthread_create failed" << std::endl;
+            return 1;
+        }
+    }
+    Stats total;
+    for (int i = 0; i < options.threads; ++i) {
+        pthread_join(threads[i], NULL);
+        total.merge(workers[i]->getStats());
+        delete workers[i];
+    }
+    report(options, total, now() - startedAt);
+    return 0;
+}
@@ -0,0 +1,4 @@
+#!/usr/bin/env python3
+
+print("Location: /document.py")
+print("")
\ No newline at end of file
@@ -0,0 +1,174 @@
+#!/usr/bin/env python3
+"""Persistent worker for the cgi_pool directive.
+
+Usage (started by webserv, never by hand):
+    cgi_path cgi_runner.py
+
+The server hands the worker one end of a socket pair as stdin and speaks
+FastCGI over it, one request at a time. Each request runs an ordinary CGI
+script in this process: the environment comes from FCGI_PARAMS, the body
+from FCGI_STDIN, and whatever the script prints goes back as FCGI_STDOUT.
+Modules the script imports stay loaded for the next request, which is what
+makes the pool faster than forking an interpreter per request.
+
+A script that raises is reported on FCGI_STDERR and the request ends with
+a nonzero application status; the server then retires the worker, which
+exits, and replaces it with a clean one.
+"""
+
+import io
+import os
+import runpy
+import socket
+import struct
+import sys
+import traceback
+
+BEGIN_REQUEST, ABORT_REQUEST, END_REQUEST, PARAMS, STDIN, STDOUT, STDERR = 1, 2, 3, 4, 5, 6, 7
+GET_VALUES, GET_VALUES_RESULT, UNKNOWN_TYPE = 9, 10, 11
+HEADER = struct.Struct("!BBHHBx")
+
+
+def record(rtype, rid, content=b""):
+    out = b""
+    for i in range(0, max(len(content), 1), 65535):
+        chunk = content[i:i + 65535]
+        pad = (8 - len(chunk) % 8) % 8
+        out += HEADER.pack(1, rtype, rid, len(chunk), pad) + chunk + b"\0" * pad
+    return out
+
+
+def decode_pairs(data):
+    pairs, pos = {}, 0
+
+    def length():
+        nonlocal pos
+        if data[pos] < 128:
+            pos += 1
+            return data[pos - 1]
+        pos += 4
+        return struct.unpack("!I", data[pos - 4:pos])[0] & 0x7fffffff
+
+    while pos < len(data):
+        nlen, vlen = length(), length()
+        name = data[pos:pos + nlen].decode("latin-1")
+        pairs[name] = data[pos + nlen:pos + nlen + vlen].decode("latin-1")
+        pos += nlen + vlen
+    return pairs
+
+
+def encode_pairs(pairs):
+    out = b""
+    for name, value in pairs.items():
+        for item in (name, value):
+            out += bytes([len(item)]) if len(item) < 128 else struct.pack("!I", len(item) | 0x80000000)
+        out += name.encode() + value.encode()
+    return out
+
+
+class RecordReader:
+    def __init__(self, sock):
+        self.sock, self.buf = sock, b""
+
+    def read(self, size):
+        while len(self.buf) < size:
+            data = self.sock.recv(65536)
+            if not data:
+                sys.exit(0)
+            self.buf += data
+        out, self.buf = self.buf[:size], self.buf[size:]
+        return out
+
+    def next(self):
+        _, rtype, rid, length, pad = HEADER.unpack(self.read(HEADER.size))
+        content = self.read(length)
+        self.read(pad)
+        return rtype, rid, content
+
+
+class StdoutWriter(io.RawIOBase):
+    def __init__(self, sock, rid):
+        self.sock, self.rid = sock, rid
+
+    def writable(self):
+        return True
+
+    def write(self, data):
+        if data:
+            self.sock.sendall(record(STDOUT, self.rid, bytes(data)))
+        return len(data)
+
+
+def read_request(reader, sock):
+    """Return (id, params, body) of the next request."""
+    rid, params, body = None, b"", b""
+    params_done = stdin_done = False
+    while not (rid is not None and params_done and stdin_done):
+        rtype, record_id, content = reader.next()
+        if rtype == GET_VALUES:
+            wanted = decode_pairs(content)
+            values = {"FCGI_MPXS_CONNS": "0", "FCGI_MAX_REQS": "1", "FCGI_MAX_CONNS": "1"}
+            reply = {name: values[name] for name in wanted if name in values}
+            sock.sendall(record(GET_VALUES_RESULT, 0, encode_pairs(reply)))
+        elif record_id == 0:
+            sock.sendall(record(UNKNOWN_TYPE, 0, bytes([rtype]) + b"\0" * 7))
+        elif rtype == BEGIN_REQUEST:
+            rid, params, body = record_id, b"", b""
+            params_done = stdin_done = False
+        elif rid != record_id:
+            continue
+        elif rtype == ABORT_REQUEST:
+            rid = None
+        elif rtype == PARAMS:
+            params_done = not content
+            params += content
+        elif rtype == STDIN:
+            stdin_done = not content
+            body += content
+    return rid, decode_pairs(params), body
+
+
+def run_script(sock, rid, params, body, base_dir):
+    """Run one script; return its exit status."""
+    script = os.path.join(base_dir, params.get("SCRIPT_FILENAME", ""))
+    os.environ.clear()
+    os.environ.update(params)
+    os.chdir(os.path.dirname(script) or base_dir)
+    sys.argv = [script]
+    sys.stdin = io.TextIOWrapper(io.BytesIO(body), encoding="utf-8", errors="surrogateescape")
+    sys.stdout = io.TextIOWrapper(io.BufferedWriter(StdoutWriter(sock, rid)),
+                                  encoding="utf-8", errors="surrogateescape", newline="")
+    status = 0
+    try:
+        runpy.run_path(script, run_name="__main__")
+    except SystemExit as e:
+        if e.code not in (None, 0):
+            status = e.code if isinstance(e.code, int) else 1
+    except BaseException:
+        sock.sendall(record(STDERR, rid, traceback.format_exc().encode()))
+        status = 1
+    finally:
+        try:
+            sys.stdout.flush()
+        except OSError:
+            pass
+        sys.stdout, sys.stdin = sys.__stdout__, sys.__stdin__
+    return status
+
+
+def main():
+    sock = socket.socket(fileno=os.dup(0))
+    sock.setblocking(True)
+    reader = RecordReader(sock)
+    base_dir = os.getcwd()
+    while True:
+        rid, params, body = read_request(reader, sock)
+        status = run_script(sock, rid, params, body, base_dir)
+        sock.sendall(record(STDOUT, rid) + record(END_REQUEST, rid, struct.pack("!IB3x", status & 0xffffffff, 0)))
+        os.chdir(base_dir)
+        if status != 0:
+            return status
+
+
+if __name__ == "__main__":
+    sys.exit(main())
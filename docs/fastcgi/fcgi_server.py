@@ -0,0 +1,206 @@
+#!/usr/bin/env python3
+"""Minimal FastCGI responder used to exercise fastcgi_pass.
+
+Usage:
+    fcgi_server.py unix:/tmp/webserv-fcgi.sock
+    fcgi_server.py 127.0.0.1:9000 [--no-mpx]
+
+Each request is answered with a plain-text summary of what was received.
+A "sleep=N" query parameter delays the answer by N seconds without blocking
+other requests, which makes multiplexing and connection reuse observable.
+With --no-mpx the server behaves like php-fpm: one request per connection
+at a time, and the connection is closed after FCGI_GET_VALUES.
+"""
+
+import heapq
+import os
+import selectors
+import socket
+import struct
+import sys
+import time
+from urllib.parse import parse_qs
+
+BEGIN_REQUEST, ABORT_REQUEST, END_REQUEST, PARAMS, STDIN, STDOUT = 1, 2, 3, 4, 5, 6
+GET_VALUES, GET_VALUES_RESULT, UNKNOWN_TYPE = 9, 10, 11
+HEADER = struct.Struct("!BBHHBx")
+
+
+def record(rtype, rid, content=b""):
+    out = b""
+    for i in range(0, max(len(content), 1), 65535):
+        chunk = content[i:i + 65535]
+        pad = (8 - len(chunk) % 8) % 8
+        out += HEADER.pack(1, rtype, rid, len(chunk), pad) + chunk + b"\0" * pad
+    return out
+
+
+def decode_pairs(data):
+    pairs, pos = {}, 0
+
+    def length():
+        nonlocal pos
+        if data[pos] < 128:
+            pos += 1
+            return data[pos - 1]
+        pos += 4
+        return struct.unpack("!I", data[pos - 4:pos])[0] & 0x7fffffff
+
+    while pos < len(data):
+        nlen, vlen = length(), length()
+        name = data[pos:pos + nlen].decode("latin-1")
+        pairs[name] = data[pos + nlen:pos + nlen + vlen].decode("latin-1")
+        pos += nlen + vlen
+    return pairs
+
+
+def encode_pairs(pairs):
+    out = b""
+    for name, value in pairs.items():
+        for item in (name, value):
+            out += bytes([len(item)]) if len(item) < 128 else struct.pack("!I", len(item) | 0x80000000)
+        out += name.encode() + value.encode()
+    return out
+
+
+class Connection:
+    counter = 0
+
+    def __init__(self, server, sock):
+        Connection.counter += 1
+        self.id = Connection.counter
+        self.server, self.sock = server, sock
+        self.inbuf, self.outbuf = b"", b""
+        self.requests = {}
+        self.close_after_flush = False
+
+    def on_readable(self):
+        data = self.sock.recv(65536)
+        if not data:
+            self.close()
+            return
+        self.inbuf += data
+        while len(self.inbuf) >= 8:
+            _, rtype, rid, clen, plen = HEADER.unpack(self.inbuf[:8])
+            if len(self.inbuf) < 8 + clen + plen:
+                break
+            content = self.inbuf[8:8 + clen]
+            self.inbuf = self.inbuf[8 + clen + plen:]
+            self.on_record(rtype, rid, content)
+
+    def on_record(self, rtype, rid, content):
+        if rtype == GET_VALUES:
+            mpx = "0" if self.server.no_mpx else "1"
+            reply = {"FCGI_MPXS_CONNS": mpx, "FCGI_MAX_REQS": "64"}
+            names = decode_pairs(content)
+            self.send(record(GET_VALUES_RESULT, 0,
+                             encode_pairs({k: v for k, v in reply.items() if k in names})))
+            self.close_after_flush = self.server.no_mpx
+        elif rtype == BEGIN_REQUEST:
+            self.requests[rid] = {"params": b"", "stdin": b""}
+        elif rtype == PARAMS and rid in self.requests:
+            self.requests[rid]["params"] += content
+        elif rtype == STDIN and rid in self.requests:
+            if content:
+                self.requests[rid]["stdin"] += content
+            else:
+                self.schedule(rid)
+        elif rtype == ABORT_REQUEST and rid in self.requests:
+            self.finish(rid, b"")
+        elif rtype not in (PARAMS, STDIN, ABORT_REQUEST):
+            self.send(record(UNKNOWN_TYPE, 0, bytes([rtype]) + b"\0" * 7))
+
+    def schedule(self, rid):
+        params = decode_pairs(self.requests[rid]["params"])
+        query = parse_qs(params.get("QUERY_STRING", ""))
+        delay = float(query.get("sleep", ["0"])[0])
+        body = "".join("%s=%s\n" % item for item in sorted({
+            "script": params.get("SCRIPT_FILENAME", ""),
+            "uri": params.get("REQUEST_URI", ""),
+            "method": params.get("REQUEST_METHOD", ""),
+            "body_length": str(len(self.requests[rid]["stdin"])),
+            "connection": str(self.id),
+            "request_id": str(rid),
+        }.items()))
+        size = int(query.get("size", ["0"])[0])
+        output = ("Content-Type: text/plain\r\n\r\n" + body).encode() + b"x" * size
+        self.server.later(delay, self, rid, output)
+
+    def finish(self, rid, output):
+        if rid not in self.requests:
+            return
+        del self.requests[rid]
+        if output:
+            self.send(record(STDOUT, rid, output))
+        self.send(record(STDOUT, rid) + record(END_REQUEST, rid, b"\0" * 8))
+
+    def send(self, data):
+        self.outbuf += data
+        self.server.update(self)
+
+    def on_writable(self):
+        sent = self.sock.send(self.outbuf)
+        self.outbuf = self.outbuf[sent:]
+        if not self.outbuf and self.close_after_flush:
+            self.close()
+        else:
+            self.server.update(self)
+
+    def close(self):
+        self.server.forget(self)
+        self.sock.close()
+
+
+class Server:
+    def __init__(self, address, no_mpx):
+        self.no_mpx = no_mpx
+        self.selector = selectors.DefaultSelector()
+        self.timers = []
+        if address.startswith("unix:"):
+            path = address[5:]
+            if os.path.exists(path):
+                os.unlink(path)
+            self.listener = socket.socket(socket.AF_UNIX)
+            self.listener.bind(path)
+        else:
+            host, port = address.rsplit(":", 1)
+            self.listener = socket.socket()
+            self.listener.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+            self.listener.bind((host, int(port)))
+        self.listener.listen(128)
+        self.selector.register(self.listener, selectors.EVENT_READ, None)
+
+    def later(self, delay, conn, rid, output):
+        heapq.heappush(self.timers, (time.time() + delay, id(conn), rid, conn, output))
+
+    def update(self, conn):
+        events = selectors.EVENT_READ | (selectors.EVENT_WRITE if conn.outbuf else 0)
+        self.selector.modify(conn.sock, events, conn)
+
+    def forget(self, conn):
+        self.selector.unregister(conn.sock)
+        self.timers = [t for t in self.timers if t[3] is not conn]
+        heapq.heapify(self.timers)
+
+    def run(self):
+        while True:
+            timeout = max(0, self.timers[0][0] - time.time()) if self.timers else None
+            for key, mask in self.selector.select(timeout):
+                if key.data is None:
+                    sock, _ = self.listener.accept()
+                    conn = Connection(self, sock)
+                    self.selector.register(sock, selectors.EVENT_READ, conn)
+                    continue
+                if mask & selectors.EVENT_READ:
+                    key.data.on_readable()
+                if mask & selectors.EVENT_WRITE and key.data.sock.fileno() != -1:
+                    key.data.on_writable()
+            while self.timers and self.timers[0][0] <= time.time():
+                _, _, rid, conn, output = heapq.heappop(self.timers)
+                conn.finish(rid, output)
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 2:
+        sys.exit(__doc__)
+    Server(sys.argv[1], "--no-mpx" in sys.argv[2:]).run()
@@ -1,6 +1,7 @@
 // Copyright 2025 Ideal Broccoli
 
 #include <string>
+#include <vector>
 
 #include "config.hpp"
 #include "config_http.hpp"
@@ -9,11 +10,12 @@
 
 #include "../../toolbox/shared.hpp"
 #include "../../toolbox/stepmark.hpp"
+#include "../../toolbox/string.hpp"
 
 namespace config {
 
 Config::Config() :
-_tokenCount(0) {
+_generation(0) {
 }
 
 Config::~Config() {
@@ -35,17 +37,37 @@ Config& Config::getInstance() {
  * @throws ConfigException If the configuration file cannot be parsed successfully
  */
 void Config::loadConfig(const std::string& configFile) {
-    Config& instance = getInstance();
+    installConfig(parseConfig(configFile));
+    getInstance()._configFile = configFile;
+}
+
+// - Leaves the running configuration untouched, so a reload that fails
+//   here keeps serving with it.
+toolbox::SharedPtr<HttpConfig> Config::parseConfig(
+        const std::string& configFile) {
     ConfigParser parser;
     toolbox::SharedPtr<HttpConfig> httpConfig = parser.parseFile(configFile);
-    if (!httpConfig) {
+    if (!httpConfig || parser.getTokenCount() == 0) {
         throwConfigError("Failed to parse configuration file: " + configFile);
     }
-    instance._tokenCount = parser.getTokenCount();
-    if (instance._tokenCount > 0) {
-        instance._httpConfig = httpConfig;
+    const std::vector<toolbox::SharedPtr<ServerConfig> >& servers =
+        httpConfig->getServers();
+    for (std::size_t i = 0; i < servers.size(); ++i) {
+        servers[i]->compileLocations();
     }
-    toolbox::logger::StepMark::info("Configuration loaded successfully");
+    return httpConfig;
+}
+
+// - Connections accepted earlier hold the server name table of the
+//   configuration they came in under, which keeps it alive for them.
+void Config::installConfig(const toolbox::SharedPtr<HttpConfig>& httpConfig) {
+    Config& instance = getInstance();
+    instance._httpConfig = httpConfig;
+    instance._virtualHosts = toolbox::SharedPtr<VirtualHosts>(
+        new VirtualHosts(*httpConfig));
+    ++instance._generation;
+    toolbox::logger::StepMark::info("Configuration "
+        + toolbox::to_string(instance._generation) + " loaded successfully");
 }
 
 ConfigException::ConfigException(const std::string& message):
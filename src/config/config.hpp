@@ -11,6 +11,7 @@
 #include "config_http.hpp"
 #include "config_server.hpp"
 #include "config_location.hpp"
+#include "config_vhost.hpp"
 
 
 #include "../../toolbox/shared.hpp"
@@ -28,6 +29,8 @@ namespace config {
  * - Singleton pattern ensures only one configuration instance exists
  * - Loading and parsing of configuration files
  * - Global access to HTTP configuration
+ * - Replacing it at run time: each installed configuration is a new
+ *   generation, and the previous one lives on while requests use it
  *
  * Usage example:
  * @code
@@ -39,10 +42,17 @@ namespace config {
  *   
  *   // Or access directly using static method
  *   const toolbox::SharedPtr<config::HttpConfig>& httpConfig = config::Config::getHttpConfig();
+ *
+ *   // Server selection table, compiled from the same configuration
+ *   const toolbox::SharedPtr<config::VirtualHosts>& virtualHosts = config::Config::getVirtualHosts();
  *   
  *   // Use configuration values
  *   std::string root = httpConfig->getRoot();
- *   
+ *
+ *   // Reload: parse first, install only if that succeeded
+ *   toolbox::SharedPtr<config::HttpConfig> next =
+ *       config::Config::parseConfig(config::Config::getConfigFile());
+ *   config::Config::installConfig(next);
  * @endcode
  *
  * @note In C++98 environments, thread safety is not guaranteed. For multi-threaded
@@ -51,17 +61,31 @@ namespace config {
 class Config {
  public:
     static void loadConfig(const std::string& configFile);
+
+    /**
+     * @brief Parses and compiles a configuration without installing it.
+     * @throws ConfigException If the file is not a valid configuration.
+     */
+    static toolbox::SharedPtr<HttpConfig> parseConfig(
+        const std::string& configFile);
+
+    /**
+     * @brief Makes a parsed configuration the current one for new
+     * connections.
+     */
+    static void installConfig(const toolbox::SharedPtr<HttpConfig>& httpConfig);
+
     static Config& getConfig() { return getInstance(); }
     static const toolbox::SharedPtr<config::HttpConfig>&
                     getHttpConfig() { return getInstance()._httpConfig; }
-    static std::size_t getTokenCount() { return getInstance()._tokenCount; }
+    static const toolbox::SharedPtr<config::VirtualHosts>&
+                    getVirtualHosts() { return getInstance()._virtualHosts; }
+    static const std::string& getConfigFile() { return getInstance()._configFile; }
+    static std::size_t getGeneration() { return getInstance()._generation; }
     static void setHttpConfig
     (const toolbox::SharedPtr<config::HttpConfig>& httpConfig) {
         getInstance()._httpConfig = httpConfig;
     }
-    static void setTokenCount(const std::size_t tokenCount) {
-        getInstance()._tokenCount = tokenCount;
-    }
 
  private:
     Config();
@@ -70,7 +94,9 @@ class Config {
     Config& operator=(const Config& other);
 
     toolbox::SharedPtr<config::HttpConfig> _httpConfig;
-    std::size_t _tokenCount;
+    toolbox::SharedPtr<config::VirtualHosts> _virtualHosts;
+    std::string _configFile;
+    std::size_t _generation;
 
     static Config& getInstance();
 };
@@ -5,6 +5,20 @@
 
 #include "config_base.hpp"
 
+#include "../../toolbox/log_format.hpp"
+
+namespace {
+// - Compiled once; every unset AccessLog starts from a copy.
+const toolbox::logger::LogFormat& getMainFormat() {
+    static toolbox::logger::LogFormat format;
+    if (format.getText().empty()) {
+        std::string unknown;
+        format.compile(config::MAIN_LOG_FORMAT, &unknown);
+    }
+    return format;
+}
+}  // namespace
+
 namespace config {
 
 ErrorPage::ErrorPage() :
@@ -101,11 +115,128 @@ Return& Return::operator=(const Return& other) {
 Return::~Return() {
 }
 
+FastcgiPass::FastcgiPass() :
+_address(),
+_unixPath(),
+_host(),
+_port(0) {
+}
+
+FastcgiPass::FastcgiPass(const FastcgiPass& other) :
+_address(other._address),
+_unixPath(other._unixPath),
+_host(other._host),
+_port(other._port) {
+}
+
+FastcgiPass& FastcgiPass::operator=(const FastcgiPass& other) {
+    if (this != &other) {
+        _address = other._address;
+        _unixPath = other._unixPath;
+        _host = other._host;
+        _port = other._port;
+    }
+    return *this;
+}
+
+FastcgiPass::~FastcgiPass() {
+}
+
+CgiPool::CgiPool() :
+_runner(),
+_workers(DEFAULT_CGI_POOL_WORKERS),
+_maxRequests(DEFAULT_CGI_POOL_MAX_REQUESTS),
+_idleTimeout(DEFAULT_CGI_POOL_IDLE_TIMEOUT) {
+}
+
+CgiPool::CgiPool(const CgiPool& other) :
+_runner(other._runner),
+_workers(other._workers),
+_maxRequests(other._maxRequests),
+_idleTimeout(other._idleTimeout) {
+}
+
+CgiPool& CgiPool::operator=(const CgiPool& other) {
+    if (this != &other) {
+        _runner = other._runner;
+        _workers = other._workers;
+        _maxRequests = other._maxRequests;
+        _idleTimeout = other._idleTimeout;
+    }
+    return *this;
+}
+
+CgiPool::~CgiPool() {
+}
+
+CgiCache::CgiCache() :
+_ttl(0),
+_maxSize(DEFAULT_CGI_CACHE_SIZE),
+_key(DEFAULT_CGI_CACHE_KEY) {
+}
+
+CgiCache::CgiCache(const CgiCache& other) :
+_ttl(other._ttl),
+_maxSize(other._maxSize),
+_key(other._key) {
+}
+
+CgiCache& CgiCache::operator=(const CgiCache& other) {
+    if (this != &other) {
+        _ttl = other._ttl;
+        _maxSize = other._maxSize;
+        _key = other._key;
+    }
+    return *this;
+}
+
+CgiCache::~CgiCache() {
+}
+
+AccessLog::AccessLog() :
+_isSet(false),
+_isOff(false),
+_path(DEFAULT_ACCESS_LOG),
+_format(getMainFormat()),
+_bufferSize(0),
+_flushInterval(DEFAULT_LOG_BUFFER_FLUSH) {
+}
+
+AccessLog::AccessLog(const AccessLog& other) :
+_isSet(other._isSet),
+_isOff(other._isOff),
+_path(other._path),
+_format(other._format),
+_bufferSize(other._bufferSize),
+_flushInterval(other._flushInterval) {
+}
+
+AccessLog& AccessLog::operator=(const AccessLog& other) {
+    if (this != &other) {
+        _isSet = other._isSet;
+        _isOff = other._isOff;
+        _path = other._path;
+        _format = other._format;
+        _bufferSize = other._bufferSize;
+        _flushInterval = other._flushInterval;
+    }
+    return *this;
+}
+
+AccessLog::~AccessLog() {
+}
+
 ConfigBase::ConfigBase() :
+_accessLog(),
 _allowedMethods(),
 _autoindex(DEFAULT_AUTOINDEX),
 _cgiExtensions(),
 _cgiPath(),
+_cgiPool(),
+_cgiCache(),
+_cgiMaxConcurrency(DEFAULT_CGI_MAX_CONCURRENCY),
+_cgiQueueSize(DEFAULT_CGI_QUEUE_SIZE),
+_cgiQueueTimeout(DEFAULT_CGI_QUEUE_TIMEOUT),
 _clientMaxBodySize(DEFAULT_CLIENT_MAX_BODY_SIZE),
 _errorPages(),
 _indices(),
@@ -114,10 +245,16 @@ _uploadStore(DEFAULT_UPLOAD_STORE) {
 }
 
 ConfigBase::ConfigBase(const ConfigBase& other) :
+_accessLog(other._accessLog),
 _allowedMethods(other._allowedMethods),
 _autoindex(other._autoindex),
 _cgiExtensions(other._cgiExtensions),
 _cgiPath(other._cgiPath),
+_cgiPool(other._cgiPool),
+_cgiCache(other._cgiCache),
+_cgiMaxConcurrency(other._cgiMaxConcurrency),
+_cgiQueueSize(other._cgiQueueSize),
+_cgiQueueTimeout(other._cgiQueueTimeout),
 _clientMaxBodySize(other._clientMaxBodySize),
 _errorPages(other._errorPages),
 _indices(other._indices),
@@ -127,10 +264,16 @@ _uploadStore(other._uploadStore) {
 
 ConfigBase& ConfigBase::operator=(const ConfigBase& other) {
     if (this != &other) {
+        _accessLog = other._accessLog;
         _allowedMethods = other._allowedMethods;
         _autoindex = other._autoindex;
         _cgiExtensions = other._cgiExtensions;
         _cgiPath = other._cgiPath;
+        _cgiPool = other._cgiPool;
+        _cgiCache = other._cgiCache;
+        _cgiMaxConcurrency = other._cgiMaxConcurrency;
+        _cgiQueueSize = other._cgiQueueSize;
+        _cgiQueueTimeout = other._cgiQueueTimeout;
         _clientMaxBodySize = other._clientMaxBodySize;
         _errorPages = other._errorPages;
         _indices = other._indices;
@@ -8,6 +8,8 @@
 
 #include "config_namespace.hpp"
 
+#include "../../toolbox/log_format.hpp"
+
 namespace config {
 /**
  * @class ErrorPage
@@ -114,6 +116,9 @@ class Listen {
  * wildcard.setName("example.com");
  * wildcard.setType(ServerName::WILDCARD_START);
  * // This represents *.example.com
+ *
+ * // Names are kept as written: "*.example.com" is WILDCARD_START,
+ * // "www.example.*" is WILDCARD_END
  * @endcode
  */
 class ServerName {
@@ -183,6 +188,185 @@ class Return {
     bool _hasReturnValue;
 };
 
+/**
+ * @class FastcgiPass
+ * @brief Class for managing the address of a FastCGI application server
+ *
+ * Holds either a UNIX-domain socket path or a host and port. The address as
+ * written in the configuration identifies the connection pool it uses.
+ *
+ * Usage example:
+ * @code
+ * FastcgiPass pass;
+ * pass.setAddress("unix:/run/php-fpm.sock");
+ * pass.setUnixPath("/run/php-fpm.sock");
+ *
+ * // Accessing the configured settings
+ * bool isSet = pass.isSet();                    // Returns true
+ * bool isUnix = pass.isUnixSocket();            // Returns true
+ * const std::string& path = pass.getUnixPath(); // Returns "/run/php-fpm.sock"
+ * @endcode
+ */
+class FastcgiPass {
+ public:
+    FastcgiPass();
+    FastcgiPass(const FastcgiPass&);
+    FastcgiPass& operator=(const FastcgiPass&);
+    ~FastcgiPass();
+
+    bool isSet() const { return !_address.empty(); }
+    bool isUnixSocket() const { return !_unixPath.empty(); }
+    const std::string& getAddress() const { return _address; }
+    const std::string& getUnixPath() const { return _unixPath; }
+    const std::string& getHost() const { return _host; }
+    std::size_t getPort() const { return _port; }
+    void setAddress(const std::string& address) { _address = address; }
+    void setUnixPath(const std::string& path) { _unixPath = path; }
+    void setHost(const std::string& host) { _host = host; }
+    void setPort(std::size_t port) { _port = port; }
+
+ private:
+    std::string _address;
+    std::string _unixPath;
+    std::string _host;
+    std::size_t _port;
+};
+
+/**
+ * @class CgiPool
+ * @brief Class for managing a pool of persistent CGI workers
+ *
+ * Workers run the runner script with the location's cgi_path interpreter
+ * and execute CGI scripts in-process, one request at a time. A worker is
+ * replaced after max_requests requests and stopped after idle_timeout
+ * seconds without one.
+ *
+ * Usage example:
+ * @code
+ * CgiPool pool;
+ * pool.setRunner("/usr/local/lib/webserv/cgi_runner.py");
+ * pool.setWorkers(8);
+ *
+ * // Accessing the configured settings
+ * bool isSet = pool.isSet();                        // Returns true
+ * std::size_t workers = pool.getWorkers();          // Returns 8
+ * std::size_t maxRequests = pool.getMaxRequests();  // Returns default value
+ * @endcode
+ */
+class CgiPool {
+ public:
+    CgiPool();
+    CgiPool(const CgiPool&);
+    CgiPool& operator=(const CgiPool&);
+    ~CgiPool();
+
+    bool isSet() const { return !_runner.empty(); }
+    const std::string& getRunner() const { return _runner; }
+    std::size_t getWorkers() const { return _workers; }
+    std::size_t getMaxRequests() const { return _maxRequests; }
+    std::size_t getIdleTimeout() const { return _idleTimeout; }
+    void setRunner(const std::string& runner) { _runner = runner; }
+    void setWorkers(std::size_t workers) { _workers = workers; }
+    void setMaxRequests(std::size_t maxRequests) { _maxRequests = maxRequests; }
+    void setIdleTimeout(std::size_t idleTimeout) { _idleTimeout = idleTimeout; }
+
+ private:
+    std::string _runner;
+    std::size_t _workers;
+    std::size_t _maxRequests;
+    std::size_t _idleTimeout;
+};
+
+/**
+ * @class CgiCache
+ * @brief Class for managing the cache of CGI responses of a location
+ *
+ * Successful CGI responses to GET and HEAD are kept for ttl seconds, or
+ * as long as their Cache-Control or Expires allows. The key template
+ * chooses which parts of the request tell responses apart, and size
+ * bounds the bytes kept for the location.
+ *
+ * Usage example:
+ * @code
+ * CgiCache cache;
+ * cache.setTtl(5);
+ * cache.setKey("$method:$host$path$query$http_accept_language");
+ *
+ * // Accessing the configured settings
+ * bool isSet = cache.isSet();                 // Returns true
+ * std::size_t ttl = cache.getTtl();           // Returns 5
+ * std::size_t maxSize = cache.getMaxSize();   // Returns default value
+ * @endcode
+ */
+class CgiCache {
+ public:
+    CgiCache();
+    CgiCache(const CgiCache&);
+    CgiCache& operator=(const CgiCache&);
+    ~CgiCache();
+
+    bool isSet() const { return _ttl > 0; }
+    std::size_t getTtl() const { return _ttl; }
+    std::size_t getMaxSize() const { return _maxSize; }
+    const std::string& getKey() const { return _key; }
+    void setTtl(std::size_t ttl) { _ttl = ttl; }
+    void setMaxSize(std::size_t maxSize) { _maxSize = maxSize; }
+    void setKey(const std::string& key) { _key = key; }
+
+ private:
+    std::size_t _ttl;
+    std::size_t _maxSize;
+    std::string _key;
+};
+
+/**
+ * @class AccessLog
+ * @brief Class for managing where and how requests are logged
+ *
+ * Holds the file and the compiled log_format of the access log, or off.
+ * Without buffer= the file is buffered as log_buffer says; with buffer=
+ * or flush= it gets its own buffer, the missing one taking its default.
+ * An unset AccessLog logs to access.log in the main format.
+ *
+ * Usage example:
+ * @code
+ * AccessLog accessLog;
+ * accessLog.setPath("logs/api.log");
+ * accessLog.setFormat(format);
+ *
+ * // Accessing the configured settings
+ * bool isSet = accessLog.isSet();                    // Returns true
+ * std::size_t size = accessLog.getBufferSize();      // Returns 0: log_buffer's
+ * @endcode
+ */
+class AccessLog {
+ public:
+    AccessLog();
+    AccessLog(const AccessLog&);
+    AccessLog& operator=(const AccessLog&);
+    ~AccessLog();
+
+    bool isSet() const { return _isSet; }
+    bool isOff() const { return _isOff; }
+    const std::string& getPath() const { return _path; }
+    const toolbox::logger::LogFormat& getFormat() const { return _format; }
+    std::size_t getBufferSize() const { return _bufferSize; }
+    std::size_t getFlushInterval() const { return _flushInterval; }
+    void setOff() { _isSet = true; _isOff = true; }
+    void setPath(const std::string& path) { _isSet = true; _path = path; }
+    void setFormat(const toolbox::logger::LogFormat& format) { _format = format; }
+    void setBufferSize(std::size_t size) { _bufferSize = size; }
+    void setFlushInterval(std::size_t seconds) { _flushInterval = seconds; }
+
+ private:
+    bool _isSet;
+    bool _isOff;
+    std::string _path;
+    toolbox::logger::LogFormat _format;
+    std::size_t _bufferSize;     // 0: as log_buffer says
+    std::size_t _flushInterval;  // seconds, with _bufferSize only
+};
+
 /**
  * @class ConfigBase
  * @brief Base class for web server configuration
@@ -191,9 +375,12 @@ class Return {
  * Serves as a common foundation for HTTP, server, and location configuration classes.
  *
  * Key configuration items:
+ * - Access log
  * - Allowed HTTP methods
  * - Directory listing (autoindex)
  * - CGI extensions and execution path
+ * - CGI worker pool
+ * - CGI response cache
  * - Maximum client body size
  * - Error page mappings
  * - Index files
@@ -225,22 +412,34 @@ class ConfigBase {
     ConfigBase& operator=(const ConfigBase&);
     virtual ~ConfigBase();
 
+    const AccessLog& getAccessLog() const { return _accessLog; }
     const std::vector<std::string>& getAllowedMethods() const { return _allowedMethods; }
     bool getAutoindex() const { return _autoindex; }
     const std::vector<std::string>& getCgiExtensions() const { return _cgiExtensions; }
     const std::string& getCgiPath() const { return _cgiPath; }
+    const CgiPool& getCgiPool() const { return _cgiPool; }
+    const CgiCache& getCgiCache() const { return _cgiCache; }
+    std::size_t getCgiMaxConcurrency() const { return _cgiMaxConcurrency; }
+    std::size_t getCgiQueueSize() const { return _cgiQueueSize; }
+    std::size_t getCgiQueueTimeout() const { return _cgiQueueTimeout; }
     std::size_t getClientMaxBodySize() const { return _clientMaxBodySize; }
     const std::vector<ErrorPage>& getErrorPages() const { return _errorPages; }
     const std::vector<std::string>& getIndices() const { return _indices; }
     const std::string& getRoot() const { return _root; }
     const std::string& getUploadStore() const { return _uploadStore; }
 
+    void setAccessLog(const AccessLog& accessLog) { _accessLog = accessLog; }
     void setAllowedMethods(const std::vector<std::string>& methods) { _allowedMethods = methods; }
     void addAllowedMethod(const std::string& method) { _allowedMethods.push_back(method); }
     void setAutoindex(bool value) { _autoindex = value; }
     void setCgiExtensions(const std::vector<std::string>& extensions) { _cgiExtensions = extensions; }
     void addCgiExtension(const std::string& extension) { _cgiExtensions.push_back(extension); }
     void setCgiPath(const std::string& path) { _cgiPath = path; }
+    void setCgiPool(const CgiPool& pool) { _cgiPool = pool; }
+    void setCgiCache(const CgiCache& cache) { _cgiCache = cache; }
+    void setCgiMaxConcurrency(std::size_t count) { _cgiMaxConcurrency = count; }
+    void setCgiQueueSize(std::size_t size) { _cgiQueueSize = size; }
+    void setCgiQueueTimeout(std::size_t seconds) { _cgiQueueTimeout = seconds; }
     void setClientMaxBodySize(std::size_t size) { _clientMaxBodySize = size; }
     void setErrorPages(const std::vector<ErrorPage>& pages) { _errorPages = pages; }
     void addErrorPage(const ErrorPage& page) { _errorPages.push_back(page); }
@@ -250,10 +449,16 @@ class ConfigBase {
     void setUploadStore(const std::string& path) { _uploadStore = path; }
 
  private:
+    AccessLog _accessLog;
     std::vector<std::string> _allowedMethods;
     bool _autoindex;
     std::vector<std::string> _cgiExtensions;
     std::string _cgiPath;
+    CgiPool _cgiPool;
+    CgiCache _cgiCache;
+    std::size_t _cgiMaxConcurrency;
+    std::size_t _cgiQueueSize;
+    std::size_t _cgiQueueTimeout;
     std::size_t _clientMaxBodySize;
     std::vector<ErrorPage> _errorPages;
     std::vector<std::string> _indices;
@@ -14,6 +14,7 @@ namespace config {
 
 DirectiveParser::DirectiveParser() {
     initDirectiveInfo();
+    initLogFormats();
 }
 
 DirectiveParser::~DirectiveParser() {
@@ -69,6 +70,57 @@ void DirectiveParser::initDirectiveInfo() {
     info.directive = config::directive::RETURN;
     info.context = CONTEXT_SERVER_LOCATION;
     _directiveInfo[config::directive::RETURN] = info;
+
+    info.directive = config::directive::CGI_POOL;
+    info.context = CONTEXT_ALL;
+    _directiveInfo[config::directive::CGI_POOL] = info;
+
+    info.directive = config::directive::CGI_CACHE;
+    info.context = CONTEXT_ALL;
+    _directiveInfo[config::directive::CGI_CACHE] = info;
+
+    info.directive = config::directive::CGI_MAX_CONCURRENCY;
+    info.context = CONTEXT_ALL;
+    _directiveInfo[config::directive::CGI_MAX_CONCURRENCY] = info;
+
+    info.directive = config::directive::CGI_QUEUE_SIZE;
+    info.context = CONTEXT_ALL;
+    _directiveInfo[config::directive::CGI_QUEUE_SIZE] = info;
+
+    info.directive = config::directive::CGI_QUEUE_TIMEOUT;
+    info.context = CONTEXT_ALL;
+    _directiveInfo[config::directive::CGI_QUEUE_TIMEOUT] = info;
+
+    info.directive = config::directive::FASTCGI_PASS;
+    info.context = CONTEXT_LOCATION;
+    _directiveInfo[config::directive::FASTCGI_PASS] = info;
+
+    info.directive = config::directive::STUB_STATUS;
+    info.context = CONTEXT_LOCATION;
+    _directiveInfo[config::directive::STUB_STATUS] = info;
+
+    info.directive = config::directive::SHUTDOWN_TIMEOUT;
+    info.context = CONTEXT_HTTP;
+    _directiveInfo[config::directive::SHUTDOWN_TIMEOUT] = info;
+
+    info.directive = config::directive::LOG_BUFFER;
+    info.context = CONTEXT_HTTP;
+    _directiveInfo[config::directive::LOG_BUFFER] = info;
+
+    info.directive = config::directive::LOG_FORMAT;
+    info.context = CONTEXT_HTTP;
+    _directiveInfo[config::directive::LOG_FORMAT] = info;
+
+    info.directive = config::directive::ACCESS_LOG;
+    info.context = CONTEXT_ALL;
+    _directiveInfo[config::directive::ACCESS_LOG] = info;
+}
+
+void DirectiveParser::initLogFormats() {
+    std::string unknown;
+    _logFormats[config::directive::LOG_FORMAT_MAIN].compile(config::MAIN_LOG_FORMAT, &unknown);
+    _logFormats[config::directive::LOG_FORMAT_COMBINED].compile(config::COMBINED_LOG_FORMAT, &unknown);
+    _logFormats[config::directive::LOG_FORMAT_TIMING].compile(config::TIMING_LOG_FORMAT, &unknown);
 }
 
 bool DirectiveParser::parseDirective(const std::vector<std::string>& tokens, std::size_t* pos, const std::string& directive, config::HttpConfig* http, config::ServerConfig* server, config::LocationConfig* location) {
@@ -86,6 +138,14 @@ bool DirectiveParser::parseDirective(const std::vector<std::string>& tokens, std
         return handleUploadStoreDirective(tokens, pos, http, server, location);
     } else if (directive == config::directive::CGI_PATH) {
         return handleCgiPathDirective(tokens, pos, http, server, location);
+    } else if (directive == config::directive::CGI_POOL) {
+        return handleCgiPoolDirective(tokens, pos, http, server, location);
+    } else if (directive == config::directive::CGI_CACHE) {
+        return handleCgiCacheDirective(tokens, pos, http, server, location);
+    } else if (directive == config::directive::CGI_MAX_CONCURRENCY
+            || directive == config::directive::CGI_QUEUE_SIZE
+            || directive == config::directive::CGI_QUEUE_TIMEOUT) {
+        return handleCgiLimitDirective(directive, tokens, pos, http, server, location);
     } else if (directive == config::directive::CGI_EXTENSION) {
         return handleCgiExtensionDirective(tokens, pos, http, server, location);
     } else if (directive == config::directive::RETURN) {
@@ -96,6 +156,18 @@ bool DirectiveParser::parseDirective(const std::vector<std::string>& tokens, std
         return handleListenDirective(tokens, pos, http, server, location);
     } else if (directive == config::directive::SERVER_NAME) {
         return handleServerNameDirective(tokens, pos, http, server, location);
+    } else if (directive == config::directive::FASTCGI_PASS) {
+        return handleFastcgiPassDirective(tokens, pos, http, server, location);
+    } else if (directive == config::directive::STUB_STATUS) {
+        return handleStubStatusDirective(tokens, pos, http, server, location);
+    } else if (directive == config::directive::SHUTDOWN_TIMEOUT) {
+        return handleShutdownTimeoutDirective(tokens, pos, http, server, location);
+    } else if (directive == config::directive::LOG_BUFFER) {
+        return handleLogBufferDirective(tokens, pos, http, server, location);
+    } else if (directive == config::directive::LOG_FORMAT) {
+        return handleLogFormatDirective(tokens, pos, http, server, location);
+    } else if (directive == config::directive::ACCESS_LOG) {
+        return handleAccessLogDirective(tokens, pos, http, server, location);
     }
     return false;
 }
@@ -205,6 +277,76 @@ bool DirectiveParser::handleCgiPathDirective(const std::vector<std::string>& tok
     return result;
 }
 
+bool DirectiveParser::handleCgiPoolDirective(const std::vector<std::string>& tokens, std::size_t* pos, config::HttpConfig* http, config::ServerConfig* server, config::LocationConfig* location) {
+    CgiPool cgiPool;
+    if (http) {
+        cgiPool = http->getCgiPool();
+    } else if (server) {
+        cgiPool = server->getCgiPool();
+    } else if (location) {
+        cgiPool = location->getCgiPool();
+    } else {
+        return false;
+    }
+    bool result = parseCgiPoolDirective(tokens, pos, &cgiPool);
+    if (result) {
+        if (http) {
+            http->setCgiPool(cgiPool);
+        } else if (server) {
+            server->setCgiPool(cgiPool);
+        } else if (location) {
+            location->setCgiPool(cgiPool);
+        }
+    }
+    return result;
+}
+
+bool DirectiveParser::handleCgiCacheDirective(const std::vector<std::string>& tokens, std::size_t* pos, config::HttpConfig* http, config::ServerConfig* server, config::LocationConfig* location) {
+    CgiCache cgiCache;
+    bool result = parseCgiCacheDirective(tokens, pos, &cgiCache);
+    if (result) {
+        if (http) {
+            http->setCgiCache(cgiCache);
+        } else if (server) {
+            server->setCgiCache(cgiCache);
+        } else if (location) {
+            location->setCgiCache(cgiCache);
+        } else {
+            return false;
+        }
+    }
+    return result;
+}
+
+// - cgi_max_concurrency and cgi_queue_size may be 0 (no limit, no queue);
+//   a queue timeout has to be at least one second.
+bool DirectiveParser::handleCgiLimitDirective(const std::string& directive, const std::vector<std::string>& tokens, std::size_t* pos, config::HttpConfig* http, config::ServerConfig* server, config::LocationConfig* location) {
+    ConfigBase* config;
+    if (http) {
+        config = http;
+    } else if (server) {
+        config = server;
+    } else if (location) {
+        config = location;
+    } else {
+        return false;
+    }
+    std::size_t value;
+    bool result = parseCountDirective(tokens, pos, directive, &value);
+    if (result) {
+        if (directive == config::directive::CGI_MAX_CONCURRENCY) {
+            config->setCgiMaxConcurrency(value);
+        } else if (directive == config::directive::CGI_QUEUE_SIZE) {
+            config->setCgiQueueSize(value);
+        } else if (value == 0) {
+            throwConfigError("\"" + directive + "\" directive invalid value");
+        } else {
+            config->setCgiQueueTimeout(value);
+        }
+    }
+    return result;
+}
+
 bool DirectiveParser::handleErrorPageDirective(const std::vector<std::string>& tokens, std::size_t* pos, config::HttpConfig* http, config::ServerConfig* server, config::LocationConfig* location) {
     std::vector<ErrorPage> errorPages;
     if (http) {
@@ -259,6 +401,93 @@ bool DirectiveParser::handleClientMaxBodySizeDirective(const std::vector<std::st
     return result;
 }
 
+bool DirectiveParser::handleFastcgiPassDirective(const std::vector<std::string>& tokens, std::size_t* pos, config::HttpConfig* http, config::ServerConfig* server, config::LocationConfig* location) {
+    if (http || server) {
+        throwConfigError("\"" + std::string(config::directive::FASTCGI_PASS) + "\" directive is not allowed here");
+    }
+    if (!location) {
+        return false;
+    }
+    FastcgiPass fastcgiPass = location->getFastcgiPass();
+    bool result = parseFastcgiPassDirective(tokens, pos, &fastcgiPass);
+    if (result) {
+        location->setFastcgiPass(fastcgiPass);
+    }
+    return result;
+}
+
+bool DirectiveParser::handleStubStatusDirective(const std::vector<std::string>& tokens, std::size_t* pos, config::HttpConfig* http, config::ServerConfig* server, config::LocationConfig* location) {
+    if (http || server) {
+        throwConfigError("\"" + std::string(config::directive::STUB_STATUS) + "\" directive is not allowed here");
+    }
+    if (!location) {
+        return false;
+    }
+    bool result = parseStubStatusDirective(tokens, pos);
+    if (result) {
+        location->setStubStatus(true);
+    }
+    return result;
+}
+
+// - 0 is allowed: connections still open are closed at once.
+bool DirectiveParser::handleShutdownTimeoutDirective(const std::vector<std::string>& tokens, std::size_t* pos, config::HttpConfig* http, config::ServerConfig* server, config::LocationConfig* location) {
+    if (server || location) {
+        throwConfigError("\"" + std::string(config::directive::SHUTDOWN_TIMEOUT) + "\" directive is not allowed here");
+    }
+    if (!http) {
+        return false;
+    }
+    std::size_t seconds;
+    bool result = parseCountDirective(tokens, pos, config::directive::SHUTDOWN_TIMEOUT, &seconds);
+    if (result) {
+        http->setShutdownTimeout(seconds);
+    }
+    return result;
+}
+
+bool DirectiveParser::handleLogBufferDirective(const std::vector<std::string>& tokens, std::size_t* pos, config::HttpConfig* http, config::ServerConfig* server, config::LocationConfig* location) {
+    if (server || location) {
+        throwConfigError("\"" + std::string(config::directive::LOG_BUFFER) + "\" directive is not allowed here");
+    }
+    if (!http) {
+        return false;
+    }
+    LogBuffer logBuffer;
+    bool result = parseLogBufferDirective(tokens, pos, &logBuffer);
+    if (result) {
+        http->setLogBuffer(logBuffer);
+    }
+    return result;
+}
+
+bool DirectiveParser::handleLogFormatDirective(const std::vector<std::string>& tokens, std::size_t* pos, config::HttpConfig* http, config::ServerConfig* server, config::LocationConfig* location) {
+    if (server || location) {
+        throwConfigError("\"" + std::string(config::directive::LOG_FORMAT) + "\" directive is not allowed here");
+    }
+    if (!http) {
+        return false;
+    }
+    return parseLogFormatDirective(tokens, pos);
+}
+
+bool DirectiveParser::handleAccessLogDirective(const std::vector<std::string>& tokens, std::size_t* pos, config::HttpConfig* http, config::ServerConfig* server, config::LocationConfig* location) {
+    AccessLog accessLog;
+    bool result = parseAccessLogDirective(tokens, pos, &accessLog);
+    if (result) {
+        if (http) {
+            http->setAccessLog(accessLog);
+        } else if (server) {
+            server->setAccessLog(accessLog);
+        } else if (location) {
+            location->setAccessLog(accessLog);
+        } else {
+            return false;
+        }
+    }
+    return result;
+}
+
 bool DirectiveParser::handleIndexDirective(const std::vector<std::string>& tokens, std::size_t* pos, config::HttpConfig* http, config::ServerConfig* server, config::LocationConfig* location) {
     std::vector<std::string> indices;
     if (http) {
@@ -410,6 +639,7 @@ bool DirectiveParser::isAllowedDuplicate(const std::string& directiveName) {
         config::directive::INDEX,
         config::directive::SERVER_NAME,
         config::directive::LISTEN,
+        config::directive::LOG_FORMAT,
     };
     const std::size_t allowedCount = sizeof(allowedDuplicates) / sizeof(allowedDuplicates[0]);
     for (std::size_t i = 0; i < allowedCount; ++i) {
@@ -9,6 +9,8 @@
 #include "config.hpp"
 #include "config_namespace.hpp"
 
+#include "../../toolbox/log_format.hpp"
+
 namespace config {
 
 enum DirectiveContext {
@@ -46,10 +48,18 @@ class DirectiveParser {
     bool parseErrorPageDirective(const std::vector<std::string>& tokens, std::size_t* pos, std::vector<ErrorPage>* errorPages);
     bool parseUploadStoreDirective(const std::vector<std::string>& tokens, std::size_t* pos, std::string* uploadStore);
     bool parseCgiPathDirective(const std::vector<std::string>& tokens, std::size_t* pos, std::string* cgiPath);
+    bool parseCgiPoolDirective(const std::vector<std::string>& tokens, std::size_t* pos, CgiPool* cgiPool);
+    bool parseCgiCacheDirective(const std::vector<std::string>& tokens, std::size_t* pos, CgiCache* cgiCache);
     bool parseCgiExtensionDirective(const std::vector<std::string>& tokens, std::size_t* pos, std::vector<std::string>* cgiExtensions);
     bool parseReturnDirective(const std::vector<std::string>& tokens, std::size_t* pos, Return* returnValue);
+    bool parseAccessLogDirective(const std::vector<std::string>& tokens, std::size_t* pos, AccessLog* accessLog);
+    bool parseLogFormatDirective(const std::vector<std::string>& tokens, std::size_t* pos);
+    bool parseLogBufferDirective(const std::vector<std::string>& tokens, std::size_t* pos, LogBuffer* logBuffer);
+    bool parseCountDirective(const std::vector<std::string>& tokens, std::size_t* pos, const std::string& directive, std::size_t* value);
     bool parseClientMaxBodySize(const std::vector<std::string>& tokens, std::size_t* pos, std::size_t* clientMaxBodySize);
     bool parseListenDirective(const std::vector<std::string>& tokens, std::size_t* pos, std::vector<Listen>* listen);
+    bool parseFastcgiPassDirective(const std::vector<std::string>& tokens, std::size_t* pos, FastcgiPass* fastcgiPass);
+    bool parseStubStatusDirective(const std::vector<std::string>& tokens, std::size_t* pos);
     bool parseServerNameDirective(const std::vector<std::string>& tokens, std::size_t* pos, std::vector<config::ServerName>* serverNames);
     bool isDirectiveAllowedInContext(const std::string& directive, DirectiveContext context) const;
     bool handleDuplicateDirective(const std::string& directiveName, const std::vector<std::string>& tokens, std::size_t* pos, bool* shouldSkip);
@@ -59,7 +69,11 @@ class DirectiveParser {
     DirectiveParser& operator=(const DirectiveParser& other);
 
     std::map<std::string, DirectiveInfo> _directiveInfo;
+    // log_format names seen so far, for access_log to refer to.
+    std::map<std::string, toolbox::logger::LogFormat> _logFormats;
     void initDirectiveInfo();
+    void initLogFormats();
+    bool handleAccessLogDirective(const std::vector<std::string>& tokens, std::size_t* pos, config::HttpConfig* http, config::ServerConfig* server, config::LocationConfig* location);
     bool handleAllowedMethodsDirective(const std::vector<std::string>& tokens, std::size_t* pos, config::HttpConfig* http, config::ServerConfig* server, config::LocationConfig* location);
     bool handleAutoindexDirective(const std::vector<std::string>& tokens, std::size_t* pos, config::HttpConfig* http, config::ServerConfig* server, config::LocationConfig* location);
     bool handleRootDirective(const std::vector<std::string>& tokens, std::size_t* pos, config::HttpConfig* http, config::ServerConfig* server, config::LocationConfig* location);
@@ -67,10 +81,18 @@ class DirectiveParser {
     bool handleErrorPageDirective(const std::vector<std::string>& tokens, std::size_t* pos, config::HttpConfig* http, config::ServerConfig* server, config::LocationConfig* location);
     bool handleUploadStoreDirective(const std::vector<std::string>& tokens, std::size_t* pos, config::HttpConfig* http, config::ServerConfig* server, config::LocationConfig* location);
     bool handleCgiPathDirective(const std::vector<std::string>& tokens, std::size_t* pos, config::HttpConfig* http, config::ServerConfig* server, config::LocationConfig* location);
+    bool handleCgiPoolDirective(const std::vector<std::string>& tokens, std::size_t* pos, config::HttpConfig* http, config::ServerConfig* server, config::LocationConfig* location);
     bool handleCgiExtensionDirective(const std::vector<std::string>& tokens, std::size_t* pos, config::HttpConfig* http, config::ServerConfig* server, config::LocationConfig* location);
     bool handleReturnDirective(const std::vector<std::string>& tokens, std::size_t* pos, config::HttpConfig* http, config::ServerConfig* server, config::LocationConfig* location);
+    bool handleCgiCacheDirective(const std::vector<std::string>& tokens, std::size_t* pos, config::HttpConfig* http, config::ServerConfig* server, config::LocationConfig* location);
+    bool handleCgiLimitDirective(const std::string& directive, const std::vector<std::string>& tokens, std::size_t* pos, config::HttpConfig* http, config::ServerConfig* server, config::LocationConfig* location);
     bool handleClientMaxBodySizeDirective(const std::vector<std::string>& tokens, std::size_t* pos, config::HttpConfig* http, config::ServerConfig* server, config::LocationConfig* location);
     bool handleListenDirective(const std::vector<std::string>& tokens, std::size_t* pos, config::HttpConfig* http, config::ServerConfig* server, config::LocationConfig* location);
+    bool handleFastcgiPassDirective(const std::vector<std::string>& tokens, std::size_t* pos, config::HttpConfig* http, config::ServerConfig* server, config::LocationConfig* location);
+    bool handleLogFormatDirective(const std::vector<std::string>& tokens, std::size_t* pos, config::HttpConfig* http, config::ServerConfig* server, config::LocationConfig* location);
+    bool handleLogBufferDirective(const std::vector<std::string>& tokens, std::size_t* pos, config::HttpConfig* http, config::ServerConfig* server, config::LocationConfig* location);
+    bool handleShutdownTimeoutDirective(const std::vector<std::string>& tokens, std::size_t* pos, config::HttpConfig* http, config::ServerConfig* server, config::LocationConfig* location);
+    bool handleStubStatusDirective(const std::vector<std::string>& tokens, std::size_t* pos, config::HttpConfig* http, config::ServerConfig* server, config::LocationConfig* location);
     bool handleServerNameDirective(const std::vector<std::string>& tokens, std::size_t* pos, config::HttpConfig* http, config::ServerConfig* server, config::LocationConfig* location);
     bool isAllowedDuplicate(const std::string& directiveName);
     bool isIgnoredDuplicate(const std::string& directiveName);
@@ -1,11 +1,14 @@
 // Copyright 2025 Ideal Broccoli
 
 #include <algorithm>
+#include <cctype>
 #include <limits>
+#include <map>
 #include <string>
 #include <cstring>
 
 #include <sys/socket.h>
+#include <sys/un.h>
 #include <netinet/in.h>
 #include <netdb.h>
 
@@ -75,7 +78,36 @@ bool parseSize(const std::string& str, std::size_t* result) {
     return true;
 }
 
-void validateHost(const std::string& host, const std::string& fullValue) {
+// - A variable is '$' and a name of lowercase letters, digits and '_':
+//   one of CGI_CACHE_KEY_VARIABLES or a header as $http_<name>.
+bool isValidCacheKey(const std::string& key) {
+    std::size_t pos = key.find(config::directive::CGI_CACHE_KEY_VARIABLE);
+    while (pos != std::string::npos) {
+        std::size_t end = pos + 1;
+        while (end < key.size() && (std::islower(key[end])
+                || std::isdigit(key[end]) || key[end] == '_')) {
+            ++end;
+        }
+        std::string name = key.substr(pos + 1, end - pos - 1);
+        std::string prefix = config::directive::CGI_CACHE_KEY_HEADER_PREFIX;
+        bool isKnown = name.size() > prefix.size()
+            && name.compare(0, prefix.size(), prefix) == 0;
+        for (std::size_t i = 0;
+                i < config::directive::CGI_CACHE_KEY_VARIABLES_COUNT; ++i) {
+            if (name == config::directive::CGI_CACHE_KEY_VARIABLES[i]) {
+                isKnown = true;
+            }
+        }
+        if (!isKnown) {
+            return false;
+        }
+        pos = key.find(config::directive::CGI_CACHE_KEY_VARIABLE, end);
+    }
+    return true;
+}
+
+void validateHost(const std::string& host, const std::string& fullValue,
+                  const std::string& directiveName = config::directive::LISTEN) {
     struct addrinfo hints;
     struct addrinfo* result = NULL;
     std::memset(&hints, 0, sizeof(hints));
@@ -83,10 +115,10 @@ void validateHost(const std::string& host, const std::string& fullValue) {
     hints.ai_socktype = SOCK_STREAM;
     int status = getaddrinfo(host.c_str(), NULL, &hints, &result);
     if (status != 0) {
-        throwConfigError("host not found in \"" + fullValue + "\" of the \"" + std::string(config::directive::LISTEN) + "\" directive: ");
+        throwConfigError("host not found in \"" + fullValue + "\" of the \"" + directiveName + "\" directive: ");
     }
     if (result == NULL) {
-        throwConfigError("host not found in \"" + fullValue + "\" of the \"" + std::string(config::directive::LISTEN) + "\" directive: ");
+        throwConfigError("host not found in \"" + fullValue + "\" of the \"" + directiveName + "\" directive: ");
     }
     freeaddrinfo(result);
 }
@@ -164,6 +196,228 @@ bool DirectiveParser::parseCgiPathDirective(const std::vector<std::string>& toke
     return expectSemicolon(tokens, pos, std::string(config::directive::CGI_PATH));
 }
 
+bool DirectiveParser::parseCgiPoolDirective(const std::vector<std::string>& tokens, std::size_t* pos, CgiPool* cgiPool) {
+    if (!cgiPool || *pos >= tokens.size()) {
+        toolbox::logger::StepMark::error("Unexpected Error :" + std::string(config::directive::CGI_POOL));
+        return false;
+    }
+    if (tokens[*pos] == config::directive::SEMICOLON) {
+        throwConfigError("invalid number of arguments in \"" + std::string(config::directive::CGI_POOL) + "\" directive");
+    }
+    CgiPool tmpPool;
+    tmpPool.setRunner(tokens[(*pos)++]);
+    while (*pos < tokens.size() && tokens[*pos] != config::directive::SEMICOLON) {
+        const std::string& param = tokens[(*pos)++];
+        std::size_t equalPos = param.find(config::directive::EQUAL);
+        if (equalPos == std::string::npos) {
+            throwConfigError("invalid parameter \"" + param + "\" in \"" + std::string(config::directive::CGI_POOL) + "\" directive");
+        }
+        std::string name = param.substr(0, equalPos);
+        std::size_t value;
+        if (!config::stringToSizeT(param.substr(equalPos + 1), &value) || value == 0) {
+            throwConfigError("invalid value in \"" + param + "\" of the \"" + std::string(config::directive::CGI_POOL) + "\" directive");
+        }
+        if (name == config::directive::CGI_POOL_WORKERS) {
+            tmpPool.setWorkers(value);
+        } else if (name == config::directive::CGI_POOL_MAX_REQUESTS) {
+            tmpPool.setMaxRequests(value);
+        } else if (name == config::directive::CGI_POOL_IDLE_TIMEOUT) {
+            tmpPool.setIdleTimeout(value);
+        } else {
+            throwConfigError("invalid parameter \"" + param + "\" in \"" + std::string(config::directive::CGI_POOL) + "\" directive");
+        }
+    }
+    *cgiPool = tmpPool;
+    return expectSemicolon(tokens, pos, std::string(config::directive::CGI_POOL));
+}
+
+bool DirectiveParser::parseCgiCacheDirective(const std::vector<std::string>& tokens, std::size_t* pos, CgiCache* cgiCache) {
+    if (!cgiCache || *pos >= tokens.size()) {
+        toolbox::logger::StepMark::error("Unexpected Error :" + std::string(config::directive::CGI_CACHE));
+        return false;
+    }
+    if (tokens[*pos] == config::directive::SEMICOLON) {
+        throwConfigError("invalid number of arguments in \"" + std::string(config::directive::CGI_CACHE) + "\" directive");
+    }
+    CgiCache tmpCache;
+    std::size_t ttl;
+    if (!config::stringToSizeT(tokens[*pos], &ttl) || ttl == 0) {
+        throwConfigError("invalid time value \"" + tokens[*pos] + "\" in \"" + std::string(config::directive::CGI_CACHE) + "\" directive");
+    }
+    tmpCache.setTtl(ttl);
+    (*pos)++;
+    while (*pos < tokens.size() && tokens[*pos] != config::directive::SEMICOLON) {
+        const std::string& param = tokens[(*pos)++];
+        std::size_t equalPos = param.find(config::directive::EQUAL);
+        if (equalPos == std::string::npos) {
+            throwConfigError("invalid parameter \"" + param + "\" in \"" + std::string(config::directive::CGI_CACHE) + "\" directive");
+        }
+        std::string name = param.substr(0, equalPos);
+        std::string value = param.substr(equalPos + 1);
+        if (name == config::directive::CGI_CACHE_SIZE) {
+            std::size_t maxSize;
+            if (!parseSize(value, &maxSize) || maxSize == 0) {
+                throwConfigError("invalid value in \"" + param + "\" of the \"" + std::string(config::directive::CGI_CACHE) + "\" directive");
+            }
+            tmpCache.setMaxSize(maxSize);
+        } else if (name == config::directive::CGI_CACHE_KEY) {
+            if (value.empty() || !isValidCacheKey(value)) {
+                throwConfigError("invalid value in \"" + param + "\" of the \"" + std::string(config::directive::CGI_CACHE) + "\" directive");
+            }
+            tmpCache.setKey(value);
+        } else {
+            throwConfigError("invalid parameter \"" + param + "\" in \"" + std::string(config::directive::CGI_CACHE) + "\" directive");
+        }
+    }
+    *cgiCache = tmpCache;
+    return expectSemicolon(tokens, pos, std::string(config::directive::CGI_CACHE));
+}
+
+// - access_log off | <path> [<format>] [buffer=<size>] [flush=<seconds>];
+//   the format is a log_format defined before, main by default.
+bool DirectiveParser::parseAccessLogDirective(const std::vector<std::string>& tokens, std::size_t* pos, AccessLog* accessLog) {
+    if (!accessLog || *pos >= tokens.size()) {
+        toolbox::logger::StepMark::error("Unexpected Error :" + std::string(config::directive::ACCESS_LOG));
+        return false;
+    }
+    if (tokens[*pos] == config::directive::SEMICOLON) {
+        throwConfigError("invalid number of arguments in \"" + std::string(config::directive::ACCESS_LOG) + "\" directive");
+    }
+    AccessLog tmpLog;
+    if (tokens[*pos] == config::directive::OFF) {
+        (*pos)++;
+        tmpLog.setOff();
+        *accessLog = tmpLog;
+        return expectSemicolon(tokens, pos, std::string(config::directive::ACCESS_LOG));
+    }
+    tmpLog.setPath(tokens[(*pos)++]);
+    if (*pos < tokens.size() && tokens[*pos] != config::directive::SEMICOLON
+            && tokens[*pos].find(config::directive::EQUAL) == std::string::npos) {
+        std::map<std::string, toolbox::logger::LogFormat>::const_iterator format = _logFormats.find(tokens[*pos]);
+        if (format == _logFormats.end()) {
+            throwConfigError("unknown log format \"" + tokens[*pos] + "\" in \"" + std::string(config::directive::ACCESS_LOG) + "\" directive");
+        }
+        tmpLog.setFormat(format->second);
+        (*pos)++;
+    }
+    while (*pos < tokens.size() && tokens[*pos] != config::directive::SEMICOLON) {
+        const std::string& param = tokens[(*pos)++];
+        std::size_t equalPos = param.find(config::directive::EQUAL);
+        if (equalPos == std::string::npos) {
+            throwConfigError("invalid parameter \"" + param + "\" in \"" + std::string(config::directive::ACCESS_LOG) + "\" directive");
+        }
+        std::string name = param.substr(0, equalPos);
+        std::string value = param.substr(equalPos + 1);
+        std::size_t number;
+        if (name == config::directive::ACCESS_LOG_BUFFER) {
+            if (!parseSize(value, &number) || number == 0) {
+                throwConfigError("invalid value in \"" + param + "\" of the \"" + std::string(config::directive::ACCESS_LOG) + "\" directive");
+            }
+            tmpLog.setBufferSize(number);
+        } else if (name == config::directive::LOG_BUFFER_FLUSH) {
+            if (!config::stringToSizeT(value, &number)) {
+                throwConfigError("invalid value in \"" + param + "\" of the \"" + std::string(config::directive::ACCESS_LOG) + "\" directive");
+            }
+            tmpLog.setFlushInterval(number);
+            if (tmpLog.getBufferSize() == 0) {
+                tmpLog.setBufferSize(config::DEFAULT_LOG_BUFFER_SIZE);
+            }
+        } else {
+            throwConfigError("invalid parameter \"" + param + "\" in \"" + std::string(config::directive::ACCESS_LOG) + "\" directive");
+        }
+    }
+    *accessLog = tmpLog;
+    return expectSemicolon(tokens, pos, std::string(config::directive::ACCESS_LOG));
+}
+
+// - log_format <name> <string> [<string> ...]; the strings are joined, as
+//   a long format is easier to write over several lines.
+bool DirectiveParser::parseLogFormatDirective(const std::vector<std::string>& tokens, std::size_t* pos) {
+    if (*pos >= tokens.size()) {
+        toolbox::logger::StepMark::error("Unexpected Error :" + std::string(config::directive::LOG_FORMAT));
+        return false;
+    }
+    if (tokens[*pos] == config::directive::SEMICOLON
+            || *pos + 1 >= tokens.size() || tokens[*pos + 1] == config::directive::SEMICOLON) {
+        throwConfigError("invalid number of arguments in \"" + std::string(config::directive::LOG_FORMAT) + "\" directive");
+    }
+    const std::string& name = tokens[(*pos)++];
+    if (_logFormats.find(name) != _logFormats.end()) {
+        throwConfigError("duplicate \"" + std::string(config::directive::LOG_FORMAT) + "\" name \"" + name + "\"");
+    }
+    std::string text;
+    while (*pos < tokens.size() && tokens[*pos] != config::directive::SEMICOLON) {
+        text += tokens[(*pos)++];
+    }
+    toolbox::logger::LogFormat format;
+    std::string unknown;
+    if (!format.compile(text, &unknown)) {
+        if (unknown.empty()) {
+            throwConfigError("invalid variable name in \"" + std::string(config::directive::LOG_FORMAT) + "\" directive");
+        }
+        throwConfigError("unknown \"" + unknown + "\" variable in \"" + std::string(config::directive::LOG_FORMAT) + "\" directive");
+    }
+    _logFormats[name] = format;
+    return expectSemicolon(tokens, pos, std::string(config::directive::LOG_FORMAT));
+}
+
+// - log_buffer <size> [flush=<seconds>] [overflow=drop|block]; flush=0
+//   writes at every turn of the event loop.
+bool DirectiveParser::parseLogBufferDirective(const std::vector<std::string>& tokens, std::size_t* pos, LogBuffer* logBuffer) {
+    if (!logBuffer || *pos >= tokens.size()) {
+        toolbox::logger::StepMark::error("Unexpected Error :" + std::string(config::directive::LOG_BUFFER));
+        return false;
+    }
+    if (tokens[*pos] == config::directive::SEMICOLON) {
+        throwConfigError("invalid number of arguments in \"" + std::string(config::directive::LOG_BUFFER) + "\" directive");
+    }
+    LogBuffer tmpBuffer;
+    std::size_t size;
+    if (!parseSize(tokens[*pos], &size) || size == 0) {
+        throwConfigError("invalid buffer size \"" + tokens[*pos] + "\" in \"" + std::string(config::directive::LOG_BUFFER) + "\" directive");
+    }
+    tmpBuffer.setSize(size);
+    (*pos)++;
+    while (*pos < tokens.size() && tokens[*pos] != config::directive::SEMICOLON) {
+        const std::string& param = tokens[(*pos)++];
+        std::size_t equalPos = param.find(config::directive::EQUAL);
+        if (equalPos == std::string::npos) {
+            throwConfigError("invalid parameter \"" + param + "\" in \"" + std::string(config::directive::LOG_BUFFER) + "\" directive");
+        }
+        std::string name = param.substr(0, equalPos);
+        std::string value = param.substr(equalPos + 1);
+        if (name == config::directive::LOG_BUFFER_FLUSH) {
+            std::size_t seconds;
+            if (!config::stringToSizeT(value, &seconds)) {
+                throwConfigError("invalid value in \"" + param + "\" of the \"" + std::string(config::directive::LOG_BUFFER) + "\" directive");
+            }
+            tmpBuffer.setFlushInterval(seconds);
+        } else if (name == config::directive::LOG_BUFFER_OVERFLOW
+                && (value == config::directive::LOG_BUFFER_DROP
+                    || value == config::directive::LOG_BUFFER_BLOCK)) {
+            tmpBuffer.setBlocking(value == config::directive::LOG_BUFFER_BLOCK);
+        } else {
+            throwConfigError("invalid parameter \"" + param + "\" in \"" + std::string(config::directive::LOG_BUFFER) + "\" directive");
+        }
+    }
+    *logBuffer = tmpBuffer;
+    return expectSemicolon(tokens, pos, std::string(config::directive::LOG_BUFFER));
+}
+
+bool DirectiveParser::parseCountDirective(const std::vector<std::string>& tokens, std::size_t* pos, const std::string& directive, std::size_t* value) {
+    if (!value || *pos >= tokens.size()) {
+        toolbox::logger::StepMark::error("Unexpected Error :" + directive);
+        return false;
+    }
+    if (tokens[*pos] == config::directive::SEMICOLON) {
+        throwConfigError("invalid number of arguments in \"" + directive + "\" directive");
+    }
+    if (!config::stringToSizeT(tokens[(*pos)++], value)) {
+        throwConfigError("\"" + directive + "\" directive invalid value");
+    }
+    return expectSemicolon(tokens, pos, directive);
+}
+
 bool DirectiveParser::parseClientMaxBodySize(const std::vector<std::string>& tokens, std::size_t* pos, std::size_t* clientMaxBodySize) {
     if (*pos >= tokens.size()) {
         toolbox::logger::StepMark::error("Unexpected Error :" + std::string(config::directive::CLIENT_MAX_BODY_SIZE));
@@ -262,6 +516,58 @@ bool DirectiveParser::parseIndexDirective(const std::vector<std::string>& tokens
     return expectSemicolon(tokens, pos, std::string(config::directive::INDEX));
 }
 
+bool DirectiveParser::parseFastcgiPassDirective(const std::vector<std::string>& tokens, std::size_t* pos, FastcgiPass* fastcgiPass) {
+    if (!fastcgiPass || *pos >= tokens.size()) {
+        toolbox::logger::StepMark::error("Unexpected Error :" + std::string(config::directive::FASTCGI_PASS));
+        return false;
+    }
+    if (tokens[*pos] == config::directive::SEMICOLON) {
+        throwConfigError("invalid number of arguments in \"" + std::string(config::directive::FASTCGI_PASS) + "\" directive");
+    }
+    std::string address = tokens[(*pos)++];
+    FastcgiPass tmpPass;
+    tmpPass.setAddress(address);
+    const std::string unixPrefix = config::directive::UNIX_SOCKET_PREFIX;
+    if (address.compare(0, unixPrefix.size(), unixPrefix) == 0) {
+        std::string path = address.substr(unixPrefix.size());
+        if (path.empty()) {
+            throwConfigError("no path in \"" + address + "\" of the \"" + std::string(config::directive::FASTCGI_PASS) + "\" directive");
+        }
+        if (path.size() >= sizeof(((struct sockaddr_un*)0)->sun_path)) {
+            throwConfigError("too long path in \"" + address + "\" of the \"" + std::string(config::directive::FASTCGI_PASS) + "\" directive");
+        }
+        tmpPass.setUnixPath(path);
+    } else {
+        std::size_t colonPos = address.rfind(config::token::COLON);
+        if (colonPos == std::string::npos) {
+            throwConfigError("no port in \"" + address + "\" of the \"" + std::string(config::directive::FASTCGI_PASS) + "\" directive");
+        }
+        std::string hostStr = address.substr(0, colonPos);
+        std::string portStr = address.substr(colonPos + 1);
+        std::size_t port;
+        if (!config::stringToSizeT(portStr, &port) ||
+            port < config::directive::MIN_PORT || port > config::directive::MAX_PORT) {
+            throwConfigError("invalid port in \"" + address + "\" of the \"" + std::string(config::directive::FASTCGI_PASS) + "\" directive");
+        }
+        if (hostStr.empty()) {
+            throwConfigError("no host in \"" + address + "\" of the \"" + std::string(config::directive::FASTCGI_PASS) + "\" directive");
+        }
+        validateHost(hostStr, address, config::directive::FASTCGI_PASS);
+        tmpPass.setHost(hostStr);
+        tmpPass.setPort(port);
+    }
+    *fastcgiPass = tmpPass;
+    return expectSemicolon(tokens, pos, std::string(config::directive::FASTCGI_PASS));
+}
+
+bool DirectiveParser::parseStubStatusDirective(const std::vector<std::string>& tokens, std::size_t* pos) {
+    if (*pos >= tokens.size()) {
+        toolbox::logger::StepMark::error("Unexpected Error :" + std::string(config::directive::STUB_STATUS));
+        return false;
+    }
+    return expectSemicolon(tokens, pos, std::string(config::directive::STUB_STATUS));
+}
+
 bool DirectiveParser::parseListenDirective(const std::vector<std::string>& tokens, std::size_t* pos, std::vector<Listen>* listen) {
     if (!listen || *pos >= tokens.size()) {
         toolbox::logger::StepMark::error("Unexpected Error :" + std::string(config::directive::LISTEN));
@@ -387,6 +693,10 @@ bool DirectiveParser::parseServerNameDirective(const std::vector<std::string>& t
             }
             serverName.setType(ServerName::WILDCARD_START);
             serverName.setName(name);
+        } else if (name.size() >= 3 && name[name.size() - 1] == config::directive::ASTERISK[0]
+                && name[name.size() - 2] == config::token::PERIOD[0]) {
+            serverName.setType(ServerName::WILDCARD_END);
+            serverName.setName(name);
         } else {
             serverName.setType(ServerName::EXACT);
             serverName.setName(name);
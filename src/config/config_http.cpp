@@ -7,10 +7,36 @@
 
 namespace config {
 
-HttpConfig::HttpConfig() {
+LogBuffer::LogBuffer() :
+_size(DEFAULT_LOG_BUFFER_SIZE),
+_flushInterval(DEFAULT_LOG_BUFFER_FLUSH),
+_isBlocking(false) {
 }
 
-HttpConfig::HttpConfig(const HttpConfig& other) : ConfigBase(other) {
+LogBuffer::LogBuffer(const LogBuffer& other) :
+_size(other._size),
+_flushInterval(other._flushInterval),
+_isBlocking(other._isBlocking) {
+}
+
+LogBuffer& LogBuffer::operator=(const LogBuffer& other) {
+    if (this != &other) {
+        _size = other._size;
+        _flushInterval = other._flushInterval;
+        _isBlocking = other._isBlocking;
+    }
+    return *this;
+}
+
+LogBuffer::~LogBuffer() {
+}
+
+HttpConfig::HttpConfig() : _shutdownTimeout(DEFAULT_SHUTDOWN_TIMEOUT) {
+}
+
+HttpConfig::HttpConfig(const HttpConfig& other)
+    : ConfigBase(other), _shutdownTimeout(other._shutdownTimeout),
+      _logBuffer(other._logBuffer) {
     for (std::size_t i = 0; i < other._servers.size(); ++i) {
         toolbox::SharedPtr<ServerConfig> newServer(new ServerConfig(*other._servers[i].get()));
         _servers.push_back(newServer);
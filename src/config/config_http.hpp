@@ -13,6 +13,42 @@
 #include "../../toolbox/shared.hpp"
 
 namespace config {
+/**
+ * @class LogBuffer
+ * @brief Class for managing how log lines are buffered before writing
+ *
+ * Applies to both the error log and the access log. Lines are written
+ * once half of size is used or after flushInterval seconds; when the file
+ * cannot keep up, a line that does not fit is dropped, or waits for the
+ * file if isBlocking is set.
+ *
+ * Usage example:
+ * @code
+ * LogBuffer logBuffer;
+ * logBuffer.setSize(256 * 1024);
+ * logBuffer.setBlocking(true);
+ * @endcode
+ */
+class LogBuffer {
+ public:
+    LogBuffer();
+    LogBuffer(const LogBuffer&);
+    LogBuffer& operator=(const LogBuffer&);
+    ~LogBuffer();
+
+    std::size_t getSize() const { return _size; }
+    std::size_t getFlushInterval() const { return _flushInterval; }
+    bool isBlocking() const { return _isBlocking; }
+    void setSize(std::size_t size) { _size = size; }
+    void setFlushInterval(std::size_t seconds) { _flushInterval = seconds; }
+    void setBlocking(bool isBlocking) { _isBlocking = isBlocking; }
+
+ private:
+    std::size_t _size;
+    std::size_t _flushInterval;
+    bool _isBlocking;
+};
+
 /**
  * @class HttpConfig
  * @brief Class for managing HTTP server configuration
@@ -50,8 +86,18 @@ class HttpConfig : public ConfigBase {
     const std::vector<toolbox::SharedPtr<ServerConfig> >& getServers() const { return _servers; }
     void addServer(const toolbox::SharedPtr<ServerConfig>& server) { _servers.push_back(server); }
 
+    /**
+     * @brief Seconds a graceful shutdown waits for open connections.
+     */
+    std::size_t getShutdownTimeout() const { return _shutdownTimeout; }
+    void setShutdownTimeout(std::size_t seconds) { _shutdownTimeout = seconds; }
+    const LogBuffer& getLogBuffer() const { return _logBuffer; }
+    void setLogBuffer(const LogBuffer& logBuffer) { _logBuffer = logBuffer; }
+
  private:
     std::vector<toolbox::SharedPtr<ServerConfig> > _servers;
+    std::size_t _shutdownTimeout;
+    LogBuffer _logBuffer;
     HttpConfig& operator=(const HttpConfig&);
 };
 
@@ -35,12 +35,24 @@ void serverEmptyCheck(ServerConfig* server) {
     }
 }
 
+// - Requests that match no location of the server are served by a "/"
+//   location inheriting everything from it.
+void defaultLocationCheck(ServerConfig* server) {
+    for (std::size_t i = 0; i < server->getLocations().size(); ++i) {
+        if (server->getLocations()[i]->getPath() == DEFAULT_LOCATION_PATH) {
+            return;
+        }
+    }
+    server->addLocation(toolbox::SharedPtr<LocationConfig>(new LocationConfig()));
+}
+
 void ConfigInherit::applyInheritance() {
     indexEmptyCheck(_httpConfig);
     for (std::size_t i = 0; i < _httpConfig->getServers().size(); ++i) {
         ServerConfig* server = _httpConfig->getServers()[i].get();
         config::ConfigInherit::inheritHttpToServer(_httpConfig, server);
         serverEmptyCheck(server);
+        defaultLocationCheck(server);
         for (std::size_t j = 0; j < server->getLocations().size(); j++) {
             LocationConfig* location = server->getLocations()[j].get();
             config::ConfigInherit::inheritServerToLocation(server, location);
@@ -77,6 +89,27 @@ void ConfigInherit::inheritHttpToServer(const HttpConfig* http, ServerConfig* se
         !http->getCgiPath().empty()) {
         server->setCgiPath(http->getCgiPath());
     }
+    if (!server->getCgiPool().isSet() && http->getCgiPool().isSet()) {
+        server->setCgiPool(http->getCgiPool());
+    }
+    if (!server->getAccessLog().isSet() && http->getAccessLog().isSet()) {
+        server->setAccessLog(http->getAccessLog());
+    }
+    if (!server->getCgiCache().isSet() && http->getCgiCache().isSet()) {
+        server->setCgiCache(http->getCgiCache());
+    }
+    if (server->getCgiMaxConcurrency() == DEFAULT_CGI_MAX_CONCURRENCY &&
+        http->getCgiMaxConcurrency() != DEFAULT_CGI_MAX_CONCURRENCY) {
+        server->setCgiMaxConcurrency(http->getCgiMaxConcurrency());
+    }
+    if (server->getCgiQueueSize() == DEFAULT_CGI_QUEUE_SIZE &&
+        http->getCgiQueueSize() != DEFAULT_CGI_QUEUE_SIZE) {
+        server->setCgiQueueSize(http->getCgiQueueSize());
+    }
+    if (server->getCgiQueueTimeout() == DEFAULT_CGI_QUEUE_TIMEOUT &&
+        http->getCgiQueueTimeout() != DEFAULT_CGI_QUEUE_TIMEOUT) {
+        server->setCgiQueueTimeout(http->getCgiQueueTimeout());
+    }
     if (server->getClientMaxBodySize() == DEFAULT_CLIENT_MAX_BODY_SIZE &&
         http->getClientMaxBodySize() != DEFAULT_CLIENT_MAX_BODY_SIZE) {
         server->setClientMaxBodySize(http->getClientMaxBodySize());
@@ -117,6 +150,27 @@ void ConfigInherit::inheritServerToLocation(const ServerConfig* server, Location
         !server->getCgiPath().empty()) {
         location->setCgiPath(server->getCgiPath());
     }
+    if (!location->getCgiPool().isSet() && server->getCgiPool().isSet()) {
+        location->setCgiPool(server->getCgiPool());
+    }
+    if (!location->getAccessLog().isSet() && server->getAccessLog().isSet()) {
+        location->setAccessLog(server->getAccessLog());
+    }
+    if (!location->getCgiCache().isSet() && server->getCgiCache().isSet()) {
+        location->setCgiCache(server->getCgiCache());
+    }
+    if (location->getCgiMaxConcurrency() == DEFAULT_CGI_MAX_CONCURRENCY &&
+        server->getCgiMaxConcurrency() != DEFAULT_CGI_MAX_CONCURRENCY) {
+        location->setCgiMaxConcurrency(server->getCgiMaxConcurrency());
+    }
+    if (location->getCgiQueueSize() == DEFAULT_CGI_QUEUE_SIZE &&
+        server->getCgiQueueSize() != DEFAULT_CGI_QUEUE_SIZE) {
+        location->setCgiQueueSize(server->getCgiQueueSize());
+    }
+    if (location->getCgiQueueTimeout() == DEFAULT_CGI_QUEUE_TIMEOUT &&
+        server->getCgiQueueTimeout() != DEFAULT_CGI_QUEUE_TIMEOUT) {
+        location->setCgiQueueTimeout(server->getCgiQueueTimeout());
+    }
     if (location->getClientMaxBodySize() == DEFAULT_CLIENT_MAX_BODY_SIZE &&
         server->getClientMaxBodySize() != DEFAULT_CLIENT_MAX_BODY_SIZE) {
         location->setClientMaxBodySize(server->getClientMaxBodySize());
@@ -157,6 +211,27 @@ void ConfigInherit::inheritLocationToLocation(const LocationConfig* parent, Loca
         !parent->getCgiPath().empty()) {
         child->setCgiPath(parent->getCgiPath());
     }
+    if (!child->getCgiPool().isSet() && parent->getCgiPool().isSet()) {
+        child->setCgiPool(parent->getCgiPool());
+    }
+    if (!child->getAccessLog().isSet() && parent->getAccessLog().isSet()) {
+        child->setAccessLog(parent->getAccessLog());
+    }
+    if (!child->getCgiCache().isSet() && parent->getCgiCache().isSet()) {
+        child->setCgiCache(parent->getCgiCache());
+    }
+    if (child->getCgiMaxConcurrency() == DEFAULT_CGI_MAX_CONCURRENCY &&
+        parent->getCgiMaxConcurrency() != DEFAULT_CGI_MAX_CONCURRENCY) {
+        child->setCgiMaxConcurrency(parent->getCgiMaxConcurrency());
+    }
+    if (child->getCgiQueueSize() == DEFAULT_CGI_QUEUE_SIZE &&
+        parent->getCgiQueueSize() != DEFAULT_CGI_QUEUE_SIZE) {
+        child->setCgiQueueSize(parent->getCgiQueueSize());
+    }
+    if (child->getCgiQueueTimeout() == DEFAULT_CGI_QUEUE_TIMEOUT &&
+        parent->getCgiQueueTimeout() != DEFAULT_CGI_QUEUE_TIMEOUT) {
+        child->setCgiQueueTimeout(parent->getCgiQueueTimeout());
+    }
     if (child->getClientMaxBodySize() == DEFAULT_CLIENT_MAX_BODY_SIZE &&
         parent->getClientMaxBodySize() != DEFAULT_CLIENT_MAX_BODY_SIZE) {
         child->setClientMaxBodySize(parent->getClientMaxBodySize());
@@ -7,6 +7,7 @@
 #include "config_location.hpp"
 
 #include "../../toolbox/shared.hpp"
+#include "../../toolbox/string.hpp"
 
 namespace config {
 
@@ -14,6 +15,9 @@ LocationConfig::LocationConfig() :
 ConfigBase(),
 _path(DEFAULT_LOCATION_PATH),
 _returnValue(),
+_fastcgiPass(),
+_stubStatus(false),
+_locationTrie(),
 _parentServer(NULL),
 _parentLocation(NULL) {
 }
@@ -22,6 +26,9 @@ LocationConfig::LocationConfig(const LocationConfig& other) :
 ConfigBase(other),
 _path(other._path),
 _returnValue(other._returnValue),
+_fastcgiPass(other._fastcgiPass),
+_stubStatus(other._stubStatus),
+_locationTrie(other._locationTrie),
 _parentServer(other._parentServer),
 _parentLocation(other._parentLocation) {
     for (std::size_t i = 0; i < other._locations.size(); ++i) {
@@ -36,6 +43,9 @@ LocationConfig& LocationConfig::operator=(const LocationConfig& other) {
         ConfigBase::operator=(other);
         _path = other._path;
         _returnValue = other._returnValue;
+        _fastcgiPass = other._fastcgiPass;
+        _stubStatus = other._stubStatus;
+        _locationTrie = other._locationTrie;
         _parentServer = other._parentServer;
         _parentLocation = other._parentLocation;
         _locations.clear();
@@ -52,4 +62,59 @@ LocationConfig& LocationConfig::operator=(const LocationConfig& other) {
 LocationConfig::~LocationConfig() {
 }
 
+// - Copies share the trie: it only refers to locations by position, and
+//   a copy keeps them in the same order.
+void LocationConfig::compileLocations() {
+    _locationTrie = toolbox::SharedPtr<LocationTrie>(new LocationTrie());
+    for (std::size_t i = 0; i < _locations.size(); ++i) {
+        _locationTrie->insert(_locations[i]->getPath(), i);
+        _locations[i]->compileLocations();
+    }
+}
+
+// - An exact match ends the search; otherwise the nested locations of the
+//   match are tried before it.
+toolbox::SharedPtr<LocationConfig> LocationConfig::findLocation(
+        const std::string& path) const {
+    if (!_locationTrie) {
+        return toolbox::SharedPtr<LocationConfig>();
+    }
+    bool isExact = false;
+    std::size_t index = _locationTrie->match(path, &isExact);
+    if (index == LocationTrie::npos) {
+        return toolbox::SharedPtr<LocationConfig>();
+    }
+    if (!isExact) {
+        toolbox::SharedPtr<LocationConfig> nested =
+            _locations[index]->findLocation(path);
+        if (nested) {
+            return nested;
+        }
+    }
+    return _locations[index];
+}
+
+// - Nothing in it depends on where the blocks are in memory, which changes
+//   with every reload.
+std::string LocationConfig::getIdentity() const {
+    std::string identity;
+    if (_parentServer != NULL) {
+        const std::vector<Listen>& listens = _parentServer->getListens();
+        for (std::size_t i = 0; i < listens.size(); ++i) {
+            identity += listens[i].getIp() + ":"
+                + toolbox::to_string(listens[i].getPort()) + " ";
+        }
+        const std::vector<ServerName>& names = _parentServer->getServerNames();
+        for (std::size_t i = 0; i < names.size(); ++i) {
+            identity += names[i].getName() + " ";
+        }
+    }
+    std::string paths;
+    for (const LocationConfig* location = this; location != NULL;
+            location = location->_parentLocation) {
+        paths = location->_path + " " + paths;
+    }
+    return identity + paths;
+}
+
 }  // namespace config
@@ -8,6 +8,7 @@
 #include "config_namespace.hpp"
 #include "config_http.hpp"
 #include "config_server.hpp"
+#include "config_location_trie.hpp"
 
 #include "../../toolbox/shared.hpp"
 
@@ -52,15 +53,31 @@ class LocationConfig : public ConfigBase {
     void setPath(const std::string& path) { _path = path; }
     const Return& getReturnValue() const { return _returnValue; }
     void setReturnValue(const Return& returnValue) { _returnValue = returnValue; }
+    const FastcgiPass& getFastcgiPass() const { return _fastcgiPass; }
+    void setFastcgiPass(const FastcgiPass& fastcgiPass) { _fastcgiPass = fastcgiPass; }
+    bool isStubStatus() const { return _stubStatus; }
+    void setStubStatus(bool stubStatus) { _stubStatus = stubStatus; }
     const std::vector<toolbox::SharedPtr<LocationConfig> >& getLocations() const { return _locations; }
     void addLocation(const toolbox::SharedPtr<LocationConfig>& location) { _locations.push_back(location); }
     bool hasLocations() const { return !_locations.empty(); }
     std::size_t getLocationsCount() const { return _locations.size(); }
+    void compileLocations();
+    toolbox::SharedPtr<LocationConfig> findLocation(const std::string& path) const;
+
+    /**
+     * @brief A name for the location that stays the same across reloads.
+     * @return The listen addresses and server names of its server, and
+     *         the paths of the location and the ones it is nested in.
+     */
+    std::string getIdentity() const;
 
  private:
     std::string _path;
     Return _returnValue;
+    FastcgiPass _fastcgiPass;
+    bool _stubStatus;       // serves the metrics page; not inherited
     std::vector<toolbox::SharedPtr<LocationConfig> > _locations;
+    toolbox::SharedPtr<LocationTrie> _locationTrie;
     const ServerConfig* _parentServer;
     const LocationConfig* _parentLocation;
 };
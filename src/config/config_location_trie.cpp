@@ -0,0 +1,101 @@
+// Copyright 2025 Ideal Broccoli
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "config_location_trie.hpp"
+
+namespace config {
+
+const std::size_t LocationTrie::npos = static_cast<std::size_t>(-1);
+
+LocationTrie::Node::Node() : index(npos) {
+}
+
+LocationTrie::LocationTrie() {
+    addNode("", npos);
+}
+
+LocationTrie::~LocationTrie() {
+}
+
+std::size_t LocationTrie::addNode(const std::string& label,
+                                  std::size_t index) {
+    _nodes.push_back(Node());
+    _nodes.back().label = label;
+    _nodes.back().index = index;
+    return _nodes.size() - 1;
+}
+
+// - Nodes are referred to by position because addNode() may move them.
+//   An edge whose label only partly matches is split at the mismatch.
+void LocationTrie::insert(const std::string& path, std::size_t index) {
+    std::size_t node = 0;
+    std::size_t pos = 0;
+    while (pos < path.size()) {
+        std::map<char, std::size_t>::iterator edge =
+            _nodes[node].children.find(path[pos]);
+        if (edge == _nodes[node].children.end()) {
+            std::size_t leaf = addNode(path.substr(pos), index);
+            _nodes[node].children[path[pos]] = leaf;
+            return;
+        }
+        std::size_t child = edge->second;
+        const std::string& label = _nodes[child].label;
+        std::size_t common = 0;
+        while (common < label.size() && pos + common < path.size()
+               && label[common] == path[pos + common]) {
+            ++common;
+        }
+        if (common < label.size()) {
+            std::size_t middle = addNode(label.substr(0, common), npos);
+            _nodes[child].label.erase(0, common);
+            _nodes[middle].children[_nodes[child].label[0]] = child;
+            _nodes[node].children[path[pos]] = middle;
+            child = middle;
+        }
+        node = child;
+        pos += common;
+    }
+    if (_nodes[node].index == npos) {
+        _nodes[node].index = index;
+    }
+}
+
+// - A deeper match is always longer, so the last one seen wins. The
+//   root only holds a location with an empty path.
+std::size_t LocationTrie::match(const std::string& path, bool* isExact) const {
+    std::size_t best = npos;
+    std::size_t node = 0;
+    std::size_t pos = 0;
+    *isExact = false;
+    while (true) {
+        if (_nodes[node].index != npos) {
+            if (pos == path.size()) {
+                *isExact = true;
+                return _nodes[node].index;
+            }
+            if ((pos > 0 && path[pos - 1] == '/') || path[pos] == '/') {
+                best = _nodes[node].index;
+            }
+        }
+        if (pos == path.size()) {
+            break;
+        }
+        std::map<char, std::size_t>::const_iterator edge =
+            _nodes[node].children.find(path[pos]);
+        if (edge == _nodes[node].children.end()) {
+            break;
+        }
+        const std::string& label = _nodes[edge->second].label;
+        if (path.compare(pos, label.size(), label) != 0) {
+            break;
+        }
+        node = edge->second;
+        pos += label.size();
+    }
+    return best;
+}
+
+}  // namespace config
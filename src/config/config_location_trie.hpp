@@ -0,0 +1,69 @@
+// Copyright 2025 Ideal Broccoli
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace config {
+
+/**
+ * @class LocationTrie
+ * @brief Radix trie over the location paths of one block, for longest
+ * prefix matching.
+ *
+ * Each location path is stored under its position in the block's location
+ * list. A lookup walks the request path once, comparing edge labels in
+ * place, so it costs O(path length) whatever the number of locations and
+ * allocates nothing.
+ *
+ * A location matches when its path is a prefix of the request path that
+ * ends with '/' or stops at a segment boundary: "/img" matches "/img" and
+ * "/img/a.png" but not "/images".
+ *
+ * Usage example:
+ * @code
+ * LocationTrie trie;
+ * for (std::size_t i = 0; i < locations.size(); ++i) {
+ *     trie.insert(locations[i]->getPath(), i);
+ * }
+ * bool isExact = false;
+ * std::size_t index = trie.match("/img/a.png", &isExact);
+ * if (index != LocationTrie::npos) {
+ *     // locations[index] is the longest match
+ * }
+ * @endcode
+ *
+ * When two locations have the same path, the first one inserted keeps it.
+ */
+class LocationTrie {
+ public:
+    static const std::size_t npos;
+
+    LocationTrie();
+    ~LocationTrie();
+
+    void insert(const std::string& path, std::size_t index);
+
+    /**
+     * @brief The index of the longest matching location, or npos.
+     * @param isExact Set to whether its path equals the request path.
+     */
+    std::size_t match(const std::string& path, bool* isExact) const;
+
+ private:
+    struct Node {
+        Node();
+
+        std::string label;
+        std::size_t index;
+        std::map<char, std::size_t> children;
+    };
+
+    std::size_t addNode(const std::string& label, std::size_t index);
+
+    std::vector<Node> _nodes;
+};
+
+}  // namespace config
@@ -32,17 +32,28 @@ const char* LOCATION = "location";
 }  // namespace context
 
 namespace directive {
+const char* ACCESS_LOG = "access_log";
 const char* ALLOWED_METHODS = "allowed_methods";
 const char* AUTOINDEX = "autoindex";
+const char* CGI_CACHE = "cgi_cache";
 const char* CGI_EXTENSION = "cgi_extension";
+const char* CGI_MAX_CONCURRENCY = "cgi_max_concurrency";
 const char* CGI_PATH = "cgi_path";
+const char* CGI_POOL = "cgi_pool";
+const char* CGI_QUEUE_SIZE = "cgi_queue_size";
+const char* CGI_QUEUE_TIMEOUT = "cgi_queue_timeout";
 const char* CLIENT_MAX_BODY_SIZE = "client_max_body_size";
 const char* ERROR_PAGE = "error_page";
+const char* FASTCGI_PASS = "fastcgi_pass";
 const char* INDEX = "index";
 const char* LISTEN = "listen";
+const char* LOG_BUFFER = "log_buffer";
+const char* LOG_FORMAT = "log_format";
 const char* RETURN = "return";
 const char* ROOT = "root";
 const char* SERVER_NAME = "server_name";
+const char* SHUTDOWN_TIMEOUT = "shutdown_timeout";
+const char* STUB_STATUS = "stub_status";
 const char* UPLOAD_STORE = "upload_store";
 const char* SEMICOLON = ";";
 const char EQUAL = '=';
@@ -57,6 +68,28 @@ const std::size_t MIN_PORT = 1;
 const std::size_t MAX_PORT = 65535;
 const char* LISTEN_DEFAULT_SERVER = "default_server";
 const std::size_t MAX_RETURN_CODE = 999;
+const char* UNIX_SOCKET_PREFIX = "unix:";
+const char* CGI_POOL_WORKERS = "workers";
+const char* CGI_POOL_MAX_REQUESTS = "max_requests";
+const char* CGI_POOL_IDLE_TIMEOUT = "idle_timeout";
+const char* CGI_CACHE_SIZE = "size";
+const char* CGI_CACHE_KEY = "key";
+const char* LOG_BUFFER_FLUSH = "flush";
+const char* LOG_BUFFER_OVERFLOW = "overflow";
+const char* LOG_BUFFER_DROP = "drop";
+const char* LOG_BUFFER_BLOCK = "block";
+const char* ACCESS_LOG_BUFFER = "buffer";
+// Predefined log_format names.
+const char* LOG_FORMAT_MAIN = "main";
+const char* LOG_FORMAT_COMBINED = "combined";
+const char* LOG_FORMAT_TIMING = "timing";
+const char CGI_CACHE_KEY_VARIABLE = '$';
+// $http_<name> stands for the request header <name>, '_' read as '-'.
+const char* CGI_CACHE_KEY_HEADER_PREFIX = "http_";
+const std::size_t CGI_CACHE_KEY_VARIABLES_COUNT = 4;
+const char* CGI_CACHE_KEY_VARIABLES[CGI_CACHE_KEY_VARIABLES_COUNT] = {
+    "method", "host", "path", "query"
+};
 }  // namespace directive
 
 namespace method {
@@ -71,6 +104,31 @@ const char* ALLOWED_METHODS[ALLOWED_METHODS_COUNT] = {GET, HEAD, POST, DELETE};
 const bool DEFAULT_AUTOINDEX = false;
 const std::size_t DEFAULT_CLIENT_MAX_BODY_SIZE = 1024 * 1024;
 const char* DEFAULT_CGI_PATH = "cgi";
+const std::size_t DEFAULT_CGI_CACHE_SIZE = 10 * 1024 * 1024;
+const char* DEFAULT_CGI_CACHE_KEY = "$method:$host$path$query";
+// 0: no limit.
+const std::size_t DEFAULT_CGI_MAX_CONCURRENCY = 0;
+const std::size_t DEFAULT_CGI_POOL_WORKERS = 4;
+const std::size_t DEFAULT_CGI_POOL_MAX_REQUESTS = 100;
+const std::size_t DEFAULT_CGI_POOL_IDLE_TIMEOUT = 60;
+const std::size_t DEFAULT_CGI_QUEUE_SIZE = 0;
+const std::size_t DEFAULT_CGI_QUEUE_TIMEOUT = 30;
+const std::size_t DEFAULT_SHUTDOWN_TIMEOUT = 30;
+const std::size_t DEFAULT_LOG_BUFFER_SIZE = 64 * 1024;
+const std::size_t DEFAULT_LOG_BUFFER_FLUSH = 1;
+const char* DEFAULT_ACCESS_LOG = "access.log";
+// The default format: the combined layout access.log has always had.
+const char* MAIN_LOG_FORMAT =
+    "$remote_addr - $remote_user [$time_local] \"$request\" $status "
+    "$body_bytes_sent \"$http_referer\" \"$http_user_agent\"";
+const char* COMBINED_LOG_FORMAT =
+    "$remote_addr - $remote_user [$time_local] \"$request\" $status "
+    "$body_bytes_sent \"$http_referer\" \"$http_user_agent\"";
+// Opt-in: combined, followed by the request timings.
+const char* TIMING_LOG_FORMAT =
+    "$remote_addr - $remote_user [$time_local] \"$request\" $status "
+    "$body_bytes_sent \"$http_referer\" \"$http_user_agent\" "
+    "rt=$request_time urt=$upstream_response_time ttfb=$first_byte_time";
 const char* DEFAULT_FILE = "conf/default.conf";
 const int DEFAULT_PORT = 80;
 const std::vector<std::string> DEFAULT_INDICES(1, "index.html");
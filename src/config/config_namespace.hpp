@@ -32,17 +32,28 @@ extern const char* LOCATION;
 }  // namespace context
 
 namespace directive {
+extern const char* ACCESS_LOG;
 extern const char* ALLOWED_METHODS;
 extern const char* AUTOINDEX;
+extern const char* CGI_CACHE;
 extern const char* CGI_EXTENSION;
+extern const char* CGI_MAX_CONCURRENCY;
 extern const char* CGI_PATH;
+extern const char* CGI_POOL;
+extern const char* CGI_QUEUE_SIZE;
+extern const char* CGI_QUEUE_TIMEOUT;
 extern const char* CLIENT_MAX_BODY_SIZE;
 extern const char* ERROR_PAGE;
+extern const char* FASTCGI_PASS;
 extern const char* INDEX;
 extern const char* LISTEN;
+extern const char* LOG_BUFFER;
+extern const char* LOG_FORMAT;
 extern const char* RETURN;
 extern const char* ROOT;
 extern const char* SERVER_NAME;
+extern const char* SHUTDOWN_TIMEOUT;
+extern const char* STUB_STATUS;
 extern const char* UPLOAD_STORE;
 extern const char* SEMICOLON;
 extern const char EQUAL;
@@ -57,6 +68,24 @@ extern const std::size_t MIN_PORT;
 extern const std::size_t MAX_PORT;
 extern const char* LISTEN_DEFAULT_SERVER;
 extern const std::size_t MAX_RETURN_CODE;
+extern const char* UNIX_SOCKET_PREFIX;
+extern const char* CGI_POOL_WORKERS;
+extern const char* CGI_POOL_MAX_REQUESTS;
+extern const char* CGI_POOL_IDLE_TIMEOUT;
+extern const char* CGI_CACHE_SIZE;
+extern const char* CGI_CACHE_KEY;
+extern const char* LOG_BUFFER_FLUSH;
+extern const char* LOG_BUFFER_OVERFLOW;
+extern const char* LOG_BUFFER_DROP;
+extern const char* LOG_BUFFER_BLOCK;
+extern const char* ACCESS_LOG_BUFFER;
+extern const char* LOG_FORMAT_MAIN;
+extern const char* LOG_FORMAT_COMBINED;
+extern const char* LOG_FORMAT_TIMING;
+extern const char CGI_CACHE_KEY_VARIABLE;
+extern const char* CGI_CACHE_KEY_HEADER_PREFIX;
+extern const std::size_t CGI_CACHE_KEY_VARIABLES_COUNT;
+extern const char* CGI_CACHE_KEY_VARIABLES[];
 }  // namespace directive
 
 namespace method {
@@ -71,6 +100,21 @@ extern const char* ALLOWED_METHODS[];
 extern const bool DEFAULT_AUTOINDEX;
 extern const std::size_t DEFAULT_CLIENT_MAX_BODY_SIZE;
 extern const char* DEFAULT_CGI_PATH;
+extern const std::size_t DEFAULT_CGI_CACHE_SIZE;
+extern const char* DEFAULT_CGI_CACHE_KEY;
+extern const std::size_t DEFAULT_CGI_MAX_CONCURRENCY;
+extern const std::size_t DEFAULT_CGI_POOL_WORKERS;
+extern const std::size_t DEFAULT_CGI_POOL_MAX_REQUESTS;
+extern const std::size_t DEFAULT_CGI_POOL_IDLE_TIMEOUT;
+extern const std::size_t DEFAULT_CGI_QUEUE_SIZE;
+extern const std::size_t DEFAULT_CGI_QUEUE_TIMEOUT;
+extern const std::size_t DEFAULT_SHUTDOWN_TIMEOUT;
+extern const std::size_t DEFAULT_LOG_BUFFER_SIZE;
+extern const std::size_t DEFAULT_LOG_BUFFER_FLUSH;
+extern const char* DEFAULT_ACCESS_LOG;
+extern const char* MAIN_LOG_FORMAT;
+extern const char* COMBINED_LOG_FORMAT;
+extern const char* TIMING_LOG_FORMAT;
 extern const char* DEFAULT_FILE;
 extern const int DEFAULT_PORT;
 extern const std::vector<std::string> DEFAULT_INDICES;
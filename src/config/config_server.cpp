@@ -17,6 +17,7 @@ _listens(),
 _serverNames(),
 _returnValue(),
 _locations(),
+_locationTrie(),
 _parent(NULL) {
 }
 
@@ -25,6 +26,7 @@ ConfigBase(other),
 _listens(other._listens),
 _serverNames(other._serverNames),
 _returnValue(other._returnValue),
+_locationTrie(other._locationTrie),
 _parent(other._parent) {
     for (std::size_t i = 0; i < other._locations.size(); ++i) {
         toolbox::SharedPtr<LocationConfig> newLocation(new LocationConfig(*other._locations[i]));
@@ -36,4 +38,32 @@ _parent(other._parent) {
 ServerConfig::~ServerConfig() {
 }
 
+void ServerConfig::compileLocations() {
+    _locationTrie = toolbox::SharedPtr<LocationTrie>(new LocationTrie());
+    for (std::size_t i = 0; i < _locations.size(); ++i) {
+        _locationTrie->insert(_locations[i]->getPath(), i);
+        _locations[i]->compileLocations();
+    }
+}
+
+toolbox::SharedPtr<LocationConfig> ServerConfig::findLocation(
+        const std::string& path) const {
+    if (!_locationTrie) {
+        return toolbox::SharedPtr<LocationConfig>();
+    }
+    bool isExact = false;
+    std::size_t index = _locationTrie->match(path, &isExact);
+    if (index == LocationTrie::npos) {
+        return toolbox::SharedPtr<LocationConfig>();
+    }
+    if (!isExact) {
+        toolbox::SharedPtr<LocationConfig> nested =
+            _locations[index]->findLocation(path);
+        if (nested) {
+            return nested;
+        }
+    }
+    return _locations[index];
+}
+
 }  // namespace config
@@ -8,6 +8,7 @@
 #include "config_namespace.hpp"
 #include "config_http.hpp"
 #include "config_location.hpp"
+#include "config_location_trie.hpp"
 
 #include "../../toolbox/shared.hpp"
 
@@ -64,6 +65,17 @@ class ServerConfig : public ConfigBase {
     bool hasLocations() const { return !_locations.empty(); }
     std::size_t getLocationsCount() const { return _locations.size(); }
 
+    /**
+     * @brief Builds the lookup tries of the locations, nested ones included;
+     * to be called again after locations are added.
+     */
+    void compileLocations();
+
+    /**
+     * @brief The deepest location matching a request path, or NULL.
+     */
+    toolbox::SharedPtr<LocationConfig> findLocation(const std::string& path) const;
+
  private:
     ServerConfig& operator=(const ServerConfig&);
 
@@ -71,6 +83,7 @@ class ServerConfig : public ConfigBase {
     std::vector<ServerName> _serverNames;
     Return _returnValue;
     std::vector<toolbox::SharedPtr<LocationConfig> > _locations;
+    toolbox::SharedPtr<LocationTrie> _locationTrie;
     const HttpConfig* _parent;
 };
 
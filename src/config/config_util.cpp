@@ -103,17 +103,28 @@ bool isContextToken(const std::string& token) {
 
 bool isDirectiveToken(const std::string& token) {
     const std::string directives[] = {
+        config::directive::ACCESS_LOG,
         config::directive::ALLOWED_METHODS,
         config::directive::AUTOINDEX,
+        config::directive::CGI_CACHE,
         config::directive::CGI_EXTENSION,
+        config::directive::CGI_MAX_CONCURRENCY,
         config::directive::CGI_PATH,
+        config::directive::CGI_POOL,
+        config::directive::CGI_QUEUE_SIZE,
+        config::directive::CGI_QUEUE_TIMEOUT,
         config::directive::CLIENT_MAX_BODY_SIZE,
         config::directive::ERROR_PAGE,
+        config::directive::FASTCGI_PASS,
         config::directive::INDEX,
         config::directive::LISTEN,
+        config::directive::LOG_BUFFER,
+        config::directive::LOG_FORMAT,
         config::directive::RETURN,
         config::directive::ROOT,
         config::directive::SERVER_NAME,
+        config::directive::SHUTDOWN_TIMEOUT,
+        config::directive::STUB_STATUS,
         config::directive::UPLOAD_STORE
     };
     const std::size_t directiveCount = sizeof(directives) / sizeof(directives[0]);
@@ -0,0 +1,176 @@
+// Copyright 2025 Ideal Broccoli
+
+#include <cctype>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "config_vhost.hpp"
+#include "config_namespace.hpp"
+
+namespace config {
+namespace {
+std::string toLower(const std::string& str) {
+    std::string lower(str);
+    for (std::size_t i = 0; i < lower.size(); ++i) {
+        lower[i] = std::tolower(static_cast<unsigned char>(lower[i]));
+    }
+    return lower;
+}
+
+std::vector<std::string> splitLabels(const std::string& name) {
+    std::vector<std::string> labels;
+    std::size_t start = 0;
+    while (start <= name.size()) {
+        std::size_t end = name.find('.', start);
+        if (end == std::string::npos) {
+            end = name.size();
+        }
+        labels.push_back(name.substr(start, end - start));
+        start = end + 1;
+    }
+    return labels;
+}
+}  // namespace
+
+ServerNameTable::ServerNameTable() : _hasExplicitDefault(false) {
+}
+
+ServerNameTable::~ServerNameTable() {
+}
+
+// - "*.example.com" is kept under com -> example, "www.example.*" under
+//   www -> example.
+void ServerNameTable::add(const toolbox::SharedPtr<ServerConfig>& server,
+                          bool isDefault) {
+    const std::vector<ServerName>& names = server->getServerNames();
+    for (std::size_t i = 0; i < names.size(); ++i) {
+        std::string name = toLower(names[i].getName());
+        if (names[i].getType() == ServerName::WILDCARD_START) {
+            std::vector<std::string> labels = splitLabels(name.substr(2));
+            insert(&_leadingWildcards,
+                   std::vector<std::string>(labels.rbegin(), labels.rend()),
+                   server);
+        } else if (names[i].getType() == ServerName::WILDCARD_END) {
+            insert(&_trailingWildcards,
+                   splitLabels(name.substr(0, name.size() - 2)), server);
+        } else if (_exactNames.find(name) == _exactNames.end()) {
+            _exactNames[name] = server;
+        }
+    }
+    if (isDefault && !_hasExplicitDefault) {
+        _defaultServer = server;
+        _hasExplicitDefault = true;
+    } else if (!_defaultServer) {
+        _defaultServer = server;
+    }
+}
+
+void ServerNameTable::insert(LabelNode* root,
+                             const std::vector<std::string>& labels,
+                             const toolbox::SharedPtr<ServerConfig>& server) {
+    LabelNode* node = root;
+    for (std::size_t i = 0; i < labels.size(); ++i) {
+        toolbox::SharedPtr<LabelNode>& child = node->children[labels[i]];
+        if (!child) {
+            child = toolbox::SharedPtr<LabelNode>(new LabelNode());
+        }
+        node = child.get();
+    }
+    if (!node->server) {
+        node->server = server;
+    }
+}
+
+// - A wildcard stands for at least one label, so a node only matches when
+//   the host has labels left after it.
+toolbox::SharedPtr<ServerConfig> ServerNameTable::findLongest(
+        const LabelNode& root, const std::vector<std::string>& labels) {
+    toolbox::SharedPtr<ServerConfig> longest;
+    const LabelNode* node = &root;
+    for (std::size_t i = 0; i + 1 < labels.size(); ++i) {
+        std::map<std::string, toolbox::SharedPtr<LabelNode> >::const_iterator
+            child = node->children.find(labels[i]);
+        if (child == node->children.end()) {
+            break;
+        }
+        node = child->second.get();
+        if (node->server) {
+            longest = node->server;
+        }
+    }
+    return longest;
+}
+
+toolbox::SharedPtr<ServerConfig> ServerNameTable::find(
+        const std::string& host) const {
+    std::string name = toLower(host);
+    if (!name.empty() && name[name.size() - 1] == '.') {
+        name.erase(name.size() - 1);
+    }
+    std::map<std::string, toolbox::SharedPtr<ServerConfig> >::const_iterator
+        exact = _exactNames.find(name);
+    if (exact != _exactNames.end()) {
+        return exact->second;
+    }
+    if (name.empty()) {
+        return _defaultServer;
+    }
+    std::vector<std::string> labels = splitLabels(name);
+    toolbox::SharedPtr<ServerConfig> server = findLongest(_leadingWildcards,
+        std::vector<std::string>(labels.rbegin(), labels.rend()));
+    if (!server) {
+        server = findLongest(_trailingWildcards, labels);
+    }
+    if (!server) {
+        server = _defaultServer;
+    }
+    return server;
+}
+
+// - Servers are added in the order they were declared, so the first one
+//   on an address stays its default unless another says default_server.
+VirtualHosts::VirtualHosts(const HttpConfig& httpConfig) {
+    const std::vector<toolbox::SharedPtr<ServerConfig> >& servers =
+        httpConfig.getServers();
+    for (std::size_t i = 0; i < servers.size(); ++i) {
+        const std::vector<Listen>& listens = servers[i]->getListens();
+        for (std::size_t j = 0; j < listens.size(); ++j) {
+            Address address(listens[j].getIp(), listens[j].getPort());
+            if (!_tables[address]) {
+                _tables[address] =
+                    toolbox::SharedPtr<ServerNameTable>(new ServerNameTable());
+            }
+        }
+    }
+    for (std::map<Address, toolbox::SharedPtr<ServerNameTable> >::iterator
+            it = _tables.begin(); it != _tables.end(); ++it) {
+        for (std::size_t i = 0; i < servers.size(); ++i) {
+            const std::vector<Listen>& listens = servers[i]->getListens();
+            for (std::size_t j = 0; j < listens.size(); ++j) {
+                if (listens[j].getPort() == it->first.second
+                    && (listens[j].getIp() == it->first.first
+                        || listens[j].getIp() == DEFAULT_IP)) {
+                    it->second->add(servers[i], listens[j].isDefaultServer());
+                    break;
+                }
+            }
+        }
+    }
+}
+
+VirtualHosts::~VirtualHosts() {
+}
+
+toolbox::SharedPtr<ServerNameTable> VirtualHosts::find(const std::string& ip,
+                                                       std::size_t port) const {
+    std::map<Address, toolbox::SharedPtr<ServerNameTable> >::const_iterator
+        it = _tables.find(Address(ip, port));
+    if (it == _tables.end()) {
+        return toolbox::SharedPtr<ServerNameTable>();
+    }
+    return it->second;
+}
+
+}  // namespace config
@@ -0,0 +1,102 @@
+// Copyright 2025 Ideal Broccoli
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "config_http.hpp"
+#include "config_server.hpp"
+#include "../../toolbox/shared.hpp"
+
+namespace config {
+
+/**
+ * @class ServerNameTable
+ * @brief The servers reachable through one listening address, by name.
+ *
+ * A host is looked up the way nginx does it: an exact name first, then
+ * the longest name with a leading wildcard ("*.example.com"), then the
+ * longest name with a trailing wildcard ("www.example.*"), and finally
+ * the default server of the address. Wildcards are kept in tries of
+ * labels, read from the right for leading wildcards and from the left for
+ * trailing ones, so a lookup walks the host's labels once.
+ *
+ * Usage example:
+ * @code
+ * ServerNameTable table;
+ * table.add(server, listen.isDefaultServer());
+ * toolbox::SharedPtr<ServerConfig> selected = table.find("www.example.com");
+ * @endcode
+ *
+ * When several servers declare the same name, the first one keeps it.
+ */
+class ServerNameTable {
+ public:
+    ServerNameTable();
+    ~ServerNameTable();
+
+    void add(const toolbox::SharedPtr<ServerConfig>& server, bool isDefault);
+
+    /**
+     * @brief The server for a Host value without port; case-insensitive.
+     */
+    toolbox::SharedPtr<ServerConfig> find(const std::string& host) const;
+
+ private:
+    struct LabelNode {
+        toolbox::SharedPtr<ServerConfig> server;
+        std::map<std::string, toolbox::SharedPtr<LabelNode> > children;
+    };
+
+    ServerNameTable(const ServerNameTable& other);
+    ServerNameTable& operator=(const ServerNameTable& other);
+
+    static void insert(LabelNode* root, const std::vector<std::string>& labels,
+                       const toolbox::SharedPtr<ServerConfig>& server);
+    static toolbox::SharedPtr<ServerConfig> findLongest(
+        const LabelNode& root, const std::vector<std::string>& labels);
+
+    std::map<std::string, toolbox::SharedPtr<ServerConfig> > _exactNames;
+    LabelNode _leadingWildcards;
+    LabelNode _trailingWildcards;
+    toolbox::SharedPtr<ServerConfig> _defaultServer;
+    bool _hasExplicitDefault;
+};
+
+/**
+ * @class VirtualHosts
+ * @brief Routing table from listening address to ServerNameTable.
+ *
+ * Built once per configuration. A server listening on 0.0.0.0 is also
+ * reachable through the other addresses bound on its port.
+ *
+ * Usage example:
+ * @code
+ * // when a connection is accepted
+ * client->setServerNames(virtualHosts.find(listenIp, listenPort));
+ * // for each of its requests
+ * selected = client->getServerNames()->find(hostName);
+ * @endcode
+ */
+class VirtualHosts {
+ public:
+    explicit VirtualHosts(const HttpConfig& httpConfig);
+    ~VirtualHosts();
+
+    toolbox::SharedPtr<ServerNameTable> find(const std::string& ip,
+                                             std::size_t port) const;
+
+ private:
+    typedef std::pair<std::string, std::size_t> Address;
+
+    VirtualHosts();
+    VirtualHosts(const VirtualHosts& other);
+    VirtualHosts& operator=(const VirtualHosts& other);
+
+    std::map<Address, toolbox::SharedPtr<ServerNameTable> > _tables;
+};
+
+}  // namespace config
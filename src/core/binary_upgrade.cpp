@@ -0,0 +1,184 @@
+// Copyright 2025 Ideal Broccoli
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "binary_upgrade.hpp"
+#include "../event/child_launcher.hpp"
+#include "../../toolbox/stepmark.hpp"
+#include "../../toolbox/string.hpp"
+
+extern char** environ;
+
+namespace {
+const char* LISTENERS_VARIABLE = "WEBSERV_LISTENERS";
+const char ENTRY_SEPARATOR = ';';
+const char FIELD_SEPARATOR = ':';
+
+// - "0.0.0.0:8080:5" -> ip, port and fd, split at the last two colons.
+bool parseEntry(const std::string& entry, std::string* ip, int* port,
+                int* fd) {
+    std::size_t fdPos = entry.rfind(FIELD_SEPARATOR);
+    if (fdPos == std::string::npos || fdPos == 0) {
+        return false;
+    }
+    std::size_t portPos = entry.rfind(FIELD_SEPARATOR, fdPos - 1);
+    if (portPos == std::string::npos) {
+        return false;
+    }
+    *ip = entry.substr(0, portPos);
+    *port = std::atoi(entry.substr(portPos + 1, fdPos - portPos - 1).c_str());
+    *fd = std::atoi(entry.substr(fdPos + 1).c_str());
+    return *port > 0 && *fd > STDERR_FILENO && fcntl(*fd, F_GETFD) != -1;
+}
+}  // namespace
+
+BinaryUpgrade::BinaryUpgrade() : _childPid(-1), _parentPid(-1) {
+}
+
+BinaryUpgrade::~BinaryUpgrade() {
+}
+
+BinaryUpgrade& BinaryUpgrade::getInstance() {
+    static BinaryUpgrade instance;
+    return instance;
+}
+
+void BinaryUpgrade::init(char* const* argv) {
+    BinaryUpgrade& upgrade = getInstance();
+    upgrade._argv.clear();
+    for (std::size_t i = 0; argv[i] != NULL; ++i) {
+        upgrade._argv.push_back(argv[i]);
+    }
+}
+
+// - The variable is removed so that it does not leak into a later upgrade
+//   or into the environment of anything else started from here.
+Listeners BinaryUpgrade::takeInheritedListeners() {
+    Listeners listeners;
+    const char* value = std::getenv(LISTENERS_VARIABLE);
+    if (value == NULL) {
+        return listeners;
+    }
+    std::string list(value);
+    unsetenv(LISTENERS_VARIABLE);
+    getInstance()._parentPid = getppid();
+    std::size_t start = 0;
+    while (start < list.size()) {
+        std::size_t end = list.find(ENTRY_SEPARATOR, start);
+        if (end == std::string::npos) {
+            end = list.size();
+        }
+        std::string ip;
+        int port;
+        int fd;
+        if (parseEntry(list.substr(start, end - start), &ip, &port, &fd)) {
+            listeners[ListenAddress(ip, port)] =
+                toolbox::SharedPtr<Server>(new Server(port, ip, fd));
+            toolbox::logger::StepMark::info("BinaryUpgrade: inherited listener "
+                + ip + ":" + toolbox::to_string(port));
+        }
+        start = end + 1;
+    }
+    return listeners;
+}
+
+// - Only the process that passed the sockets is told: if it is gone, the
+//   new parent is init or a subreaper, which must not get the signal.
+void BinaryUpgrade::notifyParent() {
+    BinaryUpgrade& upgrade = getInstance();
+    if (upgrade._parentPid == -1 || getppid() != upgrade._parentPid) {
+        return;
+    }
+    toolbox::logger::StepMark::info("BinaryUpgrade: serving, asking pid "
+        + toolbox::to_string(upgrade._parentPid) + " to drain");
+    kill(upgrade._parentPid, SIGQUIT);
+    upgrade._parentPid = -1;
+}
+
+std::string BinaryUpgrade::encodeListeners(const Listeners& listeners) {
+    std::string encoded;
+    for (Listeners::const_iterator it = listeners.begin();
+            it != listeners.end(); ++it) {
+        if (!encoded.empty()) {
+            encoded += ENTRY_SEPARATOR;
+        }
+        encoded += it->first.first + FIELD_SEPARATOR
+            + toolbox::to_string(it->first.second) + FIELD_SEPARATOR
+            + toolbox::to_string(it->second->getFd());
+    }
+    return encoded;
+}
+
+// - Listening sockets are close-on-exec so that CGIs never get them; the
+//   flag is lifted only while the new binary is being started.
+void BinaryUpgrade::setInheritable(const Listeners& listeners,
+                                   bool isInheritable) {
+    for (Listeners::const_iterator it = listeners.begin();
+            it != listeners.end(); ++it) {
+        fcntl(it->second->getFd(), F_SETFD, isInheritable ? 0 : FD_CLOEXEC);
+    }
+}
+
+bool BinaryUpgrade::start(const Listeners& listeners) {
+    BinaryUpgrade& upgrade = getInstance();
+    if (upgrade._childPid != -1) {
+        toolbox::logger::StepMark::warning(
+            "BinaryUpgrade: pid " + toolbox::to_string(upgrade._childPid)
+            + " is already starting");
+        return false;
+    }
+    if (upgrade._argv.empty()) {
+        return false;
+    }
+    std::string prefix = std::string(LISTENERS_VARIABLE) + "=";
+    std::vector<std::string> variables;
+    for (char** variable = environ; *variable != NULL; ++variable) {
+        if (std::strncmp(*variable, prefix.c_str(), prefix.size()) != 0) {
+            variables.push_back(*variable);
+        }
+    }
+    variables.push_back(prefix + encodeListeners(listeners));
+    std::vector<char*> envp;
+    for (std::size_t i = 0; i < variables.size(); ++i) {
+        envp.push_back(const_cast<char*>(variables[i].c_str()));
+    }
+    envp.push_back(NULL);
+    ChildLauncher launcher;
+    setInheritable(listeners, true);
+    pid_t pid = launcher.launch(upgrade._argv[0], upgrade._argv, &envp[0]);
+    setInheritable(listeners, false);
+    if (pid == -1) {
+        toolbox::logger::StepMark::error("BinaryUpgrade: cannot execute "
+                                         + upgrade._argv[0]);
+        return false;
+    }
+    ChildReaper::watch(pid, &upgrade);
+    upgrade._childPid = pid;
+    toolbox::logger::StepMark::info("BinaryUpgrade: started "
+        + upgrade._argv[0] + " as pid " + toolbox::to_string(pid));
+    return true;
+}
+
+void BinaryUpgrade::detach() {
+    BinaryUpgrade& upgrade = getInstance();
+    if (upgrade._childPid != -1) {
+        ChildReaper::forget(upgrade._childPid);
+        upgrade._childPid = -1;
+    }
+}
+
+void BinaryUpgrade::onChildExit(pid_t pid, int status) {
+    _childPid = -1;
+    toolbox::logger::StepMark::error("BinaryUpgrade: new binary (pid "
+        + toolbox::to_string(pid) + ") exited with status "
+        + toolbox::to_string(WIFEXITED(status) ? WEXITSTATUS(status) : -1)
+        + "; this one keeps serving");
+}
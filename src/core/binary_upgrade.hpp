@@ -0,0 +1,79 @@
+// Copyright 2025 Ideal Broccoli
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <string>
+#include <vector>
+
+#include "server.hpp"
+#include "../event/child_reaper.hpp"
+
+/**
+ * @brief Replaces the running binary without closing the listening sockets.
+ *
+ * On SIGUSR2 the server starts its own command line again, with the
+ * listening sockets left open across execve() and listed in the
+ * WEBSERV_LISTENERS environment variable as "ip:port:fd" entries. The new
+ * process adopts the sockets of the addresses it is configured for instead
+ * of binding them, so connections keep being accepted throughout. Once it
+ * serves, it sends SIGQUIT to the old process, which stops accepting and
+ * exits when its last connection is done. If the new process exits before
+ * that, the old one simply keeps running.
+ *
+ * Usage example:
+ * @code
+ * BinaryUpgrade::init(argv);
+ * Listeners inherited = BinaryUpgrade::takeInheritedListeners();
+ * // ... bind the other addresses, start serving, then:
+ * BinaryUpgrade::notifyParent();
+ * // ... on SIGUSR2:
+ * BinaryUpgrade::start(listeners);
+ * @endcode
+ *
+ * The command is executed as given on the command line, so a relative
+ * path resolves against the directory the server was started in.
+ */
+class BinaryUpgrade : public ChildExitListener {
+ public:
+    static void init(char* const* argv);
+
+    /**
+     * @brief The sockets passed by the process that started this one;
+     * those left unused are closed with the returned map.
+     */
+    static Listeners takeInheritedListeners();
+
+    /**
+     * @brief Tells the process that passed the sockets to drain, if any.
+     */
+    static void notifyParent();
+
+    /**
+     * @brief Starts the new binary.
+     * @return false if one is already starting or it could not be started.
+     */
+    static bool start(const Listeners& listeners);
+
+    /**
+     * @brief Lets a started binary outlive this process, which is exiting.
+     */
+    static void detach();
+
+    virtual void onChildExit(pid_t pid, int status);
+
+ private:
+    BinaryUpgrade();
+    virtual ~BinaryUpgrade();
+    BinaryUpgrade(const BinaryUpgrade& other);
+    BinaryUpgrade& operator=(const BinaryUpgrade& other);
+
+    static BinaryUpgrade& getInstance();
+    static std::string encodeListeners(const Listeners& listeners);
+    static void setInheritable(const Listeners& listeners, bool isInheritable);
+
+    std::vector<std::string> _argv;
+    pid_t _childPid;
+    pid_t _parentPid;     // passed the sockets; -1 once told or if none
+};
@@ -3,6 +3,7 @@
 #include "client.hpp"
 
 #include <sys/socket.h>
+#include <sys/epoll.h>
 #include <unistd.h>
 #include <iostream>
 #include <string>
@@ -15,14 +16,23 @@ Client::Client(int fd, const struct sockaddr_in& client_addr,
             socklen_t client_addr_len) :
             _socket_fd(fd), _client_addr(client_addr),
             _client_addr_len(client_addr_len),
+            _hasServerAddr(false),
             _lastAccessTime(std::time(NULL)) {
+    socklen_t server_addr_len = sizeof(_server_addr);
+    if (getsockname(_socket_fd, (struct sockaddr*)&_server_addr,
+                    &server_addr_len) == 0) {
+        _hasServerAddr = true;
+    }
 }
 
 Client::Client(const Client& other): _socket_fd(other._socket_fd),
     _client_addr(other._client_addr),
     _client_addr_len(other._client_addr_len),
+    _server_addr(other._server_addr),
+    _hasServerAddr(other._hasServerAddr),
     _lastAccessTime(other._lastAccessTime),
-    _request(other._request) {
+    _request(other._request),
+    _serverNames(other._serverNames) {
 }
 
 Client& Client::operator=(const Client& other) {
@@ -30,8 +40,11 @@ Client& Client::operator=(const Client& other) {
         _socket_fd = other._socket_fd;
         _client_addr = other._client_addr;
         _client_addr_len = other._client_addr_len;
+        _server_addr = other._server_addr;
+        _hasServerAddr = other._hasServerAddr;
         _lastAccessTime = other._lastAccessTime;
         _request = other._request;
+        _serverNames = other._serverNames;
     }
     return *this;
 }
@@ -64,27 +77,19 @@ std::string Client::getIp() const {
     return convertIpToString(ip);
 }
 
+// - The local address of an accepted socket never changes, so the
+//   constructor asks for it once instead of every request.
 std::string Client::getServerIp() const {
-    struct sockaddr_in addr;
-    socklen_t addr_len = sizeof(addr);
-
-    if (getsockname(_socket_fd,
-                    (struct sockaddr*)&addr,
-                    &addr_len) == 0) {
-        uint32_t ip = ntohl(addr.sin_addr.s_addr);
-        return convertIpToString(ip);
+    if (_hasServerAddr) {
+        return convertIpToString(ntohl(_server_addr.sin_addr.s_addr));
     }
     toolbox::logger::StepMark::error("Failed to get server IP address");
     return "";
 }
 
 std::size_t Client::getServerPort() const {
-    struct sockaddr_in addr;
-    socklen_t addr_len = sizeof(addr);
-    if (getsockname(_socket_fd,
-                    (struct sockaddr*)&addr,
-                    &addr_len) == 0) {
-        return ntohs(addr.sin_port);
+    if (_hasServerAddr) {
+        return ntohs(_server_addr.sin_port);
     }
     toolbox::logger::StepMark::error("Failed to get server port");
     return 0;
@@ -111,8 +116,11 @@ bool Client::isResponseSending() const {
 }
 
 bool Client::isCgiProcessing() const {
-    return _request->getIOPendingState() == http::CGI_BODY_SENDING
+    return _request->getIOPendingState() == http::CGI_CACHE_WAITING
+        || _request->getIOPendingState() == http::CGI_QUEUED
+        || _request->getIOPendingState() == http::CGI_BODY_SENDING
         || _request->getIOPendingState() == http::CGI_OUTPUT_READING
+        || _request->getIOPendingState() == http::CGI_OUTPUT_STREAMING
         || _request->getIOPendingState() == http::CGI_LOCAL_REDIRECT_IO_PENDING;
 }
 
@@ -120,6 +128,35 @@ bool Client::isClientTimedOut() const {
     return std::time(NULL) - _lastAccessTime > core::CLIENT_TIMEOUT_SECONDS;
 }
 
+bool Client::isCgiTimedOut() const {
+    return _request->isCgiTimedOut();
+}
+
+// - While a CGI runs or waits for a slot the socket only watches for a
+//   hangup; progress comes from the CGI pipes, except that a request body
+//   still being fed to the CGI is read while the CGI has room for it. A
+//   stream waits for EPOLLOUT only while it has output queued, so an idle
+//   stream does not spin the loop.
+uint32_t Client::getEventInterest() const {
+    http::IOPendingState state = _request->getIOPendingState();
+    if (state == http::RESPONSE_SENDING) {
+        return EPOLLOUT | EPOLLRDHUP;
+    }
+    if (state == http::CGI_OUTPUT_STREAMING) {
+        if (_request->hasPendingOutput()) {
+            return EPOLLOUT | EPOLLRDHUP;
+        }
+        return EPOLLRDHUP;
+    }
+    if (_request->wantsRequestBody()) {
+        return EPOLLIN | EPOLLRDHUP;
+    }
+    if (isCgiProcessing() || state == http::ERROR_LOCAL_REDIRECT_IO_PENDING) {
+        return EPOLLRDHUP;
+    }
+    return EPOLLIN | EPOLLRDHUP;
+}
+
 std::string Client::convertIpToString(uint32_t ip) const {
     return toolbox::to_string((ip >> 24) & 0xFF) + "." +
             toolbox::to_string((ip >> 16) & 0xFF) + "." +
@@ -3,12 +3,14 @@
 #pragma once
 
 #include <netinet/in.h>
+#include <stdint.h>
 
 #include <exception>
 #include <string>
 #include <ctime>
 
 #include "../../toolbox/shared.hpp"
+#include "../config/config_vhost.hpp"
 #include "constant.hpp"
 
 namespace http {
@@ -42,10 +44,19 @@ class Client {
 
     toolbox::SharedPtr<http::Request> getRequest() const;
     void setRequest(const toolbox::SharedPtr<http::Request> request);
+    const toolbox::SharedPtr<config::ServerNameTable>& getServerNames() const {
+        return _serverNames;
+    }
+    void setServerNames(
+        const toolbox::SharedPtr<config::ServerNameTable>& serverNames) {
+        _serverNames = serverNames;
+    }
     bool isBadRequest() const;
     bool isResponseSending() const;
     bool isCgiProcessing() const;
     bool isClientTimedOut() const;
+    bool isCgiTimedOut() const;
+    uint32_t getEventInterest() const;
 
  private:
     Client();
@@ -53,8 +64,11 @@ class Client {
     int _socket_fd;
     struct sockaddr_in _client_addr;
     socklen_t _client_addr_len;
+    struct sockaddr_in _server_addr;    // local end, looked up once
+    bool _hasServerAddr;
     time_t _lastAccessTime;
     toolbox::SharedPtr<http::Request> _request;
+    toolbox::SharedPtr<config::ServerNameTable> _serverNames;   // of the listener; pins its config
 
     std::string convertIpToString(uint32_t ip) const;
 };
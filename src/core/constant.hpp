@@ -6,5 +6,8 @@
 
 namespace core {
     const std::size_t IO_BUFFER_SIZE = 16 * 1024; // 16 KB
+    const std::size_t SENDFILE_CHUNK_SIZE = 256 * 1024; // 256 KB
+    const std::size_t SPLICE_CHUNK_SIZE = 64 * 1024; // a full pipe
     const long int CLIENT_TIMEOUT_SECONDS = 60; // 60 seconds
+    const long int CHILD_KILL_GRACE_SECONDS = 3; // SIGTERM -> SIGKILL
 }
@@ -5,27 +5,214 @@
 #include <fcntl.h>
 #include <sys/epoll.h>
 #include <unistd.h>
+#include <csignal>
+#include <ctime>
 #include <string>
 #include <iostream>
 #include <cstdio>
 #include <sstream>
 #include <cstring>
-#include <set>
+#include <map>
 #include <utility>
+#include <vector>
 
 #include "server.hpp"
 #include "client.hpp"
+#include "binary_upgrade.hpp"
+#include "metrics.hpp"
 #include "constant.hpp"
 #include "../config/config_namespace.hpp"
 #include "../config/config_parser.hpp"
 #include "../event/epoll.hpp"
 #include "../event/tagged_epoll_event.hpp"
+#include "../event/child_reaper.hpp"
+#include "../event/control_signal.hpp"
 #include "../../toolbox/string.hpp"
 #include "../../toolbox/shared.hpp"
+#include "../../toolbox/stepmark.hpp"
+#include "../../toolbox/access.hpp"
 #include "../http/request/request.hpp"
 #include "../http/request/io_pending_state.hpp"
+#include "../http/fastcgi/fastcgi_pool.hpp"
+#include "../http/cgi/cgi_environment.hpp"
+#include "../http/cgi/cgi_limiter.hpp"
+#include "../http/cgi/cgi_response_cache.hpp"
+
+namespace {
+void closeClient(const toolbox::SharedPtr<Client>& client) {
+    client->getRequest()->terminateActiveCgiProcesses();
+    Epoll::del(client->getFd());
+}
+
+// - Runs the request and then narrows the socket's interest to what the
+//   new state waits for, so level-triggered epoll does not spin on it.
+void driveClient(const toolbox::SharedPtr<Client>& client) {
+    client->setLastAccessTime();
+    client->getRequest()->run();
+    if (client->getRequest()->getIOPendingState() == http::END_RESPONSE) {
+        closeClient(client);
+        return;
+    }
+    Epoll::modify(client->getFd(), client->getEventInterest());
+}
+
+// - Clients whose FastCGI request made progress, whose queued CGI got a
+//   slot or whose cached response was filled. The fd may have been closed
+//   and reused meanwhile, so only clients still waiting on a CGI are run.
+//   Running one may queue wakeups for others, hence the loop.
+std::vector<int> takeReadyClients() {
+    std::vector<int> ready = http::FastcgiPool::takeReadyClients();
+    std::vector<int> admitted = http::CgiLimiter::takeReadyClients();
+    std::vector<int> filled = http::CgiResponseCache::takeReadyClients();
+    ready.insert(ready.end(), admitted.begin(), admitted.end());
+    ready.insert(ready.end(), filled.begin(), filled.end());
+    return ready;
+}
+
+void driveReadyClients() {
+    std::vector<int> ready = takeReadyClients();
+    while (!ready.empty()) {
+        for (std::size_t i = 0; i < ready.size(); ++i) {
+            toolbox::SharedPtr<Client> client = Epoll::findClient(ready[i]);
+            if (!client || !client->isCgiProcessing()) {
+                continue;
+            }
+            try {
+                driveClient(client);
+            } catch (std::exception& e) {
+                toolbox::logger::StepMark::error("Main: ready client: " + std::string(e.what()));
+                closeClient(client);
+            }
+        }
+        ready = takeReadyClients();
+    }
+}
+
+// - Addresses that are already listened on keep their socket; the others
+//   are bound here. Nothing is registered yet, so if one cannot be bound
+//   the sockets opened so far are closed and the running set is intact.
+Listeners bindListeners(const config::HttpConfig& httpConfig,
+                        const Listeners& current) {
+    Listeners listeners;
+    for (std::size_t i = 0; i < httpConfig.getServers().size(); ++i) {
+        toolbox::SharedPtr<config::ServerConfig> serverConfig =
+                                                httpConfig.getServers()[i];
+        for (std::size_t j = 0; j < serverConfig->getListens().size(); ++j) {
+            int port = serverConfig->getListens()[j].getPort();
+            std::string ip = serverConfig->getListens()[j].getIp();
+            ListenAddress address(ip, port);
+            if (listeners.find(address) != listeners.end()) {
+                continue;
+            }
+            Listeners::const_iterator reused = current.find(address);
+            if (reused != current.end()) {
+                listeners[address] = reused->second;
+                continue;
+            }
+            toolbox::SharedPtr<Server> server(new Server(port, ip));
+            server->setName(
+                serverConfig->getServerNames()[0].getName());
+            listeners[address] = server;
+        }
+    }
+    return listeners;
+}
+
+void switchListeners(const Listeners& next, Listeners* current) {
+    for (Listeners::const_iterator it = next.begin(); it != next.end(); ++it) {
+        if (current->find(it->first) == current->end()) {
+            Epoll::addServer(it->second->getFd(), it->second);
+        }
+    }
+    for (Listeners::iterator it = current->begin(); it != current->end(); ++it) {
+        if (next.find(it->first) == next.end()) {
+            toolbox::logger::StepMark::info("Main: closing listener "
+                + it->first.first + ":" + toolbox::to_string(it->first.second));
+            Epoll::del(it->second->getFd());
+        }
+    }
+    *current = next;
+}
+
+void applyLogBuffer(const config::HttpConfig& httpConfig) {
+    const config::LogBuffer& logBuffer = httpConfig.getLogBuffer();
+    toolbox::logger::LogWriter::Overflow overflow = logBuffer.isBlocking()
+        ? toolbox::logger::LogWriter::BLOCK : toolbox::logger::LogWriter::DROP;
+    toolbox::logger::StepMark::setBuffering(logBuffer.getSize(),
+        static_cast<time_t>(logBuffer.getFlushInterval()), overflow);
+    toolbox::logger::AccessLog::setBuffering(logBuffer.getSize(),
+        static_cast<time_t>(logBuffer.getFlushInterval()), overflow);
+}
+
+// - Connections already accepted finish with the configuration they
+//   started with; only new ones see the reloaded one.
+void reloadConfig(Listeners* listeners) {
+    toolbox::logger::StepMark::info("Main: reloading "
+                                    + config::Config::getConfigFile());
+    toolbox::SharedPtr<config::HttpConfig> httpConfig;
+    Listeners next;
+    try {
+        httpConfig = config::Config::parseConfig(config::Config::getConfigFile());
+        next = bindListeners(*httpConfig, *listeners);
+    } catch (std::exception& e) {
+        toolbox::logger::StepMark::error("Main: reload failed, keeping configuration "
+            + toolbox::to_string(config::Config::getGeneration()) + ": " + e.what());
+        return;
+    }
+    config::Config::installConfig(httpConfig);
+    applyLogBuffer(*httpConfig);
+    toolbox::logger::AccessLog::reopen();
+    http::CgiEnvironment::prepare(*httpConfig);
+    http::CgiResponseCache::clear();
+    switchListeners(next, listeners);
+}
+
+// - Draining closes the listeners; the loop ends with the last client or
+//   at the deadline. A binary started by SIGUSR2 keeps running.
+void startDraining(Listeners* listeners, std::size_t timeout,
+                   time_t* drainDeadline) {
+    toolbox::logger::StepMark::info("Main: draining "
+        + toolbox::to_string(Epoll::getClientCount())
+        + " connections for up to " + toolbox::to_string(timeout) + "s");
+    BinaryUpgrade::detach();
+    switchListeners(Listeners(), listeners);
+    *drainDeadline = std::time(NULL) + static_cast<time_t>(timeout);
+}
+
+// - SIGINT still cuts a drain short, and SIGUSR1 still reopens the logs;
+//   anything else is ignored once draining.
+void handleControlSignals(Listeners* listeners, bool* isDraining,
+                          time_t* drainDeadline) {
+    std::vector<int> signals = ControlSignal::takeSignals();
+    for (std::size_t i = 0; i < signals.size(); ++i) {
+        if (signals[i] == SIGINT) {
+            startDraining(listeners, 0, drainDeadline);
+            *isDraining = true;
+        } else if (signals[i] == SIGUSR1) {
+            toolbox::logger::StepMark::info("Main: reopening the log files");
+            toolbox::logger::StepMark::reopen();
+            toolbox::logger::AccessLog::reopen();
+        } else if (*isDraining) {
+            continue;
+        } else if (signals[i] == SIGHUP) {
+            reloadConfig(listeners);
+        } else if (signals[i] == SIGUSR2) {
+            BinaryUpgrade::start(*listeners);
+        } else if (signals[i] == SIGQUIT || signals[i] == SIGTERM) {
+            startDraining(listeners,
+                config::Config::getHttpConfig()->getShutdownTimeout(),
+                drainDeadline);
+            *isDraining = true;
+        }
+    }
+}
+}  // namespace
 
 int main(int argc, char* argv[]) {
+    // A peer that resets mid-response must surface as EPIPE from
+    // send()/sendfile(), not kill the whole server.
+    std::signal(SIGPIPE, SIG_IGN);
+    BinaryUpgrade::init(argv);
     try {
         if (argc == 1) {
             config::Config::loadConfig(config::DEFAULT_FILE);
@@ -37,84 +224,114 @@ int main(int argc, char* argv[]) {
         }
         toolbox::SharedPtr<config::HttpConfig> httpConfig =
                                         config::Config::getHttpConfig();
-        std::vector<toolbox::SharedPtr<Server> > servers;
-        std::set<std::pair<std::string, int> > boundAddresses;
-        for (std::size_t i = 0; i < httpConfig->getServers().size(); ++i) {
-            toolbox::SharedPtr<config::ServerConfig> serverConfig =
-                                                    httpConfig->getServers()[i];
-            for (std::size_t j = 0; j < serverConfig->getListens().size(); ++j) {
-                int port = serverConfig->getListens()[j].getPort();
-                std::string ip = serverConfig->getListens()[j].getIp();
-                std::pair<std::string, int> address(ip, port);
-                if (boundAddresses.find(address) != boundAddresses.end()) {
-                    continue;
-                }
-                toolbox::SharedPtr<Server> server(new Server(port, ip));
-                server->setName(
-                    serverConfig->getServerNames()[0].getName());
-                Epoll::addServer(server->getFd(), server);
-                servers.push_back(server);
-                boundAddresses.insert(address);
-            }
-        }
+        applyLogBuffer(*httpConfig);
+        http::CgiEnvironment::prepare(*httpConfig);
+        Listeners listeners;
+        switchListeners(bindListeners(*httpConfig,
+                                      BinaryUpgrade::takeInheritedListeners()),
+                        &listeners);
+        Epoll::addSignal(ChildReaper::init());
+        Epoll::addSignal(ControlSignal::init());
+        BinaryUpgrade::notifyParent();
+        bool isDraining = false;
+        time_t drainDeadline = 0;
         struct epoll_event events[1000];
-        while (1) {
+        while (!isDraining || (Epoll::getClientCount() > 0
+                               && std::time(NULL) < drainDeadline)) {
             try {
                 Epoll::checkClientTimeouts();
+                ChildReaper::checkDeadlines();
+                http::FastcgiPool::checkDeadlines();
+                http::CgiLimiter::checkDeadlines();
+                toolbox::logger::StepMark::flush();
+                toolbox::logger::AccessLog::flush();
                 int nfds = Epoll::wait(events, 1000, 1000);
                 if (nfds == -1) {
                     throw std::runtime_error("epoll_wait failed");
                 }
+                Metrics::startIteration();
+                std::vector<toolbox::SharedPtr<Client> > cgiTimedOut =
+                    Epoll::getCgiTimedOutClients();
+                for (std::size_t i = 0; i < cgiTimedOut.size(); ++i) {
+                    try {
+                        driveClient(cgiTimedOut[i]);
+                    } catch (std::exception& e) {
+                        toolbox::logger::StepMark::error("Main: cgi timeout: " + std::string(e.what()));
+                        closeClient(cgiTimedOut[i]);
+                    }
+                }
                 for (int i = 0; i < nfds; i++) {
                     taggedEventData* tagged =
                         static_cast<taggedEventData*>(events[i].data.ptr);
-                    if (tagged->server) {
+                    if (!tagged->active) {
+                        continue;
+                    }
+                    if (tagged->type == taggedEventData::SERVER) {
                         try {
                             toolbox::SharedPtr<Server> server = tagged->server;
                             struct sockaddr_in client_addr;
                             socklen_t addr_len = sizeof(client_addr);
-                            int client_sock = accept(server->getFd(), (struct sockaddr*)&client_addr, &addr_len);
+                            // - Close-on-exec, or a CGI or an upgraded binary
+                            //   would hold the connection open after us.
+                            int client_sock = accept4(server->getFd(), (struct sockaddr*)&client_addr, &addr_len, SOCK_CLOEXEC);
                             if (client_sock == -1) {
                                 throw std::runtime_error("accept failed");
                             }
+                            Metrics::connectionAccepted();
                             toolbox::SharedPtr<Client> client(new Client(client_sock, client_addr, addr_len));
+                            client->setServerNames(config::Config::getVirtualHosts()->find(
+                                server->getIp(), server->getPort()));
                             client->setRequest(toolbox::SharedPtr<http::Request>(new http::Request(client.get())));
                             Epoll::addClient(client_sock, client);
+                            Metrics::connectionHandled();
                         } catch(std::exception& e) {
                             toolbox::logger::StepMark::error("Main: server: " + std::string(e.what()));
                         }
+                    } else if (tagged->type == taggedEventData::SIGNAL) {
+                        if (tagged->fd == ControlSignal::getFd()) {
+                            handleControlSignals(&listeners, &isDraining,
+                                                 &drainDeadline);
+                        } else {
+                            ChildReaper::handleSignal();
+                        }
+                    } else if (tagged->type == taggedEventData::UPSTREAM) {
+                        http::FastcgiPool::handleEvent(tagged->fd, events[i].events);
+                    } else if (tagged->type == taggedEventData::CGI_PIPE) {
+                        toolbox::SharedPtr<Client> client = tagged->client;
+                        try {
+                            driveClient(client);
+                        } catch (std::exception& e) {
+                            toolbox::logger::StepMark::error("Main: cgi: " + std::string(e.what()));
+                            closeClient(client);
+                        }
                     } else {
+                        toolbox::SharedPtr<Client> client = tagged->client;
                         try {
-                            toolbox::SharedPtr<Client> client = tagged->client;
-                            int client_sock = client->getFd();
-
                             if (isSocketDisconnected(events[i])) {
-                                if (client->isCgiProcessing()) {
-                                    client->getRequest()->terminateActiveCgiProcesses();
-                                }
-                                Epoll::del(client_sock);
-                                continue;
+                                closeClient(client);
                             } else if ((events[i].events & EPOLLOUT && (client->isResponseSending() || client->isCgiProcessing()))
                                 || (events[i].events & EPOLLIN && !client->isResponseSending())) {
-                                client->setLastAccessTime();
-                                client->getRequest()->run();
-                            }
-
-                            if (client->getRequest()->getIOPendingState() == http::END_RESPONSE) {
-                                Epoll::del(client_sock);
+                                driveClient(client);
                             }
                         } catch (std::exception& e) {
                             toolbox::logger::StepMark::error("Main: client: " + std::string(e.what()));
+                            closeClient(client);
                         }
                     }
                 }
+                driveReadyClients();
+                Metrics::finishIteration();
             } catch (std::exception& e) {
                 toolbox::logger::StepMark::error("Main: whileloop: " + std::string(e.what()));
             }
         }
-        for (std::size_t i = 0; i < servers.size(); ++i) {
-            Epoll::del(servers[i]->getFd());
+        if (Epoll::getClientCount() > 0) {
+            toolbox::logger::StepMark::warning("Main: closing "
+                + toolbox::to_string(Epoll::getClientCount())
+                + " unfinished connections");
         }
+        ChildReaper::terminateAll();
+        toolbox::logger::StepMark::info("Main: exiting");
     } catch (std::exception& e) {
         std::cerr << e.what() << std::endl;
         return EXIT_FAILURE;
@@ -0,0 +1,258 @@
+// Copyright 2025 Ideal Broccoli
+
+#include "metrics.hpp"
+
+#include <stdint.h>
+
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "client.hpp"
+#include "../event/epoll.hpp"
+#include "../event/child_reaper.hpp"
+#include "../http/request/request.hpp"
+#include "../http/request/io_pending_state.hpp"
+#include "../http/cgi/cgi_limiter.hpp"
+#include "../http/cgi/cgi_response_cache.hpp"
+#include "../../toolbox/clock.hpp"
+#include "../../toolbox/shared.hpp"
+
+namespace {
+const double ITERATION_BOUNDS[] = {
+    0.0001, 0.0005, 0.001, 0.005, 0.01, 0.05, 0.1, 0.5, 1
+};
+// - Roughly logarithmic, so that both fast static files and slow CGI
+//   requests keep their resolution.
+const double LATENCY_BOUNDS[] = {
+    0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5,
+    1, 2.5, 5, 10, 30, 60
+};
+const std::size_t LATENCY_BOUND_COUNT =
+    sizeof(LATENCY_BOUNDS) / sizeof(LATENCY_BOUNDS[0]);
+const char* STATUS_CLASSES[] = {"1xx", "2xx", "3xx", "4xx", "5xx"};
+
+void describe(std::ostringstream* out, const std::string& name,
+              const std::string& type, const std::string& help) {
+    *out << "# HELP " << name << " " << help << "\n"
+         << "# TYPE " << name << " " << type << "\n";
+}
+
+template <typename T>
+void sample(std::ostringstream* out, const std::string& name,
+            const std::string& labels, T value) {
+    *out << name;
+    if (!labels.empty()) {
+        *out << "{" << labels << "}";
+    }
+    *out << " " << value << "\n";
+}
+
+std::string escapeLabel(const std::string& value) {
+    std::string escaped;
+    for (std::size_t i = 0; i < value.size(); ++i) {
+        if (value[i] == '\\' || value[i] == '"') {
+            escaped += '\\';
+            escaped += value[i];
+        } else if (value[i] == '\n') {
+            escaped += "\\n";
+        } else {
+            escaped += value[i];
+        }
+    }
+    return escaped;
+}
+}  // namespace
+
+Metrics::Latency::Latency()
+    : request(LATENCY_BOUNDS, LATENCY_BOUND_COUNT),
+      firstByte(LATENCY_BOUNDS, LATENCY_BOUND_COUNT),
+      upstream(LATENCY_BOUNDS, LATENCY_BOUND_COUNT) {
+}
+
+Metrics::Metrics()
+    : _accepted(0), _handled(0), _bytesReceived(0), _bytesSent(0),
+      _iterationStart(0),
+      _iterations(ITERATION_BOUNDS,
+                  sizeof(ITERATION_BOUNDS) / sizeof(ITERATION_BOUNDS[0])),
+      _phases(http::RequestTimer::PHASE_COUNT,
+              toolbox::Histogram(LATENCY_BOUNDS, LATENCY_BOUND_COUNT)) {
+    for (std::size_t i = 0; i < STATUS_CLASS_COUNT; ++i) {
+        _requests[i] = 0;
+    }
+}
+
+Metrics::~Metrics() {
+}
+
+Metrics& Metrics::getInstance() {
+    static Metrics instance;
+    return instance;
+}
+
+void Metrics::connectionAccepted() {
+    ++getInstance()._accepted;
+}
+
+void Metrics::connectionHandled() {
+    ++getInstance()._handled;
+}
+
+// - Statuses outside 100-599 are not counted in any class. Phases the
+//   request never entered are not observed.
+void Metrics::requestFinished(int status, const std::string& location,
+                              const http::RequestTimer& timer) {
+    Metrics& metrics = getInstance();
+    int statusClass = status / 100 - 1;
+    if (statusClass >= INFORMATIONAL && statusClass < STATUS_CLASS_COUNT) {
+        ++metrics._requests[statusClass];
+    }
+    if (!timer.isStarted()) {
+        return;
+    }
+    Latency& latency = metrics._latencies[location];
+    latency.request.observe(timer.getRequestTime());
+    if (timer.getFirstByteTime() >= 0) {
+        latency.firstByte.observe(timer.getFirstByteTime());
+    }
+    if (timer.getUpstreamTime() >= 0) {
+        latency.upstream.observe(timer.getUpstreamTime());
+    }
+    for (std::size_t i = 0; i < http::RequestTimer::PHASE_COUNT; ++i) {
+        double spent = timer.getPhaseTime(
+            static_cast<http::RequestTimer::Phase>(i));
+        if (spent > 0) {
+            metrics._phases[i].observe(spent);
+        }
+    }
+}
+
+void Metrics::bytesReceived(std::size_t bytes) {
+    getInstance()._bytesReceived += bytes;
+}
+
+void Metrics::bytesSent(std::size_t bytes) {
+    getInstance()._bytesSent += bytes;
+}
+
+void Metrics::startIteration() {
+    getInstance()._iterationStart = toolbox::getMonotonicSeconds();
+}
+
+void Metrics::finishIteration() {
+    Metrics& metrics = getInstance();
+    metrics._iterations.observe(
+        toolbox::getMonotonicSeconds() - metrics._iterationStart);
+}
+
+std::string Metrics::renderLatency(const std::string& name,
+                                   toolbox::Histogram Latency::* histogram) {
+    Metrics& metrics = getInstance();
+    std::string out;
+    for (std::map<std::string, Latency>::const_iterator it =
+            metrics._latencies.begin(); it != metrics._latencies.end(); ++it) {
+        out += (it->second.*histogram).render(name,
+            "location=\"" + escapeLabel(it->first) + "\"");
+    }
+    return out;
+}
+
+// - A connection is waiting until its first bytes arrive, reading while
+//   the request comes in, and writing from then on, CGI included, as in
+//   nginx's stub_status.
+std::string Metrics::render() {
+    Metrics& metrics = getInstance();
+    std::vector<toolbox::SharedPtr<Client> > clients = Epoll::getClients();
+    std::size_t reading = 0;
+    std::size_t waiting = 0;
+    for (std::size_t i = 0; i < clients.size(); ++i) {
+        const http::Request& request = *clients[i]->getRequest();
+        if (!request.isStarted()) {
+            ++waiting;
+        } else if (request.getIOPendingState() == http::START_READING
+                || request.getIOPendingState() == http::REQUEST_READING) {
+            ++reading;
+        }
+    }
+    http::CgiResponseCache::Stats cache = http::CgiResponseCache::getStats();
+
+    std::ostringstream out;
+    describe(&out, "webserv_connections_accepted_total", "counter",
+             "Client connections accepted.");
+    sample(&out, "webserv_connections_accepted_total", "", metrics._accepted);
+    describe(&out, "webserv_connections_handled_total", "counter",
+             "Accepted connections that were registered for serving.");
+    sample(&out, "webserv_connections_handled_total", "", metrics._handled);
+    describe(&out, "webserv_connections_active", "gauge",
+             "Client connections open now.");
+    sample(&out, "webserv_connections_active", "", clients.size());
+    describe(&out, "webserv_connections", "gauge",
+             "Client connections open now, by state.");
+    sample(&out, "webserv_connections", "state=\"reading\"", reading);
+    sample(&out, "webserv_connections", "state=\"writing\"",
+           clients.size() - reading - waiting);
+    sample(&out, "webserv_connections", "state=\"waiting\"", waiting);
+    describe(&out, "webserv_requests_total", "counter",
+             "Responses finished, by status class.");
+    for (std::size_t i = 0; i < STATUS_CLASS_COUNT; ++i) {
+        sample(&out, "webserv_requests_total",
+               "class=\"" + std::string(STATUS_CLASSES[i]) + "\"",
+               metrics._requests[i]);
+    }
+    describe(&out, "webserv_received_bytes_total", "counter",
+             "Bytes read from client connections.");
+    sample(&out, "webserv_received_bytes_total", "", metrics._bytesReceived);
+    describe(&out, "webserv_sent_bytes_total", "counter",
+             "Bytes written to client connections.");
+    sample(&out, "webserv_sent_bytes_total", "", metrics._bytesSent);
+    describe(&out, "webserv_child_processes", "gauge",
+             "CGI and cgi_pool processes not reaped yet.");
+    sample(&out, "webserv_child_processes", "",
+           ChildReaper::getChildCount());
+    describe(&out, "webserv_cgi_queued_requests", "gauge",
+             "CGI requests waiting for a cgi_max_concurrency slot.");
+    sample(&out, "webserv_cgi_queued_requests", "",
+           http::CgiLimiter::getQueueDepth());
+    describe(&out, "webserv_cgi_cache_lookups_total", "counter",
+             "cgi_cache lookups, by result.");
+    sample(&out, "webserv_cgi_cache_lookups_total", "result=\"hit\"",
+           cache.hits);
+    sample(&out, "webserv_cgi_cache_lookups_total", "result=\"miss\"",
+           cache.misses);
+    sample(&out, "webserv_cgi_cache_lookups_total", "result=\"wait\"",
+           cache.waits);
+    sample(&out, "webserv_cgi_cache_lookups_total", "result=\"bypass\"",
+           cache.bypasses);
+    describe(&out, "webserv_cgi_cache_entries", "gauge",
+             "Responses stored by cgi_cache.");
+    sample(&out, "webserv_cgi_cache_entries", "", cache.entries);
+    describe(&out, "webserv_cgi_cache_bytes", "gauge",
+             "Memory used by the responses stored by cgi_cache.");
+    sample(&out, "webserv_cgi_cache_bytes", "", cache.size);
+    describe(&out, "webserv_loop_iteration_seconds", "histogram",
+             "Time spent handling the events of one event-loop iteration.");
+    out << metrics._iterations.render("webserv_loop_iteration_seconds", "");
+    describe(&out, "webserv_request_duration_seconds", "histogram",
+             "Time from the first request byte to the last response byte, "
+             "by location.");
+    out << renderLatency("webserv_request_duration_seconds",
+                         &Latency::request);
+    describe(&out, "webserv_request_first_byte_seconds", "histogram",
+             "Time from the first request byte to the first response byte, "
+             "by location.");
+    out << renderLatency("webserv_request_first_byte_seconds",
+                         &Latency::firstByte);
+    describe(&out, "webserv_upstream_response_seconds", "histogram",
+             "Time a CGI or FastCGI process took to respond, by location.");
+    out << renderLatency("webserv_upstream_response_seconds",
+                         &Latency::upstream);
+    describe(&out, "webserv_request_phase_seconds", "histogram",
+             "Time requests spent in each phase.");
+    for (std::size_t i = 0; i < http::RequestTimer::PHASE_COUNT; ++i) {
+        out << metrics._phases[i].render("webserv_request_phase_seconds",
+            "phase=\"" + std::string(http::RequestTimer::getPhaseName(
+                static_cast<http::RequestTimer::Phase>(i))) + "\"");
+    }
+    return out.str();
+}
@@ -0,0 +1,92 @@
+// Copyright 2025 Ideal Broccoli
+
+#pragma once
+
+#include <stdint.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "../http/request/request_timer.hpp"
+#include "../../toolbox/histogram.hpp"
+
+/**
+ * @brief Counts what the server does, for the stub_status endpoint.
+ *
+ * The event loop and the request code report events as they happen;
+ * gauges such as the connections by state, the child processes and the
+ * CGI cache are read from their owners only when the page is rendered.
+ * render() produces the Prometheus text exposition format.
+ *
+ * Finished requests also feed latency histograms: the total, the time to
+ * the first byte and the CGI time by location, and each phase overall.
+ *
+ * Usage example:
+ * @code
+ * Metrics::connectionAccepted();
+ * // ... once the connection is registered:
+ * Metrics::connectionHandled();
+ * // ... in a location with stub_status:
+ * response.setBody(Metrics::render());
+ * @endcode
+ *
+ * @note The server is single-threaded, so the counters are plain integers.
+ */
+class Metrics {
+ public:
+    static void connectionAccepted();
+    static void connectionHandled();
+
+    /**
+     * @param location Path of the location that served it, or empty.
+     */
+    static void requestFinished(int status, const std::string& location,
+                                const http::RequestTimer& timer);
+    static void bytesReceived(std::size_t bytes);
+    static void bytesSent(std::size_t bytes);
+
+    /**
+     * @brief Bracket the work of one event-loop iteration, after the wait.
+     */
+    static void startIteration();
+    static void finishIteration();
+
+    static std::string render();
+
+ private:
+    enum StatusClass {
+        INFORMATIONAL,
+        SUCCESS,
+        REDIRECTION,
+        CLIENT_ERROR,
+        SERVER_ERROR,
+        STATUS_CLASS_COUNT
+    };
+
+    struct Latency {
+        Latency();
+        toolbox::Histogram request;
+        toolbox::Histogram firstByte;
+        toolbox::Histogram upstream;
+    };
+
+    Metrics();
+    ~Metrics();
+    Metrics(const Metrics& other);
+    Metrics& operator=(const Metrics& other);
+
+    static Metrics& getInstance();
+    static std::string renderLatency(const std::string& name,
+                                     toolbox::Histogram Latency::* histogram);
+
+    uint64_t _accepted;
+    uint64_t _handled;
+    uint64_t _requests[STATUS_CLASS_COUNT];
+    uint64_t _bytesReceived;
+    uint64_t _bytesSent;
+    double _iterationStart;
+    toolbox::Histogram _iterations;     // seconds
+    std::map<std::string, Latency> _latencies;  // by location
+    std::vector<toolbox::Histogram> _phases;    // by RequestTimer::Phase
+};
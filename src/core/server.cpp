@@ -40,6 +40,15 @@ Server::Server(int port, const std::string& ip) {
     createServerSocket();
 }
 
+// - Inherited across execve(), so close-on-exec has to be set again.
+Server::Server(int port, const std::string& ip, int listeningFd) {
+    _port = port;
+    _ip = ip;
+    _name = server::DEFAULT_NAME;
+    _server_sock = listeningFd;
+    fcntl(_server_sock, F_SETFD, FD_CLOEXEC);
+}
+
 Server::~Server() {
     close(_server_sock);
 }
@@ -60,28 +69,34 @@ const char* Server::ServerException::what() const throw() {
     return _message.c_str();
 }
 
+// - The socket is closed on failure: a constructor that throws runs no
+//   destructor, and a failed reload must not leak it.
 void Server::createServerSocket() {
-    _server_sock = socket(AF_INET, SOCK_STREAM, 0);
+    uint32_t address = parseIpAddress(_ip);
+    _server_sock = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
     if (_server_sock == -1) {
         throw ServerException("socket failed");
     }
     int opt = 1;
     if (setsockopt(_server_sock, SOL_SOCKET, SO_REUSEADDR,
                     &opt, sizeof(opt)) == -1) {
+        close(_server_sock);
         throw ServerException("setsockopt failed");
     }
     struct sockaddr_in server_addr;
     server_addr.sin_family = AF_INET;
-    server_addr.sin_addr.s_addr = parseIpAddress(_ip);
+    server_addr.sin_addr.s_addr = address;
     server_addr.sin_port = htons(_port);
     if (bind(_server_sock, (struct sockaddr*)&server_addr,
                 sizeof(server_addr)) == -1) {
+        close(_server_sock);
         std::string errorMsg = "bind() to " + _ip + ":"
                                 + toolbox::to_string(_port) + " failed";
         toolbox::logger::StepMark::error(errorMsg);
         throw ServerException(errorMsg);
     }
     if (listen(_server_sock, SOMAXCONN) == -1) {
+        close(_server_sock);
         throw ServerException("listen failed");
     }
 }
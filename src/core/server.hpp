@@ -4,9 +4,13 @@
 
 #include <fcntl.h>
 #include <exception>
+#include <map>
 #include <string>
+#include <utility>
 #include <stdint.h> 
 
+#include "../../toolbox/shared.hpp"
+
 namespace server {
 extern const int DEFAULT_PORT;
 extern const char* DEFAULT_NAME;
@@ -30,9 +34,17 @@ class Server {
     Server();
     explicit Server(int port);
     Server(int port, const std::string& ip);
+
+    /**
+     * @brief Adopts a socket already listening on ip:port, inherited from
+     * the process that started this one.
+     */
+    Server(int port, const std::string& ip, int listeningFd);
     virtual ~Server();
 
     int getFd() const { return _server_sock; }
+    int getPort() const { return _port; }
+    const std::string& getIp() const { return _ip; }
     void setName(const std::string& name) { _name = name; }
     std::string getName() const { return _name; }
 
@@ -47,3 +59,6 @@ class Server {
     void createServerSocket();
     uint32_t parseIpAddress(const std::string& ip) const;
 };
+
+typedef std::pair<std::string, int> ListenAddress;
+typedef std::map<ListenAddress, toolbox::SharedPtr<Server> > Listeners;
@@ -0,0 +1,146 @@
+// Copyright 2025 Ideal Broccoli
+
+#include <fcntl.h>
+#include <spawn.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "child_launcher.hpp"
+#include "child_reaper.hpp"
+#include "../../toolbox/stepmark.hpp"
+
+extern char** environ;
+
+namespace {
+const char* NULL_DEVICE = "/dev/null";
+}  // namespace
+
+ChildLauncher::ChildLauncher() {
+}
+
+ChildLauncher::~ChildLauncher() {
+}
+
+void ChildLauncher::redirect(int fd, int target) {
+    Action action;
+    action.type = ACTION_DUP2;
+    action.fd = fd;
+    action.target = target;
+    action.flags = 0;
+    _actions.push_back(action);
+}
+
+void ChildLauncher::redirectToNull(int target, int flags) {
+    Action action;
+    action.type = ACTION_OPEN;
+    action.fd = -1;
+    action.target = target;
+    action.flags = flags;
+    action.path = NULL_DEVICE;
+    _actions.push_back(action);
+}
+
+void ChildLauncher::changeDirectory(const std::string& directory) {
+    Action action;
+    action.type = ACTION_CHDIR;
+    action.fd = -1;
+    action.target = -1;
+    action.flags = 0;
+    action.path = directory;
+    _actions.push_back(action);
+}
+
+pid_t ChildLauncher::launch(const std::string& path,
+                            const std::vector<std::string>& argv,
+                            char* const* envp, Method method) const {
+    std::vector<char*> args;
+    for (std::size_t i = 0; i < argv.size(); ++i) {
+        args.push_back(const_cast<char*>(argv[i].c_str()));
+    }
+    args.push_back(NULL);
+    if (envp == NULL) {
+        envp = environ;
+    }
+    if (method == FORK) {
+        return forkAndExec(path.c_str(), &args[0], envp);
+    }
+    return spawn(path.c_str(), &args[0], envp);
+}
+
+pid_t ChildLauncher::spawn(const char* path, char* const* argv,
+                           char* const* envp) const {
+    posix_spawn_file_actions_t actions;
+    posix_spawnattr_t attributes;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawnattr_init(&attributes);
+    ChildReaper::prepareSpawnAttributes(&attributes);
+    for (std::size_t i = 0; i < _actions.size(); ++i) {
+        const Action& action = _actions[i];
+        if (action.type == ACTION_DUP2) {
+            posix_spawn_file_actions_adddup2(&actions, action.fd,
+                                             action.target);
+        } else if (action.type == ACTION_OPEN) {
+            posix_spawn_file_actions_addopen(&actions, action.target,
+                                             action.path.c_str(),
+                                             action.flags, 0);
+        } else {
+            posix_spawn_file_actions_addchdir_np(&actions,
+                                                 action.path.c_str());
+        }
+    }
+    pid_t pid = -1;
+    int result = posix_spawn(&pid, path, &actions, &attributes, argv, envp);
+    posix_spawnattr_destroy(&attributes);
+    posix_spawn_file_actions_destroy(&actions);
+    if (result != 0) {
+        toolbox::logger::StepMark::error("ChildLauncher: cannot start "
+            + std::string(path) + ": " + std::strerror(result));
+        return -1;
+    }
+    return pid;
+}
+
+// - _exit() only: running the parent's static destructors here would
+//   deregister its fds from the shared epoll instance.
+pid_t ChildLauncher::forkAndExec(const char* path, char* const* argv,
+                                 char* const* envp) const {
+    pid_t pid = fork();
+    if (pid == -1) {
+        toolbox::logger::StepMark::error("ChildLauncher: fork failed");
+        return -1;
+    }
+    if (pid == 0) {
+        ChildReaper::resetChildSignals();
+        if (applyInChild()) {
+            execve(path, argv, envp);
+        }
+        _exit(127);
+    }
+    return pid;
+}
+
+bool ChildLauncher::applyInChild() const {
+    for (std::size_t i = 0; i < _actions.size(); ++i) {
+        const Action& action = _actions[i];
+        if (action.type == ACTION_DUP2) {
+            if (dup2(action.fd, action.target) == -1) {
+                return false;
+            }
+        } else if (action.type == ACTION_OPEN) {
+            int fd = open(action.path.c_str(), action.flags);
+            if (fd == -1) {
+                return false;
+            }
+            if (fd != action.target) {
+                dup2(fd, action.target);
+                close(fd);
+            }
+        } else if (chdir(action.path.c_str()) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
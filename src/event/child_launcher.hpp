@@ -0,0 +1,79 @@
+// Copyright 2025 Ideal Broccoli
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief Starts a child process after a recorded list of fd and directory
+ * changes.
+ *
+ * SPAWN uses posix_spawn(), which glibc implements with
+ * clone(CLONE_VM | CLONE_VFORK): the parent's page tables are not copied,
+ * so starting a CGI costs the same however much memory the server holds.
+ * FORK applies the same steps after fork(); it is kept as the reference
+ * the benchmark in bench/ compares against.
+ *
+ * Usage example:
+ * @code
+ * ChildLauncher launcher;
+ * launcher.changeDirectory("/var/www/cgi-bin");
+ * launcher.redirectToNull(STDIN_FILENO, O_RDONLY);
+ * launcher.redirect(outputPipe[1], STDOUT_FILENO);
+ * pid_t pid = launcher.launch("/usr/bin/python3", argv, envp);
+ * @endcode
+ *
+ * The steps run in the order they were added. The signal state is reset
+ * as ChildReaper::resetChildSignals() describes.
+ */
+class ChildLauncher {
+ public:
+    enum Method {
+        SPAWN,
+        FORK
+    };
+
+    ChildLauncher();
+    ~ChildLauncher();
+
+    void redirect(int fd, int target);
+    void redirectToNull(int target, int flags);
+    void changeDirectory(const std::string& directory);
+
+    /**
+     * @brief Start path with argv and envp (the server's environment if NULL).
+     * @return The child's pid, or -1 if it could not be started.
+     * @note With SPAWN, a program that cannot be executed is reported
+     *       here; with FORK the child exits with status 127 instead.
+     */
+    pid_t launch(const std::string& path,
+                 const std::vector<std::string>& argv,
+                 char* const* envp, Method method = SPAWN) const;
+
+ private:
+    enum ActionType {
+        ACTION_DUP2,
+        ACTION_OPEN,
+        ACTION_CHDIR
+    };
+    struct Action {
+        ActionType type;
+        int fd;
+        int target;
+        int flags;
+        std::string path;
+    };
+
+    ChildLauncher(const ChildLauncher& other);
+    ChildLauncher& operator=(const ChildLauncher& other);
+
+    pid_t spawn(const char* path, char* const* argv, char* const* envp) const;
+    pid_t forkAndExec(const char* path, char* const* argv,
+                      char* const* envp) const;
+    bool applyInChild() const;
+
+    std::vector<Action> _actions;
+};
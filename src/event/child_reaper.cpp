@@ -0,0 +1,212 @@
+// Copyright 2025 Ideal Broccoli
+
+#include <poll.h>
+#include <sys/signalfd.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <signal.h>
+
+#include <ctime>
+#include <map>
+#include <vector>
+
+#include "child_reaper.hpp"
+#include "../core/constant.hpp"
+#include "../../toolbox/string.hpp"
+#include "../../toolbox/stepmark.hpp"
+
+namespace {
+// A deadline that is never reached.
+const time_t NO_DEADLINE = 0;
+}  // namespace
+
+ChildReaper::ChildReaper() : _signalFd(-1) {
+    sigemptyset(&_originalMask);
+}
+
+ChildReaper::~ChildReaper() {
+    if (_signalFd != -1) {
+        close(_signalFd);
+    }
+}
+
+ChildReaper::ChildReaperException::ChildReaperException(
+    const ChildReaperException& other) : _message(other._message) {}
+
+ChildReaper::ChildReaperException::~ChildReaperException() throw() {
+}
+
+ChildReaper& ChildReaper::getInstance() {
+    static ChildReaper instance;
+    return instance;
+}
+
+int ChildReaper::init() {
+    ChildReaper& reaper = getInstance();
+    if (reaper._signalFd != -1) {
+        return reaper._signalFd;
+    }
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGCHLD);
+    if (sigprocmask(SIG_BLOCK, &mask, &reaper._originalMask) == -1) {
+        throw ChildReaperException("sigprocmask failed");
+    }
+    reaper._signalFd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (reaper._signalFd == -1) {
+        throw ChildReaperException("signalfd failed");
+    }
+    return reaper._signalFd;
+}
+
+// - The blocked mask and ignored dispositions survive execve(), so a CGI
+//   would otherwise start with SIGCHLD blocked and SIGPIPE ignored.
+void ChildReaper::resetChildSignals() {
+    ChildReaper& reaper = getInstance();
+    sigprocmask(SIG_SETMASK, &reaper._originalMask, NULL);
+    signal(SIGPIPE, SIG_DFL);
+}
+
+void ChildReaper::prepareSpawnAttributes(posix_spawnattr_t* attributes) {
+    ChildReaper& reaper = getInstance();
+    sigset_t defaults;
+    sigemptyset(&defaults);
+    sigaddset(&defaults, SIGPIPE);
+    posix_spawnattr_setsigmask(attributes, &reaper._originalMask);
+    posix_spawnattr_setsigdefault(attributes, &defaults);
+    posix_spawnattr_setflags(attributes,
+                             POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+}
+
+void ChildReaper::watch(pid_t pid, ChildExitListener* owner) {
+    Child child;
+    child.owner = owner;
+    child.termAt = NO_DEADLINE;
+    child.killAt = NO_DEADLINE;
+    getInstance()._children[pid] = child;
+}
+
+void ChildReaper::release(pid_t pid, time_t deadline) {
+    ChildReaper& reaper = getInstance();
+    std::map<pid_t, Child>::iterator it = reaper._children.find(pid);
+    if (it == reaper._children.end()) {
+        return;
+    }
+    it->second.owner = NULL;
+    if (it->second.termAt == NO_DEADLINE || deadline < it->second.termAt) {
+        it->second.termAt = deadline;
+    }
+    checkDeadlines();
+}
+
+void ChildReaper::handleSignal() {
+    ChildReaper& reaper = getInstance();
+    struct signalfd_siginfo info;
+    while (read(reaper._signalFd, &info, sizeof(info)) > 0) {
+    }
+    // - SIGCHLD coalesces, so one notification may stand for many exits.
+    int status;
+    pid_t pid;
+    while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+        std::map<pid_t, Child>::iterator it = reaper._children.find(pid);
+        if (it == reaper._children.end()) {
+            logExit(pid, status);
+            continue;
+        }
+        ChildExitListener* owner = it->second.owner;
+        reaper._children.erase(it);
+        if (owner != NULL) {
+            owner->onChildExit(pid, status);
+        } else {
+            logExit(pid, status);
+        }
+    }
+}
+
+void ChildReaper::checkDeadlines() {
+    ChildReaper& reaper = getInstance();
+    time_t now = std::time(NULL);
+    for (std::map<pid_t, Child>::iterator it = reaper._children.begin();
+            it != reaper._children.end(); ++it) {
+        Child& child = it->second;
+        if (child.killAt != NO_DEADLINE) {
+            if (now >= child.killAt) {
+                toolbox::logger::StepMark::warning(
+                    "ChildReaper: sending SIGKILL to pid: "
+                    + toolbox::to_string(it->first));
+                kill(it->first, SIGKILL);
+                child.killAt = NO_DEADLINE;
+            }
+        } else if (child.termAt != NO_DEADLINE && now >= child.termAt) {
+            toolbox::logger::StepMark::info(
+                "ChildReaper: sending SIGTERM to pid: "
+                + toolbox::to_string(it->first));
+            kill(it->first, SIGTERM);
+            child.termAt = NO_DEADLINE;
+            child.killAt = now + core::CHILD_KILL_GRACE_SECONDS;
+        }
+    }
+}
+
+void ChildReaper::forget(pid_t pid) {
+    getInstance()._children.erase(pid);
+}
+
+std::size_t ChildReaper::getChildCount() {
+    return getInstance()._children.size();
+}
+
+// - SIGCHLD stays blocked, so its signalfd is what the wait sleeps on.
+void ChildReaper::terminateAll() {
+    ChildReaper& reaper = getInstance();
+    if (reaper._children.empty()) {
+        return;
+    }
+    toolbox::logger::StepMark::info("ChildReaper: terminating "
+        + toolbox::to_string(reaper._children.size()) + " children");
+    for (std::map<pid_t, Child>::iterator it = reaper._children.begin();
+            it != reaper._children.end(); ++it) {
+        kill(it->first, SIGTERM);
+    }
+    time_t killAt = std::time(NULL) + core::CHILD_KILL_GRACE_SECONDS;
+    while (!reaper._children.empty()) {
+        int status;
+        pid_t pid;
+        while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+            reaper._children.erase(pid);
+        }
+        time_t now = std::time(NULL);
+        if (reaper._children.empty() || now >= killAt) {
+            break;
+        }
+        struct pollfd pending = {reaper._signalFd, POLLIN, 0};
+        if (poll(&pending, 1, static_cast<int>(killAt - now) * 1000) > 0) {
+            struct signalfd_siginfo info;
+            while (read(reaper._signalFd, &info, sizeof(info)) > 0) {
+            }
+        }
+    }
+    for (std::map<pid_t, Child>::iterator it = reaper._children.begin();
+            it != reaper._children.end(); ++it) {
+        toolbox::logger::StepMark::warning(
+            "ChildReaper: sending SIGKILL to pid: "
+            + toolbox::to_string(it->first));
+        kill(it->first, SIGKILL);
+        waitpid(it->first, NULL, 0);
+    }
+    reaper._children.clear();
+}
+
+void ChildReaper::logExit(pid_t pid, int status) {
+    if (WIFEXITED(status) && WEXITSTATUS(status) != 0) {
+        toolbox::logger::StepMark::warning(
+            "ChildReaper: pid " + toolbox::to_string(pid)
+            + " exited with status: "
+            + toolbox::to_string(WEXITSTATUS(status)));
+    } else if (WIFSIGNALED(status)) {
+        toolbox::logger::StepMark::warning(
+            "ChildReaper: pid " + toolbox::to_string(pid)
+            + " terminated by signal: "
+            + toolbox::to_string(WTERMSIG(status)));
+    }
+}
@@ -0,0 +1,121 @@
+// Copyright 2025 Ideal Broccoli
+
+#pragma once
+
+#include <sys/types.h>
+#include <signal.h>
+#include <spawn.h>
+
+#include <ctime>
+#include <exception>
+#include <map>
+
+/**
+ * @brief Receives the exit status of a child registered with ChildReaper.
+ */
+class ChildExitListener {
+ public:
+    virtual ~ChildExitListener() {}
+    virtual void onChildExit(pid_t pid, int status) = 0;
+};
+
+/**
+ * @brief Reaps child processes from the event loop.
+ *
+ * SIGCHLD is blocked and read from a signalfd registered in epoll, so exits
+ * are collected with waitpid(WNOHANG) only when one is known to be pending
+ * and then dispatched to the owner by pid. Termination never blocks: a
+ * child gets SIGTERM at its deadline and SIGKILL after a grace period, and
+ * stays tracked until it has actually been reaped.
+ */
+class ChildReaper {
+ public:
+    class ChildReaperException : public std::exception {
+     public:
+        explicit ChildReaperException(const char* message) : _message(message) {}
+        ChildReaperException(const ChildReaperException& other);
+        virtual ~ChildReaperException() throw();
+        const char* what() const throw() { return _message; }
+     private:
+        ChildReaperException();
+        ChildReaperException& operator=(const ChildReaperException& other);
+        const char* _message;
+    };
+
+    /**
+     * @brief Block SIGCHLD and create the signalfd.
+     * @return The signalfd to register in epoll.
+     */
+    static int init();
+
+    /**
+     * @brief Restore the signal state a freshly exec'd program expects.
+     * @note Called in the child between fork() and execve().
+     */
+    static void resetChildSignals();
+
+    /**
+     * @brief Make posix_spawn() reset the signal state the same way.
+     */
+    static void prepareSpawnAttributes(posix_spawnattr_t* attributes);
+
+    static void watch(pid_t pid, ChildExitListener* owner);
+
+    /**
+     * @brief Hand a child over to the reaper.
+     *
+     * The owner is no longer notified. The child receives SIGTERM once
+     * deadline has passed (immediately if it already has), then SIGKILL
+     * after CHILD_KILL_GRACE_SECONDS.
+     */
+    static void release(pid_t pid, time_t deadline);
+
+    /**
+     * @brief Drain the signalfd and reap every child that has exited.
+     */
+    static void handleSignal();
+
+    /**
+     * @brief Deliver the signals whose deadline has passed.
+     */
+    static void checkDeadlines();
+
+    /**
+     * @brief Stop tracking a child that is meant to outlive the server.
+     */
+    static void forget(pid_t pid);
+
+    /**
+     * @brief Children not reaped yet, including those being terminated.
+     */
+    static std::size_t getChildCount();
+
+    /**
+     * @brief Terminate every child before the server exits.
+     *
+     * Sends SIGTERM to all children and waits for them, sending SIGKILL to
+     * those still running after CHILD_KILL_GRACE_SECONDS. Owners are not
+     * notified.
+     * @note Blocks; only for the way out, once nothing is served anymore.
+     */
+    static void terminateAll();
+
+ private:
+    struct Child {
+        ChildExitListener* owner;
+        time_t termAt;
+        time_t killAt;
+    };
+
+    ChildReaper();
+    ~ChildReaper();
+    ChildReaper(const ChildReaper& other);
+    ChildReaper& operator=(const ChildReaper& other);
+
+    static ChildReaper& getInstance();
+    static void logExit(pid_t pid, int status);
+
+    int _signalFd;
+    sigset_t _originalMask;
+    std::map<pid_t, Child> _children;
+};
@@ -0,0 +1,68 @@
+// Copyright 2025 Ideal Broccoli
+
+#include <sys/signalfd.h>
+#include <unistd.h>
+#include <signal.h>
+
+#include <vector>
+
+#include "control_signal.hpp"
+
+namespace {
+const int SIGNALS[] = {SIGHUP, SIGINT, SIGQUIT, SIGTERM, SIGUSR1, SIGUSR2};
+}  // namespace
+
+ControlSignal::ControlSignal() : _signalFd(-1) {
+}
+
+ControlSignal::~ControlSignal() {
+    if (_signalFd != -1) {
+        close(_signalFd);
+    }
+}
+
+ControlSignal::ControlSignalException::ControlSignalException(
+    const ControlSignalException& other) : _message(other._message) {}
+
+ControlSignal::ControlSignalException::~ControlSignalException() throw() {
+}
+
+ControlSignal& ControlSignal::getInstance() {
+    static ControlSignal instance;
+    return instance;
+}
+
+int ControlSignal::init() {
+    ControlSignal& control = getInstance();
+    if (control._signalFd != -1) {
+        return control._signalFd;
+    }
+    sigset_t mask;
+    sigemptyset(&mask);
+    for (std::size_t i = 0; i < sizeof(SIGNALS) / sizeof(SIGNALS[0]); ++i) {
+        sigaddset(&mask, SIGNALS[i]);
+    }
+    if (sigprocmask(SIG_BLOCK, &mask, NULL) == -1) {
+        throw ControlSignalException("sigprocmask failed");
+    }
+    control._signalFd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (control._signalFd == -1) {
+        throw ControlSignalException("signalfd failed");
+    }
+    return control._signalFd;
+}
+
+int ControlSignal::getFd() {
+    return getInstance()._signalFd;
+}
+
+// - A signal sent again before it was read is only reported once.
+std::vector<int> ControlSignal::takeSignals() {
+    std::vector<int> signals;
+    struct signalfd_siginfo info;
+    while (read(getInstance()._signalFd, &info, sizeof(info))
+            == static_cast<ssize_t>(sizeof(info))) {
+        signals.push_back(static_cast<int>(info.ssi_signo));
+    }
+    return signals;
+}
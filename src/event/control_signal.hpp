@@ -0,0 +1,70 @@
+// Copyright 2025 Ideal Broccoli
+
+#pragma once
+
+#include <exception>
+#include <vector>
+
+/**
+ * @brief Delivers the signals that control the server to the event loop.
+ *
+ * The signals are blocked and read from a signalfd registered in epoll, so
+ * they are acted on between events, never in the middle of one.
+ *
+ * - SIGHUP: reload the configuration.
+ * - SIGQUIT, SIGTERM: stop accepting and exit once the connections are
+ *   done, or at shutdown_timeout.
+ * - SIGINT: exit without waiting for the connections.
+ * - SIGUSR1: reopen the log files, after they were moved for rotation.
+ * - SIGUSR2: start a new binary on the same listening sockets.
+ *
+ * Usage example:
+ * @code
+ * Epoll::addSignal(ChildReaper::init());
+ * Epoll::addSignal(ControlSignal::init());
+ * // ... when the signalfd is readable:
+ * std::vector<int> signals = ControlSignal::takeSignals();
+ * @endcode
+ *
+ * @note init() must run after ChildReaper::init(): children are started
+ *       with the mask ChildReaper saved, which then has these unblocked.
+ */
+class ControlSignal {
+ public:
+    class ControlSignalException : public std::exception {
+     public:
+        explicit ControlSignalException(const char* message)
+            : _message(message) {}
+        ControlSignalException(const ControlSignalException& other);
+        virtual ~ControlSignalException() throw();
+        const char* what() const throw() { return _message; }
+     private:
+        ControlSignalException();
+        ControlSignalException& operator=(const ControlSignalException& other);
+        const char* _message;
+    };
+
+    /**
+     * @brief Block the control signals and create the signalfd.
+     * @return The signalfd to register in epoll.
+     */
+    static int init();
+
+    static int getFd();
+
+    /**
+     * @brief Drain the signalfd.
+     * @return The signals received, in order.
+     */
+    static std::vector<int> takeSignals();
+
+ private:
+    ControlSignal();
+    ~ControlSignal();
+    ControlSignal(const ControlSignal& other);
+    ControlSignal& operator=(const ControlSignal& other);
+
+    static ControlSignal& getInstance();
+
+    int _signalFd;
+};
@@ -11,13 +11,14 @@
 #include "../../toolbox/string.hpp"
 #include "../../toolbox/stepmark.hpp"
 #include "tagged_epoll_event.hpp"
+#include "../http/request/request.hpp"
 
 namespace toolbox {
 static void setNonBlocking(int fd);
 }
 
 Epoll::Epoll() {
-    _epfd = epoll_create(1);
+    _epfd = epoll_create1(EPOLL_CLOEXEC);
     if (_epfd == -1) {
         throw EpollException("epoll_create failed");
     }
@@ -31,6 +32,7 @@ Epoll::~Epoll() {
         delete tagged;
         delete ev;
     }
+    releaseRetired();
     close(_epfd);
     _events.clear();
 }
@@ -46,6 +48,8 @@ void Epoll::addServer(int fd, toolbox::SharedPtr<Server> server) {
     struct epoll_event* ev = new struct epoll_event;
     ev->events = EPOLLIN;
     taggedEventData* tagged = new taggedEventData;
+    tagged->type = taggedEventData::SERVER;
+    tagged->active = true;
     tagged->server = server;
     ev->data.ptr = static_cast<void*>(tagged);
     toolbox::setNonBlocking(fd);
@@ -60,8 +64,10 @@ void Epoll::addServer(int fd, toolbox::SharedPtr<Server> server) {
 void Epoll::addClient(int fd, toolbox::SharedPtr<Client> client) {
     Epoll& epollInstance = getInstance();
     struct epoll_event* ev = new struct epoll_event;
-    ev->events = EPOLLIN | EPOLLOUT | EPOLLRDHUP;
+    ev->events = EPOLLIN | EPOLLRDHUP;
     taggedEventData* tagged = new taggedEventData;
+    tagged->type = taggedEventData::CLIENT;
+    tagged->active = true;
     tagged->client = client;
     ev->data.ptr = static_cast<void*>(tagged);
     toolbox::setNonBlocking(fd);
@@ -73,24 +79,133 @@ void Epoll::addClient(int fd, toolbox::SharedPtr<Client> client) {
     epollInstance._events[fd] = ev;
 }
 
+void Epoll::addSignal(int fd) {
+    Epoll& epollInstance = getInstance();
+    struct epoll_event* ev = new struct epoll_event;
+    ev->events = EPOLLIN;
+    taggedEventData* tagged = new taggedEventData;
+    tagged->type = taggedEventData::SIGNAL;
+    tagged->active = true;
+    tagged->fd = fd;
+    ev->data.ptr = static_cast<void*>(tagged);
+    if (epoll_ctl(epollInstance._epfd, EPOLL_CTL_ADD, fd, ev) == -1) {
+        delete tagged;
+        delete ev;
+        throw EpollException("epoll_ctl failed");
+    }
+    epollInstance._events[fd] = ev;
+}
+
+// - Connections to FastCGI application servers belong to the pool, not to
+//   a client, since requests of several clients may share one.
+void Epoll::addUpstream(int fd, uint32_t events) {
+    Epoll& epollInstance = getInstance();
+    struct epoll_event* ev = new struct epoll_event;
+    ev->events = events;
+    taggedEventData* tagged = new taggedEventData;
+    tagged->type = taggedEventData::UPSTREAM;
+    tagged->active = true;
+    tagged->fd = fd;
+    ev->data.ptr = static_cast<void*>(tagged);
+    if (epoll_ctl(epollInstance._epfd, EPOLL_CTL_ADD, fd, ev) == -1) {
+        delete tagged;
+        delete ev;
+        throw EpollException("epoll_ctl failed");
+    }
+    epollInstance._events[fd] = ev;
+}
+
+// - CGI pipes are tagged with the owning client so that their readiness
+//   drives that client's request directly.
+void Epoll::addCgiPipe(int fd, uint32_t events, int clientFd) {
+    Epoll& epollInstance = getInstance();
+    std::map<int, struct epoll_event*>::iterator owner =
+        epollInstance._events.find(clientFd);
+    if (owner == epollInstance._events.end()) {
+        throw EpollException("addCgiPipe: owner client is not registered");
+    }
+    taggedEventData* ownerTag =
+        static_cast<taggedEventData*>(owner->second->data.ptr);
+    struct epoll_event* ev = new struct epoll_event;
+    ev->events = events;
+    taggedEventData* tagged = new taggedEventData;
+    tagged->type = taggedEventData::CGI_PIPE;
+    tagged->active = true;
+    tagged->client = ownerTag->client;
+    ev->data.ptr = static_cast<void*>(tagged);
+    if (epoll_ctl(epollInstance._epfd, EPOLL_CTL_ADD, fd, ev) == -1) {
+        delete tagged;
+        delete ev;
+        throw EpollException("epoll_ctl failed");
+    }
+    epollInstance._events[fd] = ev;
+}
+
+void Epoll::modify(int fd, uint32_t events) {
+    Epoll& epollInstance = getInstance();
+    std::map<int, struct epoll_event*>::iterator it = epollInstance._events.find(fd);
+    if (it == epollInstance._events.end() || it->second->events == events) {
+        return;
+    }
+    struct epoll_event* ev = it->second;
+    ev->events = events;
+    if (epoll_ctl(epollInstance._epfd, EPOLL_CTL_MOD, fd, ev) == -1) {
+        STEPMARK_ERROR("Epoll::modify: epoll_ctl failed for fd: " + toolbox::to_string(fd));
+    }
+}
+
+// - Server and Client own their sockets and close them in their destructors,
+//   so only the registration is dropped here.
 void Epoll::del(int fd) {
     Epoll& epollInstance = getInstance();
     std::map<int, struct epoll_event*>::iterator it = epollInstance._events.find(fd);
     if (epoll_ctl(epollInstance._epfd, EPOLL_CTL_DEL, fd, NULL) == -1) {
-        toolbox::logger::StepMark::error("Epoll::del: epoll_ctl failed for fd: " + toolbox::to_string(fd));
+        STEPMARK_ERROR("Epoll::del: epoll_ctl failed for fd: " + toolbox::to_string(fd));
     }
     if (it != epollInstance._events.end()) {
-        struct epoll_event* ev = it->second;
-        taggedEventData* tagged = static_cast<taggedEventData*>(ev->data.ptr);
-        delete tagged;
-        delete ev;
-        epollInstance._events.erase(it);
+        retire(it);
+    }
+}
+
+// - The pipe itself is closed by CgiExecute; fds that are not registered
+//   are ignored, which keeps the call safe in forked children.
+void Epoll::delCgiPipe(int fd) {
+    Epoll& epollInstance = getInstance();
+    std::map<int, struct epoll_event*>::iterator it = epollInstance._events.find(fd);
+    if (it == epollInstance._events.end()) {
+        return;
+    }
+    taggedEventData* tagged = static_cast<taggedEventData*>(it->second->data.ptr);
+    if (tagged->type != taggedEventData::CGI_PIPE) {
+        return;
+    }
+    if (epoll_ctl(epollInstance._epfd, EPOLL_CTL_DEL, fd, NULL) == -1) {
+        STEPMARK_ERROR("Epoll::delCgiPipe: epoll_ctl failed for fd: " + toolbox::to_string(fd));
     }
-    close(fd);
+    retire(it);
+}
+
+// - Tagged data may still be referenced by events of the batch being
+//   processed; it is freed at the next wait().
+void Epoll::retire(std::map<int, struct epoll_event*>::iterator it) {
+    Epoll& epollInstance = getInstance();
+    taggedEventData* tagged = static_cast<taggedEventData*>(it->second->data.ptr);
+    tagged->active = false;
+    epollInstance._retired.push_back(it->second);
+    epollInstance._events.erase(it);
+}
+
+void Epoll::releaseRetired() {
+    for (std::size_t i = 0; i < _retired.size(); ++i) {
+        delete static_cast<taggedEventData*>(_retired[i]->data.ptr);
+        delete _retired[i];
+    }
+    _retired.clear();
 }
 
 int Epoll::wait(struct epoll_event* events, int maxevents, int timeout) {
     Epoll& epollInstance = getInstance();
+    epollInstance.releaseRetired();
     return epoll_wait(epollInstance._epfd, events, maxevents, timeout);
 }
 
@@ -100,17 +215,76 @@ void Epoll::checkClientTimeouts() {
     for (std::map<int, struct epoll_event*>::iterator it = epollInstance._events.begin();
             it != epollInstance._events.end(); ++it) {
         taggedEventData* tagged = static_cast<taggedEventData*>(it->second->data.ptr);
-        if (tagged->client && tagged->client->isClientTimedOut()) {
+        if (tagged->type == taggedEventData::CLIENT &&
+            tagged->client->isClientTimedOut()) {
             toRemove.push_back(tagged->client->getFd());
         }
     }
 
     for (std::size_t i = 0; i < toRemove.size(); ++i) {
-        toolbox::logger::StepMark::info("Epoll: timeout for client fd: " + toolbox::to_string(toRemove[i]));
+        STEPMARK_INFO("Epoll: timeout for client fd: " + toolbox::to_string(toRemove[i]));
+        taggedEventData* tagged = static_cast<taggedEventData*>(
+            epollInstance._events[toRemove[i]]->data.ptr);
+        tagged->client->getRequest()->terminateActiveCgiProcesses();
         Epoll::del(toRemove[i]);
     }
 }
 
+// - A CGI that produces no output generates no events; its timeout is
+//   noticed here and handled by running the owning request.
+std::vector<toolbox::SharedPtr<Client> > Epoll::getCgiTimedOutClients() {
+    std::vector<toolbox::SharedPtr<Client> > timedOut;
+    Epoll& epollInstance = getInstance();
+    for (std::map<int, struct epoll_event*>::iterator it = epollInstance._events.begin();
+            it != epollInstance._events.end(); ++it) {
+        taggedEventData* tagged = static_cast<taggedEventData*>(it->second->data.ptr);
+        if (tagged->type == taggedEventData::CLIENT &&
+            tagged->client->isCgiTimedOut()) {
+            timedOut.push_back(tagged->client);
+        }
+    }
+    return timedOut;
+}
+
+toolbox::SharedPtr<Client> Epoll::findClient(int fd) {
+    Epoll& epollInstance = getInstance();
+    std::map<int, struct epoll_event*>::iterator it = epollInstance._events.find(fd);
+    if (it == epollInstance._events.end()) {
+        return toolbox::SharedPtr<Client>();
+    }
+    taggedEventData* tagged = static_cast<taggedEventData*>(it->second->data.ptr);
+    if (tagged->type != taggedEventData::CLIENT) {
+        return toolbox::SharedPtr<Client>();
+    }
+    return tagged->client;
+}
+
+std::size_t Epoll::getClientCount() {
+    Epoll& epollInstance = getInstance();
+    std::size_t count = 0;
+    for (std::map<int, struct epoll_event*>::iterator it = epollInstance._events.begin();
+            it != epollInstance._events.end(); ++it) {
+        taggedEventData* tagged = static_cast<taggedEventData*>(it->second->data.ptr);
+        if (tagged->type == taggedEventData::CLIENT) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+std::vector<toolbox::SharedPtr<Client> > Epoll::getClients() {
+    Epoll& epollInstance = getInstance();
+    std::vector<toolbox::SharedPtr<Client> > clients;
+    for (std::map<int, struct epoll_event*>::iterator it = epollInstance._events.begin();
+            it != epollInstance._events.end(); ++it) {
+        taggedEventData* tagged = static_cast<taggedEventData*>(it->second->data.ptr);
+        if (tagged->type == taggedEventData::CLIENT) {
+            clients.push_back(tagged->client);
+        }
+    }
+    return clients;
+}
+
 Epoll& Epoll::getInstance() {
     static Epoll instance;
     return instance;
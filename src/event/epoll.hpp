@@ -3,8 +3,10 @@
 #pragma once
 
 #include <sys/epoll.h>
+#include <stdint.h>
 #include <exception>
 #include <map>
+#include <vector>
 
 #include "../core/server.hpp"
 #include "../core/client.hpp"
@@ -26,9 +28,18 @@ class Epoll {
 
     static void addServer(int fd, toolbox::SharedPtr<Server> server);
     static void addClient(int fd, toolbox::SharedPtr<Client> client);
+    static void addCgiPipe(int fd, uint32_t events, int clientFd);
+    static void addSignal(int fd);
+    static void addUpstream(int fd, uint32_t events);
+    static void modify(int fd, uint32_t events);
     static void del(int fd);
+    static void delCgiPipe(int fd);
     static int wait(struct epoll_event* events, int maxevents, int timeout);
     static void checkClientTimeouts();
+    static std::vector<toolbox::SharedPtr<Client> > getCgiTimedOutClients();
+    static toolbox::SharedPtr<Client> findClient(int fd);
+    static std::size_t getClientCount();
+    static std::vector<toolbox::SharedPtr<Client> > getClients();
 
  private:
     Epoll();
@@ -37,9 +48,12 @@ class Epoll {
     Epoll& operator=(const Epoll&) { return *this; }
 
     static Epoll& getInstance();
+    static void retire(std::map<int, struct epoll_event*>::iterator it);
+    void releaseRetired();
 
     int _epfd;
     std::map<int, struct epoll_event*> _events;
+    std::vector<struct epoll_event*> _retired;
 };
 
-inline bool isSocketDisconnected(const epoll_event& event) { return (event.events & EPOLLRDHUP) != 0; }
+inline bool isSocketDisconnected(const epoll_event& event) { return (event.events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)) != 0; }
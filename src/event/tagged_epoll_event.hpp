@@ -7,6 +7,21 @@
 #include "../../toolbox/shared.hpp"
 
 struct taggedEventData {
+    enum Type {
+        SERVER,
+        CLIENT,
+        CGI_PIPE,
+        SIGNAL,
+        UPSTREAM
+    };
+    Type type;
+    // Cleared when the fd is removed, so that events for it that are still
+    // queued in the current epoll_wait() batch can be skipped safely.
+    bool active;
     toolbox::SharedPtr<Server> server;
+    // For CGI_PIPE, the client whose request owns the pipe.
     toolbox::SharedPtr<Client> client;
+    // For UPSTREAM, the socket; the connection is looked up by it. For
+    // SIGNAL, the signalfd.
+    int fd;
 };
@@ -0,0 +1,123 @@
+// Copyright 2025 Ideal Broccoli
+
+#include <cctype>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "cgi_environment.hpp"
+#include "../http_namespace.hpp"
+#include "../fastcgi/fastcgi_record.hpp"
+#include "../../../toolbox/string.hpp"
+
+namespace http {
+
+CgiEnvironment::CgiEnvironment() {
+}
+
+CgiEnvironment::~CgiEnvironment() {
+}
+
+std::map<std::size_t, CgiEnvironment::Entries>& CgiEnvironment::getTemplates() {
+    static std::map<std::size_t, Entries> templates;
+    return templates;
+}
+
+void CgiEnvironment::prepare(const config::HttpConfig& httpConfig) {
+    const std::vector<toolbox::SharedPtr<config::ServerConfig> >& servers =
+        httpConfig.getServers();
+    for (std::size_t i = 0; i < servers.size(); ++i) {
+        const std::vector<config::Listen>& listens = servers[i]->getListens();
+        for (std::size_t j = 0; j < listens.size(); ++j) {
+            getTemplate(listens[j].getPort());
+        }
+    }
+}
+
+// - Built on first use for a port no server listens on, which only
+//   happens if prepare() was not called.
+const CgiEnvironment::Entries& CgiEnvironment::getTemplate(
+        std::size_t serverPort) {
+    std::map<std::size_t, Entries>& templates = getTemplates();
+    std::map<std::size_t, Entries>::iterator it = templates.find(serverPort);
+    if (it != templates.end()) {
+        return it->second;
+    }
+    Entries& entries = templates[serverPort];
+    append(&entries, cgi::meta::AUTH_TYPE, "");
+    append(&entries, cgi::meta::GATEWAY_INTERFACE, cgi::GATEWAY_INTERFACE);
+    append(&entries, cgi::meta::REMOTE_HOST, "");
+    append(&entries, cgi::meta::REMOTE_IDENT, "");
+    append(&entries, cgi::meta::REMOTE_USER, "");
+    append(&entries, cgi::meta::SERVER_PORT,
+           serverPort == 0 ? "" : toolbox::to_string(serverPort));
+    append(&entries, cgi::meta::SERVER_SOFTWARE, cgi::SERVER_SOFTWARE);
+    return entries;
+}
+
+void CgiEnvironment::append(Entries* entries, const char* name,
+                            const std::string& value) {
+    entries->offsets.push_back(entries->buffer.size());
+    entries->buffer += name;
+    entries->buffer += '=';
+    entries->buffer += value;
+    entries->buffer += '\0';
+}
+
+void CgiEnvironment::reset(std::size_t serverPort) {
+    const Entries& entries = getTemplate(serverPort);
+    _entries.buffer.assign(entries.buffer);
+    _entries.offsets.assign(entries.offsets.begin(), entries.offsets.end());
+}
+
+void CgiEnvironment::clear() {
+    _entries.buffer.clear();
+    _entries.offsets.clear();
+    _envp.clear();
+}
+
+void CgiEnvironment::set(const char* name, const std::string& value) {
+    append(&_entries, name, value);
+}
+
+// - "user-agent" becomes HTTP_USER_AGENT.
+void CgiEnvironment::setHeader(const std::string& fieldName,
+                               const std::string& value) {
+    _entries.offsets.push_back(_entries.buffer.size());
+    _entries.buffer += cgi::ENV_PREFIX;
+    for (std::size_t i = 0; i < fieldName.size(); ++i) {
+        char c = fieldName[i];
+        _entries.buffer += c == '-' ? '_'
+            : static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    }
+    _entries.buffer += '=';
+    _entries.buffer += value;
+    _entries.buffer += '\0';
+}
+
+char* const* CgiEnvironment::getEnvp() {
+    _envp.clear();
+    for (std::size_t i = 0; i < _entries.offsets.size(); ++i) {
+        _envp.push_back(&_entries.buffer[_entries.offsets[i]]);
+    }
+    _envp.push_back(NULL);
+    return &_envp[0];
+}
+
+std::string CgiEnvironment::encodeFastcgi() const {
+    std::string out;
+    out.reserve(_entries.buffer.size() + _entries.offsets.size() * 2);
+    for (std::size_t i = 0; i < _entries.offsets.size(); ++i) {
+        const char* entry = _entries.buffer.data() + _entries.offsets[i];
+        std::size_t length = std::strlen(entry);
+        const char* equal = static_cast<const char*>(
+            std::memchr(entry, '=', length));
+        std::size_t nameLength = equal - entry;
+        fastcgi::appendNameValue(&out, entry, nameLength, equal + 1,
+                                 length - nameLength - 1);
+    }
+    return out;
+}
+
+}  // namespace http
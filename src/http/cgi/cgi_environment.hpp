@@ -0,0 +1,77 @@
+// Copyright 2025 Ideal Broccoli
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "../../config/config.hpp"
+
+namespace http {
+
+/**
+ * @brief The environment of one CGI request, kept as "NAME=value" entries
+ * in a single buffer.
+ *
+ * The variables that only depend on the listener (gateway, software,
+ * SERVER_PORT and the ones this server always leaves empty) are prepared
+ * once per port when the configuration is loaded; each request starts from
+ * a copy of its port's entries and appends its own. The buffer keeps its
+ * capacity across reset(), so a keep-alive connection builds the
+ * environment of later requests without allocating.
+ *
+ * Usage example:
+ * @code
+ * CgiEnvironment::prepare(*config::Config::getHttpConfig());
+ * // ... per request:
+ * environment.reset(client->getServerPort());
+ * environment.set(cgi::meta::REQUEST_METHOD, request.method);
+ * environment.setHeader("user-agent", "curl");     // HTTP_USER_AGENT
+ * launcher.launch(path, argv, environment.getEnvp());
+ * @endcode
+ *
+ * Names are not checked for duplicates: each variable is set once.
+ */
+class CgiEnvironment {
+ public:
+    CgiEnvironment();
+    ~CgiEnvironment();
+
+    static void prepare(const config::HttpConfig& httpConfig);
+
+    void reset(std::size_t serverPort);
+    void clear();
+    void set(const char* name, const std::string& value);
+    void setHeader(const std::string& fieldName, const std::string& value);
+
+    /**
+     * @brief NULL-terminated pointers into the buffer, valid until the
+     * next change.
+     */
+    char* const* getEnvp();
+
+    /**
+     * @brief The entries as FastCGI PARAMS name-value pairs.
+     */
+    std::string encodeFastcgi() const;
+
+ private:
+    struct Entries {
+        std::string buffer;
+        std::vector<std::size_t> offsets;
+    };
+
+    CgiEnvironment(const CgiEnvironment& other);
+    CgiEnvironment& operator=(const CgiEnvironment& other);
+
+    static std::map<std::size_t, Entries>& getTemplates();
+    static const Entries& getTemplate(std::size_t serverPort);
+    static void append(Entries* entries, const char* name,
+                       const std::string& value);
+
+    Entries _entries;
+    std::vector<char*> _envp;
+};
+
+}  // namespace http
@@ -1,5 +1,6 @@
 // Copyright 2025 Ideal Broccoli
 
+#include <algorithm>
 #include <cstring>
 #include <iostream>
 #include <cstdlib>
@@ -10,6 +11,8 @@
 #include <ctime>
 
 #include <fcntl.h>
+#include <poll.h>
+#include <sys/epoll.h>
 #include <sys/wait.h>
 #include <sys/stat.h>
 #include <signal.h>
@@ -18,11 +21,23 @@
 #include "../request/request.hpp"
 #include "../response/method_utils.hpp"
 #include "../../core/constant.hpp"
+#include "../../core/metrics.hpp"
 #include "../../event/epoll.hpp"
+#include "../../event/child_launcher.hpp"
+#include "../../event/child_reaper.hpp"
+#include "../fastcgi/fastcgi_pool.hpp"
+#include "../fastcgi/fastcgi_record.hpp"
 #include "../../../toolbox/stepmark.hpp"
 #include "../../../toolbox/string.hpp"
 
 namespace http {
+namespace {
+// - True while a Content-Length body is still being received; the rest
+//   of it is handed over through appendRequestBody().
+bool isBodyIncomplete(const HTTPRequest::Body& body) {
+    return !body.isChunked && body.receivedLength < body.contentLength;
+}
+}  // namespace
 
 CgiExecute::CgiExecute() :
 _childPid(-1),
@@ -35,10 +50,17 @@ _writeState(WRITE_IDLE),
 _totalBytes(0),
 _bytesWritten(0),
 _writeBuffer(),
+_isBodyStreaming(false),
+_isInputWatched(false),
 _readState(READ_IDLE),
 _parser(),
+_isStreaming(false),
+_streamOutput(),
+_isOutputWatched(false),
 _readStartTime(0),
-_lastReadTime(0) {
+_client(NULL),
+_backend(BACKEND_PROCESS),
+_fastcgi() {
     _inputPipe[0] = -1;
     _inputPipe[1] = -1;
     _outputPipe[0] = -1;
@@ -46,10 +68,12 @@ _lastReadTime(0) {
 }
 
 CgiExecute::~CgiExecute() {
+    terminateChildProcess();
     cleanupPipes();
 }
 
 void CgiExecute::reset() {
+    terminateChildProcess();
     cleanupPipes();
     _childPid = -1;
     _timeoutSeconds = http::cgi::TIMEOUT;
@@ -61,18 +85,21 @@ void CgiExecute::reset() {
     _totalBytes = 0;
     _bytesWritten = 0;
     _writeBuffer.clear();
+    _isBodyStreaming = false;
+    _isInputWatched = false;
     _readState = READ_IDLE;
     _parser.reset();
+    _isStreaming = false;
+    _streamOutput.clear();
+    _isOutputWatched = false;
     _readStartTime = 0;
-    _lastReadTime = 0;
-    _lastWriteTime = 0;
     _inputPipe[0] = -1;
     _inputPipe[1] = -1;
     _outputPipe[0] = -1;
     _outputPipe[1] = -1;
     _environment.clear();
-    _envStrings.clear();
     _client = NULL;
+    _backend = BACKEND_PROCESS;
 }
 
 CgiExecute::ExecuteResult CgiExecute::execute(
@@ -83,7 +110,7 @@ CgiExecute::ExecuteResult CgiExecute::execute(
                                 const config::LocationConfig& locationConfig) {
     _client = client;
     if (!validateScriptPath(scriptPath)) {
-        toolbox::logger::StepMark::error(
+        STEPMARK_ERROR(
             "Invalid CGI script path: " + scriptPath);
         return EXECUTE_PATH_ERROR;
     }
@@ -94,7 +121,7 @@ CgiExecute::ExecuteResult CgiExecute::execute(
         return result;
     }
     _startTime = std::time(NULL);
-    if (!forkAndExecute(scriptPath, interpreter)) {
+    if (!launchScript(scriptPath, interpreter)) {
         cleanupPipes();
         return EXECUTE_FORK_ERROR;
     }
@@ -106,6 +133,73 @@ CgiExecute::ExecuteResult CgiExecute::execute(
     return EXECUTE_SUCCESS;
 }
 
+// - The script is run by the application server, possibly on another
+//   filesystem, so it is not checked here; a missing one is its to report.
+//   The request is complete once submitted, so output is read straight away.
+CgiExecute::ExecuteResult CgiExecute::executeFastcgi(
+                                const std::string& scriptPath,
+                                const HTTPRequest& request,
+                                const Client* client,
+                                const config::LocationConfig& locationConfig) {
+    _client = client;
+    _backend = BACKEND_FASTCGI;
+    if (scriptPath.find("..") != std::string::npos) {
+        STEPMARK_ERROR(
+            "Invalid FastCGI script path: " + scriptPath);
+        return EXECUTE_PATH_ERROR;
+    }
+    createFastcgiRequest(scriptPath, request, client, locationConfig);
+    FastcgiPool::submit(locationConfig.getFastcgiPass(), _fastcgi);
+    return awaitFastcgiOutput();
+}
+
+// - Same as a forked CGI as far as the script can tell, except that the
+//   interpreter it runs in has served other requests before.
+CgiExecute::ExecuteResult CgiExecute::executePooled(
+                                const std::string& scriptPath,
+                                const std::string& interpreter,
+                                const HTTPRequest& request,
+                                const Client* client,
+                                const config::LocationConfig& locationConfig) {
+    _client = client;
+    _backend = BACKEND_POOL;
+    if (!validateScriptPath(scriptPath)) {
+        STEPMARK_ERROR(
+            "Invalid CGI script path: " + scriptPath);
+        return EXECUTE_PATH_ERROR;
+    }
+    createFastcgiRequest(scriptPath, request, client, locationConfig);
+    FastcgiPool::submitLocal(locationConfig.getCgiPool(), interpreter,
+                             _fastcgi);
+    return awaitFastcgiOutput();
+}
+
+void CgiExecute::createFastcgiRequest(
+                                const std::string& scriptPath,
+                                const HTTPRequest& request,
+                                const Client* client,
+                                const config::LocationConfig& locationConfig) {
+    setupEnvironmentVariables(request, scriptPath, client, locationConfig);
+    _environment.set(http::cgi::meta::SCRIPT_FILENAME, scriptPath);
+    _environment.set(http::cgi::meta::REQUEST_URI, request.uri.fullUri);
+    preparePostBody(request);
+    _fastcgi = toolbox::SharedPtr<FastcgiRequest>(new FastcgiRequest(
+        client->getFd(), _environment.encodeFastcgi(),
+        _hasPostBody ? request.body.content : std::string()));
+    _startTime = std::time(NULL);
+}
+
+CgiExecute::ExecuteResult CgiExecute::awaitFastcgiOutput() {
+    if (_fastcgi->state == FastcgiRequest::FAILED) {
+        _fastcgi.reset();
+        return EXECUTE_UPSTREAM_ERROR;
+    }
+    _writeState = WRITE_COMPLETED;
+    _readState = READ_IN_PROGRESS;
+    _readStartTime = _startTime;
+    return EXECUTE_READ_PENDING;
+}
+
 bool CgiExecute::validateScriptPath(const std::string& scriptPath) const {
     if (scriptPath.find("..") != std::string::npos) {
         return false;
@@ -127,77 +221,64 @@ void CgiExecute::setupEnvironmentVariables(const HTTPRequest& request,
                                 const std::string& scriptPath,
                                 const Client* client,
                                 const config::LocationConfig& locationConfig) {
-    _environment.clear();
-    _environment[http::cgi::meta::AUTH_TYPE] = "";
-    setServerVariables(request, client);
+    _environment.reset(client->getServerPort());
+    setServerVariables(request);
     setClientVariables(client);
     setRequestVariables(request);
     setPathVariables(request, scriptPath, locationConfig.getRoot());
     convertHeadersToEnv(request);
 }
 
-void CgiExecute::setServerVariables(const HTTPRequest& request,
-                                    const Client* client) {
-    _environment[http::cgi::meta::SERVER_SOFTWARE] = http::cgi::SERVER_SOFTWARE;
+// - SERVER_PORT and the fixed variables come with the listener's
+//   template.
+void CgiExecute::setServerVariables(const HTTPRequest& request) {
     const HTTPFields::FieldValue& hostValues =
                         request.fields.getFieldValue(http::fields::HOST);
     if (hostValues.empty()) {
-        _environment[http::cgi::meta::SERVER_NAME] = "";
-    } else {
-        _environment[http::cgi::meta::SERVER_NAME] = hostValues.front();
-    }
-    std::size_t serverPort = client->getServerPort();
-    if (serverPort == 0) {
-        _environment[http::cgi::meta::SERVER_PORT] = "";
+        _environment.set(http::cgi::meta::SERVER_NAME, "");
     } else {
-        _environment[http::cgi::meta::SERVER_PORT] =
-                                toolbox::to_string(serverPort);
+        _environment.set(http::cgi::meta::SERVER_NAME, hostValues.front());
     }
-    _environment[http::cgi::meta::SERVER_PROTOCOL] = request.version;
-    _environment[http::cgi::meta::GATEWAY_INTERFACE] =
-                                        http::cgi::GATEWAY_INTERFACE;
+    _environment.set(http::cgi::meta::SERVER_PROTOCOL, request.version);
 }
 
 void CgiExecute::setClientVariables(const Client* client) {
-    _environment[http::cgi::meta::REMOTE_ADDR] = client->getIp();
-    _environment[http::cgi::meta::REMOTE_HOST] = "";
-    _environment[http::cgi::meta::REMOTE_IDENT] = "";
-    _environment[http::cgi::meta::REMOTE_USER] = "";
+    _environment.set(http::cgi::meta::REMOTE_ADDR, client->getIp());
 }
 
 void CgiExecute::setRequestVariables(const HTTPRequest& request) {
-    _environment[http::cgi::meta::REQUEST_METHOD] = request.method;
+    _environment.set(http::cgi::meta::REQUEST_METHOD, request.method);
     std::string query = request.uri.fullQuery;
     if (!query.empty() && query[0] == '?') {
         query = query.substr(1);
     }
-    _environment[http::cgi::meta::QUERY_STRING] = query;
+    _environment.set(http::cgi::meta::QUERY_STRING, query);
     const HTTPFields::FieldValue& lengthValues =
         request.fields.getFieldValue(http::fields::CONTENT_LENGTH);
     if (!lengthValues.empty()) {
         const std::string& contentLength = lengthValues.front();
         if (!contentLength.empty()) {
-            _environment[http::cgi::meta::CONTENT_LENGTH] = contentLength;
+            _environment.set(http::cgi::meta::CONTENT_LENGTH, contentLength);
         } else {
-            _environment[http::cgi::meta::CONTENT_LENGTH] =
-                toolbox::to_string(request.body.contentLength);
+            _environment.set(http::cgi::meta::CONTENT_LENGTH,
+                toolbox::to_string(request.body.contentLength));
         }
     } else if (request.body.isChunked) {
-        _environment[http::cgi::meta::CONTENT_LENGTH] =
-            toolbox::to_string(request.body.content.size());
+        _environment.set(http::cgi::meta::CONTENT_LENGTH,
+            toolbox::to_string(request.body.content.size()));
     }
-    if (request.body.content.size() > 0) {
+    if (request.body.content.size() > 0 || isBodyIncomplete(request.body)) {
         const HTTPFields::FieldValue& typeValues =
             request.fields.getFieldValue(http::fields::CONTENT_TYPE);
         if (!typeValues.empty()) {
             const std::string& contentType = typeValues.front();
             if (!contentType.empty()) {
-                _environment[http::cgi::meta::CONTENT_TYPE] = contentType;
+                _environment.set(http::cgi::meta::CONTENT_TYPE, contentType);
             } else {
-                _environment[http::cgi::meta::CONTENT_TYPE] = "";
+                _environment.set(http::cgi::meta::CONTENT_TYPE, "");
             }
         } else {
-            _environment[http::cgi::meta::CONTENT_TYPE] = "";
+            _environment.set(http::cgi::meta::CONTENT_TYPE, "");
         }
     }
 }
@@ -206,13 +287,14 @@ void CgiExecute::setPathVariables(const HTTPRequest& request,
                                 const std::string& scriptPath,
                                 const std::string& rootPath) {
     std::string scriptName = extractScriptName(request.uri.path, scriptPath);
-    _environment[http::cgi::meta::SCRIPT_NAME] = scriptName;
-    _environment[http::cgi::meta::UPLOAD_DIR] = _client->getRequest()->getUploadPath();
+    _environment.set(http::cgi::meta::SCRIPT_NAME, scriptName);
+    _environment.set(http::cgi::meta::UPLOAD_DIR,
+                     _client->getRequest()->getUploadPath());
     std::string pathInfo = request.uri.path;
     if (!pathInfo.empty()) {
-        _environment[http::cgi::meta::PATH_INFO] = pathInfo;
-        _environment[http::cgi::meta::PATH_TRANSLATED] =
-                                http::joinPath(rootPath, pathInfo);
+        _environment.set(http::cgi::meta::PATH_INFO, pathInfo);
+        _environment.set(http::cgi::meta::PATH_TRANSLATED,
+                         http::joinPath(rootPath, pathInfo));
     }
 }
 
@@ -220,25 +302,15 @@ void CgiExecute::convertHeadersToEnv(const HTTPRequest& request) {
     const HTTPFields::FieldMap& fieldsMap = request.fields.get();
     for (HTTPFields::FieldMap::const_iterator it = fieldsMap.begin();
         it != fieldsMap.end(); ++it) {
-        std::string name = it->first;
+        const std::string& name = it->first;
         if (name == http::fields::CONTENT_TYPE
             || name == http::fields::CONTENT_LENGTH
             || name == http::fields::AUTHORIZATION) {
             continue;
         }
-        std::string envName = http::cgi::ENV_PREFIX;
-        for (std::size_t i = 0; i < name.size(); i++) {
-            char c = name[i];
-            if (c == '-') {
-                envName += '_';
-            } else {
-                envName += std::toupper(c);
-            }
-        }
         const HTTPFields::FieldValue& values = it->second;
         if (!values.empty()) {
-            const std::string& value = values.front();
-            _environment[envName] = value;
+            _environment.setHeader(name, values.front());
         }
     }
 }
@@ -248,26 +320,28 @@ void CgiExecute::preparePostBody(const HTTPRequest& request) {
                     request.method == http::method::POST);
 }
 
+// - All ends are close-on-exec so that a CGI never inherits the pipes of
+//   another request; dup2() clears the flag on the child's stdin/stdout.
 CgiExecute::ExecuteResult CgiExecute::createPipes() {
-    if (pipe(_outputPipe) == -1) {
-        toolbox::logger::StepMark::error("Failed to create output pipe");
+    if (pipe2(_outputPipe, O_CLOEXEC) == -1) {
+        STEPMARK_ERROR("Failed to create output pipe");
         return EXECUTE_IO_ERROR;
     }
     if (!setNonBlocking(_outputPipe[0])) {
         cleanupPipes();
-        toolbox::logger::StepMark::error(
+        STEPMARK_ERROR(
             "Failed to set output pipe read end to non-blocking");
         return EXECUTE_IO_ERROR;
     }
     if (_hasPostBody) {
-        if (pipe(_inputPipe) == -1) {
+        if (pipe2(_inputPipe, O_CLOEXEC) == -1) {
             cleanupPipes();
-            toolbox::logger::StepMark::error("Failed to create input pipe");
+            STEPMARK_ERROR("Failed to create input pipe");
             return EXECUTE_IO_ERROR;
         }
         if (!setNonBlocking(_inputPipe[1])) {
             cleanupPipes();
-            toolbox::logger::StepMark::error(
+            STEPMARK_ERROR(
                 "Failed to set input pipe write end to non-blocking");
             return EXECUTE_IO_ERROR;
         }
@@ -275,107 +349,38 @@ CgiExecute::ExecuteResult CgiExecute::createPipes() {
     return EXECUTE_SUCCESS;
 }
 
-bool CgiExecute::forkAndExecute(const std::string& scriptPath,
-                                const std::string& interpreter) {
-    if (!createChildProcess()) {
-        return false;
+// - The script runs in its own directory and is named relative to it.
+bool CgiExecute::launchScript(const std::string& scriptPath,
+                              const std::string& interpreter) {
+    ChildLauncher launcher;
+    std::size_t lastSlashPos = scriptPath.find_last_of('/');
+    if (lastSlashPos != std::string::npos) {
+        launcher.changeDirectory(scriptPath.substr(0, lastSlashPos));
     }
-    if (_childPid == 0) {
-        std::size_t lastSlashPos = scriptPath.find_last_of('/');
-        if (lastSlashPos != std::string::npos && chdir(scriptPath.substr(0, lastSlashPos).c_str()) != 0) {
-            toolbox::logger::StepMark::error(
-                "Failed to change directory to CGI script directory: "
-                + scriptPath.substr(0, lastSlashPos));
-            std::exit(127);
-        }
-        std::string newPath = scriptPath.substr(lastSlashPos + 1);
-        executeChildProcess(newPath, interpreter);
-        toolbox::logger::StepMark::error(
-            "Child process failed to execute CGI script");
-        std::exit(127);
+    setupChildIORedirection(&launcher);
+    std::vector<std::string> argv;
+    if (!interpreter.empty()) {
+        argv.push_back(interpreter);
     }
-    closeUnusedPipeEnds();
-    return true;
-}
-
-bool CgiExecute::createChildProcess() {
-    _childPid = fork();
+    argv.push_back(scriptPath.substr(lastSlashPos + 1));
+    _childPid = launcher.launch(argv[0], argv, _environment.getEnvp());
     if (_childPid == -1) {
-        toolbox::logger::StepMark::error("Fork failed");
+        STEPMARK_ERROR(
+            "Failed to start CGI script: " + scriptPath);
         return false;
     }
+    ChildReaper::watch(_childPid, this);
+    closeUnusedPipeEnds();
     return true;
 }
 
-void CgiExecute::executeChildProcess(const std::string& scriptPath,
-                                const std::string& interpreter) {
-    setupChildIORedirection();
-    std::vector<char*> envp = prepareEnvironmentVariables();
-    executeScript(scriptPath, interpreter, envp);
-}
-
-void CgiExecute::setupChildIORedirection() {
+void CgiExecute::setupChildIORedirection(ChildLauncher* launcher) const {
     if (_hasPostBody) {
-        dup2(_inputPipe[0], STDIN_FILENO);
+        launcher->redirect(_inputPipe[0], STDIN_FILENO);
     } else {
-        setupNullStdin();
-    }
-    dup2(_outputPipe[1], STDOUT_FILENO);
-    closeChildPipeEnds();
-}
-
-void CgiExecute::setupNullStdin() {
-    int nullfd = open("/dev/null", O_RDONLY);
-    if (nullfd != -1) {
-        dup2(nullfd, STDIN_FILENO);
-        close(nullfd);
-    }
-}
-
-void CgiExecute::closeChildPipeEnds() {
-    if (_hasPostBody) {
-        if (_inputPipe[1] != STDOUT_FILENO && _inputPipe[1] != STDIN_FILENO) {
-            wrapClose(_inputPipe[1]);
-        }
-    }
-    if (_outputPipe[0] != STDOUT_FILENO && _outputPipe[0] != STDIN_FILENO) {
-        wrapClose(_outputPipe[0]);
-    }
-    if (_outputPipe[1] != STDOUT_FILENO && _outputPipe[1] != STDIN_FILENO) {
-        wrapClose(_outputPipe[1]);
-    }
-}
-
-std::vector<char*> CgiExecute::prepareEnvironmentVariables() {
-    _envStrings.clear();
-    for (std::map<std::string, std::string>::const_iterator it =
-        _environment.begin();
-        it != _environment.end(); ++it) {
-        _envStrings.push_back(it->first + "=" + it->second);
-    }
-    std::vector<char*> envp;
-    for (std::size_t i = 0; i < _envStrings.size(); ++i) {
-        envp.push_back(const_cast<char*>(_envStrings[i].c_str()));
-    }
-    envp.push_back(NULL);
-    return envp;
-}
-
-void CgiExecute::executeScript(const std::string& scriptPath,
-                            const std::string& interpreter,
-                            const std::vector<char*>& envp) {
-    if (!interpreter.empty()) {
-        char* argv[3];
-        argv[0] = const_cast<char*>(interpreter.c_str());
-        argv[1] = const_cast<char*>(scriptPath.c_str());
-        argv[2] = NULL;
-        execve(interpreter.c_str(), argv, const_cast<char**>(&envp[0]));
-    } else {
-        char* argv[2];
-        argv[0] = const_cast<char*>(scriptPath.c_str());
-        argv[1] = NULL;
-        execve(scriptPath.c_str(), argv, const_cast<char**>(&envp[0]));
+        launcher->redirectToNull(STDIN_FILENO, O_RDONLY);
     }
+    launcher->redirect(_outputPipe[1], STDOUT_FILENO);
 }
 
 void CgiExecute::closeUnusedPipeEnds() {
@@ -412,11 +417,6 @@ CgiExecute::ExecuteResult CgiExecute::processData(
     } else if (_readState != READ_COMPLETED) {
         return EXECUTE_READ_PENDING;
     }
-    if (!waitForChildProcess()) {
-        terminateChildProcess();
-        cleanupPipes();
-        return EXECUTE_TIMEOUT;
-    }
     if (_isExecveError) {
         cleanupPipes();
         return EXECUTE_EXEC_ERROR;
@@ -425,31 +425,61 @@ CgiExecute::ExecuteResult CgiExecute::processData(
 }
 
 
+// - A body that is still arriving starts out empty; the pipe is only
+//   watched while there is something to write to it.
 bool CgiExecute::initWriteRequestBody(const HTTPRequest& request) {
     if (!_hasPostBody) {
         _writeState = WRITE_COMPLETED;
         return true;
     }
     _writeState = WRITE_IN_PROGRESS;
-    _writeBuffer = request.body.content;
+    _isBodyStreaming = isBodyIncomplete(request.body);
+    _writeBuffer = _isBodyStreaming ? std::string() : request.body.content;
     _totalBytes = _writeBuffer.size();
     _bytesWritten = 0;
+    watchInput(_totalBytes > 0);
+    if (_totalBytes > 0 && !_isInputWatched) {
+        _writeState = WRITE_ERROR;
+    }
     return false;
 }
 
+// - Bytes the script will not read (it closed stdin, or failed) are
+//   dropped; the client still has to send them.
+void CgiExecute::appendRequestBody(std::string* data, bool isLast) {
+    if (_writeState == WRITE_IN_PROGRESS && _inputPipe[1] != -1) {
+        _writeBuffer.erase(0, _bytesWritten);
+        _writeBuffer.append(*data);
+        _bytesWritten = 0;
+        _totalBytes = _writeBuffer.size();
+        watchInput(_totalBytes > 0);
+    }
+    data->clear();
+    if (isLast && _isBodyStreaming) {
+        _isBodyStreaming = false;
+        // - The script's timeout counts from the end of the upload, as it
+        //   would if the body had been buffered first.
+        _startTime = std::time(NULL);
+    }
+}
+
+bool CgiExecute::wantsRequestBody() const {
+    return _isBodyStreaming
+        && _totalBytes - _bytesWritten < http::cgi::BODY_BUFFER_LIMIT;
+}
+
 bool CgiExecute::continueWriteRequestBody() {
     if (_writeState != WRITE_IN_PROGRESS) {
         return _writeState == WRITE_COMPLETED;
     }
     if (hasTimedOut()) {
         _isTimeOut = true;
-        toolbox::logger::StepMark::error("CGI write operation timed out");
+        STEPMARK_ERROR("CGI write operation timed out");
         _writeState = WRITE_ERROR;
         return false;
     }
-    time_t currentTime = std::time(NULL);
-    if (_lastWriteTime != 0 && (currentTime - _lastWriteTime) < 1) {
-        return false;
+    if (_inputPipe[1] == -1 || _bytesWritten >= _totalBytes) {
+        return finishBodyWrite();
     }
     std::size_t remaining = _totalBytes - _bytesWritten;
     std::size_t writeSize = remaining;
@@ -458,24 +488,24 @@ bool CgiExecute::continueWriteRequestBody() {
     }
     ssize_t written =
         write(_inputPipe[1], _writeBuffer.c_str() + _bytesWritten, writeSize);
-    toolbox::logger::StepMark::info(
+    STEPMARK_INFO(
         "continueWriteRequestBody: write returned "
         + toolbox::to_string(written) + " bytes");
     if (written > 0) {
         _bytesWritten += written;
-        _lastWriteTime = 0;
         if (_bytesWritten >= _totalBytes) {
-            _writeState = WRITE_COMPLETED;
-            wrapClose(_inputPipe[1]);
-            toolbox::logger::StepMark::debug(
-                "POST data write completed, pipe closed");
-            return true;
+            return finishBodyWrite();
         }
         return false;
     } else if (written == -1) {
-        // Non-blocking write might return -1 when it would block
-        // Set timer for next retry attempt
-        _lastWriteTime = currentTime;
+        // Either the pipe is full, or the script closed its stdin without
+        // reading the body; in the latter case go on to read its output.
+        if (isPipeBroken(_inputPipe[1])) {
+            STEPMARK_WARNING(
+                "CGI closed stdin before the request body was written");
+            closePipe(_inputPipe[1]);
+            return finishBodyWrite();
+        }
         return false;
     } else {
         _writeState = WRITE_ERROR;
@@ -484,61 +514,116 @@ bool CgiExecute::continueWriteRequestBody() {
     return false;
 }
 
+// - An empty buffer only means waiting for the client while the body is
+//   still arriving; otherwise the script gets EOF.
+bool CgiExecute::finishBodyWrite() {
+    _writeBuffer.clear();
+    _totalBytes = 0;
+    _bytesWritten = 0;
+    if (_isBodyStreaming) {
+        watchInput(false);
+        return false;
+    }
+    _writeState = WRITE_COMPLETED;
+    closePipe(_inputPipe[1]);
+    STEPMARK_DEBUG(
+        "POST data write completed, pipe closed");
+    return true;
+}
+
 bool CgiExecute::initReadOutput() {
     if (_readState != READ_IDLE) {
         return _readState == READ_COMPLETED;
     }
-    if (isChildProcessEnded()) {
-        toolbox::logger::StepMark::warning(
+    if (!hasActiveChild()) {
+        STEPMARK_WARNING(
             "Child process already ended before reading output");
     }
+    if (!watchPipe(_outputPipe[0], EPOLLIN)) {
+        _readState = READ_ERROR;
+        return false;
+    }
+    _isOutputWatched = true;
     _readState = READ_IN_PROGRESS;
     _readStartTime = std::time(NULL);
     return false;
 }
 
 bool CgiExecute::continueReadOutput() {
+    if (_backend != BACKEND_PROCESS) {
+        return continueReadFastcgi();
+    }
     if (_readState != READ_IN_PROGRESS) {
         return _readState == READ_COMPLETED;
     }
     if (hasTimedOut()) {
         _isTimeOut = true;
-        toolbox::logger::StepMark::error("CGI read operation timed out");
+        STEPMARK_ERROR("CGI read operation timed out");
         _readState = READ_ERROR;
         return false;
     }
-    time_t currentTime = std::time(NULL);
-    time_t elapsed = currentTime - _readStartTime;
-    if (elapsed < 1) {
-        return false;
-    }
-    if (_lastReadTime != 0 && (currentTime - _lastReadTime) < 1) {
-        return false;
-    }
     char buffer[core::IO_BUFFER_SIZE];
     ssize_t bytes = read(_outputPipe[0], buffer, sizeof(buffer) - 1);
-    toolbox::logger::StepMark::info(
+    STEPMARK_INFO(
         "continueReadOutput: read returned "
         + toolbox::to_string(bytes) + " bytes");
+    bool completed;
     if (bytes > 0) {
-        _lastReadTime = 0;
-        return processReadBytes(buffer, bytes);
+        completed = processReadBytes(buffer, bytes);
     } else if (bytes == 0) {
-        return processEndOfFile();
+        completed = processEndOfFile();
     } else {
-        _lastReadTime = currentTime;
-        return handleReadError();
+        completed = handleReadError();
+    }
+    // - A pipe at EOF stays readable; stop watching it once reading is over.
+    if (_readState != READ_IN_PROGRESS) {
+        closePipe(_outputPipe[0]);
+    }
+    return completed;
+}
+
+// - FCGI_STDOUT collected by the pool takes the place of the pipe;
+//   FCGI_END_REQUEST takes the place of EOF.
+bool CgiExecute::continueReadFastcgi() {
+    if (_readState != READ_IN_PROGRESS) {
+        return _readState == READ_COMPLETED;
+    }
+    if (hasTimedOut()) {
+        _isTimeOut = true;
+        STEPMARK_ERROR("FastCGI request timed out");
+        _readState = READ_ERROR;
+        return false;
+    }
+    if (_fastcgi->state == FastcgiRequest::FAILED) {
+        STEPMARK_ERROR("FastCGI request failed");
+        _readState = READ_ERROR;
+        return false;
+    }
+    bool completed = false;
+    if (!_fastcgi->output.empty()) {
+        std::string output;
+        output.swap(_fastcgi->output);
+        completed = processReadBytes(output.data(), output.size());
     }
+    if (_readState == READ_IN_PROGRESS &&
+        _fastcgi->state == FastcgiRequest::ENDED) {
+        completed = processEndOfFile();
+    }
+    return completed;
 }
 
 bool CgiExecute::processReadBytes(const char* buffer, std::size_t bytes) {
+    if (_isStreaming) {
+        _streamOutput.append(buffer, bytes);
+        return false;
+    }
     BaseParser::ParseStatus status = _parser.run(std::string(buffer, bytes));
     if (status == BaseParser::P_COMPLETED) {
         _readState = READ_COMPLETED;
         _parser.get().identifyCgiType();
         return true;
     } else if (status == BaseParser::P_ERROR) {
-        toolbox::logger::StepMark::error("CGI response parsing error");
+        STEPMARK_ERROR("CGI response parsing error");
         _readState = READ_ERROR;
         return false;
     }
@@ -547,9 +632,13 @@ bool CgiExecute::processReadBytes(const char* buffer, std::size_t bytes) {
 }
 
 bool CgiExecute::processEndOfFile() {
+    if (_isStreaming) {
+        _readState = READ_COMPLETED;
+        return true;
+    }
     BaseParser::ParseStatus status = _parser.run("");
     if (status == BaseParser::P_ERROR) {
-        toolbox::logger::StepMark::error("CGI response parsing error at EOF");
+        STEPMARK_ERROR("CGI response parsing error at EOF");
         _readState = READ_ERROR;
         return false;
     }
@@ -561,12 +650,11 @@ bool CgiExecute::processEndOfFile() {
 bool CgiExecute::handleReadError() {
     if (hasTimedOut()) {
         _isTimeOut = true;
-        toolbox::logger::StepMark::error("CGI execution timed out");
+        STEPMARK_ERROR("CGI execution timed out");
         _readState = READ_ERROR;
         return false;
     }
-    bool childEnded = isChildProcessEnded();
-    if (childEnded) {
+    if (!hasActiveChild()) {
         const int READ_TIMEOUT = http::cgi::READ_TIMEOUT_SEC;
         if ((std::time(NULL) - _readStartTime) > READ_TIMEOUT) {
             _readState = READ_ERROR;
@@ -576,31 +664,9 @@ bool CgiExecute::handleReadError() {
     return false;
 }
 
-bool CgiExecute::isChildProcessEnded() {
-    if (_childPid <= 0) {
-        return true;
-    }
-    int status;
-    pid_t result = waitpid(_childPid, &status, WNOHANG);
-    return (result == _childPid);
-}
-
-bool CgiExecute::waitForChildProcess() {
-    int status;
-    while (true) {
-        pid_t result = waitpid(_childPid, &status, WNOHANG);
-        if (result == _childPid) {
-            return handleProcessExit(status);
-        }
-        if (result == -1) {
-            _childPid = -1;
-            return true;
-        }
-        if (hasTimedOut()) {
-            _isTimeOut = true;
-            toolbox::logger::StepMark::error("CGI execution timed out");
-            return false;
-        }
+void CgiExecute::onChildExit(pid_t pid, int status) {
+    if (pid == _childPid) {
+        handleProcessExit(status);
     }
 }
 
@@ -608,14 +674,14 @@ bool CgiExecute::handleProcessExit(int status) {
     if (WIFEXITED(status)) {
         int exitCode = WEXITSTATUS(status);
         if (exitCode != 0) {
-            toolbox::logger::StepMark::warning(
+            STEPMARK_WARNING(
                 "CGI exited with status: " + toolbox::to_string(exitCode));
             if (exitCode == 127) {
                 _isExecveError = true;
             }
         }
     } else if (WIFSIGNALED(status)) {
-        toolbox::logger::StepMark::warning(
+        STEPMARK_WARNING(
                 "CGI terminated by signal: "
                 + toolbox::to_string(WTERMSIG(status)));
     }
@@ -624,7 +690,12 @@ bool CgiExecute::handleProcessExit(int status) {
 }
 
 
+// - Not while the request body is still arriving; the client timeout
+//   covers a stalled upload.
 bool CgiExecute::hasTimedOut() const {
+    if (_isBodyStreaming) {
+        return false;
+    }
     time_t currentTime = std::time(NULL);
     time_t elapsed = currentTime - _startTime;
     if (elapsed > _timeoutSeconds) {
@@ -634,19 +705,41 @@ bool CgiExecute::hasTimedOut() const {
 }
 
 void CgiExecute::terminateChildProcess() {
+    if (_fastcgi) {
+        FastcgiPool::cancel(_fastcgi);
+        _fastcgi.reset();
+    }
     if (_childPid > 0) {
-        kill(_childPid, SIGTERM);
-        kill(_childPid, SIGKILL);
-        waitpid(_childPid, NULL, 0);
+        ChildReaper::release(_childPid, std::time(NULL));
+        _childPid = -1;
+    }
+}
+
+// - The output is complete, so the script is normally exiting already; it
+//   is only signalled if it is still around when its timeout expires.
+void CgiExecute::releaseChildProcess() {
+    if (_fastcgi) {
+        FastcgiPool::release(_fastcgi);
+        _fastcgi.reset();
+    }
+    if (_childPid > 0) {
+        ChildReaper::release(_childPid, _startTime + _timeoutSeconds);
         _childPid = -1;
     }
 }
 
 void CgiExecute::cleanupPipes() {
     wrapClose(_inputPipe[0]);
-    wrapClose(_inputPipe[1]);
-    wrapClose(_outputPipe[0]);
+    closePipe(_inputPipe[1]);
+    closePipe(_outputPipe[0]);
     wrapClose(_outputPipe[1]);
+    _isInputWatched = false;
+    _isOutputWatched = false;
+}
+
+bool CgiExecute::isRunning() const {
+    return _childPid > 0 || _inputPipe[1] != -1 || _outputPipe[0] != -1
+        || _fastcgi;
 }
 
 void CgiExecute::wrapClose(int& fd) {
@@ -656,14 +749,75 @@ void CgiExecute::wrapClose(int& fd) {
     }
 }
 
+// - Parent ends may be registered in epoll; the registration has to go
+//   before the fd number can be reused. The child only uses wrapClose(),
+//   as the epoll instance is shared with the parent.
+void CgiExecute::closePipe(int& fd) {
+    if (fd != -1) {
+        Epoll::delCgiPipe(fd);
+    }
+    wrapClose(fd);
+}
+
+bool CgiExecute::watchPipe(int fd, uint32_t events) {
+    try {
+        Epoll::addCgiPipe(fd, events, _client->getFd());
+    } catch (const std::exception& e) {
+        STEPMARK_ERROR(
+            std::string("CgiExecute: watchPipe: ") + e.what());
+        return false;
+    }
+    return true;
+}
+
+// - Used to throttle a stream: the pipe is left out of epoll while the
+//   client has too much output queued. Removing the registration rather
+//   than clearing EPOLLIN also silences EPOLLHUP, which epoll always reports.
+void CgiExecute::watchOutput(bool enable) {
+    if (_outputPipe[0] == -1 || enable == _isOutputWatched) {
+        return;
+    }
+    if (enable) {
+        _isOutputWatched = watchPipe(_outputPipe[0], EPOLLIN);
+    } else {
+        Epoll::delCgiPipe(_outputPipe[0]);
+        _isOutputWatched = false;
+    }
+}
+
+// - The body pipe is writable whenever it has room, so it is only in
+//   epoll while bytes are waiting for it.
+void CgiExecute::watchInput(bool enable) {
+    if (_inputPipe[1] == -1 || enable == _isInputWatched) {
+        return;
+    }
+    if (enable) {
+        _isInputWatched = watchPipe(_inputPipe[1], EPOLLOUT);
+    } else {
+        Epoll::delCgiPipe(_inputPipe[1]);
+        _isInputWatched = false;
+    }
+}
+
+bool CgiExecute::isPipeBroken(int fd) const {
+    struct pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = POLLOUT;
+    pfd.revents = 0;
+    if (poll(&pfd, 1, 0) == -1) {
+        return false;
+    }
+    return (pfd.revents & (POLLERR | POLLHUP)) != 0;
+}
+
 bool CgiExecute::setNonBlocking(int fd) {
     int flags = fcntl(fd, F_GETFL, 0);
     if (flags == -1) {
-        toolbox::logger::StepMark::error("Failed to get file descriptor flags");
+        STEPMARK_ERROR("Failed to get file descriptor flags");
         return false;
     }
     if (fcntl(fd, F_SETFL, flags | O_NONBLOCK) == -1) {
-        toolbox::logger::StepMark::error("Failed to set non-blocking mode");
+        STEPMARK_ERROR("Failed to set non-blocking mode");
         return false;
     }
     return true;
@@ -685,6 +839,81 @@ std::string CgiExecute::extractScriptName(const std::string& requestPath,
     return requestPath;
 }
 
+bool CgiExecute::isHeaderComplete() const {
+    return _parser.getValidatePos() == BaseParser::V_BODY;
+}
+
+// - Once the header section is parsed, output bypasses the parser and is
+//   collected raw until the handler takes it.
+void CgiExecute::startStreaming() {
+    _isStreaming = true;
+    _streamOutput = _parser.get().body;
+    _parser.get().body.clear();
+}
+
+std::string CgiExecute::takeBufferedOutput() {
+    std::string output;
+    output.swap(_streamOutput);
+    return output;
+}
+
+// - Only a forked script writes into a pipe of ours; FastCGI output
+//   arrives in records that have to be decoded.
+bool CgiExecute::canRelay() const {
+    return _backend == BACKEND_PROCESS && _isStreaming
+        && _streamOutput.empty() && _readState == READ_IN_PROGRESS
+        && _outputPipe[0] != -1;
+}
+
+// - Moves output from the pipe to the socket in the kernel. A failed
+//   splice() does not tell which end would block, so both are polled.
+CgiExecute::RelayResult CgiExecute::relayOutput(int clientFd,
+                                                std::size_t maxBytes,
+                                                std::size_t* moved) {
+    *moved = 0;
+    if (hasTimedOut()) {
+        _isTimeOut = true;
+        STEPMARK_ERROR("CGI relay timed out");
+        _readState = READ_ERROR;
+        closePipe(_outputPipe[0]);
+        return RELAY_ERROR;
+    }
+    ssize_t bytes = splice(_outputPipe[0], NULL, clientFd, NULL,
+        std::min(maxBytes, core::SPLICE_CHUNK_SIZE),
+        SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    STEPMARK_INFO(
+        "relayOutput: splice returned " + toolbox::to_string(bytes) + " bytes");
+    if (bytes > 0) {
+        Metrics::bytesSent(bytes);
+        *moved = bytes;
+        return RELAY_MOVED;
+    }
+    if (bytes == 0) {
+        processEndOfFile();
+        closePipe(_outputPipe[0]);
+        return RELAY_END;
+    }
+    struct pollfd pfds[2];
+    pfds[0].fd = _outputPipe[0];
+    pfds[0].events = POLLIN;
+    pfds[0].revents = 0;
+    pfds[1].fd = clientFd;
+    pfds[1].events = POLLOUT;
+    pfds[1].revents = 0;
+    if (poll(pfds, 2, 0) != -1 && !(pfds[1].revents & (POLLERR | POLLHUP))) {
+        if (!(pfds[1].revents & POLLOUT)) {
+            return RELAY_WAIT_CLIENT;
+        }
+        if (!(pfds[0].revents & (POLLIN | POLLHUP))) {
+            return RELAY_WAIT_OUTPUT;
+        }
+    }
+    STEPMARK_ERROR("CGI relay to the client failed");
+    _readState = READ_ERROR;
+    closePipe(_outputPipe[0]);
+    return RELAY_ERROR;
+}
+
 bool CgiExecute::hasActiveChild() const {
     return _childPid > 0;
 }
@@ -6,6 +6,7 @@
 #include <map>
 #include <vector>
 #include <unistd.h>
+#include <stdint.h>
 #include <sys/types.h>
 
 #include "../request/http_request.hpp"
@@ -14,12 +15,16 @@
 #include "../../config/config_server.hpp"
 #include "../../config/config_location.hpp"
 #include "../../../toolbox/shared.hpp"
+#include "cgi_environment.hpp"
 #include "cgi_response.hpp"
 #include "cgi_response_parser.hpp"
 #include "../../core/client.hpp"
+#include "../../event/child_launcher.hpp"
+#include "../../event/child_reaper.hpp"
+#include "../fastcgi/fastcgi_request.hpp"
 
 namespace http {
-class CgiExecute {
+class CgiExecute : public ChildExitListener {
  public:
     enum ExecuteResult {
         EXECUTE_SUCCESS,
@@ -27,6 +32,7 @@ class CgiExecute {
         EXECUTE_FORK_ERROR,
         EXECUTE_EXEC_ERROR,
         EXECUTE_IO_ERROR,
+        EXECUTE_UPSTREAM_ERROR,
         EXECUTE_TIMEOUT,
         EXECUTE_WRITE_PENDING,
         EXECUTE_READ_PENDING
@@ -43,16 +49,36 @@ class CgiExecute {
         READ_COMPLETED,
         READ_ERROR
     };
+    enum RelayResult {
+        RELAY_MOVED,
+        RELAY_WAIT_OUTPUT,   // the script has not written more yet
+        RELAY_WAIT_CLIENT,   // the client socket is full
+        RELAY_END,           // the script closed its stdout
+        RELAY_ERROR
+    };
     CgiExecute();
-    ~CgiExecute();
+    virtual ~CgiExecute();
 
     ExecuteResult execute(const std::string& scriptPath,
                         const std::string& interpreter,
                         const HTTPRequest& request,
                         const Client* client,
                         const config::LocationConfig& locationConfig);
+    ExecuteResult executeFastcgi(const std::string& scriptPath,
+                        const HTTPRequest& request,
+                        const Client* client,
+                        const config::LocationConfig& locationConfig);
+    ExecuteResult executePooled(const std::string& scriptPath,
+                        const std::string& interpreter,
+                        const HTTPRequest& request,
+                        const Client* client,
+                        const config::LocationConfig& locationConfig);
+    bool isFastcgi() const { return _backend == BACKEND_FASTCGI; }
     bool initWriteRequestBody(const HTTPRequest& request);
     bool continueWriteRequestBody();
+    void appendRequestBody(std::string* data, bool isLast);
+    bool isBodyStreaming() const { return _isBodyStreaming; }
+    bool wantsRequestBody() const;
     bool isWriteComplete() const { return _writeState == WRITE_COMPLETED; }
     bool hasWriteError() const { return _writeState == WRITE_ERROR; }
 
@@ -62,17 +88,38 @@ class CgiExecute {
     bool isReadComplete() const { return _readState == READ_COMPLETED; }
     bool hasReadError() const { return _readState == READ_ERROR; }
     CgiResponse& getResponse() { return _parser.get(); }
+    bool isHeaderComplete() const;
+    void startStreaming();
+    std::string takeBufferedOutput();
+    bool canRelay() const;
+    RelayResult relayOutput(int clientFd, std::size_t maxBytes,
+                            std::size_t* moved);
+    void watchOutput(bool enable);
     void reset();
     void cleanupPipes();
+    bool isRunning() const;
     bool hasTimedOut() const;
-    bool waitForChildProcess();
     void terminateChildProcess();
+    void releaseChildProcess();
     bool hasActiveChild() const;
+    virtual void onChildExit(pid_t pid, int status);
 
  private:
+    enum Backend {
+        BACKEND_PROCESS,   // a child forked for this request
+        BACKEND_FASTCGI,   // fastcgi_pass
+        BACKEND_POOL       // a cgi_pool worker
+    };
+
     CgiExecute(const CgiExecute& other);
     CgiExecute& operator=(const CgiExecute& other);
 
+    void createFastcgiRequest(const std::string& scriptPath,
+                        const HTTPRequest& request,
+                        const Client* client,
+                        const config::LocationConfig& locationConfig);
+    ExecuteResult awaitFastcgiOutput();
+    bool continueReadFastcgi();
     bool processReadBytes(const char* buffer, std::size_t bytes);
     bool processEndOfFile();
     bool handleReadError();
@@ -81,8 +128,7 @@ class CgiExecute {
                                 const std::string& scriptPath,
                                 const Client* client,
                                 const config::LocationConfig& locationConfig);
-    void setServerVariables(const HTTPRequest& request,
-                        const Client* client);
+    void setServerVariables(const HTTPRequest& request);
     void setClientVariables(const Client* client);
     void setRequestVariables(const HTTPRequest& request);
     void setPathVariables(const HTTPRequest& request,
@@ -91,26 +137,21 @@ class CgiExecute {
     void convertHeadersToEnv(const HTTPRequest& request);
     void preparePostBody(const HTTPRequest& request);
     ExecuteResult createPipes();
-    bool forkAndExecute(const std::string& scriptPath,
-                        const std::string& interpreter);
-    bool createChildProcess();
-    void executeChildProcess(const std::string& scriptPath,
+    bool launchScript(const std::string& scriptPath,
                         const std::string& interpreter);
-    void setupChildIORedirection();
-    void setupNullStdin();
-    void closeChildPipeEnds();
-    std::vector<char*> prepareEnvironmentVariables();
-    void executeScript(const std::string& scriptPath,
-                    const std::string& interpreter,
-                    const std::vector<char*>& envp);
+    void setupChildIORedirection(ChildLauncher* launcher) const;
     void closeUnusedPipeEnds();
     ExecuteResult processData(const HTTPRequest& request);
-    bool isChildProcessEnded();
     std::string extractScriptName(const std::string& requestPath,
                                 const std::string& scriptPath) const;
     bool handleProcessExit(int status);
     bool validateScriptPath(const std::string& scriptPath) const;
     void wrapClose(int& fd);
+    void closePipe(int& fd);
+    bool watchPipe(int fd, uint32_t events);
+    void watchInput(bool enable);
+    bool finishBodyWrite();
+    bool isPipeBroken(int fd) const;
     bool setNonBlocking(int fd);
 
     pid_t _childPid;
@@ -118,21 +159,25 @@ class CgiExecute {
     int _outputPipe[2];
     unsigned int _timeoutSeconds;
     time_t _startTime;
-    std::map<std::string, std::string> _environment;
+    CgiEnvironment _environment;
     bool _hasPostBody;
     bool _isTimeOut;
     bool _isExecveError;
-    std::vector<std::string> _envStrings;
     WriteState _writeState;
     std::size_t _totalBytes;
     std::size_t _bytesWritten;
     std::string _writeBuffer;
+    bool _isBodyStreaming;
+    bool _isInputWatched;
     ReadState _readState;
     CgiResponseParser _parser;
+    bool _isStreaming;
+    std::string _streamOutput;
+    bool _isOutputWatched;
     time_t _readStartTime;
-    time_t _lastReadTime;
-    time_t _lastWriteTime;
     const Client* _client;
+    Backend _backend;
+    toolbox::SharedPtr<FastcgiRequest> _fastcgi;
 };
 
 }  // namespace http
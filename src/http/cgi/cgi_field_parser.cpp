@@ -14,13 +14,13 @@ bool CgiFieldParser::isUnique(const std::string& key) {
 
 void CgiFieldParser::handleInvalidFieldError
 (const std::string& key, HttpStatus& hs) {
-    toolbox::logger::StepMark::info("RequestFieldParser: invalid " + key);
+    STEPMARK_INFO("RequestFieldParser: invalid " + key);
     hs.set(HttpStatus::INTERNAL_SERVER_ERROR);
 }
 
 void CgiFieldParser::handleDuplicateFieldError
 (const std::string& key, HttpStatus& hs) {
-    toolbox::logger::StepMark::info("RequestFieldParser: duplicate " + key);
+    STEPMARK_INFO("RequestFieldParser: duplicate " + key);
     hs.set(HttpStatus::INTERNAL_SERVER_ERROR);
 }
 
@@ -1,5 +1,6 @@
 // Copyright 2025 Ideal Broccoli
 
+#include <cstdlib>
 #include <iostream>
 #include <vector>
 #include <string>
@@ -18,25 +19,77 @@
 
 namespace http {
 
-CgiHandler::CgiHandler() : _redirectCount(0) {
+CgiHandler::CgiHandler() : _cacheMaxSize(0), _isCacheFilling(false),
+    _isStreaming(false), _isRelayWaitingForClient(false), _isHeadRequest(false),
+    _redirectCount(0) {
 }
 
 CgiHandler::~CgiHandler() {
+    releaseTicket();
+    releaseCacheFill();
 }
 
 void CgiHandler::reset() {
+    releaseTicket();
+    releaseCacheFill();
     _execute.reset();
+    _isStreaming = false;
+    _isRelayWaitingForClient = false;
 }
 
 void CgiHandler::forceTerminate() {
-    if (_execute.hasActiveChild()) {
-        if (!_execute.waitForChildProcess()) {
-            _execute.terminateChildProcess();
-        }
-        _execute.cleanupPipes();
+    releaseTicket();
+    releaseCacheFill();
+    _execute.terminateChildProcess();
+    _execute.cleanupPipes();
+}
+
+void CgiHandler::finishProcess() {
+    releaseTicket();
+    _execute.releaseChildProcess();
+    _execute.cleanupPipes();
+}
+
+void CgiHandler::releaseTicket() {
+    if (_ticket) {
+        CgiLimiter::release(_ticket);
+        _ticket.reset();
+    }
+}
+
+// - Set after reset() by a request that missed the cache: its response is
+//   offered to CgiResponseCache once the CGI is done.
+void CgiHandler::fillCache(const std::string& key, std::size_t maxSize) {
+    _cacheKey = key;
+    _cacheMaxSize = maxSize;
+    _cacheBody.clear();
+    _isCacheFilling = true;
+}
+
+void CgiHandler::finishCacheFill() {
+    if (!_execute.isReadComplete()) {
+        releaseCacheFill();
+        return;
+    }
+    CgiResponse& cgiResponse = _execute.getResponse();
+    CgiResponseCache::store(_cacheKey, cgiResponse,
+                            _isStreaming ? _cacheBody : cgiResponse.body);
+    _isCacheFilling = false;
+    _cacheBody.clear();
+}
+
+void CgiHandler::releaseCacheFill() {
+    if (_isCacheFilling) {
+        CgiResponseCache::abandon(_cacheKey);
+        _isCacheFilling = false;
+        _cacheBody.clear();
     }
 }
 
+bool CgiHandler::hasTimedOut() const {
+    return _execute.isRunning() && _execute.hasTimedOut();
+}
+
 bool CgiHandler::isCgiRequest(const std::string& targetPath,
                             const std::vector<std::string>& cgiExtension,
                             const std::string& cgiPath) const {
@@ -46,6 +99,38 @@ bool CgiHandler::isCgiRequest(const std::string& targetPath,
     if (cgiPath.empty()) {
         return false;
     }
+    return hasCgiExtension(targetPath, cgiExtension);
+}
+
+// - With fastcgi_pass alone every request of the location goes to the
+//   application server; cgi_extension, if present, narrows that down.
+bool CgiHandler::isFastcgiRequest(const std::string& targetPath,
+                                  const config::LocationConfig& config) const {
+    if (!config.getFastcgiPass().isSet()) {
+        return false;
+    }
+    return config.getCgiExtensions().empty()
+        || hasCgiExtension(targetPath, config.getCgiExtensions());
+}
+
+// - Only a forked script reads its body from a pipe as it arrives. A
+//   chunked body is kept until complete: CONTENT_LENGTH has to be exact.
+//   Nor is a request that would have to queue, as it holds no process.
+bool CgiHandler::canStreamBody(const HTTPRequest& request,
+                               const config::LocationConfig& config) const {
+    if (request.method != http::method::POST || request.body.isChunked) {
+        return false;
+    }
+    if (config.getFastcgiPass().isSet() || config.getCgiPool().isSet()
+        || !CgiLimiter::hasFreeSlot(config)) {
+        return false;
+    }
+    return isCgiRequest(request.uri.path, config.getCgiExtensions(),
+                        config.getCgiPath());
+}
+
+bool CgiHandler::hasCgiExtension(const std::string& targetPath,
+                        const std::vector<std::string>& cgiExtension) const {
     std::size_t componentStart = 0;
     while (componentStart < targetPath.length()) {
         std::size_t componentEnd = targetPath.find('/', componentStart);
@@ -78,16 +163,35 @@ http::IOPendingState CgiHandler::handleRequest(
                         const config::LocationConfig& locationConfig,
                         const IOPendingState ioPendingState) {
     _client = client;
+    _isHeadRequest = request.method == http::method::HEAD;
+    IOPendingState state = dispatchRequest(request, response, locationConfig,
+                                           ioPendingState);
+    if (_isCacheFilling && state != CGI_QUEUED && state != CGI_BODY_SENDING
+        && state != CGI_OUTPUT_READING && state != CGI_OUTPUT_STREAMING) {
+        finishCacheFill();
+    }
+    return state;
+}
+
+http::IOPendingState CgiHandler::dispatchRequest(
+                        const HTTPRequest& request,
+                        Response& response,
+                        const config::LocationConfig& locationConfig,
+                        const IOPendingState ioPendingState) {
     switch (ioPendingState) {
         case NO_IO_PENDING:
         case CGI_LOCAL_REDIRECT_IO_PENDING:
             return executeInitialCgiRequest(request,
                                             response,
                                             locationConfig);
+        case CGI_QUEUED:
+            return continueCgiQueued(request, response, locationConfig);
         case CGI_BODY_SENDING:
             return continueCgiBodySending(response);
         case CGI_OUTPUT_READING:
             return continueCgiOutputReading(response);
+        case CGI_OUTPUT_STREAMING:
+            return continueCgiOutputStreaming(response);
         default:
             response.setStatus(HttpStatus::INTERNAL_SERVER_ERROR);
             return NO_IO_PENDING;
@@ -98,39 +202,81 @@ IOPendingState CgiHandler::executeInitialCgiRequest(
                         const HTTPRequest& request,
                         Response& response,
                         const config::LocationConfig& locationConfig) {
+    if (locationConfig.getCgiMaxConcurrency() > 0 && !_ticket) {
+        _ticket = CgiLimiter::acquire(locationConfig, _client->getFd());
+        if (_ticket->state == CgiTicket::REJECTED) {
+            return rejectOverload(response);
+        }
+        if (_ticket->state == CgiTicket::WAITING) {
+            return CGI_QUEUED;
+        }
+    }
     std::string scriptPath =
                 buildScriptPath(locationConfig.getRoot(),
                                 request.uri.path,
                                 locationConfig.getCgiExtensions());
+    if (locationConfig.getFastcgiPass().isSet()) {
+        return handleExecuteResult(_execute.executeFastcgi(
+            scriptPath, request, _client, locationConfig), response);
+    }
     std::string interpreter = locationConfig.getCgiPath();
     if (!validateParameters(scriptPath, interpreter,
                             locationConfig.getCgiExtensions(), response)) {
-        toolbox::logger::StepMark::error(
+        STEPMARK_ERROR(
             "CgiHandler::executeInitialCgiRequest: validateParameters failed");
         return NO_IO_PENDING;
     }
+    if (locationConfig.getCgiPool().isSet()) {
+        return handleExecuteResult(_execute.executePooled(
+            scriptPath, interpreter, request, _client, locationConfig), response);
+    }
     CgiExecute::ExecuteResult result = _execute.execute(
         scriptPath, interpreter, request, _client, locationConfig);
     return handleExecuteResult(result, response);
 }
 
+IOPendingState CgiHandler::continueCgiQueued(
+                        const HTTPRequest& request,
+                        Response& response,
+                        const config::LocationConfig& locationConfig) {
+    if (!_ticket || _ticket->state == CgiTicket::EXPIRED) {
+        STEPMARK_WARNING(
+            "CgiHandler: no CGI slot within cgi_queue_timeout");
+        return rejectOverload(response);
+    }
+    if (_ticket->state == CgiTicket::WAITING) {
+        return CGI_QUEUED;
+    }
+    return executeInitialCgiRequest(request, response, locationConfig);
+}
+
+IOPendingState CgiHandler::rejectOverload(Response& response) {
+    releaseTicket();
+    response.setStatus(HttpStatus::SERVICE_UNAVAILABLE);
+    response.setHeader(fields::RETRY_AFTER,
+                       toolbox::to_string(http::cgi::RETRY_AFTER_SEC));
+    return NO_IO_PENDING;
+}
+
 IOPendingState CgiHandler::continueCgiBodySending(Response& response) {
     _execute.continueWriteRequestBody();
     if (_execute.hasWriteError()) {
         forceTerminate();
         if (_execute.hasTimedOut()) {
-            toolbox::logger::StepMark::error(
+            STEPMARK_ERROR(
                 "CGI handler result: Write EXECUTE_TIMEOUT");
             response.setStatus(HttpStatus::GATEWAY_TIMEOUT);
         } else {
-            toolbox::logger::StepMark::error(
+            STEPMARK_ERROR(
                 "CGI handler result: Write error detected");
             response.setStatus(HttpStatus::INTERNAL_SERVER_ERROR);
         }
         return NO_IO_PENDING;
     }
     if (_execute.isWriteComplete()) {
-        return CGI_OUTPUT_READING;
+        // The output pipe is only watched from here on, so start reading
+        // now rather than waiting for an event that cannot come.
+        return continueCgiOutputReading(response);
     }
     return CGI_BODY_SENDING;
 }
@@ -141,12 +287,10 @@ IOPendingState CgiHandler::continueCgiOutputReading(Response& response) {
             if (_execute.hasReadError()) {
                 forceTerminate();
                 if (_execute.hasTimedOut()) {
-                    toolbox::logger::StepMark::error(
+                    STEPMARK_ERROR(
                         "CGI execute result: EXECUTE_TIMEOUT");
-                    response.setStatus(HttpStatus::GATEWAY_TIMEOUT);
-                } else {
-                    response.setStatus(HttpStatus::INTERNAL_SERVER_ERROR);
                 }
+                response.setStatus(getFailureStatus());
                 return NO_IO_PENDING;
             }
             return CGI_OUTPUT_READING;
@@ -157,34 +301,176 @@ IOPendingState CgiHandler::continueCgiOutputReading(Response& response) {
     if (_execute.hasReadError()) {
         forceTerminate();
         if (_execute.hasTimedOut()) {
-            toolbox::logger::StepMark::error(
+            STEPMARK_ERROR(
                 "CGI execute result: read EXECUTE_TIMEOUT");
-            response.setStatus(HttpStatus::GATEWAY_TIMEOUT);
-        } else {
-            response.setStatus(HttpStatus::INTERNAL_SERVER_ERROR);
         }
+        response.setStatus(getFailureStatus());
         return NO_IO_PENDING;
     }
     if (_execute.isReadComplete()) {
-        forceTerminate();
+        finishProcess();
         IOPendingState result =
         processCgiResponse(_execute.getResponse(), response);
         return result;
     }
+    if (_execute.isHeaderComplete() && _isHeadRequest && answerHead(response)) {
+        return NO_IO_PENDING;
+    }
+    if (_execute.isHeaderComplete() && startStreaming(response)) {
+        return continueCgiOutputStreaming(response);
+    }
     return CGI_OUTPUT_READING;
 }
 
+// - A HEAD is answered as soon as the headers are in if the script gave
+//   its length; otherwise the output is read to the end to count it.
+bool CgiHandler::answerHead(Response& response) {
+    CgiResponse& cgiResponse = _execute.getResponse();
+    const HTTPFields::FieldValue& lengthValues =
+        cgiResponse.fields.getFieldValue(fields::CONTENT_LENGTH);
+    if (lengthValues.empty() || !utils::isDigitStr(lengthValues.front())) {
+        return false;
+    }
+    cgiResponse.identifyCgiType();
+    if (cgiResponse.cgiType != CgiResponse::DOCUMENT ||
+        cgiResponse.httpStatus.get() >= HttpStatus::MULTIPLE_CHOICES) {
+        cgiResponse.cgiType = CgiResponse::INVALID;
+        return false;
+    }
+    handleDocument(response, cgiResponse);
+    response.setHeadLength(
+        std::strtoul(lengthValues.front().c_str(), NULL, 10));
+    forceTerminate();
+    STEPMARK_INFO("CgiHandler: answerHead: answered HEAD from the CGI headers");
+    return true;
+}
+
+// - Only successful documents are streamed. Redirects and error statuses
+//   still need the complete response (local redirects, error_page).
+bool CgiHandler::startStreaming(Response& response) {
+    if (!response.canStream()) {
+        return false;
+    }
+    CgiResponse& cgiResponse = _execute.getResponse();
+    cgiResponse.identifyCgiType();
+    if (cgiResponse.cgiType != CgiResponse::DOCUMENT ||
+        cgiResponse.httpStatus.get() >= HttpStatus::MULTIPLE_CHOICES) {
+        cgiResponse.cgiType = CgiResponse::INVALID;
+        return false;
+    }
+    handleDocument(response, cgiResponse);
+    const HTTPFields::FieldValue& lengthValues =
+        cgiResponse.fields.getFieldValue(fields::CONTENT_LENGTH);
+    if (!lengthValues.empty() && !utils::isDigitStr(lengthValues.front())) {
+        response.setHeader(fields::CONTENT_LENGTH, "", false);
+    }
+    response.beginStream();
+    _execute.startStreaming();
+    _isStreaming = true;
+    STEPMARK_INFO(
+        "CgiHandler: startStreaming: streaming CGI output to the client");
+    return true;
+}
+
+// - Backpressure: the pipe is not read while the client has not yet taken
+//   STREAM_BUFFER_LIMIT bytes of earlier output.
+IOPendingState CgiHandler::continueCgiOutputStreaming(Response& response) {
+    if (!_isCacheFilling && response.getStreamRemaining() > 0
+        && _execute.canRelay()) {
+        return continueCgiOutputRelay(response);
+    }
+    if (response.getPendingSize() < http::cgi::STREAM_BUFFER_LIMIT) {
+        _execute.watchOutput(true);
+        _execute.continueReadOutput();
+    }
+    if (_execute.hasReadError()) {
+        STEPMARK_ERROR(
+            "CgiHandler: continueCgiOutputStreaming: read error after the "
+            "response was started, closing the connection");
+        forceTerminate();
+        return END_RESPONSE;
+    }
+    std::string output = _execute.takeBufferedOutput();
+    if (_isCacheFilling) {
+        if (_cacheBody.size() + output.size() > _cacheMaxSize) {
+            releaseCacheFill();
+        } else {
+            _cacheBody += output;
+        }
+    }
+    response.pushChunk(output);
+    if (_execute.isReadComplete()) {
+        finishProcess();
+        response.finishStream();
+        return RESPONSE_SENDING;
+    }
+    _execute.watchOutput(
+        response.getPendingSize() < http::cgi::STREAM_BUFFER_LIMIT);
+    return CGI_OUTPUT_STREAMING;
+}
+
+// - A body with a known length is spliced from the pipe to the socket
+//   once everything queued before it has been sent. Only one end is
+//   watched at a time: the pipe while the script has not written, the
+//   socket while it is full. Output past the length is read and dropped
+//   as in the buffered stream.
+IOPendingState CgiHandler::continueCgiOutputRelay(Response& response) {
+    _isRelayWaitingForClient = response.hasPendingOutput();
+    if (_isRelayWaitingForClient) {
+        _execute.watchOutput(false);
+        return CGI_OUTPUT_STREAMING;
+    }
+    std::size_t moved = 0;
+    CgiExecute::RelayResult result = _execute.relayOutput(
+        _client->getFd(), response.getStreamRemaining(), &moved);
+    response.addRelayedBody(moved);
+    switch (result) {
+        case CgiExecute::RELAY_ERROR:
+            STEPMARK_ERROR(
+                "CgiHandler: continueCgiOutputRelay: relay failed after the "
+                "response was started, closing the connection");
+            forceTerminate();
+            return END_RESPONSE;
+        case CgiExecute::RELAY_END:
+            finishProcess();
+            response.finishStream();
+            return RESPONSE_SENDING;
+        case CgiExecute::RELAY_WAIT_CLIENT:
+            _isRelayWaitingForClient = true;
+            _execute.watchOutput(false);
+            return CGI_OUTPUT_STREAMING;
+        default:
+            _execute.watchOutput(true);
+            return CGI_OUTPUT_STREAMING;
+    }
+}
+
+// - An application server that fails is a bad gateway; a script that
+//   fails is this server's own error.
+int CgiHandler::getFailureStatus() const {
+    if (_execute.hasTimedOut()) {
+        return HttpStatus::GATEWAY_TIMEOUT;
+    }
+    if (_execute.isFastcgi()) {
+        return HttpStatus::BAD_GATEWAY;
+    }
+    return HttpStatus::INTERNAL_SERVER_ERROR;
+}
+
 IOPendingState CgiHandler::handleExecuteResult(
                         CgiExecute::ExecuteResult result,
                         Response& response) {
     switch (result) {
         case CgiExecute::EXECUTE_SUCCESS:
-            forceTerminate();
+            finishProcess();
             return processCgiResponse(_execute.getResponse(), response);
         case CgiExecute::EXECUTE_WRITE_PENDING:
             return CGI_BODY_SENDING;
         case CgiExecute::EXECUTE_READ_PENDING:
             return CGI_OUTPUT_READING;
+        case CgiExecute::EXECUTE_UPSTREAM_ERROR:
+            response.setStatus(getFailureStatus());
+            return NO_IO_PENDING;
         case CgiExecute::EXECUTE_TIMEOUT:
             forceTerminate();
             response.setStatus(HttpStatus::GATEWAY_TIMEOUT);
@@ -205,7 +491,7 @@ IOPendingState CgiHandler::handleExecuteResult(
             return NO_IO_PENDING;
         default:
             forceTerminate();
-            toolbox::logger::StepMark::error(
+            STEPMARK_ERROR(
                 "Unknown CGI execute result: " +
                 toolbox::to_string(static_cast<int>(result)));
             response.setStatus(HttpStatus::INTERNAL_SERVER_ERROR);
@@ -236,7 +522,7 @@ IOPendingState CgiHandler::processCgiResponse(const CgiResponse& cgiResponse,
         }
     } catch (const std::exception& e) {
         forceTerminate();
-        toolbox::logger::StepMark::error(
+        STEPMARK_ERROR(
             std::string("CGI response processing exception: ") + e.what());
         response.setStatus(HttpStatus::INTERNAL_SERVER_ERROR);
         return NO_IO_PENDING;
@@ -249,11 +535,21 @@ void CgiHandler::copyCgiResponseToResponse(const CgiResponse& cgiResponse,
     const HTTPFields::FieldMap& fields = cgiResponse.fields.get();
     for (HTTPFields::FieldMap::const_iterator it =
                                     fields.begin(); it != fields.end(); ++it) {
-        if (it->first != http::fields::cgi::STATUS && !it->second.empty()) {
+        if (it->first == http::fields::cgi::STATUS || it->second.empty()) {
+            continue;
+        }
+        if (it->first == http::fields::SET_COOKIE) {
             response.setHeader(it->first, it->second.front());
+        } else {
+            response.setHeader(it->first, it->second);
         }
     }
-    response.setBody(cgiResponse.body);
+    if (_isHeadRequest) {
+        response.setBody("");
+        response.setHeadLength(cgiResponse.body.size());
+    } else {
+        response.setBody(cgiResponse.body);
+    }
 }
 
 bool CgiHandler::handleDocument(Response& response,
@@ -297,7 +593,7 @@ IOPendingState CgiHandler::handleLocalRedirect(Response& response,
 bool CgiHandler::validateRedirectRequest(Response& response,
                                         const CgiResponse& cgiResponse) {
     if (_redirectCount >= http::cgi::MAX_REDIRECTS) {
-        toolbox::logger::StepMark::error("CGI redirect loop detected");
+        STEPMARK_ERROR("CGI redirect loop detected");
         response.setStatus(HttpStatus::INTERNAL_SERVER_ERROR);
         response.setBody("CGI redirect loop detected");
         response.setHeader("Content-Type", "text/plain");
@@ -318,7 +614,7 @@ CgiHandler::extractRedirectInfo(const CgiResponse& cgiResponse) {
     const HTTPFields::FieldValue& locationValues =
         cgiResponse.fields.getFieldValue(fields::LOCATION);
     info.location = locationValues.front();
-    toolbox::logger::StepMark::info(
+    STEPMARK_INFO(
         "CgiHandler::extractRedirectInfo: Location header value: "
         + info.location);
     const HTTPFields::FieldValue& hostValues =
@@ -335,7 +631,8 @@ IOPendingState CgiHandler::executeInternalRequest(
                             std::size_t redirectCount) {
     toolbox::SharedPtr<http::Request> clientRequest = _client->getRequest();
     clientRequest->setRedirectCount(redirectCount);
-    clientRequest->setLocalRedirectInfo(http::method::GET, location, host);
+    clientRequest->setLocalRedirectInfo(
+        _isHeadRequest ? http::method::HEAD : http::method::GET, location, host);
     return CGI_LOCAL_REDIRECT_IO_PENDING;
 }
 
@@ -344,7 +641,7 @@ bool CgiHandler::validateParameters(const std::string& scriptPath,
                                 const std::vector<std::string>& cgi_extension,
                                 Response& response) const {
     if (cgi_extension.empty()) {
-        toolbox::logger::StepMark::error(
+        STEPMARK_ERROR(
             "validateParameters: cgi_extension is empty");
         response.setStatus(HttpStatus::FORBIDDEN);
         return false;
@@ -361,7 +658,7 @@ bool CgiHandler::validateParameters(const std::string& scriptPath,
     if (lastDot != std::string::npos) {
         fileExtension = fileName.substr(lastDot);
     } else {
-        toolbox::logger::StepMark::error(
+        STEPMARK_ERROR(
             "validateParameters: No file extension found in: " + fileName);
         response.setStatus(HttpStatus::FORBIDDEN);
         return false;
@@ -374,7 +671,7 @@ bool CgiHandler::validateParameters(const std::string& scriptPath,
         }
     }
     if (isValidExtension == false) {
-        toolbox::logger::StepMark::error(
+        STEPMARK_ERROR(
             "validateParameters: Invalid extension '"
             + fileExtension + "' for file: " + scriptPath);
         response.setStatus(HttpStatus::FORBIDDEN);
@@ -382,19 +679,19 @@ bool CgiHandler::validateParameters(const std::string& scriptPath,
     }
     struct stat st;
     if (stat(scriptPath.c_str(), &st) != 0) {
-        toolbox::logger::StepMark::error(
+        STEPMARK_ERROR(
             "validateParameters: stat() failed for: " + scriptPath);
         response.setStatus(HttpStatus::FORBIDDEN);
         return false;
     }
     if (!(st.st_mode & S_IXUSR)) {
-        toolbox::logger::StepMark::error(
+        STEPMARK_ERROR(
             "validateParameters: File not executable: " + scriptPath);
         response.setStatus(HttpStatus::FORBIDDEN);
         return false;
     }
     if (!interpreter.empty() && access(interpreter.c_str(), X_OK) != 0) {
-        toolbox::logger::StepMark::error(
+        STEPMARK_ERROR(
             "validateParameters: Interpreter not executable: " + interpreter);
         response.setStatus(HttpStatus::FORBIDDEN);
         return false;
@@ -11,6 +11,8 @@
 #include "../../config/config.hpp"
 #include "../../core/client.hpp"
 #include "cgi_execute.hpp"
+#include "cgi_limiter.hpp"
+#include "cgi_response_cache.hpp"
 #include "cgi_response_parser.hpp"
 #include "cgi_response.hpp"
 
@@ -28,25 +30,56 @@ class CgiHandler {
     bool isCgiRequest(const std::string& targetPath,
                       const std::vector<std::string>& cgiExtension,
                       const std::string& cgiPath) const;
+    bool isFastcgiRequest(const std::string& targetPath,
+                          const config::LocationConfig& config) const;
     IOPendingState handleRequest(const HTTPRequest& request,
                        Response& Response,
                        const Client* client,
                        const config::LocationConfig& config,
                        const http::IOPendingState ioPendingState);
+    bool canStreamBody(const HTTPRequest& request,
+                       const config::LocationConfig& config) const;
+    void appendRequestBody(std::string* data, bool isLast) {
+        _execute.appendRequestBody(data, isLast);
+    }
+    bool isBodyStreaming() const { return _execute.isBodyStreaming(); }
+    bool wantsRequestBody() const { return _execute.wantsRequestBody(); }
+    bool isRelayWaitingForClient() const { return _isRelayWaitingForClient; }
     void setRedirectCount(std::size_t count) { _redirectCount = count; }
+    void fillCache(const std::string& key, std::size_t maxSize);
     void reset();
     void forceTerminate();
+    void finishProcess();
+    bool hasTimedOut() const;
 
  private:
     CgiHandler(const CgiHandler& other);
     CgiHandler& operator=(const CgiHandler& other);
 
+    IOPendingState dispatchRequest(const HTTPRequest& request,
+                        Response& response,
+                        const config::LocationConfig& locationConfig,
+                        const http::IOPendingState ioPendingState);
+    void finishCacheFill();
+    void releaseCacheFill();
     IOPendingState executeInitialCgiRequest(
                         const HTTPRequest& request,
                         Response& response,
                         const config::LocationConfig& locationConfig);
+    IOPendingState continueCgiQueued(const HTTPRequest& request,
+                        Response& response,
+                        const config::LocationConfig& locationConfig);
+    IOPendingState rejectOverload(Response& response);
+    void releaseTicket();
     IOPendingState continueCgiBodySending(Response& response);
     IOPendingState continueCgiOutputReading(Response& response);
+    IOPendingState continueCgiOutputStreaming(Response& response);
+    IOPendingState continueCgiOutputRelay(Response& response);
+    bool startStreaming(Response& response);
+    bool answerHead(Response& response);
+    bool hasCgiExtension(const std::string& targetPath,
+                         const std::vector<std::string>& cgiExtension) const;
+    int getFailureStatus() const;
     IOPendingState handleExecuteResult(CgiExecute::ExecuteResult result,
                                       Response& response);
     bool validateParameters(const std::string& scriptPath,
@@ -70,6 +103,14 @@ class CgiHandler {
                                const std::string& uriPath,
                                const std::vector<std::string>& cgiExtensions) const;
     CgiExecute _execute;
+    toolbox::SharedPtr<CgiTicket> _ticket;
+    std::string _cacheKey;
+    std::size_t _cacheMaxSize;
+    std::string _cacheBody;
+    bool _isCacheFilling;
+    bool _isStreaming;
+    bool _isRelayWaitingForClient;
+    bool _isHeadRequest;
     std::size_t _redirectCount;
     const Client* _client;
 };
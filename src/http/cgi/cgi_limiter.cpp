@@ -0,0 +1,148 @@
+// Copyright 2025 Ideal Broccoli
+
+#include <ctime>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "cgi_limiter.hpp"
+#include "../../../toolbox/stepmark.hpp"
+#include "../../../toolbox/string.hpp"
+
+namespace http {
+
+CgiLimiter::CgiLimiter() : _queueDepth(0) {
+}
+
+CgiLimiter::~CgiLimiter() {
+}
+
+CgiLimiter& CgiLimiter::getInstance() {
+    static CgiLimiter instance;
+    return instance;
+}
+
+bool CgiLimiter::hasFreeSlot(const config::LocationConfig& config) {
+    if (config.getCgiMaxConcurrency() == 0) {
+        return true;
+    }
+    CgiLimiter& limiter = getInstance();
+    std::map<std::string, Slots>::const_iterator it =
+        limiter._slots.find(config.getIdentity());
+    return it == limiter._slots.end()
+        || it->second.running < config.getCgiMaxConcurrency();
+}
+
+// - The limit is taken from every request, so that a changed
+//   configuration applies to the next one; the slots are kept by location
+//   identity, so the CGIs still running from before a reload count too.
+toolbox::SharedPtr<CgiTicket> CgiLimiter::acquire(
+        const config::LocationConfig& config, int clientFd) {
+    CgiLimiter& limiter = getInstance();
+    std::string key = config.getIdentity();
+    toolbox::SharedPtr<CgiTicket> ticket(new CgiTicket(key, clientFd,
+        std::time(NULL) + config.getCgiQueueTimeout()));
+    Slots& slots = limiter._slots[key];
+    slots.limit = config.getCgiMaxConcurrency();
+    if (slots.running < slots.limit && slots.queue.empty()) {
+        ++slots.running;
+        ticket->state = CgiTicket::ADMITTED;
+    } else if (slots.queue.size() < config.getCgiQueueSize()) {
+        slots.queue.push_back(ticket);
+        limiter.setQueueDepth(limiter._queueDepth + 1);
+    } else {
+        ticket->state = CgiTicket::REJECTED;
+        STEPMARK_WARNING("CgiLimiter: " + config.getPath()
+            + ": all " + toolbox::to_string(slots.limit)
+            + " CGI slots busy and queue full, rejecting");
+        limiter.eraseIfIdle(limiter._slots.find(key));
+    }
+    return ticket;
+}
+
+void CgiLimiter::release(const toolbox::SharedPtr<CgiTicket>& ticket) {
+    CgiLimiter& limiter = getInstance();
+    std::map<std::string, Slots>::iterator it =
+        limiter._slots.find(ticket->key);
+    if (it == limiter._slots.end()) {
+        ticket->state = CgiTicket::RELEASED;
+        return;
+    }
+    Slots& slots = it->second;
+    if (ticket->state == CgiTicket::ADMITTED) {
+        --slots.running;
+        limiter.promote(&slots);
+    } else if (ticket->state == CgiTicket::WAITING) {
+        for (std::deque<toolbox::SharedPtr<CgiTicket> >::iterator q =
+                slots.queue.begin(); q != slots.queue.end(); ++q) {
+            if (q->get() == ticket.get()) {
+                slots.queue.erase(q);
+                limiter.setQueueDepth(limiter._queueDepth - 1);
+                break;
+            }
+        }
+    }
+    limiter.eraseIfIdle(it);
+    ticket->state = CgiTicket::RELEASED;
+}
+
+void CgiLimiter::checkDeadlines() {
+    CgiLimiter& limiter = getInstance();
+    time_t now = std::time(NULL);
+    for (std::map<std::string, Slots>::iterator it = limiter._slots.begin();
+            it != limiter._slots.end(); ) {
+        std::deque<toolbox::SharedPtr<CgiTicket> >& queue = it->second.queue;
+        std::size_t i = 0;
+        while (i < queue.size()) {
+            if (queue[i]->deadline > now) {
+                ++i;
+                continue;
+            }
+            queue[i]->state = CgiTicket::EXPIRED;
+            limiter._readyClients.insert(queue[i]->clientFd);
+            queue.erase(queue.begin() + i);
+            limiter.setQueueDepth(limiter._queueDepth - 1);
+        }
+        limiter.eraseIfIdle(it++);
+    }
+}
+
+std::vector<int> CgiLimiter::takeReadyClients() {
+    CgiLimiter& limiter = getInstance();
+    std::vector<int> ready(limiter._readyClients.begin(),
+                           limiter._readyClients.end());
+    limiter._readyClients.clear();
+    return ready;
+}
+
+std::size_t CgiLimiter::getQueueDepth() {
+    return getInstance()._queueDepth;
+}
+
+void CgiLimiter::promote(Slots* slots) {
+    while (slots->running < slots->limit && !slots->queue.empty()) {
+        toolbox::SharedPtr<CgiTicket> ticket = slots->queue.front();
+        slots->queue.pop_front();
+        setQueueDepth(_queueDepth - 1);
+        ++slots->running;
+        ticket->state = CgiTicket::ADMITTED;
+        _readyClients.insert(ticket->clientFd);
+    }
+}
+
+// - Slots with nothing running or waiting are dropped, so locations that
+//   a reload removed leave nothing behind.
+void CgiLimiter::eraseIfIdle(std::map<std::string, Slots>::iterator it) {
+    if (it->second.running == 0 && it->second.queue.empty()) {
+        _slots.erase(it);
+    }
+}
+
+void CgiLimiter::setQueueDepth(std::size_t depth) {
+    _queueDepth = depth;
+    STEPMARK_INFO("CgiLimiter: queue depth "
+        + toolbox::to_string(_queueDepth));
+}
+
+}  // namespace http
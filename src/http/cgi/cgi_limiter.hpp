@@ -0,0 +1,98 @@
+// Copyright 2025 Ideal Broccoli
+
+#pragma once
+
+#include <ctime>
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "../../config/config.hpp"
+#include "../../../toolbox/shared.hpp"
+
+namespace http {
+
+/**
+ * @brief A request's claim on one of the CGI slots of its location.
+ */
+struct CgiTicket {
+    enum State {
+        WAITING,    // queued; holds no slot yet
+        ADMITTED,   // holds a slot until released
+        REJECTED,   // the queue was full
+        EXPIRED,    // waited cgi_queue_timeout without getting a slot
+        RELEASED
+    };
+
+    CgiTicket(const std::string& key, int clientFd, time_t deadline)
+        : key(key), clientFd(clientFd), deadline(deadline), state(WAITING) {}
+
+    std::string key;
+    int clientFd;
+    time_t deadline;
+    State state;
+};
+
+/**
+ * @brief Bounds the CGI requests of each location that run at once.
+ *
+ * A location with cgi_max_concurrency set admits that many requests;
+ * later ones wait in a FIFO of up to cgi_queue_size tickets, which hold
+ * no process, and anything beyond it is rejected at once. A released slot
+ * goes straight to the head of the queue, and a ticket that waits longer
+ * than cgi_queue_timeout expires.
+ *
+ * Usage example:
+ * @code
+ * toolbox::SharedPtr<CgiTicket> ticket =
+ *     CgiLimiter::acquire(locationConfig, client->getFd());
+ * if (ticket->state == CgiTicket::WAITING) {
+ *     // wait until the client fd comes out of takeReadyClients()
+ * }
+ * // ... run the CGI ...
+ * CgiLimiter::release(ticket);
+ * @endcode
+ *
+ * Like FastcgiPool, the limiter never drives clients itself: the fds of
+ * clients whose ticket was admitted or expired are taken by the event loop.
+ */
+class CgiLimiter {
+ public:
+    static bool hasFreeSlot(const config::LocationConfig& config);
+    static toolbox::SharedPtr<CgiTicket> acquire(
+        const config::LocationConfig& config, int clientFd);
+    static void release(const toolbox::SharedPtr<CgiTicket>& ticket);
+    static void checkDeadlines();
+    static std::vector<int> takeReadyClients();
+
+    /**
+     * @brief Number of requests waiting for a slot, over all locations.
+     */
+    static std::size_t getQueueDepth();
+
+ private:
+    struct Slots {
+        Slots() : running(0), limit(0) {}
+        std::size_t running;
+        std::size_t limit;
+        std::deque<toolbox::SharedPtr<CgiTicket> > queue;
+    };
+
+    CgiLimiter();
+    ~CgiLimiter();
+    CgiLimiter(const CgiLimiter&);
+    CgiLimiter& operator=(const CgiLimiter&);
+
+    static CgiLimiter& getInstance();
+    void promote(Slots* slots);
+    void eraseIfIdle(std::map<std::string, Slots>::iterator it);
+    void setQueueDepth(std::size_t depth);
+
+    std::map<std::string, Slots> _slots;
+    std::set<int> _readyClients;
+    std::size_t _queueDepth;
+};
+
+}  // namespace http
@@ -32,7 +32,7 @@ void CgiResponse::identifyCgiType() {
     if (httpStatus.get() == HttpStatus::INTERNAL_SERVER_ERROR) {
         return;
     }
-    HTTPFields::FieldValue location = fields.getFieldValue(fields::LOCATION);
+    const HTTPFields::FieldValue& location = fields.getFieldValue(fields::LOCATION);
     bool emptyContentType = fields.getFieldValue(fields::CONTENT_TYPE).empty();
     bool isStatusUnset = httpStatus.get() == HttpStatus::UNSET;
     if (location.empty()) {
@@ -0,0 +1,302 @@
+// Copyright 2025 Ideal Broccoli
+
+#include <cctype>
+#include <cstdlib>
+#include <ctime>
+#include <list>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "cgi_response_cache.hpp"
+#include "../get_gmt.hpp"
+#include "../http_namespace.hpp"
+#include "../string_utils.hpp"
+#include "../../config/config_namespace.hpp"
+#include "../../../toolbox/stepmark.hpp"
+#include "../../../toolbox/string.hpp"
+
+namespace http {
+namespace {
+const char* NO_STORE = "no-store";
+const char* NO_CACHE = "no-cache";
+const char* PRIVATE = "private";
+const char* MAX_AGE = "max-age=";
+const char* S_MAXAGE = "s-maxage=";
+
+bool isKeyChar(char c) {
+    return std::islower(static_cast<unsigned char>(c))
+        || std::isdigit(static_cast<unsigned char>(c)) || c == '_';
+}
+
+bool startsWith(const std::string& str, const std::string& prefix) {
+    return str.compare(0, prefix.size(), prefix) == 0;
+}
+
+bool parseSeconds(const std::string& value, std::size_t* seconds) {
+    if (value.empty() || !utils::isDigitStr(value)) {
+        return false;
+    }
+    *seconds = std::strtoul(value.c_str(), NULL, 10);
+    return true;
+}
+}  // namespace
+
+CgiResponseCache::CgiResponseCache() {
+}
+
+CgiResponseCache::~CgiResponseCache() {
+}
+
+CgiResponseCache& CgiResponseCache::getInstance() {
+    static CgiResponseCache instance;
+    return instance;
+}
+
+// - The template was checked when the configuration was loaded, so every
+//   '$' starts a known variable.
+std::string CgiResponseCache::makeKey(const HTTPRequest& request,
+                                      const config::LocationConfig& config) {
+    const std::string& pattern = config.getCgiCache().getKey();
+    std::string key = config.getIdentity() + "\n";
+    std::size_t pos = 0;
+    while (pos < pattern.size()) {
+        if (pattern[pos] != config::directive::CGI_CACHE_KEY_VARIABLE) {
+            key += pattern[pos++];
+            continue;
+        }
+        std::size_t end = pos + 1;
+        while (end < pattern.size() && isKeyChar(pattern[end])) {
+            ++end;
+        }
+        key += expandVariable(request, pattern.substr(pos + 1, end - pos - 1));
+        pos = end;
+    }
+    return key;
+}
+
+std::string CgiResponseCache::expandVariable(const HTTPRequest& request,
+                                             const std::string& name) {
+    const std::string prefix = config::directive::CGI_CACHE_KEY_HEADER_PREFIX;
+    if (name == "method") {
+        return request.method;
+    } else if (name == "host") {
+        return utils::joinFieldValues(request.fields.getFieldValue(fields::HOST));
+    } else if (name == "path") {
+        return request.uri.path;
+    } else if (name == "query") {
+        return request.uri.fullQuery;
+    } else if (startsWith(name, prefix)) {
+        std::string field = name.substr(prefix.size());
+        for (std::size_t i = 0; i < field.size(); ++i) {
+            if (field[i] == '_') {
+                field[i] = '-';
+            }
+        }
+        return utils::joinFieldValues(request.fields.getFieldValue(field));
+    }
+    return "";
+}
+
+CgiResponseCache::LookupResult CgiResponseCache::lookup(
+        const config::LocationConfig& config, const std::string& key,
+        int clientFd, toolbox::SharedPtr<CgiCacheEntry>* entry) {
+    CgiResponseCache& cache = getInstance();
+    std::string zoneKey = config.getIdentity();
+    Zone& zone = cache._zones[zoneKey];
+    zone.maxSize = config.getCgiCache().getMaxSize();
+    std::map<std::string, Slot>::iterator slot = zone.slots.find(key);
+    if (slot != zone.slots.end()
+            && slot->second.entry->expires <= std::time(NULL)) {
+        cache.evict(&zone, slot);
+        slot = zone.slots.end();
+    }
+    if (slot != zone.slots.end()) {
+        zone.recency.splice(zone.recency.begin(), zone.recency,
+                            slot->second.recency);
+        if (slot->second.entry->isPass) {
+            ++cache._stats.bypasses;
+            return BYPASS;
+        }
+        *entry = slot->second.entry;
+        ++cache._stats.hits;
+        return HIT;
+    }
+    std::map<std::string, Fill>::iterator fill = cache._fills.find(key);
+    if (fill != cache._fills.end()) {
+        fill->second.waiters.insert(clientFd);
+        ++cache._stats.waits;
+        return WAIT;
+    }
+    Fill& newFill = cache._fills[key];
+    newFill.zoneKey = zoneKey;
+    newFill.ttl = config.getCgiCache().getTtl();
+    ++cache._stats.misses;
+    return MISS;
+}
+
+// - Only a complete 200 document without cookies is kept. Its own
+//   Cache-Control or Expires decides how long; the configured ttl is
+//   used when it has neither.
+bool CgiResponseCache::getExpiry(const CgiResponse& response, std::size_t ttl,
+                                 time_t now, time_t* expires) {
+    int status = response.httpStatus.get();
+    if (response.cgiType != CgiResponse::DOCUMENT
+            || (status != HttpStatus::UNSET && status != 0
+                && status != HttpStatus::OK)
+            || !response.fields.getFieldValue(fields::SET_COOKIE).empty()) {
+        return false;
+    }
+    std::string cacheControl = utils::joinFieldValues(
+        response.fields.getFieldValue(fields::CACHE_CONTROL));
+    bool hasMaxAge = false;
+    bool hasSharedMaxAge = false;
+    std::size_t maxAge = 0;
+    std::istringstream directives(cacheControl);
+    std::string directive;
+    while (std::getline(directives, directive, ',')) {
+        utils::trimSpace(&directive);
+        for (std::size_t i = 0; i < directive.size(); ++i) {
+            directive[i] = std::tolower(static_cast<unsigned char>(directive[i]));
+        }
+        if (startsWith(directive, NO_STORE) || startsWith(directive, NO_CACHE)
+                || startsWith(directive, PRIVATE)) {
+            return false;
+        }
+        if (startsWith(directive, S_MAXAGE)) {
+            hasSharedMaxAge = parseSeconds(
+                directive.substr(std::string(S_MAXAGE).size()), &maxAge);
+            if (!hasSharedMaxAge) {
+                return false;
+            }
+        } else if (startsWith(directive, MAX_AGE) && !hasSharedMaxAge) {
+            hasMaxAge = parseSeconds(
+                directive.substr(std::string(MAX_AGE).size()), &maxAge);
+            if (!hasMaxAge) {
+                return false;
+            }
+        }
+    }
+    if (hasSharedMaxAge || hasMaxAge) {
+        *expires = now + maxAge;
+    } else if (!response.fields.getFieldValue(fields::EXPIRES).empty()) {
+        if (!parseGMT(utils::joinFieldValues(
+                response.fields.getFieldValue(fields::EXPIRES)), expires)) {
+            return false;
+        }
+    } else {
+        *expires = now + ttl;
+    }
+    return *expires > now;
+}
+
+void CgiResponseCache::store(const std::string& key,
+                             const CgiResponse& response,
+                             const std::string& body) {
+    CgiResponseCache& cache = getInstance();
+    std::map<std::string, Fill>::iterator fill = cache._fills.find(key);
+    if (fill == cache._fills.end()) {
+        return;
+    }
+    time_t now = std::time(NULL);
+    toolbox::SharedPtr<CgiCacheEntry> entry(new CgiCacheEntry());
+    entry->storedAt = now;
+    if (!getExpiry(response, fill->second.ttl, now, &entry->expires)) {
+        abandon(key);
+        return;
+    }
+    std::size_t size = key.size() + body.size();
+    const HTTPFields::FieldMap& responseFields = response.fields.get();
+    for (HTTPFields::FieldMap::const_iterator it = responseFields.begin();
+            it != responseFields.end(); ++it) {
+        if (it->first == fields::cgi::STATUS || it->second.empty()) {
+            continue;
+        }
+        entry->fields.insert(*it);
+        size += it->first.size() + utils::joinFieldValues(it->second).size();
+    }
+    if (size > cache._zones[fill->second.zoneKey].maxSize) {
+        abandon(key);
+        return;
+    }
+    entry->body = body;
+    cache.finishFill(key, entry, size);
+}
+
+void CgiResponseCache::abandon(const std::string& key) {
+    CgiResponseCache& cache = getInstance();
+    std::map<std::string, Fill>::iterator fill = cache._fills.find(key);
+    if (fill == cache._fills.end()) {
+        return;
+    }
+    toolbox::SharedPtr<CgiCacheEntry> entry(new CgiCacheEntry());
+    entry->storedAt = std::time(NULL);
+    entry->expires = entry->storedAt + fill->second.ttl;
+    entry->isPass = true;
+    cache.finishFill(key, entry, key.size());
+}
+
+std::vector<int> CgiResponseCache::takeReadyClients() {
+    CgiResponseCache& cache = getInstance();
+    std::vector<int> ready(cache._readyClients.begin(),
+                           cache._readyClients.end());
+    cache._readyClients.clear();
+    return ready;
+}
+
+void CgiResponseCache::clear() {
+    getInstance()._zones.clear();
+}
+
+CgiResponseCache::Stats CgiResponseCache::getStats() {
+    CgiResponseCache& cache = getInstance();
+    Stats stats = cache._stats;
+    for (std::map<std::string, Zone>::const_iterator it = cache._zones.begin();
+            it != cache._zones.end(); ++it) {
+        stats.entries += it->second.slots.size();
+        stats.size += it->second.size;
+    }
+    return stats;
+}
+
+void CgiResponseCache::finishFill(const std::string& key,
+                                  const toolbox::SharedPtr<CgiCacheEntry>& entry,
+                                  std::size_t size) {
+    std::map<std::string, Fill>::iterator fill = _fills.find(key);
+    insert(&_zones[fill->second.zoneKey], key, entry, size);
+    _readyClients.insert(fill->second.waiters.begin(),
+                         fill->second.waiters.end());
+    _fills.erase(fill);
+}
+
+void CgiResponseCache::insert(Zone* zone, const std::string& key,
+                              const toolbox::SharedPtr<CgiCacheEntry>& entry,
+                              std::size_t size) {
+    std::map<std::string, Slot>::iterator old = zone->slots.find(key);
+    if (old != zone->slots.end()) {
+        evict(zone, old);
+    }
+    while (zone->size + size > zone->maxSize && !zone->recency.empty()) {
+        evict(zone, zone->slots.find(zone->recency.back()));
+    }
+    Slot& slot = zone->slots[key];
+    slot.entry = entry;
+    slot.size = size;
+    slot.recency = zone->recency.insert(zone->recency.begin(), key);
+    zone->size += size;
+    STEPMARK_INFO("CgiResponseCache: stored "
+        + std::string(entry->isPass ? "pass " : "") + "entry, "
+        + toolbox::to_string(zone->slots.size()) + " entries, "
+        + toolbox::to_string(zone->size) + " bytes");
+}
+
+void CgiResponseCache::evict(Zone* zone,
+                             std::map<std::string, Slot>::iterator slot) {
+    zone->size -= slot->second.size;
+    zone->recency.erase(slot->second.recency);
+    zone->slots.erase(slot);
+}
+
+}  // namespace http
@@ -0,0 +1,142 @@
+// Copyright 2025 Ideal Broccoli
+
+#pragma once
+
+#include <ctime>
+#include <list>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "../request/http_fields.hpp"
+#include "../request/http_request.hpp"
+#include "../../config/config.hpp"
+#include "../../../toolbox/shared.hpp"
+#include "cgi_response.hpp"
+
+namespace http {
+
+/**
+ * @brief A CGI response kept by CgiResponseCache.
+ */
+struct CgiCacheEntry {
+    CgiCacheEntry() : storedAt(0), expires(0), isPass(false) {}
+
+    HTTPFields::FieldMap fields;
+    std::string body;
+    time_t storedAt;
+    time_t expires;
+    bool isPass;    // not cacheable: requests go to the CGI until expires
+};
+
+/**
+ * @brief Keeps the CGI responses of locations with cgi_cache set.
+ *
+ * A lookup that finds a fresh entry is served without running the CGI.
+ * Otherwise the first request for a key fills it: later requests for the
+ * same key wait for that one CGI instead of starting their own, and are
+ * woken once the response is stored. A response that cannot be cached
+ * marks the key as passed, so that its requests run the CGI in parallel
+ * for the cache's ttl rather than queueing behind each other.
+ *
+ * Usage example:
+ * @code
+ * std::string key = CgiResponseCache::makeKey(request, locationConfig);
+ * toolbox::SharedPtr<CgiCacheEntry> entry;
+ * switch (CgiResponseCache::lookup(locationConfig, key, fd, &entry)) {
+ *     case CgiResponseCache::HIT:     // answer with *entry
+ *     case CgiResponseCache::WAIT:    // wait for fd in takeReadyClients()
+ *     case CgiResponseCache::MISS:    // run the CGI, then store() or abandon()
+ *     case CgiResponseCache::BYPASS:  // run the CGI
+ * }
+ * @endcode
+ *
+ * Each location has its own size budget; the least recently used entries
+ * are dropped to stay within it.
+ */
+class CgiResponseCache {
+ public:
+    enum LookupResult {
+        HIT,
+        MISS,
+        WAIT,
+        BYPASS
+    };
+
+    /**
+     * @brief Lookups by result since startup, and what is stored now.
+     */
+    struct Stats {
+        Stats() : hits(0), misses(0), waits(0), bypasses(0),
+                  entries(0), size(0) {}
+        std::size_t hits;
+        std::size_t misses;
+        std::size_t waits;
+        std::size_t bypasses;
+        std::size_t entries;
+        std::size_t size;
+    };
+
+    static std::string makeKey(const HTTPRequest& request,
+                               const config::LocationConfig& config);
+    static LookupResult lookup(const config::LocationConfig& config,
+                               const std::string& key, int clientFd,
+                               toolbox::SharedPtr<CgiCacheEntry>* entry);
+    static void store(const std::string& key, const CgiResponse& response,
+                      const std::string& body);
+    static void abandon(const std::string& key);
+    static std::vector<int> takeReadyClients();
+
+    /**
+     * @brief Drops every stored response, e.g. when the configuration is
+     * replaced; fills in progress still wake their waiters.
+     */
+    static void clear();
+
+    static Stats getStats();
+
+ private:
+    struct Slot {
+        toolbox::SharedPtr<CgiCacheEntry> entry;
+        std::size_t size;
+        std::list<std::string>::iterator recency;
+    };
+    struct Zone {
+        Zone() : maxSize(0), size(0) {}
+        std::size_t maxSize;
+        std::size_t size;
+        std::map<std::string, Slot> slots;
+        std::list<std::string> recency;     // most recently used first
+    };
+    struct Fill {
+        std::string zoneKey;
+        std::size_t ttl;
+        std::set<int> waiters;
+    };
+
+    CgiResponseCache();
+    ~CgiResponseCache();
+    CgiResponseCache(const CgiResponseCache&);
+    CgiResponseCache& operator=(const CgiResponseCache&);
+
+    static CgiResponseCache& getInstance();
+    static std::string expandVariable(const HTTPRequest& request,
+                                      const std::string& name);
+    static bool getExpiry(const CgiResponse& response, std::size_t ttl,
+                          time_t now, time_t* expires);
+    void finishFill(const std::string& key,
+                    const toolbox::SharedPtr<CgiCacheEntry>& entry,
+                    std::size_t size);
+    void insert(Zone* zone, const std::string& key,
+                const toolbox::SharedPtr<CgiCacheEntry>& entry,
+                std::size_t size);
+    void evict(Zone* zone, std::map<std::string, Slot>::iterator slot);
+
+    std::map<std::string, Zone> _zones;
+    std::map<std::string, Fill> _fills;
+    std::set<int> _readyClients;
+    Stats _stats;       // entries and size are summed by getStats()
+};
+
+}  // namespace http
@@ -0,0 +1,321 @@
+// Copyright 2025 Ideal Broccoli
+
+#include "fastcgi_connection.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+
+#include <ctime>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "../http_namespace.hpp"
+#include "../../event/epoll.hpp"
+#include "../../event/child_launcher.hpp"
+#include "../../event/child_reaper.hpp"
+#include "../../../toolbox/stepmark.hpp"
+#include "../../../toolbox/string.hpp"
+
+namespace http {
+
+FastcgiConnection::FastcgiConnection()
+: _fd(-1),
+  _state(CLOSED),
+  _openedAt(0),
+  _pid(-1),
+  _servedCount(0),
+  _hasFailedRequest(false),
+  _idleSince(0),
+  _hasProbeReply(false) {
+}
+
+// - Only reached at exit, when the epoll instance may already be gone.
+FastcgiConnection::~FastcgiConnection() {
+    if (_fd != -1) {
+        ::close(_fd);
+    }
+}
+
+// - A nonblocking connect() completes, or fails, once the socket reports
+//   writable; the result is picked up by finishConnect().
+bool FastcgiConnection::open(const struct sockaddr* address,
+                             socklen_t length) {
+    _fd = socket(address->sa_family,
+                 SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (_fd == -1) {
+        STEPMARK_ERROR("FastcgiConnection: socket failed");
+        return false;
+    }
+    connect(_fd, address, length);
+    try {
+        Epoll::addUpstream(_fd, EPOLLOUT);
+    } catch (const std::exception& e) {
+        STEPMARK_ERROR(
+            std::string("FastcgiConnection: open: ") + e.what());
+        ::close(_fd);
+        _fd = -1;
+        return false;
+    }
+    _state = CONNECTING;
+    _openedAt = std::time(NULL);
+    return true;
+}
+
+// - The worker is given its end of the pair as stdin, which is where a
+//   FastCGI application started by a process manager finds its listening
+//   socket; records are its only channel, so stdout goes to /dev/null.
+bool FastcgiConnection::spawn(const std::vector<std::string>& command) {
+    int pair[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, pair) == -1) {
+        STEPMARK_ERROR(
+            "FastcgiConnection: socketpair failed");
+        return false;
+    }
+    ChildLauncher launcher;
+    launcher.redirect(pair[1], STDIN_FILENO);
+    launcher.redirectToNull(STDOUT_FILENO, O_WRONLY);
+    pid_t pid = launcher.launch(command[0], command, NULL);
+    ::close(pair[1]);
+    if (pid == -1) {
+        ::close(pair[0]);
+        return false;
+    }
+    ChildReaper::watch(pid, NULL);
+    _pid = pid;
+    _fd = pair[0];
+    fcntl(_fd, F_SETFL, fcntl(_fd, F_GETFL) | O_NONBLOCK);
+    try {
+        Epoll::addUpstream(_fd, EPOLLIN | EPOLLRDHUP);
+    } catch (const std::exception& e) {
+        STEPMARK_ERROR(
+            std::string("FastcgiConnection: spawn: ") + e.what());
+        ::close(_fd);
+        _fd = -1;
+        ChildReaper::release(_pid, std::time(NULL));
+        _pid = -1;
+        return false;
+    }
+    _state = READY;
+    _openedAt = std::time(NULL);
+    _idleSince = _openedAt;
+    return true;
+}
+
+void FastcgiConnection::close() {
+    if (_fd != -1) {
+        Epoll::del(_fd);
+        ::close(_fd);
+        _fd = -1;
+    }
+    if (_pid != -1) {
+        ChildReaper::release(_pid, std::time(NULL)
+            + static_cast<time_t>(fastcgi::WORKER_EXIT_TIMEOUT_SEC));
+        _pid = -1;
+    }
+    _state = CLOSED;
+}
+
+bool FastcgiConnection::finishConnect(uint32_t events) {
+    if (events & (EPOLLERR | EPOLLHUP)) {
+        return false;
+    }
+    int error = 0;
+    socklen_t length = sizeof(error);
+    if (getsockopt(_fd, SOL_SOCKET, SO_ERROR, &error, &length) == -1 ||
+        error != 0) {
+        return false;
+    }
+    _state = READY;
+    updateInterest();
+    return true;
+}
+
+// - Asks whether the application multiplexes; requests are held back
+//   until it answers, since one that does not may close the connection
+//   after replying.
+void FastcgiConnection::startProbe() {
+    std::map<std::string, std::string> names;
+    names[fastcgi::MPXS_CONNS] = "";
+    names[fastcgi::MAX_REQS] = "";
+    std::string content = fastcgi::encodeNameValues(names);
+    fastcgi::appendRecord(&_outBuffer, fastcgi::GET_VALUES, 0,
+                          content.data(), content.size());
+    _state = PROBING;
+    _openedAt = std::time(NULL);
+    updateInterest();
+}
+
+void FastcgiConnection::assign(
+        const toolbox::SharedPtr<FastcgiRequest>& request) {
+    request->id = allocateId();
+    request->connection = this;
+    request->state = FastcgiRequest::ACTIVE;
+    _requests[request->id] = request;
+    fastcgi::appendBeginRequest(&_outBuffer, request->id, true);
+    fastcgi::appendStream(&_outBuffer, fastcgi::PARAMS, request->id,
+                          request->params);
+    fastcgi::appendStream(&_outBuffer, fastcgi::STDIN, request->id,
+                          request->body);
+    updateInterest();
+}
+
+// - The id stays reserved until FCGI_END_REQUEST confirms the abort, so
+//   late records for it are recognised and dropped.
+void FastcgiConnection::abort(
+        const toolbox::SharedPtr<FastcgiRequest>& request) {
+    fastcgi::appendRecord(&_outBuffer, fastcgi::ABORT_REQUEST,
+                          request->id, "", 0);
+    request->state = FastcgiRequest::ABORTED;
+    updateInterest();
+}
+
+void FastcgiConnection::flush() {
+    if (_outBuffer.empty() || _state == CONNECTING) {
+        return;
+    }
+    ssize_t sent = send(_fd, _outBuffer.data(), _outBuffer.size(),
+                        MSG_NOSIGNAL);
+    if (sent > 0) {
+        _outBuffer.erase(0, sent);
+    }
+    updateInterest();
+}
+
+// - Returns false once the application server has closed the connection;
+//   records that arrived before the close are still delivered.
+bool FastcgiConnection::receive(std::set<int>* touched) {
+    char buffer[fastcgi::READ_BUFFER_SIZE];
+    ssize_t bytes = recv(_fd, buffer, sizeof(buffer), 0);
+    if (bytes <= 0) {
+        return false;
+    }
+    _inBuffer.append(buffer, bytes);
+    processRecords(touched);
+    return true;
+}
+
+void FastcgiConnection::detachRequests(
+        std::map<uint16_t, toolbox::SharedPtr<FastcgiRequest> >* requests) {
+    requests->swap(_requests);
+    _requests.clear();
+    for (std::map<uint16_t, toolbox::SharedPtr<FastcgiRequest> >::iterator it =
+            requests->begin(); it != requests->end(); ++it) {
+        it->second->connection = NULL;
+    }
+}
+
+std::vector<toolbox::SharedPtr<FastcgiRequest> > FastcgiConnection::takeRejected() {
+    std::vector<toolbox::SharedPtr<FastcgiRequest> > rejected;
+    rejected.swap(_rejected);
+    return rejected;
+}
+
+uint16_t FastcgiConnection::allocateId() const {
+    uint16_t id = 1;
+    while (_requests.find(id) != _requests.end()) {
+        ++id;
+    }
+    return id;
+}
+
+void FastcgiConnection::processRecords(std::set<int>* touched) {
+    std::size_t pos = 0;
+    fastcgi::RecordHeader header;
+    while (fastcgi::parseHeader(_inBuffer, pos, &header)) {
+        std::size_t recordLength = fastcgi::HEADER_LENGTH
+            + header.contentLength + header.paddingLength;
+        if (_inBuffer.size() - pos < recordLength) {
+            break;
+        }
+        handleRecord(header,
+                     _inBuffer.substr(pos + fastcgi::HEADER_LENGTH,
+                                      header.contentLength),
+                     touched);
+        pos += recordLength;
+    }
+    _inBuffer.erase(0, pos);
+}
+
+void FastcgiConnection::handleRecord(const fastcgi::RecordHeader& header,
+                                     const std::string& content,
+                                     std::set<int>* touched) {
+    if (header.type == fastcgi::GET_VALUES_RESULT) {
+        _probeReply.clear();
+        fastcgi::decodeNameValues(content, &_probeReply);
+        _hasProbeReply = true;
+        return;
+    }
+    if (header.type == fastcgi::UNKNOWN_TYPE) {
+        _hasProbeReply = true;
+        return;
+    }
+    std::map<uint16_t, toolbox::SharedPtr<FastcgiRequest> >::iterator it =
+        _requests.find(header.requestId);
+    if (it == _requests.end()) {
+        return;
+    }
+    FastcgiRequest& request = *it->second;
+    if (header.type == fastcgi::END_REQUEST) {
+        endRequest(header.requestId, content, touched);
+    } else if (header.type == fastcgi::STDOUT) {
+        if (request.state == FastcgiRequest::ACTIVE && !content.empty()) {
+            request.output += content;
+            request.hasOutput = true;
+            touched->insert(request.clientFd);
+        }
+    } else if (header.type == fastcgi::STDERR && !content.empty()) {
+        STEPMARK_WARNING(
+            "FastCGI stderr: " + content);
+    }
+}
+
+void FastcgiConnection::endRequest(uint16_t id, const std::string& content,
+                                   std::set<int>* touched) {
+    toolbox::SharedPtr<FastcgiRequest> request = _requests[id];
+    _requests.erase(id);
+    request->connection = NULL;
+    ++_servedCount;
+    if (_requests.empty()) {
+        _idleSince = std::time(NULL);
+    }
+    if (content.size() >= 4 && (content[0] | content[1] | content[2] | content[3])) {
+        _hasFailedRequest = true;
+    }
+    if (request->state != FastcgiRequest::ACTIVE) {
+        return;
+    }
+    int protocolStatus = fastcgi::REQUEST_COMPLETE;
+    if (content.size() > 4) {
+        protocolStatus = static_cast<unsigned char>(content[4]);
+    }
+    if (protocolStatus == fastcgi::CANT_MPX_CONN && !request->hasOutput) {
+        _rejected.push_back(request);
+        return;
+    }
+    if (protocolStatus != fastcgi::REQUEST_COMPLETE) {
+        STEPMARK_ERROR(
+            "FastCGI request rejected, protocol status: "
+            + toolbox::to_string(protocolStatus));
+        request->state = FastcgiRequest::FAILED;
+    } else {
+        request->state = FastcgiRequest::ENDED;
+    }
+    touched->insert(request->clientFd);
+}
+
+void FastcgiConnection::updateInterest() {
+    if (_fd == -1 || _state == CONNECTING) {
+        return;
+    }
+    uint32_t events = EPOLLIN | EPOLLRDHUP;
+    if (!_outBuffer.empty()) {
+        events |= EPOLLOUT;
+    }
+    Epoll::modify(_fd, events);
+}
+
+}  // namespace http
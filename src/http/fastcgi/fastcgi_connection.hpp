@@ -0,0 +1,97 @@
+// Copyright 2025 Ideal Broccoli
+
+#pragma once
+
+#include <stdint.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <ctime>
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "fastcgi_record.hpp"
+#include "fastcgi_request.hpp"
+#include "../../../toolbox/shared.hpp"
+
+namespace http {
+
+/**
+ * @brief One kept-alive connection to a FastCGI application server.
+ *
+ * Requests are written as records into an output buffer that is flushed
+ * whenever the socket is writable; records read back are routed to the
+ * request with the matching id. Several requests share the connection
+ * when the application server reported FCGI_MPXS_CONNS.
+ *
+ * A connection may also be spawned: the application is then a cgi_pool
+ * worker started by the server, reached over a socket pair.
+ */
+class FastcgiConnection {
+ public:
+    enum State {
+        CONNECTING,
+        PROBING,   // waiting for FCGI_GET_VALUES_RESULT
+        READY,
+        CLOSED
+    };
+
+    FastcgiConnection();
+    ~FastcgiConnection();
+
+    bool open(const struct sockaddr* address, socklen_t length);
+    bool spawn(const std::vector<std::string>& command);
+    void close();
+    bool finishConnect(uint32_t events);
+    void startProbe();
+
+    void assign(const toolbox::SharedPtr<FastcgiRequest>& request);
+    void abort(const toolbox::SharedPtr<FastcgiRequest>& request);
+    void flush();
+    bool receive(std::set<int>* touched);
+    void detachRequests(std::map<uint16_t, toolbox::SharedPtr<FastcgiRequest> >* requests);
+
+    int getFd() const { return _fd; }
+    State getState() const { return _state; }
+    void setState(State state) { _state = state; }
+    std::size_t getActiveCount() const { return _requests.size(); }
+    time_t getOpenedAt() const { return _openedAt; }
+    time_t getIdleSince() const { return _idleSince; }
+    std::size_t getServedCount() const { return _servedCount; }
+    bool hasFailedRequest() const { return _hasFailedRequest; }
+    bool hasProbeReply() const { return _hasProbeReply; }
+    const std::map<std::string, std::string>& getProbeReply() const { return _probeReply; }
+    std::vector<toolbox::SharedPtr<FastcgiRequest> > takeRejected();
+
+ private:
+    FastcgiConnection(const FastcgiConnection& other);
+    FastcgiConnection& operator=(const FastcgiConnection& other);
+
+    uint16_t allocateId() const;
+    void processRecords(std::set<int>* touched);
+    void handleRecord(const fastcgi::RecordHeader& header,
+                      const std::string& content, std::set<int>* touched);
+    void endRequest(uint16_t id, const std::string& content,
+                    std::set<int>* touched);
+    void updateInterest();
+
+    int _fd;
+    State _state;
+    time_t _openedAt;
+    pid_t _pid;
+    std::size_t _servedCount;
+    // A request ended with a nonzero application status.
+    bool _hasFailedRequest;
+    time_t _idleSince;
+    std::string _outBuffer;
+    std::string _inBuffer;
+    std::map<uint16_t, toolbox::SharedPtr<FastcgiRequest> > _requests;
+    bool _hasProbeReply;
+    std::map<std::string, std::string> _probeReply;
+    // Requests the application ended with FCGI_CANT_MPX_CONN.
+    std::vector<toolbox::SharedPtr<FastcgiRequest> > _rejected;
+};
+
+}  // namespace http
@@ -0,0 +1,549 @@
+// Copyright 2025 Ideal Broccoli
+
+#include "fastcgi_pool.hpp"
+
+#include <netdb.h>
+#include <sys/epoll.h>
+#include <sys/un.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "../http_namespace.hpp"
+#include "../../../toolbox/stepmark.hpp"
+#include "../../../toolbox/string.hpp"
+
+namespace http {
+
+namespace {
+const char* LOCAL_UPSTREAM_PREFIX = "cgi_pool:";
+
+// - Every setting is part of the name, so locations with different limits
+//   get their own workers, and so does a location whose cgi_pool changed
+//   in a reload.
+std::string makeLocalUpstreamName(const config::CgiPool& cgiPool,
+                                  const std::string& interpreter) {
+    return std::string(LOCAL_UPSTREAM_PREFIX) + interpreter + " "
+        + cgiPool.getRunner()
+        + " workers=" + toolbox::to_string(cgiPool.getWorkers())
+        + " max_requests=" + toolbox::to_string(cgiPool.getMaxRequests())
+        + " idle_timeout=" + toolbox::to_string(cgiPool.getIdleTimeout());
+}
+}  // namespace
+
+FastcgiPool::Upstream::Upstream()
+: name(),
+  addressLength(0),
+  isProbed(false),
+  capacity(1),
+  isLocal(false),
+  command(),
+  maxConnections(fastcgi::MAX_CONNECTIONS),
+  maxRequests(0),
+  idleTimeout(0),
+  connections(),
+  queue() {
+    std::memset(&address, 0, sizeof(address));
+}
+
+FastcgiPool::FastcgiPool() {
+}
+
+FastcgiPool::~FastcgiPool() {
+    for (std::map<std::string, Upstream*>::iterator it = _upstreams.begin();
+            it != _upstreams.end(); ++it) {
+        for (std::size_t i = 0; i < it->second->connections.size(); ++i) {
+            delete it->second->connections[i];
+        }
+        delete it->second;
+    }
+}
+
+FastcgiPool& FastcgiPool::getInstance() {
+    static FastcgiPool instance;
+    return instance;
+}
+
+// - A request that cannot even be queued is marked FAILED before this
+//   returns; the caller checks for that instead of waiting for a wakeup.
+void FastcgiPool::submit(const config::FastcgiPass& pass,
+                         const toolbox::SharedPtr<FastcgiRequest>& request) {
+    FastcgiPool& pool = getInstance();
+    Upstream* upstream = pool.findUpstream(pass);
+    if (upstream == NULL) {
+        request->state = FastcgiRequest::FAILED;
+        return;
+    }
+    request->upstream = upstream->name;
+    upstream->queue.push_back(request);
+    pool.dispatch(upstream);
+}
+
+// - Workers that exited or were recycled since the last request are
+//   started again here, so the pool is warm for the next burst.
+void FastcgiPool::submitLocal(const config::CgiPool& cgiPool,
+                              const std::string& interpreter,
+                              const toolbox::SharedPtr<FastcgiRequest>& request) {
+    FastcgiPool& pool = getInstance();
+    Upstream* upstream = pool.findLocalUpstream(cgiPool, interpreter);
+    request->upstream = upstream->name;
+    pool.replenish(upstream);
+    upstream->queue.push_back(request);
+    pool.dispatch(upstream);
+}
+
+// - Without multiplexing the connection is closed, which is how such
+//   application servers expect an abort; otherwise FCGI_ABORT_REQUEST is
+//   sent and the connection stays in use.
+void FastcgiPool::cancel(const toolbox::SharedPtr<FastcgiRequest>& request) {
+    FastcgiPool& pool = getInstance();
+    if (request->isFinished() || request->state == FastcgiRequest::ABORTED) {
+        return;
+    }
+    std::map<std::string, Upstream*>::iterator it =
+        pool._upstreams.find(request->upstream);
+    if (it == pool._upstreams.end()) {
+        request->state = FastcgiRequest::ABORTED;
+        return;
+    }
+    Upstream* upstream = it->second;
+    if (request->state == FastcgiRequest::QUEUED) {
+        for (std::deque<toolbox::SharedPtr<FastcgiRequest> >::iterator q =
+                upstream->queue.begin(); q != upstream->queue.end(); ++q) {
+            if (q->get() == request.get()) {
+                upstream->queue.erase(q);
+                break;
+            }
+        }
+        request->state = FastcgiRequest::ABORTED;
+        return;
+    }
+    FastcgiConnection* connection = request->connection;
+    if (connection == NULL) {
+        request->state = FastcgiRequest::ABORTED;
+        return;
+    }
+    if (upstream->capacity == 1) {
+        std::map<uint16_t, toolbox::SharedPtr<FastcgiRequest> > detached;
+        connection->detachRequests(&detached);
+        request->state = FastcgiRequest::ABORTED;
+        pool.removeConnection(upstream, connection);
+        pool.dispatch(upstream);
+        return;
+    }
+    connection->abort(request);
+    connection->flush();
+}
+
+// - The response is complete, so the application is about to end the
+//   request anyway; it is left to do so and keep the connection, and
+//   whatever it still sends is discarded.
+void FastcgiPool::release(const toolbox::SharedPtr<FastcgiRequest>& request) {
+    if (request->state == FastcgiRequest::ACTIVE) {
+        request->state = FastcgiRequest::ABORTED;
+        return;
+    }
+    cancel(request);
+}
+
+void FastcgiPool::handleEvent(int fd, uint32_t events) {
+    FastcgiPool& pool = getInstance();
+    std::map<int, Upstream*>::iterator it = pool._upstreamByFd.find(fd);
+    if (it == pool._upstreamByFd.end()) {
+        return;
+    }
+    Upstream* upstream = it->second;
+    FastcgiConnection* connection = NULL;
+    for (std::size_t i = 0; i < upstream->connections.size(); ++i) {
+        if (upstream->connections[i]->getFd() == fd) {
+            connection = upstream->connections[i];
+            break;
+        }
+    }
+    if (connection == NULL) {
+        return;
+    }
+    if (connection->getState() == FastcgiConnection::CONNECTING) {
+        pool.handleConnecting(upstream, connection, events);
+        return;
+    }
+    if (events & EPOLLOUT) {
+        connection->flush();
+    }
+    if (!(events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))) {
+        return;
+    }
+    std::set<int> touched;
+    bool isOpen = connection->receive(&touched);
+    pool._readyClients.insert(touched.begin(), touched.end());
+    std::vector<toolbox::SharedPtr<FastcgiRequest> > rejected =
+        connection->takeRejected();
+    for (std::size_t i = 0; i < rejected.size(); ++i) {
+        upstream->capacity = 1;
+        pool.requeue(upstream, rejected[i]);
+    }
+    if (connection->getState() == FastcgiConnection::PROBING &&
+        connection->hasProbeReply()) {
+        pool.applyProbeReply(upstream, connection);
+    }
+    if (!isOpen) {
+        pool.failConnection(upstream, connection);
+    } else if (upstream->isLocal && connection->getActiveCount() == 0 &&
+               (connection->getServedCount() >= upstream->maxRequests ||
+                connection->hasFailedRequest())) {
+        pool.removeConnection(upstream, connection);
+        pool.replenish(upstream);
+    }
+    pool.dispatch(upstream);
+    pool.closeSurplusIdle(upstream);
+}
+
+// - Connections stuck in connect() fail like refused ones. An application
+//   server that never answers FCGI_GET_VALUES is assumed not to multiplex.
+// - A cgi_pool whose workers have all been stopped is dropped; the next
+//   request for it starts it again. This is also how the pools of settings
+//   that a reload replaced go away.
+void FastcgiPool::checkDeadlines() {
+    FastcgiPool& pool = getInstance();
+    time_t now = std::time(NULL);
+    for (std::map<std::string, Upstream*>::iterator it = pool._upstreams.begin();
+            it != pool._upstreams.end(); ) {
+        Upstream* upstream = it->second;
+        if (upstream->isLocal) {
+            pool.closeIdleWorkers(upstream, now);
+            if (upstream->connections.empty() && upstream->queue.empty()) {
+                delete upstream;
+                pool._upstreams.erase(it++);
+            } else {
+                ++it;
+            }
+            continue;
+        }
+        for (std::size_t i = 0; i < upstream->connections.size(); ++i) {
+            FastcgiConnection* connection = upstream->connections[i];
+            if (connection->getState() != FastcgiConnection::CONNECTING &&
+                connection->getState() != FastcgiConnection::PROBING) {
+                continue;
+            }
+            if (now - connection->getOpenedAt() <=
+                static_cast<time_t>(fastcgi::CONNECT_TIMEOUT_SEC)) {
+                continue;
+            }
+            if (connection->getState() == FastcgiConnection::CONNECTING) {
+                pool.handleConnecting(upstream, connection, EPOLLERR);
+                break;
+            }
+            STEPMARK_WARNING("FastcgiPool: " + upstream->name
+                + ": no reply to FCGI_GET_VALUES, not multiplexing");
+            upstream->isProbed = true;
+            upstream->capacity = 1;
+            connection->setState(FastcgiConnection::READY);
+            pool.dispatch(upstream);
+        }
+        ++it;
+    }
+}
+
+std::vector<int> FastcgiPool::takeReadyClients() {
+    FastcgiPool& pool = getInstance();
+    std::vector<int> ready(pool._readyClients.begin(), pool._readyClients.end());
+    pool._readyClients.clear();
+    return ready;
+}
+
+FastcgiPool::Upstream* FastcgiPool::findUpstream(
+        const config::FastcgiPass& pass) {
+    std::map<std::string, Upstream*>::iterator it =
+        _upstreams.find(pass.getAddress());
+    if (it != _upstreams.end()) {
+        return it->second;
+    }
+    Upstream* upstream = new Upstream;
+    upstream->name = pass.getAddress();
+    if (!resolve(pass, upstream)) {
+        STEPMARK_ERROR(
+            "FastcgiPool: cannot resolve " + pass.getAddress());
+        delete upstream;
+        return NULL;
+    }
+    _upstreams[upstream->name] = upstream;
+    return upstream;
+}
+
+// - Locations with the same interpreter, runner and settings share the
+//   workers.
+FastcgiPool::Upstream* FastcgiPool::findLocalUpstream(
+        const config::CgiPool& cgiPool, const std::string& interpreter) {
+    std::string name = makeLocalUpstreamName(cgiPool, interpreter);
+    std::map<std::string, Upstream*>::iterator it = _upstreams.find(name);
+    if (it != _upstreams.end()) {
+        return it->second;
+    }
+    Upstream* upstream = new Upstream;
+    upstream->name = name;
+    upstream->isProbed = true;
+    upstream->isLocal = true;
+    upstream->command.push_back(interpreter);
+    upstream->command.push_back(cgiPool.getRunner());
+    upstream->maxConnections = cgiPool.getWorkers();
+    upstream->maxRequests = cgiPool.getMaxRequests();
+    upstream->idleTimeout = cgiPool.getIdleTimeout();
+    _upstreams[name] = upstream;
+    return upstream;
+}
+
+// - Addresses are resolved once, when the first request for them arrives.
+bool FastcgiPool::resolve(const config::FastcgiPass& pass,
+                          Upstream* upstream) const {
+    if (pass.isUnixSocket()) {
+        struct sockaddr_un address;
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, pass.getUnixPath().c_str(),
+                     sizeof(address.sun_path) - 1);
+        std::memcpy(&upstream->address, &address, sizeof(address));
+        upstream->addressLength = sizeof(address);
+        return true;
+    }
+    struct addrinfo hints;
+    struct addrinfo* result = NULL;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_NUMERICSERV;
+    if (getaddrinfo(pass.getHost().c_str(),
+                    toolbox::to_string(pass.getPort()).c_str(),
+                    &hints, &result) != 0 || result == NULL) {
+        return false;
+    }
+    std::memcpy(&upstream->address, result->ai_addr, result->ai_addrlen);
+    upstream->addressLength = result->ai_addrlen;
+    freeaddrinfo(result);
+    return true;
+}
+
+void FastcgiPool::dispatch(Upstream* upstream) {
+    while (!upstream->queue.empty()) {
+        FastcgiConnection* connection = findAvailable(upstream);
+        if (connection == NULL) {
+            if (!openConnection(upstream)) {
+                return;
+            }
+            continue;
+        }
+        toolbox::SharedPtr<FastcgiRequest> request = upstream->queue.front();
+        upstream->queue.pop_front();
+        connection->assign(request);
+        connection->flush();
+    }
+}
+
+FastcgiConnection* FastcgiPool::findAvailable(Upstream* upstream) const {
+    FastcgiConnection* best = NULL;
+    for (std::size_t i = 0; i < upstream->connections.size(); ++i) {
+        FastcgiConnection* connection = upstream->connections[i];
+        if (connection->getState() != FastcgiConnection::READY ||
+            connection->getActiveCount() >= upstream->capacity) {
+            continue;
+        }
+        if (best == NULL ||
+            connection->getActiveCount() < best->getActiveCount()) {
+            best = connection;
+        }
+    }
+    return best;
+}
+
+// - Opens another connection only if those already being set up cannot
+//   take the queue; until the first one has been probed, it is the only one.
+bool FastcgiPool::openConnection(Upstream* upstream) {
+    if (upstream->connections.size() >= upstream->maxConnections) {
+        return false;
+    }
+    if (!upstream->isProbed && !upstream->connections.empty()) {
+        return false;
+    }
+    std::size_t pendingSlots = 0;
+    for (std::size_t i = 0; i < upstream->connections.size(); ++i) {
+        if (upstream->connections[i]->getState() != FastcgiConnection::READY) {
+            pendingSlots += upstream->capacity;
+        }
+    }
+    if (pendingSlots >= upstream->queue.size()) {
+        return false;
+    }
+    if (!addConnection(upstream)) {
+        failQueue(upstream);
+        return false;
+    }
+    return true;
+}
+
+bool FastcgiPool::addConnection(Upstream* upstream) {
+    FastcgiConnection* connection = new FastcgiConnection;
+    bool isOpen = upstream->isLocal
+        ? connection->spawn(upstream->command)
+        : connection->open(reinterpret_cast<struct sockaddr*>(&upstream->address),
+                           upstream->addressLength);
+    if (!isOpen) {
+        delete connection;
+        return false;
+    }
+    upstream->connections.push_back(connection);
+    _upstreamByFd[connection->getFd()] = upstream;
+    return true;
+}
+
+void FastcgiPool::replenish(Upstream* upstream) {
+    while (upstream->connections.size() < upstream->maxConnections) {
+        if (!addConnection(upstream)) {
+            return;
+        }
+    }
+}
+
+void FastcgiPool::handleConnecting(Upstream* upstream,
+                                   FastcgiConnection* connection,
+                                   uint32_t events) {
+    if (!connection->finishConnect(events)) {
+        STEPMARK_ERROR(
+            "FastcgiPool: cannot connect to " + upstream->name);
+        removeConnection(upstream, connection);
+        if (upstream->connections.empty()) {
+            failQueue(upstream);
+        }
+        return;
+    }
+    if (!upstream->isProbed) {
+        connection->startProbe();
+        connection->flush();
+        return;
+    }
+    dispatch(upstream);
+}
+
+void FastcgiPool::applyProbeReply(Upstream* upstream,
+                                  FastcgiConnection* connection) {
+    const std::map<std::string, std::string>& reply = connection->getProbeReply();
+    std::map<std::string, std::string>::const_iterator mpxs =
+        reply.find(fastcgi::MPXS_CONNS);
+    std::map<std::string, std::string>::const_iterator maxReqs =
+        reply.find(fastcgi::MAX_REQS);
+    upstream->capacity = 1;
+    if (mpxs != reply.end() && mpxs->second == "1") {
+        upstream->capacity = fastcgi::MAX_REQUESTS_PER_CONNECTION;
+        if (maxReqs != reply.end()) {
+            long value = std::strtol(maxReqs->second.c_str(), NULL, 10);
+            if (value > 0 &&
+                static_cast<std::size_t>(value) < upstream->capacity) {
+                upstream->capacity = value;
+            }
+        }
+    }
+    upstream->isProbed = true;
+    connection->setState(FastcgiConnection::READY);
+    STEPMARK_INFO("FastcgiPool: " + upstream->name
+        + ": requests per connection: " + toolbox::to_string(upstream->capacity));
+}
+
+void FastcgiPool::requeue(Upstream* upstream,
+                          const toolbox::SharedPtr<FastcgiRequest>& request) {
+    if (request->isRetried) {
+        request->state = FastcgiRequest::FAILED;
+        markReady(request);
+        return;
+    }
+    request->isRetried = true;
+    request->state = FastcgiRequest::QUEUED;
+    request->connection = NULL;
+    upstream->queue.push_front(request);
+}
+
+void FastcgiPool::failConnection(Upstream* upstream,
+                                 FastcgiConnection* connection) {
+    std::map<uint16_t, toolbox::SharedPtr<FastcgiRequest> > requests;
+    connection->detachRequests(&requests);
+    if (connection->getState() == FastcgiConnection::PROBING) {
+        upstream->isProbed = true;
+        upstream->capacity = 1;
+    }
+    removeConnection(upstream, connection);
+    for (std::map<uint16_t, toolbox::SharedPtr<FastcgiRequest> >::iterator it =
+            requests.begin(); it != requests.end(); ++it) {
+        if (it->second->state != FastcgiRequest::ACTIVE) {
+            continue;
+        }
+        // - A worker that died took the script with it; running the script
+        //   again could repeat whatever it did before failing.
+        if (it->second->hasOutput || upstream->isLocal) {
+            it->second->state = FastcgiRequest::FAILED;
+            markReady(it->second);
+        } else {
+            requeue(upstream, it->second);
+        }
+    }
+}
+
+void FastcgiPool::failQueue(Upstream* upstream) {
+    while (!upstream->queue.empty()) {
+        upstream->queue.front()->state = FastcgiRequest::FAILED;
+        markReady(upstream->queue.front());
+        upstream->queue.pop_front();
+    }
+}
+
+void FastcgiPool::removeConnection(Upstream* upstream,
+                                   FastcgiConnection* connection) {
+    _upstreamByFd.erase(connection->getFd());
+    connection->close();
+    for (std::size_t i = 0; i < upstream->connections.size(); ++i) {
+        if (upstream->connections[i] == connection) {
+            upstream->connections.erase(upstream->connections.begin() + i);
+            break;
+        }
+    }
+    delete connection;
+}
+
+// - A cgi_pool keeps all of its workers; they go by idle_timeout instead.
+void FastcgiPool::closeSurplusIdle(Upstream* upstream) {
+    if (upstream->isLocal) {
+        return;
+    }
+    std::size_t idle = 0;
+    for (std::size_t i = 0; i < upstream->connections.size(); ) {
+        FastcgiConnection* connection = upstream->connections[i];
+        if (connection->getState() == FastcgiConnection::READY &&
+            connection->getActiveCount() == 0 &&
+            ++idle > fastcgi::KEEPALIVE_CONNECTIONS) {
+            removeConnection(upstream, connection);
+            continue;
+        }
+        ++i;
+    }
+}
+
+void FastcgiPool::closeIdleWorkers(Upstream* upstream, time_t now) {
+    for (std::size_t i = 0; i < upstream->connections.size(); ) {
+        FastcgiConnection* connection = upstream->connections[i];
+        if (connection->getActiveCount() == 0 &&
+            now - connection->getIdleSince() >
+                static_cast<time_t>(upstream->idleTimeout)) {
+            removeConnection(upstream, connection);
+            continue;
+        }
+        ++i;
+    }
+}
+
+void FastcgiPool::markReady(const toolbox::SharedPtr<FastcgiRequest>& request) {
+    _readyClients.insert(request->clientFd);
+}
+
+}  // namespace http
@@ -0,0 +1,101 @@
+// Copyright 2025 Ideal Broccoli
+
+#pragma once
+
+#include <stdint.h>
+#include <sys/socket.h>
+
+#include <ctime>
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "fastcgi_connection.hpp"
+#include "fastcgi_request.hpp"
+#include "../../config/config_base.hpp"
+#include "../../../toolbox/shared.hpp"
+
+namespace http {
+
+/**
+ * @brief Pools of kept-alive connections, one pool per fastcgi_pass address.
+ *
+ * Requests are queued per address and handed to a ready connection with a
+ * free slot; new connections are opened up to fastcgi::MAX_CONNECTIONS.
+ * The first connection to an address asks the application server whether
+ * it multiplexes, which decides how many requests share a connection.
+ *
+ * A cgi_pool is carried the same way: its upstream is a set of worker
+ * processes spawned by the server, one request at a time each, started
+ * ahead of the first request and replaced after max_requests or after a
+ * request that ended with a nonzero application status.
+ *
+ * The pool never drives clients itself: the fds of clients whose request
+ * made progress are collected and taken by the event loop.
+ */
+class FastcgiPool {
+ public:
+    static void submit(const config::FastcgiPass& pass,
+                       const toolbox::SharedPtr<FastcgiRequest>& request);
+    static void submitLocal(const config::CgiPool& cgiPool,
+                            const std::string& interpreter,
+                            const toolbox::SharedPtr<FastcgiRequest>& request);
+    static void cancel(const toolbox::SharedPtr<FastcgiRequest>& request);
+    static void release(const toolbox::SharedPtr<FastcgiRequest>& request);
+    static void handleEvent(int fd, uint32_t events);
+    static void checkDeadlines();
+    static std::vector<int> takeReadyClients();
+
+ private:
+    struct Upstream {
+        Upstream();
+        std::string name;
+        struct sockaddr_storage address;
+        socklen_t addressLength;
+        bool isProbed;
+        std::size_t capacity;
+        // Set for a cgi_pool: connections are spawned from command.
+        bool isLocal;
+        std::vector<std::string> command;
+        std::size_t maxConnections;
+        std::size_t maxRequests;
+        std::size_t idleTimeout;
+        std::vector<FastcgiConnection*> connections;
+        std::deque<toolbox::SharedPtr<FastcgiRequest> > queue;
+    };
+
+    FastcgiPool();
+    ~FastcgiPool();
+    FastcgiPool(const FastcgiPool&);
+    FastcgiPool& operator=(const FastcgiPool&);
+
+    static FastcgiPool& getInstance();
+    Upstream* findUpstream(const config::FastcgiPass& pass);
+    Upstream* findLocalUpstream(const config::CgiPool& cgiPool,
+                                const std::string& interpreter);
+    bool resolve(const config::FastcgiPass& pass, Upstream* upstream) const;
+    void dispatch(Upstream* upstream);
+    FastcgiConnection* findAvailable(Upstream* upstream) const;
+    bool openConnection(Upstream* upstream);
+    bool addConnection(Upstream* upstream);
+    void replenish(Upstream* upstream);
+    void handleConnecting(Upstream* upstream, FastcgiConnection* connection,
+                          uint32_t events);
+    void applyProbeReply(Upstream* upstream, FastcgiConnection* connection);
+    void requeue(Upstream* upstream,
+                 const toolbox::SharedPtr<FastcgiRequest>& request);
+    void failConnection(Upstream* upstream, FastcgiConnection* connection);
+    void failQueue(Upstream* upstream);
+    void removeConnection(Upstream* upstream, FastcgiConnection* connection);
+    void closeSurplusIdle(Upstream* upstream);
+    void closeIdleWorkers(Upstream* upstream, time_t now);
+    void markReady(const toolbox::SharedPtr<FastcgiRequest>& request);
+
+    std::map<std::string, Upstream*> _upstreams;
+    std::map<int, Upstream*> _upstreamByFd;
+    std::set<int> _readyClients;
+};
+
+}  // namespace http
@@ -0,0 +1,145 @@
+// Copyright 2025 Ideal Broccoli
+
+#include "fastcgi_record.hpp"
+
+#include <map>
+#include <string>
+
+namespace http {
+namespace fastcgi {
+
+const std::size_t HEADER_LENGTH = 8;
+const std::size_t MAX_CONTENT_LENGTH = 65535;
+const char* MPXS_CONNS = "FCGI_MPXS_CONNS";
+const char* MAX_REQS = "FCGI_MAX_REQS";
+
+namespace {
+const unsigned char VERSION_1 = 1;
+const unsigned char FLAG_KEEP_CONN = 1;
+const std::size_t SHORT_LENGTH_LIMIT = 127;
+
+void appendLength(std::string* out, std::size_t length) {
+    if (length <= SHORT_LENGTH_LIMIT) {
+        out->push_back(static_cast<char>(length));
+        return;
+    }
+    out->push_back(static_cast<char>(((length >> 24) & 0x7f) | 0x80));
+    out->push_back(static_cast<char>((length >> 16) & 0xff));
+    out->push_back(static_cast<char>((length >> 8) & 0xff));
+    out->push_back(static_cast<char>(length & 0xff));
+}
+
+bool readLength(const std::string& content, std::size_t* pos,
+                std::size_t* length) {
+    if (*pos >= content.size()) {
+        return false;
+    }
+    unsigned char first = static_cast<unsigned char>(content[*pos]);
+    if ((first & 0x80) == 0) {
+        *length = first;
+        *pos += 1;
+        return true;
+    }
+    if (*pos + 4 > content.size()) {
+        return false;
+    }
+    *length = (static_cast<std::size_t>(first & 0x7f) << 24)
+        | (static_cast<std::size_t>(static_cast<unsigned char>(content[*pos + 1])) << 16)
+        | (static_cast<std::size_t>(static_cast<unsigned char>(content[*pos + 2])) << 8)
+        | static_cast<std::size_t>(static_cast<unsigned char>(content[*pos + 3]));
+    *pos += 4;
+    return true;
+}
+}  // namespace
+
+// - Content is padded to a multiple of 8 bytes, as the specification
+//   recommends for alignment.
+void appendRecord(std::string* out, RecordType type, uint16_t requestId,
+                  const char* content, std::size_t length) {
+    unsigned char padding = static_cast<unsigned char>((8 - (length % 8)) % 8);
+    out->push_back(static_cast<char>(VERSION_1));
+    out->push_back(static_cast<char>(type));
+    out->push_back(static_cast<char>((requestId >> 8) & 0xff));
+    out->push_back(static_cast<char>(requestId & 0xff));
+    out->push_back(static_cast<char>((length >> 8) & 0xff));
+    out->push_back(static_cast<char>(length & 0xff));
+    out->push_back(static_cast<char>(padding));
+    out->push_back(0);
+    out->append(content, length);
+    out->append(padding, '\0');
+}
+
+void appendStream(std::string* out, RecordType type, uint16_t requestId,
+                  const std::string& content) {
+    std::size_t pos = 0;
+    while (pos < content.size()) {
+        std::size_t length = content.size() - pos;
+        if (length > MAX_CONTENT_LENGTH) {
+            length = MAX_CONTENT_LENGTH;
+        }
+        appendRecord(out, type, requestId, content.data() + pos, length);
+        pos += length;
+    }
+    appendRecord(out, type, requestId, "", 0);
+}
+
+void appendBeginRequest(std::string* out, uint16_t requestId, bool keepConn) {
+    char body[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    body[1] = static_cast<char>(RESPONDER);
+    body[2] = static_cast<char>(keepConn ? FLAG_KEEP_CONN : 0);
+    appendRecord(out, BEGIN_REQUEST, requestId, body, sizeof(body));
+}
+
+void appendNameValue(std::string* out, const char* name,
+                     std::size_t nameLength, const char* value,
+                     std::size_t valueLength) {
+    appendLength(out, nameLength);
+    appendLength(out, valueLength);
+    out->append(name, nameLength);
+    out->append(value, valueLength);
+}
+
+std::string encodeNameValues(const std::map<std::string, std::string>& pairs) {
+    std::string out;
+    for (std::map<std::string, std::string>::const_iterator it = pairs.begin();
+            it != pairs.end(); ++it) {
+        appendNameValue(&out, it->first.data(), it->first.size(),
+                        it->second.data(), it->second.size());
+    }
+    return out;
+}
+
+bool decodeNameValues(const std::string& content,
+                      std::map<std::string, std::string>* pairs) {
+    std::size_t pos = 0;
+    while (pos < content.size()) {
+        std::size_t nameLength;
+        std::size_t valueLength;
+        if (!readLength(content, &pos, &nameLength) ||
+            !readLength(content, &pos, &valueLength) ||
+            nameLength + valueLength > content.size() - pos) {
+            return false;
+        }
+        (*pairs)[content.substr(pos, nameLength)] =
+            content.substr(pos + nameLength, valueLength);
+        pos += nameLength + valueLength;
+    }
+    return true;
+}
+
+bool parseHeader(const std::string& buffer, std::size_t pos,
+                 RecordHeader* header) {
+    if (buffer.size() < pos + HEADER_LENGTH) {
+        return false;
+    }
+    const unsigned char* p =
+        reinterpret_cast<const unsigned char*>(buffer.data() + pos);
+    header->type = p[1];
+    header->requestId = static_cast<uint16_t>((p[2] << 8) | p[3]);
+    header->contentLength = static_cast<uint16_t>((p[4] << 8) | p[5]);
+    header->paddingLength = p[6];
+    return true;
+}
+
+}  // namespace fastcgi
+}  // namespace http
@@ -0,0 +1,89 @@
+// Copyright 2025 Ideal Broccoli
+
+#pragma once
+
+#include <stdint.h>
+
+#include <map>
+#include <string>
+
+namespace http {
+namespace fastcgi {
+
+// Record types, roles and flags of the FastCGI 1.0 specification.
+enum RecordType {
+    BEGIN_REQUEST = 1,
+    ABORT_REQUEST = 2,
+    END_REQUEST = 3,
+    PARAMS = 4,
+    STDIN = 5,
+    STDOUT = 6,
+    STDERR = 7,
+    DATA = 8,
+    GET_VALUES = 9,
+    GET_VALUES_RESULT = 10,
+    UNKNOWN_TYPE = 11
+};
+
+enum Role {
+    RESPONDER = 1
+};
+
+enum ProtocolStatus {
+    REQUEST_COMPLETE = 0,
+    CANT_MPX_CONN = 1,
+    OVERLOADED = 2,
+    UNKNOWN_ROLE = 3
+};
+
+struct RecordHeader {
+    unsigned char type;
+    uint16_t requestId;
+    uint16_t contentLength;
+    unsigned char paddingLength;
+};
+
+/**
+ * @brief Append one record; content must not exceed 65535 bytes.
+ */
+void appendRecord(std::string* out, RecordType type, uint16_t requestId,
+                  const char* content, std::size_t length);
+
+/**
+ * @brief Append a stream (PARAMS, STDIN) split into records and closed by
+ * the empty record that marks its end.
+ */
+void appendStream(std::string* out, RecordType type, uint16_t requestId,
+                  const std::string& content);
+
+void appendBeginRequest(std::string* out, uint16_t requestId, bool keepConn);
+
+/**
+ * @brief Append one name-value pair with the 1- or 4-byte length prefixes.
+ */
+void appendNameValue(std::string* out, const char* name,
+                     std::size_t nameLength, const char* value,
+                     std::size_t valueLength);
+
+/**
+ * @brief Encode name-value pairs with the 1- or 4-byte length prefixes.
+ */
+std::string encodeNameValues(const std::map<std::string, std::string>& pairs);
+
+bool decodeNameValues(const std::string& content,
+                      std::map<std::string, std::string>* pairs);
+
+/**
+ * @brief Decode a record header at pos.
+ * @return false if fewer than HEADER_LENGTH bytes are available.
+ */
+bool parseHeader(const std::string& buffer, std::size_t pos,
+                 RecordHeader* header);
+
+extern const std::size_t HEADER_LENGTH;
+extern const std::size_t MAX_CONTENT_LENGTH;
+extern const char* MPXS_CONNS;
+extern const char* MAX_REQS;
+
+}  // namespace fastcgi
+}  // namespace http
@@ -0,0 +1,64 @@
+// Copyright 2025 Ideal Broccoli
+
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+
+namespace http {
+
+class FastcgiConnection;
+
+/**
+ * @brief One request handed to a FastCGI application server.
+ *
+ * Shared between the CgiExecute that submitted it and the pool that
+ * carries it, so that either side may drop it first. The pool fills in
+ * the upstream when the request is submitted.
+ */
+struct FastcgiRequest {
+    enum State {
+        QUEUED,   // waiting for a connection with a free slot
+        ACTIVE,   // records sent or being sent
+        ENDED,    // FCGI_END_REQUEST received
+        FAILED,   // the application server could not be reached or failed
+        ABORTED   // cancelled by the client side; output is discarded
+    };
+
+    FastcgiRequest(int ownerFd, const std::string& encodedParams,
+                   const std::string& requestBody)
+    : state(QUEUED),
+      upstream(),
+      clientFd(ownerFd),
+      params(encodedParams),
+      body(requestBody),
+      output(),
+      id(0),
+      connection(NULL),
+      isRetried(false),
+      hasOutput(false) {}
+
+    bool isFinished() const { return state == ENDED || state == FAILED; }
+
+    State state;
+    std::string upstream;
+    int clientFd;
+    std::string params;
+    std::string body;
+    // FCGI_STDOUT received and not yet taken by CgiExecute.
+    std::string output;
+    uint16_t id;
+    FastcgiConnection* connection;
+    // A request is re-sent once if its connection fails before any output
+    // arrived, which is what a kept-alive connection closed by the
+    // application server looks like.
+    bool isRetried;
+    bool hasOutput;
+
+ private:
+    FastcgiRequest(const FastcgiRequest& other);
+    FastcgiRequest& operator=(const FastcgiRequest& other);
+};
+
+}  // namespace http
@@ -4,24 +4,39 @@
 
 #include <string>
 #include <ctime>
+#include <cstring>
 
 #include "../../toolbox/stepmark.hpp"
 
 namespace http {
 
 std::string getCurrentGMT() {
+    return formatGMT(std::time(NULL));
+}
+
+std::string formatGMT(std::time_t time) {
     char buffer[32];
-    std::time_t now = std::time(NULL);
-    std::tm* gmtm = std::gmtime(&now);
+    std::tm* gmtm = std::gmtime(&time);
     if (gmtm == NULL) {
-        toolbox::logger::StepMark::error("getCurrentGMT: Failed to get GMT time");
+        STEPMARK_ERROR("formatGMT: Failed to get GMT time");
         return "";
     }
     if (!std::strftime(buffer, sizeof(buffer), "%a, %d %b %Y %H:%M:%S GMT", gmtm)) {
-        toolbox::logger::StepMark::error("getCurrentGMT: Failed to format GMT time");
+        STEPMARK_ERROR("formatGMT: Failed to format GMT time");
         return "";
     }
     return std::string(buffer);
 }
 
+bool parseGMT(const std::string& date, std::time_t* time) {
+    std::tm gmtm;
+    std::memset(&gmtm, 0, sizeof(gmtm));
+    const char* end = strptime(date.c_str(), "%a, %d %b %Y %H:%M:%S GMT", &gmtm);
+    if (end == NULL || *end != '\0') {
+        return false;
+    }
+    *time = timegm(&gmtm);
+    return *time != -1;
+}
+
 }  // namespace http
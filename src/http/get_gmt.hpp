@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include <ctime>
 #include <string>
 
 namespace http {
@@ -16,4 +17,24 @@ namespace http {
  */
 std::string getCurrentGMT();
 
+/**
+ * @brief Format an arbitrary time in HTTP format (IMF-fixdate).
+ *
+ * Used for validators such as Last-Modified, which must be comparable
+ * byte-for-byte with the HTTP-date a client echoes back in If-Range.
+ *
+ * @param time Seconds since the epoch
+ * @return The formatted date, or an empty string on failure.
+ */
+std::string formatGMT(std::time_t time);
+
+/**
+ * @brief Parse an HTTP-date in IMF-fixdate form, as written by formatGMT.
+ *
+ * @param date The date, e.g. "Mon, 01 Jan 2023 12:00:00 GMT"
+ * @param time Receives the seconds since the epoch
+ * @return false if date is not an IMF-fixdate.
+ */
+bool parseGMT(const std::string& date, std::time_t* time);
+
 }  // namespace http
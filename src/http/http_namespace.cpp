@@ -37,19 +37,29 @@ const char* AUTHORIZATION = "Authorization";
 const char* USER_AGENT = "User-Agent";
 const char* COOKIE = "Cookie";
 const char* REFERER = "Referer";
+const char* RANGE = "Range";
+const char* IF_RANGE = "If-Range";
 // response fields
 const char* SERVER = "Server";
 const char* SET_COOKIE = "Set-Cookie";
 const char* LOCATION = "Location";
 const char* WWW_AUTHENTICATE = "WWW-Authenticate";
 const char* LAST_MODIFIED = "Last-Modified";
+const char* ACCEPT_RANGES = "Accept-Ranges";
+const char* CONTENT_RANGE = "Content-Range";
+const char* ETAG = "ETag";
+const char* RETRY_AFTER = "Retry-After";
+const char* EXPIRES = "Expires";
+const char* AGE = "Age";
 const char* FIELDS[] = {
 DATE,          CACHE_CONTROL,    CONNECTION,       CONTENT_LENGTH,
 CONTENT_TYPE,  CONTENT_ENCODING, CONTENT_LANGUAGE, TRANSFER_ENCODING,
 HOST,          ACCEPT,           ACCEPT_ENCODING,  ACCEPT_LANGUAGE,
 AUTHORIZATION, USER_AGENT,       COOKIE,           REFERER,
+RANGE,         IF_RANGE,
 SERVER,        SET_COOKIE,       LOCATION,         WWW_AUTHENTICATE,
-LAST_MODIFIED
+LAST_MODIFIED, ACCEPT_RANGES,    CONTENT_RANGE,    ETAG,
+RETRY_AFTER,   EXPIRES,          AGE
 };
 const std::size_t FIELD_SIZE = sizeof(FIELDS) / sizeof(FIELDS[0]);
 const std::size_t MAX_FIELDLINE_SIZE = 8192;
@@ -83,6 +93,12 @@ const std::size_t MAX_REDIRECTS = 10;
 const std::size_t TIMEOUT = 30;
 const std::size_t READ_BUFFER_SIZE = 4096;
 const std::size_t READ_TIMEOUT_SEC = 1;
+// Stop reading CGI output while this much is still waiting for the client.
+const std::size_t STREAM_BUFFER_LIMIT = 64 * 1024;
+// Stop reading a request body while this much is still waiting for the CGI.
+const std::size_t BODY_BUFFER_LIMIT = 64 * 1024;
+// Retry-After of a 503 for a location whose CGI slots and queue are full.
+const std::size_t RETRY_AFTER_SEC = 5;
 const char* GATEWAY_INTERFACE = "CGI/1.1";
 const char* SERVER_SOFTWARE = "WebServ-Ideal Broccoli/1.0";
 const char* ENV_PREFIX = "HTTP_";
@@ -105,6 +121,24 @@ const char* SERVER_PORT = "SERVER_PORT";
 const char* SERVER_PROTOCOL = "SERVER_PROTOCOL";
 const char* SERVER_SOFTWARE = "SERVER_SOFTWARE";
 const char* UPLOAD_DIR = "UPLOAD_DIR";
+const char* SCRIPT_FILENAME = "SCRIPT_FILENAME";
+const char* REQUEST_URI = "REQUEST_URI";
 }  // namespace meta
 }  // namespace cgi
+
+namespace fastcgi {
+// Connections opened to one fastcgi_pass address; further requests queue.
+const std::size_t MAX_CONNECTIONS = 16;
+// Idle connections kept open per address for reuse.
+const std::size_t KEEPALIVE_CONNECTIONS = 8;
+// Upper bound on requests multiplexed over one connection, even when the
+// application reports a larger FCGI_MAX_REQS.
+const std::size_t MAX_REQUESTS_PER_CONNECTION = 32;
+const std::size_t READ_BUFFER_SIZE = 16384;
+// Also bounds the wait for the FCGI_GET_VALUES reply on a new address.
+const std::size_t CONNECT_TIMEOUT_SEC = 5;
+// A cgi_pool worker that is let go exits on end of input; it is sent
+// SIGTERM if it has not done so by then.
+const std::size_t WORKER_EXIT_TIMEOUT_SEC = 5;
+}  // namespace fastcgi
 }  // namespace http
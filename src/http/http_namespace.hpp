@@ -40,12 +40,20 @@ extern const char* AUTHORIZATION;
 extern const char* USER_AGENT;
 extern const char* COOKIE;
 extern const char* REFERER;
+extern const char* RANGE;
+extern const char* IF_RANGE;
 // response fields
 extern const char* SERVER;
 extern const char* SET_COOKIE;
 extern const char* LOCATION;
 extern const char* WWW_AUTHENTICATE;
 extern const char* LAST_MODIFIED;
+extern const char* ACCEPT_RANGES;
+extern const char* CONTENT_RANGE;
+extern const char* ETAG;
+extern const char* RETRY_AFTER;
+extern const char* EXPIRES;
+extern const char* AGE;
 extern const char* FIELDS[];
 extern const std::size_t FIELD_SIZE;
 extern const std::size_t MAX_FIELDLINE_SIZE;
@@ -79,6 +87,9 @@ extern const std::size_t MAX_REDIRECTS;
 extern const std::size_t TIMEOUT;
 extern const std::size_t READ_BUFFER_SIZE;
 extern const std::size_t READ_TIMEOUT_SEC;
+extern const std::size_t STREAM_BUFFER_LIMIT;
+extern const std::size_t BODY_BUFFER_LIMIT;
+extern const std::size_t RETRY_AFTER_SEC;
 extern const char* GATEWAY_INTERFACE;
 extern const char* SERVER_SOFTWARE;
 extern const char* ENV_PREFIX;
@@ -101,6 +112,17 @@ extern const char* SERVER_PORT;
 extern const char* SERVER_PROTOCOL;
 extern const char* SERVER_SOFTWARE;
 extern const char* UPLOAD_DIR;
+extern const char* SCRIPT_FILENAME;
+extern const char* REQUEST_URI;
 }  // namespace meta
 }  // namespace cgi
+
+namespace fastcgi {
+extern const std::size_t MAX_CONNECTIONS;
+extern const std::size_t KEEPALIVE_CONNECTIONS;
+extern const std::size_t MAX_REQUESTS_PER_CONNECTION;
+extern const std::size_t READ_BUFFER_SIZE;
+extern const std::size_t CONNECT_TIMEOUT_SEC;
+extern const std::size_t WORKER_EXIT_TIMEOUT_SEC;
+}  // namespace fastcgi
 }  // namespace http
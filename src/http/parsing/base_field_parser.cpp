@@ -77,15 +77,15 @@ void BaseFieldParser::normalFieldLine(HTTPFields::FieldMap::iterator& target,
 
 bool BaseFieldParser::validateHost(const HTTPFields::FieldValue& values) {
     if (values.empty()) {
-        toolbox::logger::StepMark::info("FieldParser: host value not found");
+        STEPMARK_INFO("FieldParser: host value not found");
         return false;
     }
     if (values.size() != 1) {
-        toolbox::logger::StepMark::info("FieldParser: too many host");
+        STEPMARK_INFO("FieldParser: too many host");
         return false;
     }
     if (utils::hasWhiteSpace(values[0])) {
-        toolbox::logger::StepMark::info("FieldParser: host has invalid char");
+        STEPMARK_INFO("FieldParser: host has invalid char");
         return false;
     }
     return true;
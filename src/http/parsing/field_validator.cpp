@@ -44,7 +44,7 @@ bool FieldValidator::validateCgiHeaders(HTTPFields& fields,
 
 HttpStatus::EHttpStatus FieldValidator::validateHostExists(HTTPFields& fields) {
     if (fields.get().find(fields::HOST)->second.empty()) {
-        toolbox::logger::StepMark::info(
+        STEPMARK_INFO(
             "FieldValidator: host does not exist");
         return HttpStatus::BAD_REQUEST;
     }
@@ -59,7 +59,7 @@ HttpStatus::EHttpStatus FieldValidator::validateContentHeaders(
         fields.get().find(fields::TRANSFER_ENCODING);
     if (!contentLength->second.empty()) {
         if (!transferEncoding->second.empty()) {
-            toolbox::logger::StepMark::info(
+            STEPMARK_INFO(
                 "FieldValidator: content-length and transfer-encoding must not "
                 "coexist");
             return HttpStatus::BAD_REQUEST;
@@ -74,13 +74,13 @@ HttpStatus::EHttpStatus FieldValidator::validateContentHeaders(
 HttpStatus::EHttpStatus FieldValidator::validateContentLength(
     HTTPFields::FieldMap::iterator contentLength) {
     if (!utils::isDigitStr(contentLength->second[0])) {
-        toolbox::logger::StepMark::info(
+        STEPMARK_INFO(
             "FieldValidator: content-length is not number");
         return HttpStatus::BAD_REQUEST;
     }
     for (std::size_t i = 1; i < contentLength->second.size(); ++i) {
         if (contentLength->second[0] != contentLength->second[i]) {
-            toolbox::logger::StepMark::info(
+            STEPMARK_INFO(
                 "FieldValidator: content-length has different multiple number");
             return HttpStatus::BAD_REQUEST;
         }
@@ -92,8 +92,8 @@ HttpStatus::EHttpStatus FieldValidator::validateTransferEncoding(
     HTTPFields::FieldMap::iterator transferEncoding) {
     for (std::size_t i = 0; i < transferEncoding->second.size(); ++i) {
         if ("chunked" != transferEncoding->second[i]) {
-            toolbox::logger::StepMark::info
-                ("FieldValidator: transfer-encoding not implemented");
+            STEPMARK_INFO(
+                "FieldValidator: transfer-encoding not implemented");
             return HttpStatus::NOT_IMPLEMENTED;
         }
     }
@@ -3,11 +3,17 @@
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <ctime>
 
 #include "../cgi/cgi_handler.hpp"
 #include "request.hpp"
 #include "../response/server_method_handler.hpp"
 #include "io_pending_state.hpp"
+#include "../../core/metrics.hpp"
+
+namespace {
+const char* STATUS_CONTENT_TYPE = "text/plain; version=0.0.4; charset=utf-8";
+}  // namespace
 
 namespace http {
 void Request::handleRequest() {
@@ -15,20 +21,20 @@ void Request::handleRequest() {
         return;
     }
     if (_response.getStatus() != 200) {
-        toolbox::logger::StepMark::error(
+        STEPMARK_ERROR(
             "Request: handleRequest: Response already set status "
                 + toolbox::to_string(_response.getStatus()) + " does not handle request");
         return;
     }
 
     HTTPRequest& httpRequest = _parsedRequest.get();
-    const std::vector<std::string>& allowedMethods = _config.getAllowedMethods();
+    const std::vector<std::string>& allowedMethods = _config->getAllowedMethods();
 
     if (std::find(allowedMethods.begin(), allowedMethods.end(),
                     httpRequest.method) == allowedMethods.end()) {
         _response.setStatus(HttpStatus::METHOD_NOT_ALLOWED);
         _ioPendingState = NO_IO_PENDING;
-        toolbox::logger::StepMark::error(
+        STEPMARK_ERROR(
             "Request: handleRequest: Method not allowed: "
                 + httpRequest.method);
         return;
@@ -41,36 +47,114 @@ void Request::handleRequest() {
             _cgiHandler.reset();
             _cgiHandler.setRedirectCount(_requestDepth);
             _ioPendingState = NO_IO_PENDING;
-            toolbox::logger::StepMark::info(
+            STEPMARK_INFO(
                 "CGI_LOCAL_REDIRECT_IO_PENDING: requestDepth="
                 + toolbox::to_string(_requestDepth));
             break;
+        case CGI_CACHE_WAITING:
+            // The fill this request waited for is over: look again.
+            _ioPendingState = NO_IO_PENDING;
+            break;
+        case CGI_QUEUED:
         case CGI_BODY_SENDING:
         case CGI_OUTPUT_READING:
+        case CGI_OUTPUT_STREAMING:
             _ioPendingState = _cgiHandler.handleRequest(httpRequest, _response,
-            _client, _config, _ioPendingState);
+            _client, *_config, _ioPendingState);
             return;
         default:
             break;
     }
+    if (_config->isStubStatus()) {
+        serveStatus(httpRequest);
+        return;
+    }
+    // A HEAD carries no body, so there is no stream to frame.
+    if (!_isErrorInternalRedirect && httpRequest.method != method::HEAD) {
+        _response.allowStreaming(httpRequest.version);
+    }
     bool isCgi = _cgiHandler.isCgiRequest(httpRequest.uri.path,
-                                _config.getCgiExtensions(),
-                                _config.getCgiPath());
+                                _config->getCgiExtensions(),
+                                _config->getCgiPath())
+        || _cgiHandler.isFastcgiRequest(httpRequest.uri.path, *_config);
     if (isCgi) {
         if (_ioPendingState == NO_IO_PENDING) {
             _cgiHandler.reset();
+            if (lookupCgiCache(httpRequest)) {
+                return;
+            }
         }
         _cgiHandler.setRedirectCount(_requestDepth);
         _ioPendingState = _cgiHandler.handleRequest(httpRequest, _response,
-            _client, _config, _ioPendingState);
+            _client, *_config, _ioPendingState);
     } else {
         _requestDepth = 0;
         serverMethod::serverMethodHandler(
-            _parsedRequest, _config, httpRequest.fields, _response);
+            _parsedRequest, *_config, httpRequest.fields, _response);
     }
 
-    toolbox::logger::StepMark::info("Request: handleRequest: handled request for "
+    STEPMARK_INFO("Request: handleRequest: handled request for "
         + httpRequest.uri.path + " with method " + httpRequest.method);
 }
 
+// - Returns true if the request was answered from the cache or waits for
+//   another request filling the same key; false if it runs the CGI.
+//   Error pages are left out: their request is not woken on its own.
+bool Request::lookupCgiCache(const HTTPRequest& httpRequest) {
+    if (!_config->getCgiCache().isSet() || _isErrorInternalRedirect
+        || (httpRequest.method != method::GET
+            && httpRequest.method != method::HEAD)) {
+        return false;
+    }
+    std::string key = CgiResponseCache::makeKey(httpRequest, *_config);
+    toolbox::SharedPtr<CgiCacheEntry> entry;
+    switch (CgiResponseCache::lookup(*_config, key, _client->getFd(), &entry)) {
+        case CgiResponseCache::HIT:
+            serveCachedResponse(*entry);
+            return true;
+        case CgiResponseCache::WAIT:
+            _ioPendingState = CGI_CACHE_WAITING;
+            return true;
+        case CgiResponseCache::MISS:
+            _cgiHandler.fillCache(key, _config->getCgiCache().getMaxSize());
+            return false;
+        default:
+            return false;
+    }
+}
+
+void Request::serveCachedResponse(const CgiCacheEntry& entry) {
+    _response.setStatus(HttpStatus::OK);
+    for (HTTPFields::FieldMap::const_iterator it = entry.fields.begin();
+            it != entry.fields.end(); ++it) {
+        _response.setHeader(it->first, it->second);
+    }
+    _response.setHeader(fields::AGE,
+                        toolbox::to_string(std::time(NULL) - entry.storedAt));
+    if (_parsedRequest.get().method == method::HEAD) {
+        _response.setHeadLength(entry.body.size());
+    } else {
+        _response.setBody(entry.body);
+    }
+    STEPMARK_INFO("Request: handleRequest: served "
+        + _parsedRequest.get().uri.path + " from the CGI cache");
+}
+
+// - Rendered for every request; a scraper must never see a stale page.
+void Request::serveStatus(const HTTPRequest& httpRequest) {
+    if (httpRequest.method != method::GET
+            && httpRequest.method != method::HEAD) {
+        _response.setStatus(HttpStatus::METHOD_NOT_ALLOWED);
+        return;
+    }
+    _response.setStatus(HttpStatus::OK);
+    _response.setHeader(fields::CONTENT_TYPE, STATUS_CONTENT_TYPE);
+    _response.setHeader(fields::CACHE_CONTROL, "no-cache");
+    if (httpRequest.method == method::GET) {
+        _response.setBody(Metrics::render());
+    } else {
+        _response.setHeadLength(Metrics::render().size());
+    }
+}
+
 }  // namespace http
@@ -6,8 +6,11 @@ namespace http {
 enum IOPendingState {
     START_READING,
     REQUEST_READING,
+    CGI_CACHE_WAITING,
+    CGI_QUEUED,
     CGI_BODY_SENDING,
     CGI_OUTPUT_READING,
+    CGI_OUTPUT_STREAMING,
     CGI_LOCAL_REDIRECT_IO_PENDING,
     ERROR_LOCAL_REDIRECT_IO_PENDING,
     RESPONSE_START,
@@ -1,11 +1,17 @@
 // Copyright 2025 Ideal Broccoli
 
+#include <poll.h>
+#include <sys/socket.h>
+
+#include <algorithm>
 #include <string>
 #include <limits>
+#include <vector>
 
 #include "../../../toolbox/stepmark.hpp"
 #include "../../core/client.hpp"
 #include "../../core/constant.hpp"
+#include "../../core/metrics.hpp"
 #include "request_parser.hpp"
 #include "request.hpp"
 #include "io_pending_state.hpp"
@@ -18,13 +24,13 @@ int handleRecvResult(int receivedSize,
                       const Client* client) {
     int statusCode = 200;
     if (receivedSize == 0) {
-        toolbox::logger::StepMark::info("Request: recvRequest: client "
+        STEPMARK_INFO("Request: recvRequest: client "
             "disconnected " + toolbox::to_string(client->getFd()));
         if (validatePos != BaseParser::V_COMPLETED) {
             statusCode = 400;
         }
     } else if (receivedSize == -1) {
-        toolbox::logger::StepMark::error("Request: recvRequest: recv failed "
+        STEPMARK_ERROR("Request: recvRequest: recv failed "
             "in recv from " + toolbox::to_string(client->getFd()));
         statusCode = 500;
     }
@@ -35,7 +41,7 @@ bool isValidContentLength(std::size_t contentLength,
                           std::size_t clientMaxBodySize) {
     if (contentLength != std::numeric_limits<std::size_t>::max()
         && contentLength > clientMaxBodySize) {
-        toolbox::logger::StepMark::info( "Request: recvRequest: content length"
+        STEPMARK_INFO( "Request: recvRequest: content length"
             " exceeds client max body size");
         return false;
     }
@@ -45,13 +51,26 @@ bool isValidContentLength(std::size_t contentLength,
 bool isValidReceivedLength(std::size_t receivedLength,
                            std::size_t clientMaxBodySize) {
     if (receivedLength > clientMaxBodySize) {
-        toolbox::logger::StepMark::info("Request: recvRequest: received length"
+        STEPMARK_INFO("Request: recvRequest: received length"
             " exceeds client max body size");
         return false;
     }
     return true;
 }
 
+// - The request is also run for events on its CGI pipes, when the socket
+//   may have nothing to read.
+bool isReadable(int fd) {
+    struct pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    if (poll(&pfd, 1, 0) == -1) {
+        return false;
+    }
+    return (pfd.revents & (POLLIN | POLLHUP | POLLERR)) != 0;
+}
+
 }  // namespace
 
 bool Request::performRecv(std::string& receivedData) {
@@ -66,17 +85,20 @@ bool Request::performRecv(std::string& receivedData) {
         return false;
     }
 
+    Metrics::bytesReceived(receivedSize);
     receivedData = std::string(buffer, receivedSize);
     return true;
 }
 
 bool Request::loadConfig() {
+    _timer.enter(RequestTimer::CONFIG);
     fetchConfig();
+    _timer.enter(RequestTimer::READ);
     if (_ioPendingState == RESPONSE_START) {
         return false;
     }
     if (_response.getStatus() != HttpStatus::OK) {
-        toolbox::logger::StepMark::info(
+        STEPMARK_INFO(
             "Request: loadConfig: fetchConfig failed");
         return false;
     }
@@ -94,7 +116,7 @@ bool Request::isValidBodySize() {
         return false;
     }
 
-    const std::size_t clientMaxBodySize = _config.getClientMaxBodySize();
+    const std::size_t clientMaxBodySize = _config->getClientMaxBodySize();
     const std::size_t contentLength = _parsedRequest.get().body.contentLength;
     const std::size_t receivedLength = _parsedRequest.get().body.receivedLength;
 
@@ -110,7 +132,7 @@ void Request::recvRequest() {
 
     if (!performRecv(receivedData)) {
         _ioPendingState = NO_IO_PENDING;
-        toolbox::logger::StepMark::error("Request: recvRequest: failed to receive data");
+        STEPMARK_ERROR("Request: recvRequest: failed to receive data");
         return;
     }
 
@@ -125,7 +147,7 @@ void Request::recvRequest() {
     if (parseStatus == BaseParser::P_ERROR) {
         _response.setStatus(_parsedRequest.get().httpStatus.get());
         _ioPendingState = NO_IO_PENDING;
-        toolbox::logger::StepMark::error("Request: recvRequest: failed to parse request");
+        STEPMARK_ERROR("Request: recvRequest: failed to parse request");
         return;
     }
 
@@ -135,16 +157,73 @@ void Request::recvRequest() {
         }
         _response.setStatus(HttpStatus::PAYLOAD_TOO_LARGE);
         _ioPendingState = NO_IO_PENDING;
-        toolbox::logger::StepMark::error("Request: recvRequest: request have "
+        STEPMARK_ERROR("Request: recvRequest: request have "
             "invalid body/content size");
         return;
     }
 
     if (parseStatus == BaseParser::P_COMPLETED) {
         _ioPendingState = NO_IO_PENDING;
-        toolbox::logger::StepMark::info("Request: recvRequest: request "
+        STEPMARK_INFO("Request: recvRequest: request "
             "received and parsed successfully");
+    } else if (canStreamBody()) {
+        startBodyStreaming();
+    }
+}
+
+bool Request::canStreamBody() {
+    if (_parsedRequest.getValidatePos() != BaseParser::V_BODY
+        || _response.getStatus() != HttpStatus::OK) {
+        return false;
+    }
+    const HTTPRequest& httpRequest = _parsedRequest.get();
+    const std::vector<std::string>& allowedMethods = _config->getAllowedMethods();
+    if (std::find(allowedMethods.begin(), allowedMethods.end(),
+                  httpRequest.method) == allowedMethods.end()) {
+        return false;
+    }
+    return _cgiHandler.canStreamBody(httpRequest, *_config);
+}
+
+// - The CGI is started as soon as the header section is in; what has
+//   arrived of the body so far is its first input.
+void Request::startBodyStreaming() {
+    _ioPendingState = NO_IO_PENDING;
+    handleRequest();
+    if (_ioPendingState != CGI_BODY_SENDING) {
+        return;
+    }
+    _cgiHandler.appendRequestBody(&_parsedRequest.get().body.content, false);
+    STEPMARK_INFO("Request: startBodyStreaming: CGI "
+        "started before the request body was received");
+}
+
+// - Flow control: the socket is only read while the CGI has taken most
+//   of what was read before (Client::getEventInterest() drops EPOLLIN
+//   meanwhile), so a slow script slows the upload down.
+void Request::streamRequestBody() {
+    if (!_cgiHandler.wantsRequestBody() || !isReadable(_client->getFd())) {
+        return;
+    }
+    std::string receivedData;
+    if (!performRecv(receivedData)) {
+        _cgiHandler.forceTerminate();
+        _ioPendingState = NO_IO_PENDING;
+        STEPMARK_ERROR("Request: streamRequestBody: "
+            "failed to receive data");
+        return;
+    }
+    int parseStatus = _parsedRequest.run(receivedData);
+    if (parseStatus == BaseParser::P_ERROR) {
+        _cgiHandler.forceTerminate();
+        _response.setStatus(_parsedRequest.get().httpStatus.get());
+        _ioPendingState = NO_IO_PENDING;
+        STEPMARK_ERROR("Request: streamRequestBody: "
+            "failed to parse request body");
+        return;
     }
+    _cgiHandler.appendRequestBody(&_parsedRequest.get().body.content,
+                                  parseStatus == BaseParser::P_COMPLETED);
 }
 
 }  // namespace http
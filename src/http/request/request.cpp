@@ -4,29 +4,78 @@
 #include "io_pending_state.hpp"
 
 namespace http {
+namespace {
+// - The phase a request waits in until its next event.
+RequestTimer::Phase getWaitingPhase(IOPendingState state) {
+    switch (state) {
+        case START_READING:
+        case REQUEST_READING:
+            return RequestTimer::READ;
+        case CGI_BODY_SENDING:
+        case CGI_OUTPUT_READING:
+        case CGI_OUTPUT_STREAMING:
+        case CGI_LOCAL_REDIRECT_IO_PENDING:
+            return RequestTimer::CGI;
+        case CGI_CACHE_WAITING:
+        case CGI_QUEUED:
+            return RequestTimer::HANDLE;
+        default:
+            return RequestTimer::SEND;
+    }
+}
+}  // namespace
+
 void Request::run() {
     const std::size_t root_depth = 0;
+    _timer.start();
     switch (_ioPendingState) {
         case START_READING:
         case NO_IO_PENDING:
         case REQUEST_READING:
             if (_requestDepth == root_depth) {
+                _timer.enter(RequestTimer::READ);
                 recvRequest();
                 if (_ioPendingState != NO_IO_PENDING && _ioPendingState != RESPONSE_START)
                     break;
             }
         // fallthrough
         case CGI_BODY_SENDING:
+            if (_ioPendingState == CGI_BODY_SENDING
+                && _cgiHandler.isBodyStreaming()) {
+                streamRequestBody();
+            }
+        // fallthrough
+        case CGI_CACHE_WAITING:
+        case CGI_QUEUED:
         case CGI_OUTPUT_READING:
+        case CGI_OUTPUT_STREAMING:
         case CGI_LOCAL_REDIRECT_IO_PENDING:
+            _timer.enter(_ioPendingState == NO_IO_PENDING
+                ? RequestTimer::HANDLE : getWaitingPhase(_ioPendingState));
             handleRequest();
-            if (_ioPendingState != NO_IO_PENDING && _ioPendingState != RESPONSE_START)
+            // A local redirect has no event of its own to wait for: the
+            // CGI pipes are closed, so start the redirected request now.
+            while (_ioPendingState == CGI_LOCAL_REDIRECT_IO_PENDING) {
+                handleRequest();
+            }
+            if (_ioPendingState == END_RESPONSE) {
+                writeAccessLog();
+                break;
+            }
+            if (_ioPendingState != NO_IO_PENDING && _ioPendingState != RESPONSE_START
+                && _ioPendingState != CGI_OUTPUT_STREAMING
+                && _ioPendingState != RESPONSE_SENDING)
                 break;
         // fallthrough
         case ERROR_LOCAL_REDIRECT_IO_PENDING:
         case RESPONSE_START:
         case RESPONSE_SENDING:
-            if (_requestDepth == root_depth || _requestDepth == http::cgi::MAX_REDIRECTS) {
+            // A local redirect raises the depth of the request itself; only
+            // an error page subrequest leaves sending to its parent.
+            if (!_isErrorInternalRedirect) {
+                if (_ioPendingState != CGI_OUTPUT_STREAMING) {
+                    _timer.enter(RequestTimer::SEND);
+                }
                 Request::sendResponse();
             }
             break;
@@ -34,6 +83,7 @@ void Request::run() {
             // never come here
             break;
     }
+    _timer.enter(getWaitingPhase(_ioPendingState));
 }
 
 }  // namespace http
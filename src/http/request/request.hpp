@@ -11,6 +11,7 @@
 #include "../../config/config.hpp"
 #include "../../../toolbox/shared.hpp"
 #include "io_pending_state.hpp"
+#include "request_timer.hpp"
 
 class Client;
 
@@ -69,6 +70,11 @@ class Request {
      */
     void sendResponse();
 
+    /**
+     * @brief Write the access log entry once the response is over.
+     */
+    void writeAccessLog();
+
     /**
      * @brief Returns the current I/O pending state of the request.
      * @return The current I/O pending state.
@@ -77,6 +83,19 @@ class Request {
         return _ioPendingState;
     }
 
+    /**
+     * @brief Returns true once the connection had its first event, i.e.
+     * the client sent something or hung up.
+     */
+    bool isStarted() const { return _timer.isStarted(); }
+
+    /**
+     * @brief Returns the phase timings of the request.
+     */
+    const RequestTimer& getTimer() const {
+        return _timer;
+    }
+
     /**
      * @brief Returns the prepared HTTP response.
      * @return A copy of the Response object.
@@ -105,9 +124,26 @@ class Request {
      */
     void terminateActiveCgiProcesses();
 
+    /**
+     * @brief Returns true if a CGI of this request (or of its error page
+     * request) is still running past its timeout.
+     */
+    bool isCgiTimedOut() const;
+
+    /**
+     * @brief Returns true while response bytes are waiting for the socket.
+     */
+    bool hasPendingOutput() const;
+
+    /**
+     * @brief Returns true while a CGI is fed the request body as it arrives
+     * and has room for more of it.
+     */
+    bool wantsRequestBody() const;
+
  private:
     http::RequestParser _parsedRequest;
-    config::LocationConfig _config;
+    toolbox::SharedPtr<config::LocationConfig> _config;
     http::Response _response;
     const Client* _client;
     std::size_t _requestDepth;
@@ -115,6 +151,7 @@ class Request {
     toolbox::SharedPtr<http::Request> _errorPageRequest;
     CgiHandler _cgiHandler;
     bool _isErrorInternalRedirect;
+    RequestTimer _timer;
 
     Request();
     Request(const Request& other);
@@ -124,15 +161,16 @@ class Request {
     bool performRecv(std::string& receivedData);
     bool loadConfig();
     bool isValidBodySize();
+    bool canStreamBody();
+    void startBodyStreaming();
+    void streamRequestBody();
+    // handleRequest helper methods
+    bool lookupCgiCache(const HTTPRequest& httpRequest);
+    void serveCachedResponse(const CgiCacheEntry& entry);
+    void serveStatus(const HTTPRequest& httpRequest);
     // fetchConfig helper methods
     toolbox::SharedPtr<config::ServerConfig> selectServer();
-    bool extractCandidateServers(
-        const std::vector<toolbox::SharedPtr<config::ServerConfig> >& servers,
-        std::vector<toolbox::SharedPtr<config::ServerConfig> >& candidateServers);
     std::string extractHostName();
-    toolbox::SharedPtr<config::ServerConfig> matchServerByName(
-        const std::vector<toolbox::SharedPtr<config::ServerConfig> >& servers,
-        const std::string& hostName);
     bool processReturn(const config::Return& returnValue);
     void processReturnWithContent(std::size_t statusCode,
                                   const std::string& content);
@@ -148,10 +186,7 @@ class Request {
     std::string generateDefaultBody(std::size_t statusCode);
     bool selectLocation(
         const toolbox::SharedPtr<config::ServerConfig>& server);
-    toolbox::SharedPtr<config::LocationConfig> findDeepestMatchingLocation(
-        const std::vector<toolbox::SharedPtr
-        <config::LocationConfig> >& locations,
-        const std::string& path);
+    bool isLocationSelected() const;
 };
 
 }  // namespace http
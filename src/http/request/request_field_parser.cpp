@@ -11,13 +11,13 @@ bool RequestFieldParser::isUnique(const std::string& key) {
 
 void RequestFieldParser::handleInvalidFieldError(const std::string& key,
                                                 HttpStatus& hs) {
-    toolbox::logger::StepMark::info("RequestFieldParser: invalid " + key);
+    STEPMARK_INFO("RequestFieldParser: invalid " + key);
     hs.set(HttpStatus::BAD_REQUEST);
 }
 
 void RequestFieldParser::handleDuplicateFieldError(const std::string& key,
                                                 HttpStatus& hs) {
-    toolbox::logger::StepMark::info("RequestFieldParser: duplicate " + key);
+    STEPMARK_INFO("RequestFieldParser: duplicate " + key);
     hs.set(HttpStatus::BAD_REQUEST);
 }
 
@@ -8,8 +8,19 @@
 #include "request_parser.hpp"
 #include "io_pending_state.hpp"
 
+namespace {
+// - Stands for the location until one is selected, e.g. when the request
+//   line is already invalid.
+const toolbox::SharedPtr<config::LocationConfig>& getUnselectedLocation() {
+    static toolbox::SharedPtr<config::LocationConfig> location(
+        new config::LocationConfig());
+    return location;
+}
+}  // namespace
+
 http::Request::Request(const Client* client, std::size_t requestDepth)
-    : _client(client), _requestDepth(requestDepth), _ioPendingState(REQUEST_READING),
+    : _config(getUnselectedLocation()), _client(client),
+    _requestDepth(requestDepth), _ioPendingState(REQUEST_READING),
     _isErrorInternalRedirect(false) {
 }
 
@@ -41,10 +52,35 @@ void http::Request::setErrorInternalRedirect() {
     _isErrorInternalRedirect = true;
 }
 
+bool http::Request::isLocationSelected() const {
+    return _config.get() != getUnselectedLocation().get();
+}
+
 const std::string& http::Request::getUploadPath() const {
-    return _config.getUploadStore();
+    return _config->getUploadStore();
 }
 
 void http::Request::terminateActiveCgiProcesses() {
     _cgiHandler.forceTerminate();
+    if (_errorPageRequest) {
+        _errorPageRequest->terminateActiveCgiProcesses();
+    }
+}
+
+bool http::Request::isCgiTimedOut() const {
+    if (_cgiHandler.hasTimedOut()) {
+        return true;
+    }
+    return _errorPageRequest && _errorPageRequest->isCgiTimedOut();
+}
+
+bool http::Request::hasPendingOutput() const {
+    return _response.hasPendingOutput()
+        || (_ioPendingState == CGI_OUTPUT_STREAMING
+            && _cgiHandler.isRelayWaitingForClient());
+}
+
+bool http::Request::wantsRequestBody() const {
+    return _ioPendingState == CGI_BODY_SENDING
+        && _cgiHandler.wantsRequestBody();
 }
@@ -5,7 +5,6 @@
 
 #include "request.hpp"
 #include "../../core/client.hpp"
-#include "../../config/config_inherit.hpp"
 
 namespace http {
 
@@ -18,7 +17,7 @@ void Request::fetchConfig() {
     }
     if (processReturn(selectedServer->getReturnValue())) {
         _ioPendingState = RESPONSE_START;
-        toolbox::logger::StepMark::info(
+        STEPMARK_INFO(
             "Request: fetchConfig: processReturn selectedServer found return value");
         return;
     }
@@ -26,47 +25,24 @@ void Request::fetchConfig() {
         _response.setStatus(HttpStatus::INTERNAL_SERVER_ERROR);
         return;
     }
-    if (processReturn(_config.getReturnValue())) {
+    if (processReturn(_config->getReturnValue())) {
         _ioPendingState = RESPONSE_START;
-        toolbox::logger::StepMark::info(
+        STEPMARK_INFO(
             "Request: fetchConfig: processReturn _config found return value");
         return;
     }
 }
 
+// - The names reachable through the address the connection came in on
+//   were looked up when it was accepted.
 toolbox::SharedPtr<config::ServerConfig> Request::selectServer() {
-    const toolbox::SharedPtr<config::HttpConfig>& httpConfig =
-                                                config::Config::getHttpConfig();
-    std::vector<toolbox::SharedPtr<config::ServerConfig> > candidateServers;
-    if (!extractCandidateServers(httpConfig->getServers(), candidateServers)) {
+    toolbox::SharedPtr<config::ServerNameTable> serverNames =
+                                                _client->getServerNames();
+    if (!serverNames) {
         _response.setStatus(HttpStatus::BAD_REQUEST);
         return toolbox::SharedPtr<config::ServerConfig>(NULL);
     }
-    std::string hostName = extractHostName();
-    toolbox::SharedPtr<config::ServerConfig> selectedServer =
-            matchServerByName(candidateServers, hostName);
-    if (!selectedServer) {
-        selectedServer = candidateServers[0];
-    }
-    return selectedServer;
-}
-
-bool Request::extractCandidateServers(
-    const std::vector<toolbox::SharedPtr<config::ServerConfig> >& servers,
-    std::vector<toolbox::SharedPtr<config::ServerConfig> >& candidateServers) {
-    for (std::size_t i = 0; i < servers.size(); ++i) {
-        const std::vector<config::Listen>& listens = servers[i]->getListens();
-        for (std::size_t j = 0; j < listens.size(); ++j) {
-            if (listens[j].getPort() == _client->getServerPort()) {
-                if (listens[j].getIp() ==  _client->getServerIp()) {
-                    candidateServers.push_back(servers[i]);
-                } else if (listens[j].getIp() == "0.0.0.0") {
-                    candidateServers.push_back(servers[i]);
-                }
-            }
-        }
-    }
-    return !candidateServers.empty();
+    return serverNames->find(extractHostName());
 }
 
 std::string Request::extractHostName() {
@@ -83,22 +59,6 @@ std::string Request::extractHostName() {
     return hostName;
 }
 
-toolbox::SharedPtr<config::ServerConfig> Request::matchServerByName(
-    const std::vector<toolbox::SharedPtr<config::ServerConfig> >& candidates,
-    const std::string& hostName) {
-    for (std::size_t i = 0; i < candidates.size(); ++i) {
-        const std::vector<config::ServerName>& serverNames =
-                                    candidates[i]->getServerNames();
-        for (std::size_t j = 0; j < serverNames.size(); ++j) {
-            if (serverNames[j].getType() == config::ServerName::EXACT &&
-                serverNames[j].getName() == hostName) {
-                return candidates[i];
-            }
-        }
-    }
-    return toolbox::SharedPtr<config::ServerConfig>(NULL);
-}
-
 bool Request::processReturn(const config::Return& returnValue) {
     if (!returnValue.hasReturnValue()) {
         return false;
@@ -189,57 +149,17 @@ std::string Request::generateDefaultBody(std::size_t statusCode) {
            "</html>\n";
 }
 
+// - The locations are shared with the configuration: they were fully
+//   inherited when it was loaded, and every server has one for "/".
 bool Request::selectLocation(
     const toolbox::SharedPtr<config::ServerConfig>& server) {
-    std::string requestPath = _parsedRequest.get().uri.path;
     toolbox::SharedPtr<config::LocationConfig> matchedLocation =
-        findDeepestMatchingLocation(server->getLocations(), requestPath);
-    if (matchedLocation) {
-        _config = *matchedLocation;
-        return true;
-    } else {
-        if (requestPath == config::DEFAULT_LOCATION_PATH) {
-            server->addLocation(toolbox::SharedPtr
-                <config::LocationConfig>(new config::LocationConfig()));
-            config::ConfigInherit
-            inherit(config::Config::getHttpConfig().get());
-            inherit.applyInheritance();
-            matchedLocation =
-                findDeepestMatchingLocation(server->getLocations(),
-                                            requestPath);
-            return true;
-        }
-    }
-    return false;
-}
-
-toolbox::SharedPtr<config::LocationConfig> Request::findDeepestMatchingLocation(
-    const std::vector<toolbox::SharedPtr<config::LocationConfig> >& locations,
-    const std::string& path) {
-    toolbox::SharedPtr<config::LocationConfig> bestMatch;
-    std::size_t longestMatchLength = 0;
-    for (std::size_t i = 0; i < locations.size(); ++i) {
-        std::string locPath = locations[i]->getPath();
-        if (locPath == path) {
-            return locations[i];
-        }
-        if (path.find(locPath) == 0 && locPath.size() > longestMatchLength) {
-            if (locPath[locPath.size() - 1] == '/' ||
-                path.size() == locPath.size() ||
-                path[locPath.size()] == '/') {
-                bestMatch = locations[i];
-                longestMatchLength = locPath.size();
-            }
-        }
-    }
-    if (bestMatch && bestMatch->hasLocations()) {
-        toolbox::SharedPtr<config::LocationConfig> childMatch =
-            findDeepestMatchingLocation(bestMatch->getLocations(), path);
-        if (childMatch) {
-            return childMatch;
-        }
+        server->findLocation(_parsedRequest.get().uri.path);
+    if (!matchedLocation) {
+        return false;
     }
-    return bestMatch;
+    _config = matchedLocation;
+    return true;
 }
 
 }  // namespace http
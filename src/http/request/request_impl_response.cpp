@@ -2,23 +2,80 @@
 
 #include "request.hpp"
 
+#include <ctime>
 #include <string>
 #include <vector>
 
 #include "../../core/client.hpp"
+#include "../../core/metrics.hpp"
 #include "../../../toolbox/access.hpp"
+#include "../../../toolbox/log_format.hpp"
 #include "../../../toolbox/string.hpp"
 #include "io_pending_state.hpp"
 
 namespace {
-    std::string getFieldValue(
-        http::HTTPRequest& request, const std::string& fieldName) {
-        std::vector<std::string> values = request.fields.getFieldValue(fieldName);
-        if (!values.empty()) {
-            return values[0];
+    // - Reads the values straight from the request, the response and the
+    //   timer, so that a line costs no copies beyond its own text.
+    class AccessLogRecord : public toolbox::logger::LogRecord {
+     public:
+        AccessLogRecord(const Client& client, const http::HTTPRequest& request,
+                        const http::Response& response,
+                        const http::RequestTimer& timer)
+            : _client(client), _request(request), _response(response),
+              _timer(timer) {}
+
+        virtual void append(toolbox::logger::LogFormat::Variable variable,
+                            const std::string& field,
+                            std::string* line) const {
+            typedef toolbox::logger::LogFormat LogFormat;
+            switch (variable) {
+                case LogFormat::BODY_BYTES_SENT:
+                    LogFormat::appendNumber(_response.getContentLength(), line);
+                    break;
+                case LogFormat::FIRST_BYTE_TIME:
+                    LogFormat::appendSeconds(_timer.getFirstByteTime(), line);
+                    break;
+                case LogFormat::HTTP_FIELD: {
+                    const http::HTTPFields::FieldValue& values =
+                        _request.fields.getFieldValue(field);
+                    LogFormat::appendEscaped(
+                        values.empty() ? "" : values[0], line);
+                    break;
+                }
+                case LogFormat::REMOTE_ADDR:
+                    *line += _client.getIp();
+                    break;
+                case LogFormat::REQUEST:
+                    LogFormat::appendEscaped(_request.originalRequestLine, line);
+                    break;
+                case LogFormat::REQUEST_METHOD:
+                    LogFormat::appendEscaped(_request.method, line);
+                    break;
+                case LogFormat::REQUEST_TIME:
+                    LogFormat::appendSeconds(_timer.getRequestTime(), line);
+                    break;
+                case LogFormat::REQUEST_URI:
+                    LogFormat::appendEscaped(_request.uri.fullUri, line);
+                    break;
+                case LogFormat::STATUS:
+                    LogFormat::appendNumber(
+                        static_cast<std::size_t>(_response.getStatus()), line);
+                    break;
+                case LogFormat::UPSTREAM_RESPONSE_TIME:
+                    LogFormat::appendSeconds(_timer.getUpstreamTime(), line);
+                    break;
+                default:
+                    *line += '-';
+                    break;
+            }
         }
-        return "-";
-    }
+
+     private:
+        const Client& _client;
+        const http::HTTPRequest& _request;
+        const http::Response& _response;
+        const http::RequestTimer& _timer;
+    };
 
     void propagateErrorPage(
         http::Response* response, const http::Response& errorResponse) {
@@ -43,7 +100,7 @@ namespace {
             }
             response->setHeader(header.first, headerValue);
         }
-        response->setBody(errorResponse.getBody());
+        response->copyBodyFrom(errorResponse);
     }
 
     void setDefaultErrorPage(http::Response* response, std::size_t status) {
@@ -90,10 +147,11 @@ void http::Request::sendResponse() {
     std::size_t status = _response.getStatus();
     if (_ioPendingState != http::RESPONSE_SENDING && 
         _ioPendingState != http::RESPONSE_START &&
+        _ioPendingState != http::CGI_OUTPUT_STREAMING &&
         status >= config::directive::MIN_ERROR_PAGE_CODE && 
         status <= config::directive::MAX_ERROR_PAGE_CODE) {
         if (_ioPendingState != http::ERROR_LOCAL_REDIRECT_IO_PENDING) {
-            std::vector<config::ErrorPage> errorPages = _config.getErrorPages();
+            std::vector<config::ErrorPage> errorPages = _config->getErrorPages();
             bool errorPageFound = false;
             for (std::size_t i = 0; i < errorPages.size(); ++i) {
                 if (std::find(errorPages[i].getCodes().begin(),
@@ -174,7 +232,7 @@ void http::Request::sendResponse() {
                 || _errorPageRequest->getIOPendingState() == http::CGI_OUTPUT_READING
                 || _errorPageRequest->getIOPendingState() == http::CGI_LOCAL_REDIRECT_IO_PENDING) {
                 _ioPendingState = http::ERROR_LOCAL_REDIRECT_IO_PENDING;
-                toolbox::logger::StepMark::info(
+                STEPMARK_INFO(
                     "Request: sendResponse: local redirect to error page");
                 return;
             }
@@ -195,35 +253,39 @@ void http::Request::sendResponse() {
         }
     }
 
-    if (_ioPendingState != http::RESPONSE_SENDING) {
-        std::string remote_addr = _client->getIp();
-        std::string remote_user = "-";
-        std::string request = _parsedRequest.get().originalRequestLine;
-        int finalStatus = _response.getStatus();
-        std::size_t body_bytes_sent = _response.getContentLength();
-        std::string http_referer = getFieldValue(
-            _parsedRequest.get(), http::fields::REFERER);
-        std::string http_user_agent = getFieldValue(
-            _parsedRequest.get(), http::fields::USER_AGENT);
-
-        toolbox::logger::AccessLog::log(
-            remote_addr,
-            remote_user,
-            request,
-            finalStatus,
-            body_bytes_sent,
-            http_referer,
-            http_user_agent
-        );
+    if (_ioPendingState != http::RESPONSE_SENDING &&
+        _ioPendingState != http::CGI_OUTPUT_STREAMING) {
         _ioPendingState = http::RESPONSE_SENDING;
-        toolbox::logger::StepMark::info(
+        STEPMARK_INFO(
             "Request: sendResponse: ready to send response");
         return;
     }
+    // The first call always sends the start of the header, or throws.
     bool endSending = _response.sendResponse(_client->getFd());
+    _timer.markFirstByte();
     if (endSending) {
         _ioPendingState = http::END_RESPONSE;
-        toolbox::logger::StepMark::info(
+        writeAccessLog();
+        STEPMARK_INFO(
             "Request: sendResponse: successfully sent response");
     }
+}
+
+// - Logged at the end rather than when sending starts, so that streamed
+//   bodies are reported with the number of bytes actually produced. A
+//   request that never got a location logs as the http block says.
+void http::Request::writeAccessLog() {
+    _timer.finish();
+    Metrics::requestFinished(_response.getStatus(),
+        isLocationSelected() ? _config->getPath() : "", _timer);
+    const config::AccessLog& accessLog = isLocationSelected()
+        ? _config->getAccessLog()
+        : config::Config::getHttpConfig()->getAccessLog();
+    if (accessLog.isOff()) {
+        return;
+    }
+    AccessLogRecord record(*_client, _parsedRequest.get(), _response, _timer);
+    toolbox::logger::AccessLog::log(accessLog.getPath(), accessLog.getFormat(),
+        record, accessLog.getBufferSize(),
+        static_cast<time_t>(accessLog.getFlushInterval()));
 }
\ No newline at end of file
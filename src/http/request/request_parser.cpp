@@ -7,6 +7,7 @@
 #include <cstdlib>
 #include <limits>
 #include <sstream>
+#include <algorithm>
 
 #include "request_parser.hpp"
 
@@ -55,7 +56,7 @@ BaseParser::ParseStatus RequestParser::processFieldLine() {
         }
         if (lineEndPos == 0) {
             if (!FieldValidator::validateRequestHeaders(_request.fields, _request.httpStatus)) {
-                toolbox::logger::StepMark::error(
+                STEPMARK_ERROR(
                     "RequestParser: invalid request headers");
                 throw ParseException("");
             }
@@ -66,7 +67,7 @@ BaseParser::ParseStatus RequestParser::processFieldLine() {
 
         std::string line = toolbox::trim(getBuf(), symbols::CRLF);
         if (!FieldValidator::validateFieldLine(line)) {
-            toolbox::logger::StepMark::error(
+            STEPMARK_ERROR(
                 "RequestParser: invalid character in field line");
             _request.httpStatus.set(HttpStatus::BAD_REQUEST);
             continue;
@@ -74,7 +75,7 @@ BaseParser::ParseStatus RequestParser::processFieldLine() {
         HTTPFields::FieldPair pair = RequestFieldParser::splitFieldLine(&line);
         if (!_fieldParser.parseFieldLine(pair, _request.fields.get(),
                                         _request.httpStatus)) {
-            toolbox::logger::StepMark::error("RequestParser: invalid field line");
+            STEPMARK_ERROR("RequestParser: invalid field line");
             throw ParseException("");
         }
     }
@@ -90,7 +91,7 @@ BaseParser::ParseStatus RequestParser::processRequestLine() {
     validateMethod();
     processURI();
     if (_request.httpStatus.get() != HttpStatus::OK) {
-        toolbox::logger::StepMark::error(
+        STEPMARK_ERROR(
             "RequestParser: invalid request line");
         throw ParseException("");
     }
@@ -101,7 +102,7 @@ BaseParser::ParseStatus RequestParser::processRequestLine() {
 void RequestParser::parseRequestLine() {
     std::string line = toolbox::trim(getBuf(), symbols::CRLF);
     if (line.find(symbols::SP) == std::string::npos) {
-        toolbox::logger::StepMark::error(
+        STEPMARK_ERROR(
             "RequestParser: request line has no space");
         _request.httpStatus.set(HttpStatus::BAD_REQUEST);
         return;
@@ -115,7 +116,7 @@ void RequestParser::parseRequestLine() {
 
     if (_request.version.find(symbols::SP) != std::string::npos) {
         _request.httpStatus.set(HttpStatus::BAD_REQUEST);
-        toolbox::logger::StepMark::error(
+        STEPMARK_ERROR(
             "RequestParser: invalid request line");
     }
 }
@@ -123,18 +124,18 @@ void RequestParser::parseRequestLine() {
 void RequestParser::validateVersion() {
     if (_request.version.empty()) {
         _request.httpStatus.set(HttpStatus::BAD_REQUEST);
-        toolbox::logger::StepMark::error(
+        STEPMARK_ERROR(
             "RequestParser: version not found");
         return;
     }
     if (utils::hasCtlChar(_request.version)) {
         _request.httpStatus.set(HttpStatus::BAD_REQUEST);
-        toolbox::logger::StepMark::error(
+        STEPMARK_ERROR(
             "RequestParser: version has control character");
         return;
     }
     if (!isValidFormat()) {
-        toolbox::logger::StepMark::error(
+        STEPMARK_ERROR(
             "RequestParser: invalid version format");
         return;
     }
@@ -170,13 +171,13 @@ bool RequestParser::isValidFormat() {
 void RequestParser::validateMethod() {
     if (_request.method.empty()) {
         _request.httpStatus.set(HttpStatus::BAD_REQUEST);
-        toolbox::logger::StepMark::error(
+        STEPMARK_ERROR(
             "RequestParser: method not found");
         return;
     }
     if (!utils::isUpperStr(_request.method)) {
         _request.httpStatus.set(HttpStatus::BAD_REQUEST);
-        toolbox::logger::StepMark::error(
+        STEPMARK_ERROR(
             "RequestParser: method is not uppercase");
         return;
     }
@@ -210,13 +211,13 @@ void RequestParser::parseURI() {
 void RequestParser::validatePath() {
     if (_request.uri.fullUri.empty()) {
         _request.httpStatus.set(HttpStatus::BAD_REQUEST);
-        toolbox::logger::StepMark::error(
+        STEPMARK_ERROR(
             "RequestParser: uri not found");
         return;
     }
     if (_request.uri.path.size() > http::uri::MAX_URI_SIZE) {
         _request.httpStatus.set(HttpStatus::URI_TOO_LONG);
-        toolbox::logger::StepMark::error(
+        STEPMARK_ERROR(
             "RequestParser: uri too large");
     }
 }
@@ -246,8 +247,8 @@ void RequestParser::percentDecode(std::string& line) {
                 if (line[0] == '/' ||
                     i + parser::HEX_DIGIT_LENGTH < line.size()) {  // is path
                     _request.httpStatus.set(HttpStatus::BAD_REQUEST);
-                    toolbox::logger::StepMark::error
-                        ("RequestParser: path has invalid hexdecimal");
+                    STEPMARK_ERROR(
+                        "RequestParser: path has invalid hexdecimal");
                     return;
                 }
                 res += line[i];
@@ -322,7 +323,7 @@ void RequestParser::verifySafePath() {
     for (std::size_t i = 0; i < _request.uri.splitPath.size(); ++i) {
         if (_request.uri.splitPath[i] == "/..") {
             if (pathDeque.empty()) {
-                toolbox::logger::StepMark::error(
+                STEPMARK_ERROR(
                     "RequestParser: invalid path, try parent directory");
                 _request.httpStatus.set(HttpStatus::BAD_REQUEST);
                 return;
@@ -362,8 +363,9 @@ BaseParser::ParseStatus RequestParser::processBody() {
     if (_request.body.contentLength > _request.body.receivedLength) {
         std::size_t remainLen = _request.body.contentLength - _request.body.receivedLength;
 
-        _request.body.content += getBuf()->substr(0, remainLen);
-        _request.body.receivedLength = _request.body.content.size();
+        std::size_t size = std::min(remainLen, getBuf()->size());
+        _request.body.content.append(*getBuf(), 0, size);
+        _request.body.receivedLength += size;
     }
     if (_request.body.contentLength <= _request.body.receivedLength) {
         setValidatePos(V_COMPLETED);
@@ -379,104 +381,60 @@ bool RequestParser::isChunkedEncoding() {
     return !value.empty() && value[0] == "chunked";
 }
 
-void RequestParser::solveChunkedBody(std::string& recvBody) {
-    std::string unchunkedBody;
+// - Chunks are decoded as they arrive: data is appended to the body and
+//   consumed from the buffer, so each byte is looked at once however the
+//   body is split across reads.
+BaseParser::ParseStatus RequestParser::parseChunkedEncoding() {
+    std::string& buf = *getBuf();
     std::size_t pos = 0;
 
-    while (pos < recvBody.size()) {
-        std::size_t chunkSizeEnd = recvBody.find(symbols::CRLF, pos);
-        if (chunkSizeEnd == std::string::npos) {
-            toolbox::logger::StepMark::error(
-                "runPost: solveChunkedBody failed: chunk size end not found");
-            throw HttpStatus::BAD_REQUEST;
-        }
-
-        std::string chunkSizeStr = recvBody.substr(pos, chunkSizeEnd - pos);
-
-        std::size_t chunkSize;
-        if (!parseChunkSize(chunkSizeStr, chunkSize)) {
-            toolbox::logger::StepMark::error(
-                "runPost: solveChunkedBody failed: invalid chunk size " +
-                chunkSizeStr);
-            throw HttpStatus::BAD_REQUEST;
+    while (true) {
+        if (_chunkState == CHUNK_DATA) {
+            std::size_t size = std::min(_chunkRemaining, buf.size() - pos);
+            _request.body.content.append(buf, pos, size);
+            _request.body.receivedLength += size;
+            _chunkRemaining -= size;
+            pos += size;
+            if (_chunkRemaining > 0) {
+                break;
+            }
+            _chunkState = CHUNK_DATA_END;
+            continue;
         }
-        if (chunkSize == 0) {
+        if (buf.size() - pos < symbols::CRLF_SIZE) {
             break;
         }
-
-        pos = chunkSizeEnd + symbols::CRLF_SIZE;
-        if (pos + chunkSize > recvBody.size()) {
-            toolbox::logger::StepMark::error(
-                "runPost: solveChunkedBody failed: chunk size exceeds body "
-                "size");
-            throw HttpStatus::BAD_REQUEST;
-        }
-
-        std::string chunkData = recvBody.substr(pos, chunkSize);
-        pos += chunkSize;
-
-        if (pos + symbols::CRLF_SIZE > recvBody.size() ||
-            recvBody.find(symbols::CRLF, pos) != pos) {
-            toolbox::logger::StepMark::error(
-                "runPost: solveChunkedBody failed: CRLF not found after chunk "
-                "data");
-            throw HttpStatus::BAD_REQUEST;
-        }
-        pos += symbols::CRLF_SIZE;
-
-        unchunkedBody += chunkData;
-    }
-    recvBody = unchunkedBody;
-}
-
-BaseParser::ParseStatus RequestParser::parseChunkedEncoding() {
-    _request.body.content += *getBuf();
-    getBuf()->clear();
-
-    std::string& body = _request.body.content;
-    std::size_t pos = _request.body.receivedLength;
-
-    while (pos < body.size()) {
-        std::size_t chunkSizeEnd = body.find(symbols::CRLF, pos);
-        if (chunkSizeEnd == std::string::npos) {
-            return P_NEED_MORE_DATA;
-        }
-
-        std::string chunkSizeStr = body.substr(pos, chunkSizeEnd - pos);
-        std::size_t chunkSize;
-        if (!parseChunkSize(chunkSizeStr, chunkSize)) {
-            _request.httpStatus.set(HttpStatus::BAD_REQUEST);
-            toolbox::logger::StepMark::error("parseChunkedEncoding: invalid chunk size");
-            return P_ERROR;
-        }
-
-        if (chunkSize == 0) {
-            std::size_t finalCRLFPos = chunkSizeEnd + symbols::CRLF_SIZE;
-            if (finalCRLFPos + symbols::CRLF_SIZE <= body.size() &&
-                body.find(symbols::CRLF, finalCRLFPos) == finalCRLFPos) {
-                solveChunkedBody(_request.body.content);
-                return P_COMPLETED;
+        if (_chunkState == CHUNK_SIZE) {
+            std::size_t chunkSizeEnd = buf.find(symbols::CRLF, pos);
+            if (chunkSizeEnd == std::string::npos) {
+                break;
             }
-            return P_NEED_MORE_DATA;
-        }
-
-        std::size_t chunkDataStart = chunkSizeEnd + symbols::CRLF_SIZE;
-        std::size_t chunkDataEnd = chunkDataStart + chunkSize;
-        std::size_t chunkEnd = chunkDataEnd + symbols::CRLF_SIZE;
-
-        if (chunkEnd > body.size()) {
-            return P_NEED_MORE_DATA;
+            std::size_t chunkSize;
+            if (!parseChunkSize(buf.substr(pos, chunkSizeEnd - pos),
+                                chunkSize)) {
+                _request.httpStatus.set(HttpStatus::BAD_REQUEST);
+                STEPMARK_ERROR("parseChunkedEncoding: invalid chunk size");
+                return P_ERROR;
+            }
+            pos = chunkSizeEnd + symbols::CRLF_SIZE;
+            _chunkRemaining = chunkSize;
+            _chunkState = chunkSize == 0 ? CHUNK_LAST : CHUNK_DATA;
+            continue;
         }
-
-        if (body.substr(chunkDataEnd, symbols::CRLF_SIZE) != symbols::CRLF) {
+        if (buf.compare(pos, symbols::CRLF_SIZE, symbols::CRLF) != 0) {
             _request.httpStatus.set(HttpStatus::BAD_REQUEST);
-            toolbox::logger::StepMark::error("parseChunkedEncoding: CRLF not found after chunk");
+            STEPMARK_ERROR("parseChunkedEncoding: CRLF not found after chunk");
             return P_ERROR;
         }
-
-        pos = chunkEnd;
-        _request.body.receivedLength = pos;
+        pos += symbols::CRLF_SIZE;
+        if (_chunkState == CHUNK_LAST) {
+            buf.erase(0, pos);
+            setValidatePos(V_COMPLETED);
+            return P_COMPLETED;
+        }
+        _chunkState = CHUNK_SIZE;
     }
+    buf.erase(0, pos);
     return P_NEED_MORE_DATA;
 }
 
@@ -21,11 +21,20 @@ const std::size_t HEX_DIGIT_LENGTH = 2;
 
 class RequestParser : public BaseParser {
  public:
-    RequestParser() { setValidatePos(V_REQUEST_LINE); }
+    RequestParser() : _chunkState(CHUNK_SIZE), _chunkRemaining(0) {
+        setValidatePos(V_REQUEST_LINE);
+    }
     ~RequestParser() {}
     HTTPRequest& get() { return _request; }
 
  private:
+    enum ChunkState {
+        CHUNK_SIZE,       // waiting for a chunk-size line
+        CHUNK_DATA,       // _chunkRemaining bytes of chunk data to go
+        CHUNK_DATA_END,   // waiting for the CRLF after chunk data
+        CHUNK_LAST        // waiting for the CRLF after the last chunk
+    };
+
     RequestParser(const RequestParser& other);
     RequestParser& operator=(const RequestParser& other);
 
@@ -47,10 +56,11 @@ class RequestParser : public BaseParser {
     ParseStatus processBody();
     bool isChunkedEncoding();
     ParseStatus parseChunkedEncoding();
-    void solveChunkedBody(std::string& recvBody);
 
     HTTPRequest _request;
     RequestFieldParser _fieldParser;
+    ChunkState _chunkState;
+    std::size_t _chunkRemaining;
 };
 
 }  // namespace http
@@ -0,0 +1,104 @@
+// Copyright 2025 Ideal Broccoli
+
+#include "request_timer.hpp"
+
+#include <cstddef>
+
+#include "../../../toolbox/clock.hpp"
+
+namespace {
+const char* PHASE_NAMES[] = {"read", "config", "handle", "cgi", "send"};
+}  // namespace
+
+namespace http {
+
+RequestTimer::RequestTimer()
+    : _isStarted(false), _hasUpstream(false), _phase(READ),
+      _startedAt(0), _enteredAt(0), _firstByteAt(-1), _finishedAt(-1) {
+    for (std::size_t i = 0; i < PHASE_COUNT; ++i) {
+        _spent[i] = 0;
+    }
+}
+
+RequestTimer::RequestTimer(const RequestTimer& other) {
+    *this = other;
+}
+
+RequestTimer& RequestTimer::operator=(const RequestTimer& other) {
+    if (this != &other) {
+        _isStarted = other._isStarted;
+        _hasUpstream = other._hasUpstream;
+        _phase = other._phase;
+        _startedAt = other._startedAt;
+        _enteredAt = other._enteredAt;
+        _firstByteAt = other._firstByteAt;
+        _finishedAt = other._finishedAt;
+        for (std::size_t i = 0; i < PHASE_COUNT; ++i) {
+            _spent[i] = other._spent[i];
+        }
+    }
+    return *this;
+}
+
+RequestTimer::~RequestTimer() {
+}
+
+void RequestTimer::start() {
+    if (_isStarted) {
+        return;
+    }
+    _isStarted = true;
+    _startedAt = toolbox::getMonotonicSeconds();
+    _enteredAt = _startedAt;
+    _phase = READ;
+}
+
+void RequestTimer::enter(Phase phase) {
+    if (!_isStarted || _finishedAt >= 0 || phase == _phase) {
+        return;
+    }
+    double now = toolbox::getMonotonicSeconds();
+    _spent[_phase] += now - _enteredAt;
+    _phase = phase;
+    _enteredAt = now;
+    if (phase == CGI) {
+        _hasUpstream = true;
+    }
+}
+
+void RequestTimer::markFirstByte() {
+    if (_isStarted && _firstByteAt < 0) {
+        _firstByteAt = toolbox::getMonotonicSeconds();
+    }
+}
+
+void RequestTimer::finish() {
+    if (!_isStarted || _finishedAt >= 0) {
+        return;
+    }
+    _finishedAt = toolbox::getMonotonicSeconds();
+    _spent[_phase] += _finishedAt - _enteredAt;
+}
+
+double RequestTimer::getRequestTime() const {
+    if (!_isStarted) {
+        return 0;
+    }
+    double end = _finishedAt >= 0 ? _finishedAt
+                                  : toolbox::getMonotonicSeconds();
+    return end - _startedAt;
+}
+
+double RequestTimer::getFirstByteTime() const {
+    return _firstByteAt < 0 ? -1 : _firstByteAt - _startedAt;
+}
+
+double RequestTimer::getUpstreamTime() const {
+    return _hasUpstream ? _spent[CGI] : -1;
+}
+
+const char* RequestTimer::getPhaseName(Phase phase) {
+    return PHASE_NAMES[phase];
+}
+
+}  // namespace http
@@ -0,0 +1,87 @@
+// Copyright 2025 Ideal Broccoli
+
+#pragma once
+
+namespace http {
+
+/**
+ * @brief Measures where a request spends its time.
+ *
+ * The clock starts when the request is first run, which is when its first
+ * bytes arrive. Every phase transition is timestamped, and the time until
+ * the next one, waiting for the socket or a CGI included, is added to the
+ * phase being left.
+ *
+ * Usage example:
+ * @code
+ * timer.start();
+ * timer.enter(RequestTimer::READ);
+ * // ... the request is read, then:
+ * timer.enter(RequestTimer::HANDLE);
+ * // ... once the whole response is sent:
+ * timer.finish();
+ * double total = timer.getRequestTime();
+ * @endcode
+ */
+class RequestTimer {
+ public:
+    enum Phase {
+        READ,       // receiving the request
+        CONFIG,     // selecting the server and location
+        HANDLE,     // building the response, CGI queue and cache waits
+        CGI,        // a CGI or FastCGI process producing the response
+        SEND,       // writing the response
+        PHASE_COUNT
+    };
+
+    RequestTimer();
+    RequestTimer(const RequestTimer& other);
+    RequestTimer& operator=(const RequestTimer& other);
+    ~RequestTimer();
+
+    /**
+     * @brief Start the clock in the READ phase; later calls do nothing.
+     */
+    void start();
+    bool isStarted() const { return _isStarted; }
+
+    void enter(Phase phase);
+
+    /**
+     * @brief Note that the response started to go out; only the first call
+     * counts.
+     */
+    void markFirstByte();
+
+    void finish();
+
+    /**
+     * @brief Seconds from the first byte received to the last one sent.
+     */
+    double getRequestTime() const;
+
+    /**
+     * @brief Seconds until the first response byte was sent, or -1.
+     */
+    double getFirstByteTime() const;
+
+    /**
+     * @brief Seconds spent in the CGI phase, or -1 if no CGI ran.
+     */
+    double getUpstreamTime() const;
+
+    double getPhaseTime(Phase phase) const { return _spent[phase]; }
+    static const char* getPhaseName(Phase phase);
+
+ private:
+    bool _isStarted;
+    bool _hasUpstream;
+    Phase _phase;
+    double _startedAt;
+    double _enteredAt;      // of the current phase
+    double _firstByteAt;    // -1 until then
+    double _finishedAt;     // -1 until then
+    double _spent[PHASE_COUNT];
+};
+
+}  // namespace http
@@ -0,0 +1,195 @@
+// Copyright 2025 Ideal Broccoli
+
+#include "byte_range.hpp"
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <algorithm>
+#include <cctype>
+
+#include "../../../toolbox/string.hpp"
+#include "../get_gmt.hpp"
+#include "../http_namespace.hpp"
+#include "response.hpp"
+
+namespace http {
+namespace {
+const char* RANGE_UNIT = "bytes";
+const std::size_t MAX_RANGE_COUNT = 100;
+
+bool compareRange(const ByteRange& lhs, const ByteRange& rhs) {
+    return lhs.first < rhs.first;
+}
+
+std::string trimSpaces(const std::string& str) {
+    std::size_t begin = str.find_first_not_of(" \t");
+    if (begin == std::string::npos) {
+        return "";
+    }
+    std::size_t end = str.find_last_not_of(" \t");
+    return str.substr(begin, end - begin + 1);
+}
+
+// Values that do not fit in off_t saturate; they can only ever mean
+// "past the end of the file".
+bool parseOffset(const std::string& str, off_t* out) {
+    if (str.empty()) {
+        return false;
+    }
+    const off_t limit = static_cast<off_t>(
+        (static_cast<unsigned long long>(1) << (sizeof(off_t) * 8 - 1)) - 1);
+    off_t value = 0;
+    for (std::size_t i = 0; i < str.size(); ++i) {
+        if (!std::isdigit(static_cast<unsigned char>(str[i]))) {
+            return false;
+        }
+        int digit = str[i] - '0';
+        if (value > (limit - digit) / 10) {
+            value = limit;
+        } else {
+            value = value * 10 + digit;
+        }
+    }
+    *out = value;
+    return true;
+}
+
+// Returns false on a syntax error. A spec that is valid but does not
+// overlap the entity leaves *satisfiable false.
+bool parseRangeSpec(const std::string& spec, off_t size,
+                    ByteRange* range, bool* satisfiable) {
+    std::size_t dash = spec.find('-');
+    if (dash == std::string::npos) {
+        return false;
+    }
+    std::string firstStr = trimSpaces(spec.substr(0, dash));
+    std::string lastStr = trimSpaces(spec.substr(dash + 1));
+    *satisfiable = false;
+
+    if (firstStr.empty()) {
+        off_t suffix;
+        if (!parseOffset(lastStr, &suffix)) {
+            return false;
+        }
+        if (suffix == 0 || size == 0) {
+            return true;
+        }
+        range->first = suffix >= size ? 0 : size - suffix;
+        range->last = size - 1;
+        *satisfiable = true;
+        return true;
+    }
+
+    off_t first;
+    if (!parseOffset(firstStr, &first)) {
+        return false;
+    }
+    off_t last = size - 1;
+    if (!lastStr.empty()) {
+        if (!parseOffset(lastStr, &last) || last < first) {
+            return false;
+        }
+        if (last >= size) {
+            last = size - 1;
+        }
+    }
+    if (first >= size) {
+        return true;
+    }
+    range->first = first;
+    range->last = last;
+    *satisfiable = true;
+    return true;
+}
+}  // namespace
+
+ERangeResult parseRangeHeader(const std::string& value, off_t size,
+                              std::vector<ByteRange>* ranges) {
+    ranges->clear();
+    std::size_t equal = value.find('=');
+    if (equal == std::string::npos ||
+        !toolbox::isEqualIgnoreCase(trimSpaces(value.substr(0, equal)),
+                                    RANGE_UNIT)) {
+        return RANGE_NONE;
+    }
+
+    std::vector<ByteRange> candidates;
+    std::string specs = value.substr(equal + 1);
+    std::size_t specCount = 0;
+    std::size_t pos = 0;
+    while (pos <= specs.size()) {
+        std::size_t comma = specs.find(',', pos);
+        if (comma == std::string::npos) {
+            comma = specs.size();
+        }
+        std::string spec = trimSpaces(specs.substr(pos, comma - pos));
+        pos = comma + 1;
+        if (spec.empty()) {
+            continue;
+        }
+        if (++specCount > MAX_RANGE_COUNT) {
+            return RANGE_NONE;
+        }
+        ByteRange range;
+        bool satisfiable;
+        if (!parseRangeSpec(spec, size, &range, &satisfiable)) {
+            return RANGE_NONE;
+        }
+        if (satisfiable) {
+            candidates.push_back(range);
+        }
+    }
+    if (specCount == 0) {
+        return RANGE_NONE;
+    }
+    if (candidates.empty()) {
+        return RANGE_NOT_SATISFIABLE;
+    }
+
+    std::sort(candidates.begin(), candidates.end(), compareRange);
+    ranges->push_back(candidates[0]);
+    for (std::size_t i = 1; i < candidates.size(); ++i) {
+        ByteRange& current = ranges->back();
+        if (candidates[i].first <= current.last + 1) {
+            current.last = std::max(current.last, candidates[i].last);
+        } else {
+            ranges->push_back(candidates[i]);
+        }
+    }
+    return RANGE_SATISFIABLE;
+}
+
+bool isIfRangeSatisfied(const std::string& ifRange, const std::string& etag,
+                        const std::string& lastModified) {
+    std::string validator = trimSpaces(ifRange);
+    if (validator.empty()) {
+        return true;
+    }
+    if (validator[0] == '"' || validator.compare(0, 2, "W/") == 0) {
+        // Weak tags never match for the purposes of If-Range.
+        return validator == etag;
+    }
+    return !lastModified.empty() && validator == lastModified;
+}
+
+std::string makeEntityTag(const struct stat& st) {
+    std::ostringstream oss;
+    oss << "\"" << std::hex << static_cast<unsigned long>(st.st_mtime)
+        << "-" << static_cast<unsigned long long>(st.st_size) << "\"";
+    return oss.str();
+}
+
+void setFileValidators(const struct stat& st, Response& response) {
+    response.setHeader(fields::ACCEPT_RANGES, RANGE_UNIT);
+    response.setHeader(fields::ETAG, makeEntityTag(st));
+    response.setHeader(fields::LAST_MODIFIED, formatGMT(st.st_mtime));
+}
+
+std::string makeContentRange(const ByteRange& range, off_t size) {
+    std::ostringstream oss;
+    oss << RANGE_UNIT << " " << range.first << "-" << range.last << "/" << size;
+    return oss.str();
+}
+
+}  // namespace http
@@ -0,0 +1,68 @@
+// Copyright 2025 Ideal Broccoli
+
+#pragma once
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <string>
+#include <vector>
+
+namespace http {
+
+class Response;
+
+struct ByteRange {
+    off_t first;
+    off_t last;
+};
+
+enum ERangeResult {
+    RANGE_NONE,            // no usable Range header, send the whole entity
+    RANGE_SATISFIABLE,     // at least one range overlaps the entity
+    RANGE_NOT_SATISFIABLE  // syntactically valid but nothing overlaps
+};
+
+/**
+ * @brief Parse a "bytes=" Range header value against an entity size.
+ *
+ * Overlapping and adjacent ranges are coalesced so that a client cannot make
+ * the server send the same bytes twice. Malformed headers, unknown units and
+ * excessively fragmented requests yield RANGE_NONE, as RFC 9110 allows the
+ * server to ignore the header in these cases.
+ *
+ * @param value Range header value (e.g. "bytes=0-99,200-")
+ * @param size Size of the selected representation in bytes
+ * @param ranges Output: sorted, non-overlapping ranges
+ * @return Result of the evaluation
+ */
+ERangeResult parseRangeHeader(const std::string& value, off_t size,
+                              std::vector<ByteRange>* ranges);
+
+/**
+ * @brief Evaluate If-Range against the current validators of the file.
+ *
+ * An entity tag must match strongly; an HTTP-date must equal Last-Modified.
+ *
+ * @return true if the Range header may be honored
+ */
+bool isIfRangeSatisfied(const std::string& ifRange, const std::string& etag,
+                        const std::string& lastModified);
+
+/**
+ * @brief Build a strong entity tag from the file mtime and size.
+ */
+std::string makeEntityTag(const struct stat& st);
+
+/**
+ * @brief Set Accept-Ranges, ETag and Last-Modified for a static file, so
+ * that GET and HEAD send the same validators.
+ */
+void setFileValidators(const struct stat& st, Response& response);
+
+/**
+ * @brief Format a Content-Range value, e.g. "bytes 0-99/1234".
+ */
+std::string makeContentRange(const ByteRange& range, off_t size);
+
+}  // namespace http
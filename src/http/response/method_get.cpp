@@ -2,7 +2,6 @@
 
 #include <string>
 #include <vector>
-#include <fstream>
 #include <sstream>
 #include <map>
 #include <ctime>
@@ -10,27 +9,101 @@
 
 #include <sys/stat.h>
 #include <dirent.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <limits.h>
 
+#include "../../core/constant.hpp"
 #include "../../../toolbox/stepmark.hpp"
 #include "../../../toolbox/string.hpp"
 #include "../case_insensitive_less.hpp"
 #include "../http_status.hpp"
 #include "../http_namespace.hpp"
+#include "../string_utils.hpp"
+#include "byte_range.hpp"
 #include "method_utils.hpp"
 #include "server_method_handler.hpp"
 
 namespace http {
 namespace {
-std::string readFile(const std::string& path) {
-    std::ifstream file(path.c_str(), std::ios::binary);
-    if (!file.is_open()) {
-        throw std::runtime_error("file open error " + path);
+const char* MULTIPART_BYTERANGES = "multipart/byteranges; boundary=";
+
+std::string makeBoundary(const struct stat& st) {
+    std::ostringstream oss;
+    oss << "webserv_" << std::hex << static_cast<unsigned long>(std::time(NULL))
+        << static_cast<unsigned long>(st.st_ino);
+    return oss.str();
+}
+
+void setMultipartBody(const std::vector<ByteRange>& ranges,
+                      const struct stat& st, const std::string& contentType,
+                      Response& response) {
+    std::string boundary = makeBoundary(st);
+    for (std::size_t i = 0; i < ranges.size(); ++i) {
+        std::ostringstream part;
+        if (i > 0) {
+            part << symbols::CRLF;
+        }
+        part << "--" << boundary << symbols::CRLF
+             << fields::CONTENT_TYPE << ": " << contentType << symbols::CRLF
+             << fields::CONTENT_RANGE << ": "
+             << makeContentRange(ranges[i], st.st_size) << symbols::CRLF
+             << symbols::CRLF;
+        response.addBodyData(part.str());
+        response.addBodyFileRange(ranges[i].first,
+            ranges[i].last - ranges[i].first + 1);
+    }
+    response.addBodyData(std::string(symbols::CRLF) + "--" + boundary + "--"
+        + symbols::CRLF);
+    response.setHeader(fields::CONTENT_TYPE, MULTIPART_BYTERANGES + boundary);
+}
+
+// Regular files are never copied into memory: the body refers to the open
+// file and is sent with sendfile(2), one range at a time.
+void serveFile(const std::string& path, const struct stat& st,
+               const HTTPFields& requestFields, Response& response) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        STEPMARK_ERROR("runGet: failed to open [" + path + "]");
+        throw HttpStatus::INTERNAL_SERVER_ERROR;
+    }
+    response.setBodyFile(fd);
+
+    std::string contentType =
+        ContentTypeManager::getInstance().getContentType(path);
+    setFileValidators(st, response);
+    std::string etag = response.getHeader(fields::ETAG);
+    std::string lastModified = response.getHeader(fields::LAST_MODIFIED);
+
+    std::vector<ByteRange> ranges;
+    ERangeResult result = RANGE_NONE;
+    std::string range = utils::joinFieldValues(requestFields.getFieldValue(fields::RANGE));
+    if (!range.empty() && isIfRangeSatisfied(
+            utils::joinFieldValues(requestFields.getFieldValue(fields::IF_RANGE)),
+            etag, lastModified)) {
+        result = parseRangeHeader(range, st.st_size, &ranges);
+    }
+
+    if (result == RANGE_NOT_SATISFIABLE) {
+        std::ostringstream oss;
+        oss << "bytes */" << st.st_size;
+        response.setHeader(fields::CONTENT_RANGE, oss.str());
+        throw HttpStatus::RANGE_NOT_SATISFIABLE;
+    } else if (result == RANGE_NONE) {
+        response.setHeader(fields::CONTENT_TYPE, contentType);
+        response.addBodyFileRange(0, st.st_size);
+        return;
+    }
+    response.setStatus(HttpStatus::PARTIAL_CONTENT);
+    if (ranges.size() == 1) {
+        response.setHeader(fields::CONTENT_TYPE, contentType);
+        response.setHeader(fields::CONTENT_RANGE,
+            makeContentRange(ranges[0], st.st_size));
+        response.addBodyFileRange(ranges[0].first,
+            ranges[0].last - ranges[0].first + 1);
+    } else {
+        setMultipartBody(ranges, st, contentType, response);
     }
-    std::stringstream ss;
-    ss << file.rdbuf();
-    return ss.str();
 }
 
 // Directory handling functions
@@ -45,30 +118,39 @@ void buildFileInfoRow(FileInfo& info, std::stringstream& ss) {
        << "</tr>\n";
 }
 
-void readDirectoryEntries(const std::string& dirPath, std::stringstream& ss) {
+// Rows are pushed to the client in IO_BUFFER_SIZE batches instead of
+// building the whole listing in memory first.
+void readDirectoryEntries(const std::string& dirPath, Response& response) {
     struct stat st;
     DIR* dir = opendir(dirPath.c_str());
     if (!dir) {
         throw std::runtime_error("failed to open directory " + dirPath);
     }
 
+    std::stringstream ss;
     struct dirent* entry;
     while ((entry = readdir(dir)) != NULL) {
         FileInfo info;
         info.name = entry->d_name;
         info.path = joinPath(dirPath, info.name);
         if (stat(info.path.c_str(), &st) != 0) {
+            closedir(dir);
             throw std::runtime_error("failed to access " + info.path);
         }
         info.time = getModifiedTime(st);
         info.isDir = S_ISDIR(st.st_mode);
         info.size = st.st_size;
         buildFileInfoRow(info, ss);
+        if (static_cast<std::size_t>(ss.tellp()) >= core::IO_BUFFER_SIZE) {
+            response.pushChunk(ss.str());
+            ss.str("");
+        }
     }
     closedir(dir);
+    response.pushChunk(ss.str());
 }
 
-std::string processAutoindex(const std::string& path) {
+void processAutoindex(const std::string& path, Response& response) {
     std::stringstream ss;
     ss << "<!DOCTYPE html>\n"
        << "<html>\n"
@@ -93,70 +175,65 @@ std::string processAutoindex(const std::string& path) {
        << "      <th>Last Modified</th>\n"
        << "    </tr>\n";
 
-    readDirectoryEntries(path, ss);
-
-    ss << "  </table>\n"
-       << "</body>\n"
-       << "</html>\n";
-    return ss.str();
+    response.beginStream();
+    response.pushChunk(ss.str());
+    readDirectoryEntries(path, response);
+    response.pushChunk("  </table>\n"
+                       "</body>\n"
+                       "</html>\n");
+    response.finishStream();
 }
 
 void handleDirectory(const std::string& path, std::vector<std::string>& indices,
-                     Response& response, bool isAutoindex) {
+                     const HTTPFields& requestFields, Response& response,
+                     bool isAutoindex) {
     HttpStatus::EHttpStatus status;
 
     if (isAutoindex) {
-        response.setBody(processAutoindex(path));
         response.setHeader(fields::CONTENT_TYPE, "text/html");
+        processAutoindex(path, response);
     } else if (!indices.empty()) {
         struct stat indexSt;
         std::string fullPath = findFirstExistingIndex(path, indices);
 
         status = checkFileAccess(fullPath, indexSt);
         if (status != HttpStatus::OK) {
-            toolbox::logger::StepMark::error("runGet: checkFileAccess fail ["
+            STEPMARK_ERROR("runGet: checkFileAccess fail ["
                 + fullPath + "] " + toolbox::to_string(status));
             throw status;
         }
-        response.setBody(readFile(fullPath));
-        response.setHeader(fields::CONTENT_TYPE, ContentTypeManager::getInstance().getContentType(fullPath));
-        response.setHeader(fields::LAST_MODIFIED, getModifiedTime(indexSt));
+        serveFile(fullPath, indexSt, requestFields, response);
     }  else {
         status = HttpStatus::NOT_FOUND;
-        toolbox::logger::StepMark::error("runGet: directory not found ["
+        STEPMARK_ERROR("runGet: directory not found ["
             + path + "] " + toolbox::to_string(status));
         throw status;
     }
 }
-
-void handleFile(const std::string& path, Response& response) {
-    response.setBody(readFile(path));
-    response.setHeader(fields::CONTENT_TYPE, ContentTypeManager::getInstance().getContentType(path));
-}
 }  // namespace
 
 namespace serverMethod {
 void runGet(const std::string& path, std::vector<std::string>& indices,
-        bool isAutoindex, Response& response) {
+        bool isAutoindex, const HTTPFields& requestFields, Response& response) {
     struct stat st;
 
     try {
         HttpStatus::EHttpStatus status = checkFileAccess(path, st);
         if (status != HttpStatus::OK) {
-            toolbox::logger::StepMark::error("runGet: checkFileAccess fail ["
+            STEPMARK_ERROR("runGet: checkFileAccess fail ["
                 + path + "] " + toolbox::to_string(status));
             throw status;
         }
 
         if (isDirectory(st)) {
-            handleDirectory(path, indices, response, isAutoindex);
+            handleDirectory(path, indices, requestFields, response, isAutoindex);
         } else if (isRegularFile(st)) {
-            handleFile(path, response);
+            serveFile(path, st, requestFields, response);
         } else {
             throw HttpStatus::INTERNAL_SERVER_ERROR;
         }
     } catch (const HttpStatus::EHttpStatus& e) {
-        toolbox::logger::StepMark::error("runGet: set status "
+        STEPMARK_ERROR("runGet: set status "
             + toolbox::to_string(e));
         response.setStatus(e);
     }
@@ -4,6 +4,7 @@
 #include <iostream>
 
 #include "../request/http_fields.hpp"
+#include "byte_range.hpp"
 #include "server_method_handler.hpp"
 #include "method_utils.hpp"
 
@@ -20,14 +21,14 @@ void handleDirectory(const std::string& path, std::vector<std::string> indices,
         std::string fullPath = findFirstExistingIndex(path, indices);
         status = checkFileAccess(fullPath, indexSt);
         if (status != HttpStatus::OK) {
-            toolbox::logger::StepMark::error("runHead: handleDirectory: checkFileAccess fail [" + fullPath + "] " + toolbox::to_string(status));
+            STEPMARK_ERROR("runHead: handleDirectory: checkFileAccess fail [" + fullPath + "] " + toolbox::to_string(status));
             throw status;
         }
         response.setHeader(fields::CONTENT_TYPE, ContentTypeManager::getInstance().getContentType(fullPath));
-        response.setHeader(fields::LAST_MODIFIED, getModifiedTime(indexSt));
+        setFileValidators(indexSt, response);
     }  else {
         status = HttpStatus::NOT_FOUND;
-        toolbox::logger::StepMark::error("runHead: directory not found [" + path + "] " + toolbox::to_string(status));
+        STEPMARK_ERROR("runHead: directory not found [" + path + "] " + toolbox::to_string(status));
         throw status;
     }
 }
@@ -37,12 +38,12 @@ void handleFile(const std::string& path, Response& response) {
 
     HttpStatus::EHttpStatus status = checkFileAccess(path, st);
     if (status != HttpStatus::OK) {
-        toolbox::logger::StepMark::error("runHead: handleFile: checkFileAccess fail ["
+        STEPMARK_ERROR("runHead: handleFile: checkFileAccess fail ["
             + path + "] " + toolbox::to_string(status));
         throw status;
     }
     response.setHeader(fields::CONTENT_TYPE, ContentTypeManager::getInstance().getContentType(path));
-    response.setHeader(fields::LAST_MODIFIED, getModifiedTime(st));
+    setFileValidators(st, response);
 }
 }  // namespace
 
@@ -54,7 +55,7 @@ void runHead(const std::string& path, std::vector<std::string>& indices,
     try {
         HttpStatus::EHttpStatus status = checkFileAccess(path, st);
         if (status != HttpStatus::OK) {
-            toolbox::logger::StepMark::error("runHead: checkFileAccess fail ["
+            STEPMARK_ERROR("runHead: checkFileAccess fail ["
                 + path + "] " + toolbox::to_string(status));
             throw status;
         }
@@ -68,7 +69,7 @@ void runHead(const std::string& path, std::vector<std::string>& indices,
         }
         response.setStatus(HttpStatus::OK);
     } catch (const HttpStatus::EHttpStatus& e) {
-        toolbox::logger::StepMark::error("runHead: set status "
+        STEPMARK_ERROR("runHead: set status "
             + toolbox::to_string(e));
         response.setStatus(e);
     }
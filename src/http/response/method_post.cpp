@@ -41,32 +41,32 @@ std::string getTimestamp() {
 void saveToFile(const std::string& filepath, const std::string& content) {
     std::ofstream ofs(filepath.c_str(), std::ios::binary);
     if (ofs.fail()) {
-        toolbox::logger::StepMark::error("runPost: saveToFile make ofs failed: " + filepath);
+        STEPMARK_ERROR("runPost: saveToFile make ofs failed: " + filepath);
         throw HttpStatus::INTERNAL_SERVER_ERROR;
     }
     ofs.write(content.data(), content.size());
     if (ofs.fail()) {
-        toolbox::logger::StepMark::error("runPost: saveToFile write ofs failed: " + filepath);
+        STEPMARK_ERROR("runPost: saveToFile write ofs failed: " + filepath);
         throw HttpStatus::INTERNAL_SERVER_ERROR;
     }
-    toolbox::logger::StepMark::info("runPost: file created: " + filepath);
+    STEPMARK_INFO("runPost: file created: " + filepath);
 }
 
-bool isMultipartFormData(HTTPFields::FieldValue& contentType) {
+bool isMultipartFormData(const HTTPFields::FieldValue& contentType) {
     return !contentType.empty() && startsWith(contentType[0], MULTIPART_FORM_DATA);
 }
 
 
 std::string getBoundary(HTTPFields& fields) {
-    HTTPFields::FieldValue contentType = fields.getFieldValue(fields::CONTENT_TYPE);
+    const HTTPFields::FieldValue& contentType = fields.getFieldValue(fields::CONTENT_TYPE);
     if (contentType.empty()) {
-        toolbox::logger::StepMark::error("runPost: getBoundary failed: contentType is empty");
+        STEPMARK_ERROR("runPost: getBoundary failed: contentType is empty");
         return "";
     }
     std::string contentTypeStr = contentType[0];
     std::size_t boundaryPos = contentTypeStr.find(BOUNDARY_PREFIX);
     if (boundaryPos == std::string::npos) {
-        toolbox::logger::StepMark::error("runPost: getBoundary failed: boundary is not found");
+        STEPMARK_ERROR("runPost: getBoundary failed: boundary is not found");
         return "";
     }
     std::string boundaryStr = contentTypeStr.substr(boundaryPos + BOUNDARY_PREFIX_LEN);
@@ -99,7 +99,7 @@ void handleCreateFile(const std::string& uploadPath, std::string filename, const
         filename = getTimestamp();
     }
     if (filename.find('.') == std::string::npos) {
-        HTTPFields::FieldValue contentType = fields.getFieldValue(fields::CONTENT_TYPE);
+        const HTTPFields::FieldValue& contentType = fields.getFieldValue(fields::CONTENT_TYPE);
         if (!contentType.empty()) {
             std::string extension = ContentTypeManager::getInstance().getExtension(contentType[0]);
             if (!extension.empty()) {
@@ -153,7 +153,7 @@ void parseContentDisposition(std::string& bodyPart, FormDataField& formData) {
                 filename.erase(pos);
                 formData.filename = filename;
             } else {
-                toolbox::logger::StepMark::error("runPost: parseContentDisposition failed: filename is not closed");
+                STEPMARK_ERROR("runPost: parseContentDisposition failed: filename is not closed");
             }
         }
     }
@@ -163,7 +163,7 @@ void extractPartData(std::string& currentLine, FormDataField& formData) {
     while (!currentLine.empty()) {
         std::size_t crlfPos = currentLine.find(symbols::CRLF);
         if (crlfPos == std::string::npos) {
-            toolbox::logger::StepMark::error("runPost: handleMultipartFormData failed: unexpected line");
+            STEPMARK_ERROR("runPost: handleMultipartFormData failed: unexpected line");
             return;
         }
         std::string line = toolbox::trim(&currentLine, symbols::CRLF);
@@ -202,7 +202,7 @@ void connectFormData(std::vector<FormDataField>& formDataVec, std::map<std::stri
 void handleMultipartFormData(const std::string& uploadPath, std::string& recvBody, HTTPFields& fields) {
     std::string boundary = getBoundary(fields);
     if (boundary.empty()) {
-        toolbox::logger::StepMark::error("runPost: handleMultipartFormData failed: boundary is empty");
+        STEPMARK_ERROR("runPost: handleMultipartFormData failed: boundary is empty");
         throw HttpStatus::BAD_REQUEST;
     }
 
@@ -225,18 +225,18 @@ void runPost(const std::string& uploadPath, std::string& recvBody,
 
     try {
         if (uploadPath.empty()) {
-            toolbox::logger::StepMark::error("runPost: uploadPath is empty");
+            STEPMARK_ERROR("runPost: uploadPath is empty");
             throw HttpStatus::NOT_IMPLEMENTED;
         }
 
         HttpStatus::EHttpStatus status = checkFileAccess(uploadPath, st);
         if (status != HttpStatus::OK) {
-            toolbox::logger::StepMark::error("runPost: checkFileAccess fail [" +
+            STEPMARK_ERROR("runPost: checkFileAccess fail [" +
                 uploadPath + "] " + toolbox::to_string(status));
             throw status;
         }
 
-        HTTPFields::FieldValue contentType = fields.getFieldValue(fields::CONTENT_TYPE);
+        const HTTPFields::FieldValue& contentType = fields.getFieldValue(fields::CONTENT_TYPE);
         if (isMultipartFormData(contentType)) {
             handleMultipartFormData(uploadPath, recvBody, fields);
         } else {
@@ -244,7 +244,7 @@ void runPost(const std::string& uploadPath, std::string& recvBody,
         }
         response.setStatus(HttpStatus::CREATED);
     } catch (const HttpStatus::EHttpStatus& e) {
-        toolbox::logger::StepMark::error("runPost: failed, setStatus "
+        STEPMARK_ERROR("runPost: failed, setStatus "
             + toolbox::to_string(static_cast<int>(e)));
         response.setStatus(e);
     }
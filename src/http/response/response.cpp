@@ -3,6 +3,8 @@
 #include "response.hpp"
 
 #include <sys/socket.h>
+#include <sys/sendfile.h>
+#include <unistd.h>
 
 #include <string>
 #include <map>
@@ -10,30 +12,72 @@
 #include <vector>
 #include <utility>
 #include <algorithm>
+#include <cstdlib>
 
 #include "../../core/constant.hpp"
+#include "../../core/metrics.hpp"
 #include "../../../toolbox/stepmark.hpp"
 #include "../get_gmt.hpp"
+#include "../http_namespace.hpp"
 
 namespace http {
 
-Response::Response() : _status(200), _headers(), _body(), 
-_wholeResponseStr(), _wholeResponsePtr(NULL), _lengthSent(0),
+Response::BodyFile::BodyFile(int fd) : _fd(fd) {}
+
+Response::BodyFile::~BodyFile() {
+    if (_fd != -1) {
+        close(_fd);
+    }
+}
+
+int Response::BodyFile::getFd() const {
+    return _fd;
+}
+
+Response::Response() : _status(200), _headers(), _body(), _bodyFile(),
+_segments(), _segmentIndex(0), _segmentSent(0),
+_streamVersion(), _streamMode(STREAM_NONE), _streamFinished(false),
+_streamBuffer(), _streamSent(0), _streamedBodySize(0), _streamLimit(0),
+_hasHeadLength(false), _headLength(0), _wholeResponseStr(), _wholeResponsePtr(NULL), _lengthSent(0),
 _errorPageNewStatus(-1), _errorPageOverwrite(false) {
 }
 Response::Response(const Response& other)
 : _status(other._status), _headers(other._headers), _body(other._body),
-_wholeResponseStr(other._wholeResponseStr), _wholeResponsePtr(other._wholeResponsePtr),
+_bodyFile(other._bodyFile), _segments(other._segments),
+_segmentIndex(other._segmentIndex), _segmentSent(other._segmentSent),
+_streamVersion(other._streamVersion), _streamMode(other._streamMode),
+_streamFinished(other._streamFinished), _streamBuffer(other._streamBuffer),
+_streamSent(other._streamSent), _streamedBodySize(other._streamedBodySize),
+_streamLimit(other._streamLimit),
+_hasHeadLength(other._hasHeadLength), _headLength(other._headLength),
+_wholeResponseStr(other._wholeResponseStr), _wholeResponsePtr(NULL),
 _lengthSent(other._lengthSent), _errorPageNewStatus(other._errorPageNewStatus),
 _errorPageOverwrite(other._errorPageOverwrite) {
+    if (other._wholeResponsePtr != NULL) {
+        _wholeResponsePtr = _wholeResponseStr.c_str();
+    }
 }
 Response& Response::operator=(const Response& other) {
     if (this != &other) {
         _status = other._status;
         _headers = other._headers;
         _body = other._body;
+        _bodyFile = other._bodyFile;
+        _segments = other._segments;
+        _segmentIndex = other._segmentIndex;
+        _segmentSent = other._segmentSent;
+        _streamVersion = other._streamVersion;
+        _streamMode = other._streamMode;
+        _streamFinished = other._streamFinished;
+        _streamBuffer = other._streamBuffer;
+        _streamSent = other._streamSent;
+        _streamedBodySize = other._streamedBodySize;
+        _streamLimit = other._streamLimit;
+        _hasHeadLength = other._hasHeadLength;
+        _headLength = other._headLength;
         _wholeResponseStr = other._wholeResponseStr;
-        _wholeResponsePtr = other._wholeResponsePtr;
+        _wholeResponsePtr = other._wholeResponsePtr == NULL
+            ? NULL : _wholeResponseStr.c_str();
         _lengthSent = other._lengthSent;
         _errorPageNewStatus = other._errorPageNewStatus;
         _errorPageOverwrite = other._errorPageOverwrite;
@@ -65,40 +109,261 @@ const std::vector<FieldContent>& values, ResponseFlag enabled) {
     _headers[name] = std::make_pair(enabled, oss.str());
 }
 
+void Response::setHeadLength(std::size_t length) {
+    _hasHeadLength = true;
+    _headLength = length;
+}
+
 void Response::setBody(const std::string& body) {
     _body = body;
+    _bodyFile.reset();
+    _segments.clear();
+    resetStream();
+}
+
+void Response::setBodyFile(int fd) {
+    _body.clear();
+    _segments.clear();
+    resetStream();
+    _bodyFile.reset(new BodyFile(fd));
+}
+
+void Response::addBodyData(const std::string& data) {
+    if (data.empty()) {
+        return;
+    }
+    BodySegment segment;
+    segment.data = data;
+    segment.offset = 0;
+    segment.length = data.size();
+    segment.isFile = false;
+    _segments.push_back(segment);
+}
+
+void Response::addBodyFileRange(off_t offset, std::size_t length) {
+    if (!_bodyFile || length == 0) {
+        return;
+    }
+    BodySegment segment;
+    segment.offset = offset;
+    segment.length = length;
+    segment.isFile = true;
+    _segments.push_back(segment);
+}
+
+void Response::copyBodyFrom(const Response& other) {
+    _body = other._body;
+    _bodyFile = other._bodyFile;
+    _segments = other._segments;
+    resetStream();
+}
+
+void Response::allowStreaming(const std::string& httpVersion) {
+    _streamVersion = httpVersion;
+}
+
+bool Response::canStream() const {
+    return !_streamVersion.empty();
+}
+
+void Response::beginStream() {
+    _body.clear();
+    _bodyFile.reset();
+    _segments.clear();
+    resetStream();
+    if (_streamVersion.empty()) {
+        return;
+    }
+    std::string contentLength = getHeader(fields::CONTENT_LENGTH);
+    if (!contentLength.empty()) {
+        _streamMode = STREAM_FIXED_LENGTH;
+        _streamLimit = std::strtoul(contentLength.c_str(), NULL, 10);
+    } else if (_streamVersion == "HTTP/1.0") {
+        _streamMode = STREAM_CLOSE_DELIMITED;
+    } else {
+        _streamMode = STREAM_CHUNKED;
+    }
+}
+
+void Response::pushChunk(const std::string& data) {
+    if (data.empty() || _streamFinished) {
+        return;
+    }
+    if (_streamMode == STREAM_NONE) {
+        _body += data;
+        return;
+    }
+    if (_streamSent > 0 && _streamSent >= _streamBuffer.size() / 2) {
+        _streamBuffer.erase(0, _streamSent);
+        _streamSent = 0;
+    }
+    std::size_t appended = data.size();
+    if (_streamMode == STREAM_CHUNKED) {
+        std::ostringstream size;
+        size << std::hex << data.size();
+        _streamBuffer += size.str() + symbols::CRLF + data + symbols::CRLF;
+    } else if (_streamMode == STREAM_FIXED_LENGTH) {
+        // Never send more than the length that was announced.
+        if (_streamedBodySize >= _streamLimit) {
+            return;
+        }
+        appended = std::min(appended, _streamLimit - _streamedBodySize);
+        _streamBuffer.append(data, 0, appended);
+    } else {
+        _streamBuffer += data;
+    }
+    _streamedBodySize += appended;
+}
+
+void Response::finishStream() {
+    if (_streamMode == STREAM_CHUNKED && !_streamFinished) {
+        _streamBuffer += symbols::CHUNK_END;
+    }
+    _streamFinished = true;
+}
+
+bool Response::isStreaming() const {
+    return _streamMode != STREAM_NONE;
+}
+
+bool Response::isStreamFinished() const {
+    return _streamFinished;
+}
+
+std::size_t Response::getPendingSize() const {
+    std::size_t pending = _streamBuffer.size() - _streamSent;
+    if (_wholeResponsePtr != NULL) {
+        pending += _wholeResponseStr.size() - _lengthSent;
+    }
+    return pending;
+}
+
+// - The header is only built on the first send, so a response that has not
+//   started yet also counts as pending.
+bool Response::hasPendingOutput() const {
+    return _wholeResponsePtr == NULL || getPendingSize() > 0;
+}
+
+std::size_t Response::getStreamRemaining() const {
+    if (_streamMode != STREAM_FIXED_LENGTH || _streamFinished
+        || _streamedBodySize >= _streamLimit) {
+        return 0;
+    }
+    return _streamLimit - _streamedBodySize;
+}
+
+void Response::addRelayedBody(std::size_t bytes) {
+    _streamedBodySize += bytes;
+}
+
+void Response::resetStream() {
+    _streamMode = STREAM_NONE;
+    _streamFinished = false;
+    _streamBuffer.clear();
+    _streamSent = 0;
+    _streamedBodySize = 0;
+    _streamLimit = 0;
 }
 
 bool Response::sendResponse(int client_fd) {
     if (_wholeResponsePtr == NULL) {
-        _wholeResponseStr = buildResponse();
+        _wholeResponseStr = isStreaming() ? buildHeader() : buildResponse();
         _wholeResponsePtr = _wholeResponseStr.c_str();
     }
-    if (_lengthSent >= static_cast<ssize_t>(_wholeResponseStr.size())) {
-        return true;
+    if (_lengthSent < static_cast<ssize_t>(_wholeResponseStr.size())) {
+        ssize_t remaining = _wholeResponseStr.size() - _lengthSent;
+        ssize_t sent = send(client_fd, _wholeResponsePtr + _lengthSent,
+            std::min(remaining, static_cast<ssize_t>(core::IO_BUFFER_SIZE)), 0);
+        if (sent <= 0) {
+            std::ostringstream oss;
+            oss << "Failed to send response:\n";
+            oss << "  Sent: " << _lengthSent << "\n";
+            oss << "  Total: " << _wholeResponseStr.size() << "\n";
+            oss << "  Error: " << (sent == -1 ? "send() failed" : "Connection closed");
+            throw std::runtime_error(oss.str());
+        }
+        Metrics::bytesSent(sent);
+        _lengthSent += sent;
+    } else if (isStreaming()) {
+        sendStreamBuffer(client_fd);
+    } else if (_segmentIndex < _segments.size()) {
+        sendBodySegment(client_fd);
     }
-    ssize_t remaining = _wholeResponseStr.size() - _lengthSent;
-    ssize_t sent = send(client_fd, _wholeResponsePtr + _lengthSent,
-        std::min(remaining, static_cast<ssize_t>(core::IO_BUFFER_SIZE)), 0);
-    if (sent <= 0) {
-        std::ostringstream oss;
-        oss << "Failed to send response:\n";
-        oss << "  Sent: " << _lengthSent << "\n";
-        oss << "  Total: " << _wholeResponseStr.size() << "\n";
-        oss << "  Error: " << (sent == -1 ? "send() failed" : "Connection closed");
-        throw std::runtime_error(oss.str());
+    if (isStreaming() && (!_streamFinished || _streamSent < _streamBuffer.size())) {
+        return false;
     }
-    _lengthSent += sent;
-    if (_lengthSent >= static_cast<ssize_t>(_wholeResponseStr.size())) {
+    if (_lengthSent >= static_cast<ssize_t>(_wholeResponseStr.size()) &&
+        _segmentIndex >= _segments.size()) {
         _wholeResponseStr.clear();
         _wholeResponsePtr = NULL;
         _lengthSent = 0;
+        _segmentIndex = 0;
+        _segmentSent = 0;
         return true;
     }
     return false;
 }
 
+// - Sends at most one chunk of the current segment per call, like the
+//   header/in-memory path above, so one client cannot monopolize the loop.
+bool Response::sendBodySegment(int client_fd) {
+    const BodySegment& segment = _segments[_segmentIndex];
+    std::size_t remaining = segment.length - _segmentSent;
+    ssize_t sent;
+    if (segment.isFile) {
+        off_t offset = segment.offset + _segmentSent;
+        sent = sendfile(client_fd, _bodyFile->getFd(), &offset,
+            std::min(remaining, core::SENDFILE_CHUNK_SIZE));
+    } else {
+        sent = send(client_fd, segment.data.c_str() + _segmentSent,
+            std::min(remaining, core::IO_BUFFER_SIZE), 0);
+    }
+    if (sent <= 0) {
+        std::ostringstream oss;
+        oss << "Failed to send response body:\n";
+        oss << "  Segment: " << _segmentIndex << "/" << _segments.size() << "\n";
+        oss << "  Sent: " << _segmentSent << "/" << segment.length << "\n";
+        oss << "  Error: " << (sent == -1
+            ? (segment.isFile ? "sendfile() failed" : "send() failed")
+            : "Unexpected end of data");
+        throw std::runtime_error(oss.str());
+    }
+    Metrics::bytesSent(sent);
+    _segmentSent += sent;
+    if (_segmentSent >= segment.length) {
+        ++_segmentIndex;
+        _segmentSent = 0;
+    }
+    return _segmentIndex >= _segments.size();
+}
+
+void Response::sendStreamBuffer(int client_fd) {
+    if (_streamSent >= _streamBuffer.size()) {
+        return;
+    }
+    std::size_t remaining = _streamBuffer.size() - _streamSent;
+    ssize_t sent = send(client_fd, _streamBuffer.data() + _streamSent,
+        std::min(remaining, core::IO_BUFFER_SIZE), 0);
+    if (sent <= 0) {
+        std::ostringstream oss;
+        oss << "Failed to send streamed response:\n";
+        oss << "  Pending: " << remaining << "\n";
+        oss << "  Error: " << (sent == -1 ? "send() failed" : "Connection closed");
+        throw std::runtime_error(oss.str());
+    }
+    Metrics::bytesSent(sent);
+    _streamSent += sent;
+    if (_streamSent >= _streamBuffer.size()) {
+        _streamBuffer.clear();
+        _streamSent = 0;
+    }
+}
+
 std::string Response::buildResponse() const {
+    return buildHeader() + _body;
+}
+
+std::string Response::buildHeader() const {
     std::ostringstream oss;
     oss << "HTTP/1.1 " << _status;
     if (getStatusMessage(_status) != "Unknown Status") {
@@ -120,6 +385,11 @@ std::string Response::buildResponse() const {
             header->first == "Content-Length") {
             continue;
         }
+        // Framing of a streamed body is decided here, not by the handler.
+        if (isStreaming() && (header->first == "Transfer-Encoding" ||
+            header->first == "Connection")) {
+            continue;
+        }
         if (header->second.first) {
             oss << header->first << ": " << header->second.second << "\r\n";
         }
@@ -127,12 +397,18 @@ std::string Response::buildResponse() const {
 
     const int noContentStatus = 204;
     const int notModifiedStatus = 304;
-    if (_status != noContentStatus && _status != notModifiedStatus &&
+    if (_streamMode == STREAM_CHUNKED) {
+        oss << "Transfer-Encoding: chunked\r\n";
+    } else if (_streamMode == STREAM_CLOSE_DELIMITED) {
+        oss << "Connection: close\r\n";
+    } else if (_streamMode == STREAM_FIXED_LENGTH) {
+        oss << "Content-Length: " << _streamLimit << "\r\n";
+    } else if (_status != noContentStatus && _status != notModifiedStatus &&
         _headers.count("Transfer-Encoding") == 0) {
-        oss << "Content-Length: " << _body.size() << "\r\n";
+        oss << "Content-Length: "
+            << (_hasHeadLength ? _headLength : getContentLength()) << "\r\n";
     }
     oss << "\r\n";
-    oss << _body;
 
     return oss.str();
 }
@@ -203,7 +479,14 @@ std::string Response::getHeader(const FieldName& name) const {
 }
 
 std::size_t Response::getContentLength() const {
-    return _body.size();
+    if (isStreaming()) {
+        return _streamedBodySize;
+    }
+    std::size_t length = _body.size();
+    for (std::size_t i = 0; i < _segments.size(); ++i) {
+        length += _segments[i].length;
+    }
+    return length;
 }
 
 const std::string& Response::getBody() const {
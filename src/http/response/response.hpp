@@ -3,6 +3,7 @@
 #pragma once
 
 #include <sys/socket.h>
+#include <sys/types.h>
 
 #include <string>
 #include <map>
@@ -11,6 +12,7 @@
 #include <utility>
 
 #include "../../../toolbox/stepmark.hpp"
+#include "../../../toolbox/shared.hpp"
 
 namespace http {
 
@@ -34,6 +36,53 @@ class Response {
 
     void setBody(const std::string& body);
 
+    /**
+     * @brief Serve the body (or parts of it) straight from an open file.
+     *
+     * The response takes ownership of fd. Segments added afterwards are
+     * sent in order: in-memory parts with send(2), file ranges with
+     * sendfile(2), so ranges never have to be copied into memory.
+     */
+    void setBodyFile(int fd);
+    void addBodyData(const std::string& data);
+    void addBodyFileRange(off_t offset, std::size_t length);
+    void copyBodyFrom(const Response& other);
+
+    /**
+     * @brief Answer a HEAD request: Content-Length announces length bytes,
+     * but no body is sent.
+     */
+    void setHeadLength(std::size_t length);
+
+    /**
+     * @brief Streaming body API: beginStream(), pushChunk()..., finishStream().
+     *
+     * Headers are committed by beginStream(); data pushed afterwards is sent
+     * as soon as the socket allows it. The framing is chosen by the server:
+     * passthrough when the handler set Content-Length, chunked for HTTP/1.1,
+     * close-delimited for HTTP/1.0. Until allowStreaming() is called (e.g.
+     * for internal subrequests) the pushed data is buffered into the body.
+     */
+    void allowStreaming(const std::string& httpVersion);
+    bool canStream() const;
+    void beginStream();
+    void pushChunk(const std::string& data);
+    void finishStream();
+    bool isStreaming() const;
+    bool isStreamFinished() const;
+    std::size_t getPendingSize() const;
+    bool hasPendingOutput() const;
+
+    /**
+     * @brief Body bytes a Content-Length stream still expects (0 for the
+     * other framings).
+     *
+     * A caller that sends body bytes to the socket itself, once nothing is
+     * pending, reports them with addRelayedBody() so the length stays right.
+     */
+    std::size_t getStreamRemaining() const;
+    void addRelayedBody(std::size_t bytes);
+
     bool sendResponse(int client_fd);
     static std::string getStatusMessage(int code);
 
@@ -50,9 +99,49 @@ class Response {
     void setErrorPage(bool overwrite, int newStatus);
 
  private:
+    enum StreamMode {
+        STREAM_NONE,
+        STREAM_CHUNKED,
+        STREAM_CLOSE_DELIMITED,
+        STREAM_FIXED_LENGTH
+    };
+
+    struct BodySegment {
+        std::string data;
+        off_t offset;
+        std::size_t length;
+        bool isFile;
+    };
+
+    class BodyFile {
+     public:
+        explicit BodyFile(int fd);
+        ~BodyFile();
+        int getFd() const;
+
+     private:
+        int _fd;
+
+        BodyFile(const BodyFile& other);
+        BodyFile& operator=(const BodyFile& other);
+    };
+
     int _status;
     std::map<FieldName, HeaderField> _headers;
     std::string _body;
+    toolbox::SharedPtr<BodyFile> _bodyFile;
+    std::vector<BodySegment> _segments;
+    std::size_t _segmentIndex;
+    std::size_t _segmentSent;
+    std::string _streamVersion;
+    StreamMode _streamMode;
+    bool _streamFinished;
+    std::string _streamBuffer;
+    std::size_t _streamSent;
+    std::size_t _streamedBodySize;
+    std::size_t _streamLimit;
+    bool _hasHeadLength;
+    std::size_t _headLength;
     std::string _wholeResponseStr;
     const char* _wholeResponsePtr;
     ssize_t _lengthSent;
@@ -60,7 +149,11 @@ class Response {
     int _errorPageNewStatus;
     bool _errorPageOverwrite;
 
+    std::string buildHeader() const;
     std::string buildResponse() const;
+    bool sendBodySegment(int client_fd);
+    void sendStreamBuffer(int client_fd);
+    void resetStream();
 };
 
 }  // namespace http
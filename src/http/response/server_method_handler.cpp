@@ -22,7 +22,7 @@ void serverMethodHandler(RequestParser& parsedRequest,
     bool isAutoindex = config.getAutoindex();
 
     if (method == method::GET) {
-        runGet(fullPath, indices, isAutoindex, response);
+        runGet(fullPath, indices, isAutoindex, fields, response);
     } else if (method == method::HEAD) {
         runHead(fullPath, indices, isAutoindex, response);
     } else if (method == method::DELETE) {
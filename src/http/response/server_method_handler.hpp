@@ -28,7 +28,7 @@ void serverMethodHandler(RequestParser& parsedRequest,
                          Response& response);
 
 void runGet(const std::string& targetPath, std::vector<std::string>& indices,
-    bool isAutoindex, Response& response);
+    bool isAutoindex, const HTTPFields& requestFields, Response& response);
 void runHead(const std::string& targetPath, std::vector<std::string>& indices,
     bool isAutoindex, Response& response);
 void runDelete(const std::string& path, Response& response);
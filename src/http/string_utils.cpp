@@ -104,5 +104,17 @@ bool percentDecode(std::string& str, std::string* buf) {
     return true;
 }
 
+// The field parser splits values on ", ", which also cuts HTTP-dates apart.
+std::string joinFieldValues(const std::vector<std::string>& values) {
+    std::string joined;
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        if (i > 0) {
+            joined += symbols::COMMASP;
+        }
+        joined += values[i];
+    }
+    return joined;
+}
+
 }  // namespace utils
 }  // namespace http
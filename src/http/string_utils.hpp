@@ -3,6 +3,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include <cctype>
 #include <cstdlib>
 
@@ -23,6 +24,7 @@ void skipSpace(std::string* line);
 bool isEqualCaseInsensitive(
 const std::string& str1, const std::string& str2);
 bool percentDecode(std::string& str, std::string* buf);
+std::string joinFieldValues(const std::vector<std::string>& values);
 
 }  // namespace utils
 }  // namespace http
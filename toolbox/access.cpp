@@ -9,44 +9,52 @@ The class is designed to be simple and lightweight,
 allowing for easy logging without the overhead of exception handling.
 The class uses a singleton pattern to ensure that only one instance of the logger exists.
 The class is not thread-safe, so it should not be used in a multi-threaded environment.
+Each access_log file has its own LogWriter, so lines reach it in batches.
 */
 
 #include "access.hpp"
+#include "stepmark.hpp"
+#include "string.hpp"
 
-#include <iostream>
 #include <ctime>
-#include <iomanip>
-#include <sstream>
-#include <stdexcept>
+#include <map>
 #include <string>
 
-// namespace {
-//     const std::size_t IO_BUFFER_SIZE = 16 * 1024; // 16 KB
-// }
+namespace {
+const std::size_t DEFAULT_CAPACITY = 64 * 1024;
+const time_t DEFAULT_FLUSH_INTERVAL = 1;
+}  // namespace
 
 namespace toolbox {
 
-/*
- * @brief AccessLog constructor.
- * @note The reason for not opening the log file in the constructor is to allow
- *       the user to set the log file name before opening it.
- */
-logger::AccessLog::AccessLog() : _logFileName("access.log") {
+logger::AccessLog::AccessLog()
+    : _capacity(DEFAULT_CAPACITY), _flushInterval(DEFAULT_FLUSH_INTERVAL),
+      _overflow(LogWriter::DROP) {
 }
 
 logger::AccessLog::~AccessLog() {
-    if (_logFile.is_open()) {
-        _logFile.close();
-    }
 }
 
-void logger::AccessLog::setLogFile(const std::string& file) {
+void logger::AccessLog::setBuffering(std::size_t capacity, time_t flushInterval,
+                                     LogWriter::Overflow overflow) {
+    logger::AccessLog& instance = getInstance();
+    instance._capacity = capacity;
+    instance._flushInterval = flushInterval;
+    instance._overflow = overflow;
+}
+
+void logger::AccessLog::flush() {
     logger::AccessLog& instance = getInstance();
-    if (instance._logFile.is_open()) {
-        instance._logFile.close();
+    std::size_t dropped = 0;
+    for (std::map<std::string, SharedPtr<LogWriter> >::iterator it =
+            instance._writers.begin(); it != instance._writers.end(); ++it) {
+        it->second->flushIfDue();
+        dropped += it->second->takeDropped();
+    }
+    if (dropped > 0) {
+        StepMark::warning("AccessLog: " + toolbox::to_string(dropped)
+                          + " lines dropped, the log file could not keep up");
     }
-    instance._logFileName = file;
-    instance.openLogFile();
 }
 
 logger::AccessLog& logger::AccessLog::getInstance() {
@@ -54,67 +62,45 @@ logger::AccessLog& logger::AccessLog::getInstance() {
     return instance;
 }
 
-/*
- * @brief Logs an access request to the log file.
- * @param remote_addr The remote address of the client.
- * @param remote_user The remote user (if any).
- * @param request The HTTP request line.
- * @param status The HTTP status code.
- * @param body_bytes_sent The size of the response body in bytes.
- * @param http_referer The HTTP referer header.
- * @param http_user_agent The HTTP user agent header.
- * @note This function will create the log file if it does not exist.
- */
-void logger::AccessLog::log(
-    const std::string& remote_addr,
-    const std::string& remote_user,
-    const std::string& request,
-    int status,
-    int body_bytes_sent,
-    const std::string& http_referer,
-    const std::string& http_user_agent
-) {
+void logger::AccessLog::log(const std::string& path, const LogFormat& format,
+                            const LogRecord& record, std::size_t capacity,
+                            time_t flushInterval) {
     logger::AccessLog& instance = getInstance();
-    if (!instance._logFile.is_open()) {
-        instance.openLogFile();
-    }
-    if (instance._logFile.is_open()) {
-        instance._logFile << remote_addr << " "
-                << "- "
-                << remote_user << " "
-                << "[" << instance.getTimeStamp() << "] "
-                << "\"" << request << "\" "
-                << status << " "
-                << body_bytes_sent << " "
-                << "\"" << http_referer << "\" "
-                << "\"" << http_user_agent << "\""
-                << std::endl;
-    } else {
-        std::cerr << "Error: Log file is not open." << std::endl;
+    LogWriter& writer = instance.getWriter(path, capacity, flushInterval);
+    if (!writer.isOpen()) {
+        return;
     }
+    instance._line.clear();
+    format.format(record, &instance._line);
+    instance._line += '\n';
+    writer.append(instance._line);
 }
 
-std::string logger::AccessLog::getTimeStamp() {
-    std::time_t now = std::time(NULL);
-    std::tm* localTime = std::localtime(&now);
-    char buffer[100];
-    std::strftime(buffer, sizeof(buffer), "%d/%b/%Y:%H:%M:%S %z", localTime);
-    return std::string(buffer);
+void logger::AccessLog::reopen() {
+    getInstance()._writers.clear();
 }
 
-void logger::AccessLog::openLogFile() {
-    _logFile.open(_logFileName.c_str(), std::ios::app);
-    if (!_logFile.is_open()) {
-        std::cerr << "Error opening log file: " << _logFileName
-                << ". Defaulting to access.log." << std::endl;
-        _logFileName = "access.log";
-        _logFile.open(_logFileName.c_str(), std::ios::app);
+// - A file that cannot be opened is reported once and kept closed, so its
+//   lines are skipped until the next reopen().
+logger::LogWriter& logger::AccessLog::getWriter(const std::string& path,
+                                                std::size_t capacity,
+                                                time_t flushInterval) {
+    std::map<std::string, SharedPtr<LogWriter> >::iterator it =
+        _writers.find(path);
+    if (it != _writers.end()) {
+        return *it->second;
+    }
+    SharedPtr<LogWriter> writer(new LogWriter());
+    if (capacity > 0) {
+        writer->configure(capacity, flushInterval, _overflow);
+    } else {
+        writer->configure(_capacity, _flushInterval, _overflow);
     }
-    if (_logFile.is_open()) {
-        _logFile << "[" << getTimeStamp() << "] "
-                << "Log file opened: " << _logFileName
-                << std::endl;
+    if (!writer->open(path)) {
+        StepMark::error("AccessLog: cannot open " + path);
     }
+    _writers[path] = writer;
+    return *writer;
 }
 
 }  // namespace toolbox
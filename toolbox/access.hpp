@@ -2,8 +2,13 @@
 
 #pragma once
 
+#include <ctime>
+#include <map>
 #include <string>
-#include <fstream>
+
+#include "log_format.hpp"
+#include "log_writer.hpp"
+#include "shared.hpp"
 
 namespace toolbox {
 
@@ -11,28 +16,46 @@ namespace logger {
 
 class AccessLog {
  public:
-    static void setLogFile(const std::string& file);
-    static void log(
-        const std::string& remote_addr,
-        const std::string& remote_user,
-        const std::string& request,
-        int status,
-        int body_bytes_sent,
-        const std::string& http_referer,
-        const std::string& http_user_agent);
+    /**
+     * @brief The buffering of the logs without their own, from log_buffer.
+     * @note Applies to the files opened afterwards; see reopen().
+     */
+    static void setBuffering(std::size_t capacity, time_t flushInterval,
+                             LogWriter::Overflow overflow);
+    // Writes out the buffered lines once the flush interval has passed.
+    static void flush();
+
+    /**
+     * @brief Format one line into a reused buffer and queue it for path.
+     * @param capacity The log's own buffer size, or 0 for the log_buffer one.
+     * @param flushInterval The log's own flush interval, if capacity is set.
+     * @note The file is opened, or created, on its first line.
+     */
+    static void log(const std::string& path, const LogFormat& format,
+                    const LogRecord& record, std::size_t capacity,
+                    time_t flushInterval);
+
+    /**
+     * @brief Write out and close every file; each is opened again by its
+     * next line, so a rotated file is replaced by a new one.
+     */
+    static void reopen();
 
  private:
-    std::string _logFileName;
-    std::ofstream _logFile;
+    std::map<std::string, SharedPtr<LogWriter> > _writers;  // by path
+    std::string _line;
+    std::size_t _capacity;
+    time_t _flushInterval;
+    LogWriter::Overflow _overflow;
 
     static AccessLog& getInstance();
-    void openLogFile();
+    LogWriter& getWriter(const std::string& path, std::size_t capacity,
+                         time_t flushInterval);
 
     AccessLog();
     ~AccessLog();
     AccessLog(const AccessLog&);  // Not implemented
     AccessLog& operator=(const AccessLog&);  // Not implemented
-    std::string getTimeStamp();
 };
 
 }  // namespace logger
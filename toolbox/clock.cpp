@@ -0,0 +1,16 @@
+// Copyright 2025 Ideal Broccoli
+
+#include "clock.hpp"
+
+#include <time.h>
+
+namespace toolbox {
+
+double getMonotonicSeconds() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<double>(now.tv_sec)
+        + static_cast<double>(now.tv_nsec) / 1e9;
+}
+
+}  // namespace toolbox
@@ -0,0 +1,15 @@
+// Copyright 2025 Ideal Broccoli
+
+#pragma once
+
+namespace toolbox {
+
+/**
+ * @brief Seconds on the monotonic clock, for measuring durations.
+ *
+ * Unaffected by changes to the system time; only differences between two
+ * readings mean anything.
+ */
+double getMonotonicSeconds();
+
+}  // namespace toolbox
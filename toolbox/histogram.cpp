@@ -0,0 +1,70 @@
+// Copyright 2025 Ideal Broccoli
+
+#include "histogram.hpp"
+
+#include <stdint.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace toolbox {
+
+Histogram::Histogram(const double* bounds, std::size_t count)
+    : _bounds(bounds, bounds + count), _counts(count + 1, 0),
+      _sum(0), _count(0) {
+}
+
+Histogram::Histogram(const Histogram& other)
+    : _bounds(other._bounds), _counts(other._counts),
+      _sum(other._sum), _count(other._count) {
+}
+
+Histogram& Histogram::operator=(const Histogram& other) {
+    if (this != &other) {
+        _bounds = other._bounds;
+        _counts = other._counts;
+        _sum = other._sum;
+        _count = other._count;
+    }
+    return *this;
+}
+
+Histogram::~Histogram() {
+}
+
+void Histogram::observe(double value) {
+    std::size_t i = 0;
+    while (i < _bounds.size() && value > _bounds[i]) {
+        ++i;
+    }
+    ++_counts[i];
+    _sum += value;
+    ++_count;
+}
+
+// - Buckets are stored individually and summed here, since the exposition
+//   format wants each to include the ones below it.
+std::string Histogram::render(const std::string& name,
+                              const std::string& labels) const {
+    std::string prefix = labels.empty() ? "" : labels + ",";
+    std::string suffix = labels.empty() ? "" : "{" + labels + "}";
+    std::ostringstream out;
+    out.precision(9);
+    uint64_t cumulative = 0;
+    for (std::size_t i = 0; i < _counts.size(); ++i) {
+        cumulative += _counts[i];
+        out << name << "_bucket{" << prefix << "le=\"";
+        if (i < _bounds.size()) {
+            out << _bounds[i];
+        } else {
+            out << "+Inf";
+        }
+        out << "\"} " << cumulative << "\n";
+    }
+    out << name << "_sum" << suffix << " " << _sum << "\n";
+    out << name << "_count" << suffix << " " << _count << "\n";
+    return out.str();
+}
+
+}  // namespace toolbox
@@ -0,0 +1,52 @@
+// Copyright 2025 Ideal Broccoli
+
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+namespace toolbox {
+
+/**
+ * @brief Counts observations into fixed buckets, as a Prometheus histogram.
+ *
+ * Each bucket counts the observations up to its upper bound, and a last
+ * bucket with no bound catches the rest. render() writes the cumulative
+ * "_bucket", "_sum" and "_count" series in the text exposition format.
+ *
+ * Usage example:
+ * @code
+ * const double BOUNDS[] = {0.001, 0.01, 0.1, 1};
+ * Histogram latency(BOUNDS, sizeof(BOUNDS) / sizeof(BOUNDS[0]));
+ * latency.observe(0.004);
+ * std::string text = latency.render("webserv_latency_seconds", "");
+ * @endcode
+ */
+class Histogram {
+ public:
+    Histogram(const double* bounds, std::size_t count);
+    Histogram(const Histogram& other);
+    Histogram& operator=(const Histogram& other);
+    ~Histogram();
+
+    void observe(double value);
+
+    /**
+     * @brief The series of the histogram, without HELP and TYPE lines.
+     * @param labels Added to every series, e.g. "phase=\"read\"", or empty.
+     */
+    std::string render(const std::string& name,
+                       const std::string& labels) const;
+
+ private:
+    Histogram();
+
+    std::vector<double> _bounds;
+    std::vector<uint64_t> _counts;    // one more than _bounds: +Inf
+    double _sum;
+    uint64_t _count;
+};
+
+}  // namespace toolbox
@@ -0,0 +1,192 @@
+// Copyright 2025 Ideal Broccoli
+
+#include "log_format.hpp"
+
+#include <stdint.h>
+
+#include <cctype>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+
+namespace {
+struct VariableName {
+    const char* name;
+    toolbox::logger::LogFormat::Variable variable;
+};
+
+const VariableName VARIABLES[] = {
+    {"body_bytes_sent", toolbox::logger::LogFormat::BODY_BYTES_SENT},
+    {"first_byte_time", toolbox::logger::LogFormat::FIRST_BYTE_TIME},
+    {"remote_addr", toolbox::logger::LogFormat::REMOTE_ADDR},
+    {"remote_user", toolbox::logger::LogFormat::REMOTE_USER},
+    {"request", toolbox::logger::LogFormat::REQUEST},
+    {"request_method", toolbox::logger::LogFormat::REQUEST_METHOD},
+    {"request_time", toolbox::logger::LogFormat::REQUEST_TIME},
+    {"request_uri", toolbox::logger::LogFormat::REQUEST_URI},
+    {"status", toolbox::logger::LogFormat::STATUS},
+    {"time_local", toolbox::logger::LogFormat::TIME_LOCAL},
+    {"upstream_response_time",
+     toolbox::logger::LogFormat::UPSTREAM_RESPONSE_TIME}
+};
+const std::size_t VARIABLE_COUNT = sizeof(VARIABLES) / sizeof(VARIABLES[0]);
+const char* HEADER_PREFIX = "http_";
+const char* HEX_DIGITS = "0123456789ABCDEF";
+
+bool isNameChar(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+}  // namespace
+
+namespace toolbox {
+
+namespace logger {
+
+LogFormat::LogFormat() {
+}
+
+LogFormat::LogFormat(const LogFormat& other)
+    : _text(other._text), _segments(other._segments) {
+}
+
+LogFormat& LogFormat::operator=(const LogFormat& other) {
+    if (this != &other) {
+        _text = other._text;
+        _segments = other._segments;
+    }
+    return *this;
+}
+
+LogFormat::~LogFormat() {
+}
+
+// - An empty unknown name means a '$' that starts no name at all.
+bool LogFormat::compile(const std::string& text, std::string* unknown) {
+    std::vector<Segment> segments;
+    Segment literal;
+    literal.variable = LITERAL;
+    std::size_t pos = 0;
+    while (pos < text.size()) {
+        if (text[pos] != '$') {
+            literal.text += text[pos++];
+            continue;
+        }
+        bool isBraced = pos + 1 < text.size() && text[pos + 1] == '{';
+        std::size_t start = pos + (isBraced ? 2 : 1);
+        std::size_t end = start;
+        while (end < text.size() && isNameChar(text[end])) {
+            ++end;
+        }
+        if (isBraced && (end >= text.size() || text[end] != '}')) {
+            end = start;
+        }
+        std::string name = text.substr(start, end - start);
+        Segment segment;
+        segment.variable = LITERAL;
+        for (std::size_t i = 0; i < VARIABLE_COUNT; ++i) {
+            if (name == VARIABLES[i].name) {
+                segment.variable = VARIABLES[i].variable;
+            }
+        }
+        if (segment.variable == LITERAL && name.size() > std::strlen(HEADER_PREFIX)
+                && name.compare(0, std::strlen(HEADER_PREFIX), HEADER_PREFIX) == 0) {
+            segment.variable = HTTP_FIELD;
+            segment.text = name.substr(std::strlen(HEADER_PREFIX));
+            for (std::size_t i = 0; i < segment.text.size(); ++i) {
+                if (segment.text[i] == '_') {
+                    segment.text[i] = '-';
+                }
+            }
+        }
+        if (segment.variable == LITERAL) {
+            *unknown = name;
+            return false;
+        }
+        if (!literal.text.empty()) {
+            segments.push_back(literal);
+            literal.text.clear();
+        }
+        segments.push_back(segment);
+        pos = end + (isBraced ? 1 : 0);
+    }
+    if (!literal.text.empty()) {
+        segments.push_back(literal);
+    }
+    _text = text;
+    _segments = segments;
+    return true;
+}
+
+void LogFormat::format(const LogRecord& record, std::string* line) const {
+    for (std::size_t i = 0; i < _segments.size(); ++i) {
+        const Segment& segment = _segments[i];
+        if (segment.variable == LITERAL) {
+            *line += segment.text;
+        } else if (segment.variable == TIME_LOCAL) {
+            appendTimeLocal(line);
+        } else {
+            record.append(segment.variable, segment.text, line);
+        }
+    }
+}
+
+void LogFormat::appendEscaped(const std::string& value, std::string* line) {
+    if (value.empty()) {
+        *line += '-';
+        return;
+    }
+    for (std::size_t i = 0; i < value.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(value[i]);
+        if (c == '"' || c == '\\' || c < 0x20 || c >= 0x7f) {
+            *line += "\\x";
+            *line += HEX_DIGITS[c >> 4];
+            *line += HEX_DIGITS[c & 0x0f];
+        } else {
+            *line += static_cast<char>(c);
+        }
+    }
+}
+
+void LogFormat::appendNumber(std::size_t value, std::string* line) {
+    char digits[24];
+    std::size_t count = 0;
+    do {
+        digits[count++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+    while (count > 0) {
+        *line += digits[--count];
+    }
+}
+
+void LogFormat::appendSeconds(double seconds, std::string* line) {
+    if (seconds < 0) {
+        *line += '-';
+        return;
+    }
+    uint64_t millis = static_cast<uint64_t>(seconds * 1000 + 0.5);
+    appendNumber(static_cast<std::size_t>(millis / 1000), line);
+    *line += '.';
+    *line += static_cast<char>('0' + millis / 100 % 10);
+    *line += static_cast<char>('0' + millis / 10 % 10);
+    *line += static_cast<char>('0' + millis % 10);
+}
+
+// - The text only changes once a second, so it is kept between lines.
+void LogFormat::appendTimeLocal(std::string* line) {
+    static std::time_t cachedAt = -1;
+    static char cached[64];
+    std::time_t now = std::time(NULL);
+    if (now != cachedAt) {
+        std::tm* localTime = std::localtime(&now);
+        std::strftime(cached, sizeof(cached), "%d/%b/%Y:%H:%M:%S %z",
+                      localTime);
+        cachedAt = now;
+    }
+    *line += cached;
+}
+
+}  // namespace logger
+
+}  // namespace toolbox
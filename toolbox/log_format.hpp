@@ -0,0 +1,111 @@
+// Copyright 2025 Ideal Broccoli
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace toolbox {
+
+namespace logger {
+
+class LogRecord;
+
+/**
+ * @brief An access log line template, compiled once from its text.
+ *
+ * The text is split into literal runs and variables, written $name or
+ * ${name}, so that formatting a line only appends: literals are copied
+ * and each variable asks the LogRecord for its value. $http_<name> stands
+ * for the request header <name>, '_' read as '-'.
+ *
+ * Usage example:
+ * @code
+ * LogFormat format;
+ * std::string unknown;
+ * if (!format.compile("$remote_addr \"$request\" $status", &unknown)) {
+ *     // unknown holds the variable name that is not supported
+ * }
+ * std::string line;
+ * format.format(record, &line);
+ * @endcode
+ */
+class LogFormat {
+ public:
+    enum Variable {
+        LITERAL,
+        BODY_BYTES_SENT,
+        FIRST_BYTE_TIME,
+        HTTP_FIELD,
+        REMOTE_ADDR,
+        REMOTE_USER,
+        REQUEST,
+        REQUEST_METHOD,
+        REQUEST_TIME,
+        REQUEST_URI,
+        STATUS,
+        TIME_LOCAL,
+        UPSTREAM_RESPONSE_TIME
+    };
+
+    LogFormat();
+    LogFormat(const LogFormat& other);
+    LogFormat& operator=(const LogFormat& other);
+    ~LogFormat();
+
+    /**
+     * @return false, with the name in unknown, if a variable is not
+     *         supported; the format is left unchanged then.
+     */
+    bool compile(const std::string& text, std::string* unknown);
+    const std::string& getText() const { return _text; }
+
+    /**
+     * @brief Append the line, without its newline.
+     */
+    void format(const LogRecord& record, std::string* line) const;
+
+    /**
+     * @brief Append a value with '"', '\\' and non-printable bytes written
+     * as \\xHH, so that a request cannot forge fields or lines; an empty
+     * value is written as "-".
+     */
+    static void appendEscaped(const std::string& value, std::string* line);
+    static void appendNumber(std::size_t value, std::string* line);
+
+    /**
+     * @brief Append seconds with millisecond resolution, or "-" if negative.
+     */
+    static void appendSeconds(double seconds, std::string* line);
+
+ private:
+    struct Segment {
+        Variable variable;
+        std::string text;   // the literal, or the header name
+    };
+
+    static void appendTimeLocal(std::string* line);
+
+    std::string _text;
+    std::vector<Segment> _segments;
+};
+
+/**
+ * @brief What a LogFormat reads the values of its variables from.
+ */
+class LogRecord {
+ public:
+    virtual ~LogRecord() {}
+
+    /**
+     * @brief Append the value of variable to line.
+     * @param field The header name, for HTTP_FIELD.
+     * @note TIME_LOCAL and LITERAL are handled by the format itself.
+     */
+    virtual void append(LogFormat::Variable variable, const std::string& field,
+                        std::string* line) const = 0;
+};
+
+}  // namespace logger
+
+}  // namespace toolbox
@@ -0,0 +1,156 @@
+// Copyright 2025 Ideal Broccoli
+
+#include "log_writer.hpp"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <ctime>
+#include <string>
+#include <vector>
+
+namespace {
+const std::size_t DEFAULT_CAPACITY = 64 * 1024;
+const time_t DEFAULT_FLUSH_INTERVAL = 1;
+const int WAIT_FOREVER = -1;
+
+// - Only a pipe or a FIFO ever makes a writer wait; a regular file
+//   always reports writable. A reader that went away ends the wait.
+bool waitWritable(int fd) {
+    struct pollfd writable = {fd, POLLOUT, 0};
+    return poll(&writable, 1, WAIT_FOREVER) > 0
+        && (writable.revents & POLLOUT) != 0;
+}
+}  // namespace
+
+namespace toolbox {
+
+logger::LogWriter::LogWriter()
+    : _fd(-1), _ring(DEFAULT_CAPACITY), _head(0), _size(0),
+      _flushInterval(DEFAULT_FLUSH_INTERVAL), _lastFlush(0),
+      _overflow(DROP), _dropped(0) {
+}
+
+logger::LogWriter::~LogWriter() {
+    close();
+}
+
+// - Non-blocking, so that a full pipe shows as a short write instead of
+//   stalling the event loop.
+bool logger::LogWriter::open(const std::string& path) {
+    close();
+    _fd = ::open(path.c_str(),
+                 O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC | O_NONBLOCK, 0644);
+    return _fd != -1;
+}
+
+void logger::LogWriter::close() {
+    if (_fd == -1) {
+        return;
+    }
+    drain();
+    ::close(_fd);
+    _fd = -1;
+}
+
+void logger::LogWriter::configure(std::size_t capacity, time_t flushInterval,
+                                  Overflow overflow) {
+    if (capacity > 0 && capacity != _ring.size()) {
+        drain();
+        _ring.assign(capacity, '\0');
+        _head = 0;
+        _size = 0;
+    }
+    _flushInterval = flushInterval;
+    _overflow = overflow;
+}
+
+void logger::LogWriter::append(const std::string& line) {
+    if (_fd == -1) {
+        return;
+    }
+    if (line.size() > _ring.size() - _size && !flush()) {
+        if (_overflow == BLOCK) {
+            drain();
+        }
+    }
+    if (line.size() > _ring.size() - _size) {
+        ++_dropped;
+        return;
+    }
+    copyIn(line);
+    if (_size >= _ring.size() / 2) {
+        flush();
+    }
+}
+
+void logger::LogWriter::flushIfDue() {
+    if (_fd != -1 && _size > 0
+            && std::time(NULL) - _lastFlush >= _flushInterval) {
+        flush();
+    }
+}
+
+std::size_t logger::LogWriter::takeDropped() {
+    std::size_t dropped = _dropped;
+    _dropped = 0;
+    return dropped;
+}
+
+// - Returns whether the buffer is empty; what the file did not take stays
+//   buffered for the next attempt.
+bool logger::LogWriter::flush() {
+    _lastFlush = std::time(NULL);
+    while (_size > 0) {
+        std::size_t first = std::min(_size, _ring.size() - _head);
+        struct iovec iov[2];
+        iov[0].iov_base = &_ring[_head];
+        iov[0].iov_len = first;
+        iov[1].iov_base = &_ring[0];
+        iov[1].iov_len = _size - first;
+        ssize_t written = writev(_fd, iov, iov[1].iov_len > 0 ? 2 : 1);
+        if (written <= 0) {
+            return false;
+        }
+        discard(static_cast<std::size_t>(written));
+    }
+    return true;
+}
+
+// - Gives up on the buffer once the file fails even though it is
+//   writable, as on a full disk.
+void logger::LogWriter::drain() {
+    while (!flush()) {
+        std::size_t stuck = _size;
+        if (!waitWritable(_fd) || (!flush() && _size == stuck)) {
+            std::size_t first = std::min(_size, _ring.size() - _head);
+            _dropped += std::count(_ring.begin() + _head,
+                                   _ring.begin() + _head + first, '\n');
+            _dropped += std::count(_ring.begin(),
+                                   _ring.begin() + (_size - first), '\n');
+            discard(_size);
+            return;
+        }
+    }
+}
+
+void logger::LogWriter::discard(std::size_t length) {
+    _head = (_head + length) % _ring.size();
+    _size -= length;
+    if (_size == 0) {
+        _head = 0;
+    }
+}
+
+void logger::LogWriter::copyIn(const std::string& line) {
+    std::size_t tail = (_head + _size) % _ring.size();
+    std::size_t first = std::min(line.size(), _ring.size() - tail);
+    std::copy(line.begin(), line.begin() + first, _ring.begin() + tail);
+    std::copy(line.begin() + first, line.end(), _ring.begin());
+    _size += line.size();
+}
+
+}  // namespace toolbox
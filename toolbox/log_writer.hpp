@@ -0,0 +1,90 @@
+// Copyright 2025 Ideal Broccoli
+
+#pragma once
+
+#include <ctime>
+#include <string>
+#include <vector>
+
+namespace toolbox {
+
+namespace logger {
+
+/**
+ * @brief Appends log lines to a file through an in-memory ring buffer.
+ *
+ * Lines are copied into the buffer and written in batches: once half of
+ * the buffer is used, when flushIfDue() finds the flush interval has
+ * passed, and on destruction. A batch is one writev() without waiting
+ * for the file, so what it cannot take stays buffered. A line that does
+ * not fit either way is dropped and counted (DROP), or the buffer is
+ * written out first, waiting for the file as long as it takes (BLOCK).
+ * A line longer than the whole buffer is always dropped.
+ *
+ * Usage example:
+ * @code
+ * LogWriter writer;
+ * writer.open("access.log");
+ * writer.configure(64 * 1024, 1, LogWriter::DROP);
+ * writer.append("one line\n");
+ * // ... from the event loop:
+ * writer.flushIfDue();
+ * @endcode
+ *
+ * @note Not thread-safe, like the loggers built on it.
+ */
+class LogWriter {
+ public:
+    enum Overflow {
+        DROP,
+        BLOCK
+    };
+
+    LogWriter();
+    ~LogWriter();
+
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return _fd != -1; }
+    bool isEmpty() const { return _size == 0; }
+
+    /**
+     * @brief Change the buffering; what is buffered is written out first.
+     */
+    void configure(std::size_t capacity, time_t flushInterval,
+                   Overflow overflow);
+
+    void append(const std::string& line);
+
+    /**
+     * @brief Write the buffer if the flush interval has passed.
+     */
+    void flushIfDue();
+
+    /**
+     * @brief Lines dropped since the last call.
+     */
+    std::size_t takeDropped();
+
+ private:
+    LogWriter(const LogWriter&);
+    LogWriter& operator=(const LogWriter&);
+
+    bool flush();
+    void drain();
+    void discard(std::size_t length);
+    void copyIn(const std::string& line);
+
+    int _fd;
+    std::vector<char> _ring;
+    std::size_t _head;
+    std::size_t _size;
+    time_t _flushInterval;
+    time_t _lastFlush;
+    Overflow _overflow;
+    std::size_t _dropped;
+};
+
+}  // namespace logger
+
+}  // namespace toolbox
@@ -9,9 +9,12 @@ The class is designed to be simple and lightweight,
 allowing for easy logging without the overhead of exception handling.
 The class uses a singleton pattern to ensure that only one instance of the logger exists.
 The class is not thread-safe, so it should not be used in a multi-threaded environment.
+Lines are buffered by a LogWriter and reach the file in batches, so that
+logging from the event loop does not cost a write() per line.
 */
 
 #include "stepmark.hpp"
+#include "string.hpp"
 
 #include <iostream>
 #include <ctime>
@@ -20,10 +23,6 @@ The class is not thread-safe, so it should not be used in a multi-threaded envir
 #include <stdexcept>
 #include <string>
 
-// namespace {
-//     const std::size_t IO_BUFFER_SIZE = 16 * 1024; // 16 KB
-// }
-
 namespace toolbox {
 
 /*
@@ -35,9 +34,7 @@ logger::StepMark::StepMark() : _level(INFO), _logFileName("stepmark.log") {
 }
 
 logger::StepMark::~StepMark() {
-    if (_logFile.is_open()) {
-        _logFile.close();
-    }
+    _writer.close();
 }
 
 void logger::StepMark::setLevel(StepmarkLevel level) {
@@ -47,13 +44,39 @@ void logger::StepMark::setLevel(StepmarkLevel level) {
 
 void logger::StepMark::setLogFile(const std::string& file) {
     logger::StepMark& instance = getInstance();
-    if (instance._logFile.is_open()) {
-        instance._logFile.close();
-    }
+    instance._writer.close();
     instance._logFileName = file;
     instance.openLogFile();
 }
 
+void logger::StepMark::setBuffering(std::size_t capacity, time_t flushInterval,
+                                    LogWriter::Overflow overflow) {
+    getInstance()._writer.configure(capacity, flushInterval, overflow);
+}
+
+void logger::StepMark::reopen() {
+    getInstance()._writer.close();
+}
+
+// - Dropped lines are reported once the buffer is written out, or the
+//   report would be dropped as well.
+void logger::StepMark::flush() {
+    logger::StepMark& instance = getInstance();
+    instance._writer.flushIfDue();
+    if (!instance._writer.isEmpty()) {
+        return;
+    }
+    std::size_t dropped = instance._writer.takeDropped();
+    if (dropped > 0) {
+        warning("StepMark: " + toolbox::to_string(dropped)
+                + " lines dropped, the log file could not keep up");
+    }
+}
+
+bool logger::StepMark::isEnabled(StepmarkLevel level) {
+    return level >= getInstance()._level;
+}
+
 logger::StepMark& logger::StepMark::getInstance() {
     static StepMark instance;
     return instance;
@@ -75,13 +98,13 @@ void logger::StepMark::log(StepmarkLevel level, const std::string& message) {
     };
 
     logger::StepMark& instance = getInstance();
-    if (!instance._logFile.is_open()) {
+    if (!instance._writer.isOpen()) {
         instance.openLogFile();
     }
-    if (instance._logFile.is_open()) {
+    if (instance._writer.isOpen()) {
         if (level >= instance._level) {
-            instance._logFile << instance.getTimeStamp()
-                << " [" << levelStr[level] << "] " << message << std::endl;
+            instance._writer.append(instance.getTimeStamp()
+                + " [" + levelStr[level] + "] " + message + "\n");
         }
     } else {
         std::cerr << "Error: Log file is not open." << std::endl;
@@ -117,17 +140,15 @@ std::string logger::StepMark::getTimeStamp() {
 }
 
 void logger::StepMark::openLogFile() {
-    _logFile.open(_logFileName.c_str(), std::ios::app);
-    if (!_logFile.is_open()) {
+    if (!_writer.open(_logFileName)) {
         std::cerr << "Error opening log file: " << _logFileName
             << ". Defaulting to stepmark.log." << std::endl;
         _logFileName = "stepmark.log";
-        _logFile.open(_logFileName.c_str(), std::ios::app);
+        _writer.open(_logFileName);
     }
-    if (_logFile.is_open()) {
-        _logFile << "[" << getTimeStamp() << "] "
-            << "Log file opened: " << _logFileName
-            << std::endl;
+    if (_writer.isOpen()) {
+        _writer.append("[" + getTimeStamp() + "] "
+            + "Log file opened: " + _logFileName + "\n");
     }
 }
 
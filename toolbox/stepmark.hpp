@@ -2,8 +2,38 @@
 
 #pragma once
 
+#include <ctime>
 #include <string>
-#include <fstream>
+
+#include "log_writer.hpp"
+
+// Levels below this are compiled out of the STEPMARK_* macros; build with
+// make STEPMARK_MIN_LEVEL=2 to drop debug and info logging entirely.
+#ifndef STEPMARK_MIN_LEVEL
+#define STEPMARK_MIN_LEVEL 0
+#endif
+
+// The message expression is only evaluated if the level is logged:
+//   STEPMARK_INFO("Epoll: timeout for client fd: " + toolbox::to_string(fd));
+// A constant condition, so calls below STEPMARK_MIN_LEVEL leave no code.
+#define STEPMARK_LOG(level, message) \
+    do { \
+        if (static_cast<int>(level) >= STEPMARK_MIN_LEVEL \
+                && toolbox::logger::StepMark::isEnabled(level)) { \
+            toolbox::logger::StepMark::log((level), (message)); \
+        } \
+    } while (0)
+
+#define STEPMARK_DEBUG(message) \
+    STEPMARK_LOG(toolbox::logger::DEBUG, message)
+#define STEPMARK_INFO(message) \
+    STEPMARK_LOG(toolbox::logger::INFO, message)
+#define STEPMARK_WARNING(message) \
+    STEPMARK_LOG(toolbox::logger::WARNING, message)
+#define STEPMARK_ERROR(message) \
+    STEPMARK_LOG(toolbox::logger::ERROR, message)
+#define STEPMARK_CRITICAL(message) \
+    STEPMARK_LOG(toolbox::logger::CRITICAL, message)
 
 namespace toolbox {
 
@@ -20,7 +50,14 @@ enum StepmarkLevel {
 class StepMark {
  public:
     static void setLevel(StepmarkLevel level);
+    static bool isEnabled(StepmarkLevel level);
     static void setLogFile(const std::string& file);
+    static void setBuffering(std::size_t capacity, time_t flushInterval,
+                             LogWriter::Overflow overflow);
+    // Writes out the buffered lines once the flush interval has passed.
+    static void flush();
+    // Closes the file; the next line opens it again, for log rotation.
+    static void reopen();
     static void log(StepmarkLevel level, const std::string& message);
 
     static void debug(const std::string& message);
@@ -32,7 +69,7 @@ class StepMark {
  private:
     StepmarkLevel _level;
     std::string _logFileName;
-    std::ofstream _logFile;
+    LogWriter _writer;
 
     static StepMark& getInstance();
     void openLogFile();